@@ -77,6 +77,19 @@ void CoreTests_Str()
 	TEST_STR_EQ(Seq(Str().Dbl(123.56, 3)), "123.560");
 	TEST_STR_EQ(Seq(Str().Dbl(-123.56, 3)), "-123.560");
 
+	TEST_STR_EQ(Seq(Str().DblShortest(0.0)), "0");
+	TEST_STR_EQ(Seq(Str().DblShortest(0.1)), "0.1");
+	TEST_STR_EQ(Seq(Str().DblShortest(0.3)), "0.3");
+	TEST_STR_EQ(Seq(Str().DblShortest(1.0/3.0)), "0.3333333333333333");
+	TEST_STR_EQ(Seq(Str().DblShortest(123.0)), "123");
+	TEST_STR_EQ(Seq(Str().DblShortest(-123.56)), "-123.56");
+	TEST_STR_EQ(Seq(Str().DblShortest(1e20)), "100000000000000000000");
+	TEST_STR_EQ(Seq(Str().DblShortest(1e21)), "1e+21");
+	TEST_STR_EQ(Seq(Str().DblShortest(1e-6)), "0.000001");
+	TEST_STR_EQ(Seq(Str().DblShortest(1.23e-7)), "1.23e-7");
+	TEST_STR_EQ(Seq(Str().DblShortest(5e-324)), "5e-324");
+	TEST_STR_EQ(Seq(Str().DblShortest(1.7976931348623157e308)), "1.7976931348623157e+308");
+
 	Time t1 = Time::FromIsoStyleTimeStr("2019-03-06 22:16:23.012034").Ref();
 	TEST_STR_EQ(Str::From(t1, TimeFmt::EngDateAbbr ), "Mar 6, 2019");
 	TEST_STR_EQ(Str::From(t1, TimeFmt::EngDateFull ), "March 6, 2019");
@@ -247,6 +260,115 @@ void CoreTests_Str()
 }
 
 
+uint64 CoreTests_XorShift(uint64& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+
+void CoreTests_DblRoundTrip()
+{
+	auto readExact = [] (Seq s) -> double
+		{
+			Seq reader = s;
+			double v = reader.ReadDoubleExact();
+			if (reader.n)
+				throw "ReadDoubleExact did not consume entire input";
+			return v;
+		};
+
+	auto checkRead = [&] (Seq s, double expected)
+		{
+			TestDesc(Str::Join("ReadDoubleExact(\"", s, "\")"));
+			double v = readExact(s);
+			if (memcmp(&v, &expected, sizeof(double)) == 0)
+				Console::Out("ok\r\n");
+			else
+				Console::Out(Str("FAIL: ").DblShortest(v).Add("\r\n"));
+		};
+
+	checkRead("0",                       0.0);
+	checkRead("-0",                      -0.0);
+	checkRead("1.5",                     1.5);
+	checkRead("1.",                      1.0);
+	checkRead("1e21",                    1e21);
+	checkRead("1E-7",                    1e-7);
+	checkRead("9007199254740993",        9007199254740992.0);
+	checkRead("2.2250738585072014e-308", 2.2250738585072014e-308);
+	checkRead("2.4703282292062327e-324", 0.0);
+	checkRead("2.4703282292062328e-324", 5e-324);
+	checkRead("1e400",                   std::numeric_limits<double>::infinity());
+	checkRead("123456789012345678901234567890", 1.2345678901234568e+29);
+	checkRead("0.1000000000000000055511151231257827021181583404541015625", 0.1);
+
+	// Round trip over random bit patterns
+	enum { NrRandom = 10000000 };
+	uint64 state = 0x9E3779B97F4A7C15ULL;
+	sizet nrTested {};
+	Str s;
+	for (sizet i=0; i!=NrRandom; ++i)
+	{
+		uint64 bits = CoreTests_XorShift(state);
+		double v;
+		memcpy(&v, &bits, sizeof(double));
+		if (v != v)
+			continue;
+
+		s.Clear().DblShortest(v);
+		double r = readExact(s);
+		if (memcmp(&v, &r, sizeof(double)) != 0)
+		{
+			Console::Out(Str("DblShortest round trip FAIL: bits ").UInt(bits, 16, 16).Add(", str ").Add(s).Add("\r\n"));
+			throw "DblShortest round trip failed";
+		}
+
+		++nrTested;
+	}
+
+	Console::Out(Str("DblShortest round trip: ").UInt(nrTested).Add(" random bit patterns ok\r\n"));
+
+	// Throughput, compared to fixed precision Dbl and ReadDouble
+	enum { NrBench = 2000000 };
+	Vec<double> values;
+	values.ReserveExact(NrBench);
+	for (sizet i=0; i!=NrBench; ++i)
+		values.Add(((double) (CoreTests_XorShift(state) % 100000000)) / 1000.0);
+
+	auto bench = [&] (Seq desc, std::function<void (Str&, double)> encode, std::function<double (Seq&)> decode)
+		{
+			Str out;
+			out.ReserveExact(NrBench * 24);
+
+			Time t0 = Time::NonStrictNow();
+			for (double v : values)
+			{
+				encode(out, v);
+				out.Ch(',');
+			}
+			Time t1 = Time::NonStrictNow();
+
+			double sum {};
+			Seq reader = out;
+			while (reader.n)
+			{
+				sum += decode(reader);
+				reader.DropByte();
+			}
+			Time t2 = Time::NonStrictNow();
+
+			Console::Out(Str::Join(desc, ": encode ").Obj(t1 - t0, TimeFmt::DurationMilliseconds)
+				.Add(", decode ").Obj(t2 - t1, TimeFmt::DurationMilliseconds).Add(" for ").UInt(NrBench).Add(" values, ")
+				.UIntBytes(out.Len()).Add(", checksum ").UInt(((uint64) sum) & 0xFFFF).Add("\r\n"));
+		};
+
+	bench("Dbl(v, 8) / ReadDouble        ", [] (Str& out, double v) { out.Dbl(v, 8);       }, [] (Seq& r) { return r.ReadDouble();      } );
+	bench("DblShortest / ReadDoubleExact ", [] (Str& out, double v) { out.DblShortest(v);  }, [] (Seq& r) { return r.ReadDoubleExact(); } );
+}
+
+
 void CoreTests_Heap()
 {
 	struct Tracker
@@ -454,6 +576,7 @@ void CoreTests_Exceptions()
 void CoreTests()
 {
 	CoreTests_Str();
+	CoreTests_DblRoundTrip();
 	CoreTests_Heap();
 	CoreTests_HashMap();
 	CoreTests_Exceptions();
@@ -0,0 +1,155 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	// Reads all records with both the copying and the zero-copy reader, and checks that they produce the same fields
+	void CompareReaders(Seq content, char fieldDelim, char commentDelim, sizet expectNrRecords)
+	{
+		CsvReader strReader { content, fieldDelim, commentDelim };
+		CsvReader seqReader { content, fieldDelim, commentDelim };
+		Vec<Str> strRecord;
+		Vec<Seq> seqRecord;
+		sizet nrStrFields {}, nrSeqFields {}, nrRecords {};
+
+		while (true)
+		{
+			bool haveStr = strReader.ReadRecord(strRecord, nrStrFields);
+			bool haveSeq = seqReader.ReadRecord(seqRecord, nrSeqFields);
+			if (haveStr != haveSeq) throw "CsvReader: Zero-copy reader returned a different number of records";
+			if (!haveStr) break;
+
+			++nrRecords;
+			if (nrStrFields != nrSeqFields) throw "CsvReader: Zero-copy reader returned a different number of fields";
+			for (sizet i=0; i!=nrStrFields; ++i)
+				if (!Seq(strRecord[i]).EqualExact(seqRecord[i]))
+					throw "CsvReader: Zero-copy reader returned a different field";
+		}
+
+		if (nrRecords != expectNrRecords)
+			throw "CsvReader: Unexpected number of records";
+	}
+
+
+	void CorrectnessTests()
+	{
+		CompareReaders("a,b,c\r\n1,2,3\n\n4,,6", ',', 0, 3);
+		CompareReaders("\"a\",\"b\"\"c\", \"d\" \r\n\"e,f\",g", ',', 0, 2);
+		CompareReaders("\"multi\r\nline\",x\r\n\"esc\"\"aped\r\nmulti\"\"line\"\r\ny", ',', 0, 3);
+		CompareReaders("# comment only\r\nx;y # trailing\r\n\"q\" # after quoted\r\n;\r\n", ';', '#', 4);
+
+		// Fields of the zero-copy reader point into the content unless they need to be unescaped
+		Seq content = "abc,\"def\",\"g\"\"h\"";
+		CsvReader reader { content, ',', 0 };
+		Vec<Seq> record;
+		sizet nrFields {};
+		if (!reader.ReadRecord(record, nrFields) || nrFields != 3) throw "CsvReader: Unexpected record";
+		if (record[0].p != content.p     || record[0] != "abc" ) throw "CsvReader: Unquoted field is not zero-copy";
+		if (record[1].p != content.p + 5 || record[1] != "def" ) throw "CsvReader: Quoted field without escapes is not zero-copy";
+		if (record[2] != "g\"h")                                  throw "CsvReader: Quoted field was not unescaped";
+
+		Console::Out("CsvReader correctness: OK\r\n");
+	}
+
+
+	void OutResult(char const* desc, uint64 nrBytes, LONG64 elapsedTicks, sizet nrRecords, uint64 fieldBytes)
+	{
+		double seconds = ((double) PickMax<LONG64>(elapsedTicks, 1)) / ((double) TicksPerSec());
+		double gbPerSec = (((double) nrBytes) / seconds) / 1e9;
+
+		Console::Out(Str("  ").Add(desc).Add(": ").UInt((uint64) (seconds * 1000)).Add(" ms, ")
+			.UInt((uint64) gbPerSec).Ch('.').UInt(((uint64) (gbPerSec * 100)) % 100, 10, 2).Add(" GB/s, ")
+			.UInt(nrRecords).Add(" records, ").UInt(fieldBytes).Add(" field bytes\r\n"));
+	}
+
+
+	void GenerateBenchFile(Seq path)
+	{
+		// Resembles a MaxMind GeoLite City locations file, with a quoted city name in every record and an escaped quote in some
+		enum { NrRecords = 4000000 };
+
+		File file;
+		file.Open(path, File::OpenArgs::DefaultOverwrite());
+
+		Str chunk;
+		chunk.ReserveExact(1000000);
+		for (sizet i=0; i!=NrRecords; ++i)
+		{
+			chunk.UInt(i).Add(",\"US\",\"CA\",\"");
+			if ((i % 16) == 0)
+				chunk.Add("Lake \"\"Town\"\" ");
+			chunk.Add("San Francisco\",\"").UInt(94100 + (i % 100)).Add("\",37.7").UInt(i % 1000, 10, 3).Add(",-122.4").UInt(i % 1000, 10, 3).Add("\r\n");
+
+			if (chunk.Len() > 990000)
+			{
+				file.Write(chunk);
+				chunk.Clear();
+			}
+		}
+
+		file.Write(chunk);
+	}
+
+
+	void Benchmark(Seq path)
+	{
+		Console::Out(Str("Reading ").Add(path).Add("\r\n"));
+
+		uint64 strFieldBytes {}, seqFieldBytes {};
+
+		{
+			LONG64 startTicks = Ticks();
+			FileLoader loader { path, FileLoader::Mode::Read };
+			CsvReader reader { loader, ',', 0 };
+			Vec<Str> record;
+			sizet nrFields {}, nrRecords {};
+			while (reader.ReadRecord(record, nrFields))
+			{
+				++nrRecords;
+				for (sizet i=0; i!=nrFields; ++i)
+					strFieldBytes += record[i].Len();
+			}
+
+			OutResult("Read, copied fields   ", loader.Content().n, Ticks() - startTicks, nrRecords, strFieldBytes);
+		}
+
+		{
+			LONG64 startTicks = Ticks();
+			FileLoader loader { path, FileLoader::Mode::Map };
+			CsvReader reader { loader, ',', 0 };
+			Vec<Seq> record;
+			sizet nrFields {}, nrRecords {};
+			while (reader.ReadRecord(record, nrFields))
+			{
+				++nrRecords;
+				for (sizet i=0; i!=nrFields; ++i)
+					seqFieldBytes += record[i].n;
+			}
+
+			OutResult("Mapped, zero-copy     ", loader.Content().n, Ticks() - startTicks, nrRecords, seqFieldBytes);
+		}
+
+		if (strFieldBytes != seqFieldBytes)
+			throw "CsvReader: Zero-copy reader returned different content";
+	}
+
+} // anon
+
+
+void CsvTests(Slice<Seq> args)
+{
+	CorrectnessTests();
+
+	if (args.Len() > 2)
+		Benchmark(args[2]);
+	else
+	{
+		Seq path = "AutCsvBench.csv";
+		Console::Out(Str("Generating ").Add(path).Add("\r\n"));
+		OnExit deleteFile = [&] { DeleteFileW(WinStr(path).Z()); };
+		GenerateBenchFile(path);
+		Benchmark(path);
+	}
+}
@@ -0,0 +1,71 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	void ExpectOutput(Seq input, DeflateEncoder::Format format, Seq expected, sizet pieceLen)
+	{
+		Str out;
+		DeflateEncoder encoder { out, format };
+		while (input.n)
+			encoder.Write(input.ReadBytes(pieceLen));
+		encoder.Finish();
+
+		if (!Seq(out).EqualExact(expected))
+			throw "DeflateEncoder: Unexpected output";
+	}
+
+
+	void CorrectnessTests()
+	{
+		// Expected outputs were verified to decompress to the input using zlib
+		sizet const pieceLens[] = { 1, 5, SIZE_MAX };
+		for (sizet pieceLen : pieceLens)
+		{
+			ExpectOutput("",                            DeflateEncoder::Format::Raw,  Seq("\x02\x0C\x00", 3),                                                                             pieceLen);
+			ExpectOutput("abcabcabcabcabcabc",          DeflateEncoder::Format::Raw,  Seq("\x4A\x4C\x4A\x46\x43\x80\x01\x00", 8),                                                         pieceLen);
+			ExpectOutput("Hello, Hello, Hello, Hello!", DeflateEncoder::Format::Zlib, Seq("\x78\x01\xF2\x48\xCD\xC9\xC9\xD7\x51\xC0\x42\x29\x02\x06\x00\x7D\x2C\x08\xD6", 19),                 pieceLen);
+			ExpectOutput("a",                           DeflateEncoder::Format::Gzip, Seq("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\xFF\x4A\x04\x0C\x00\x43\xBE\xB7\xE8\x01\x00\x00\x00", 22), pieceLen);
+		}
+
+		Console::Out("DeflateEncoder correctness: OK\r\n");
+	}
+
+
+	void Benchmark()
+	{
+		// Resembles a webmail message list page
+		Str html;
+		html.Add("<!DOCTYPE html><html><head><title>Inbox</title></head><body><table class=\"msgList\">\r\n");
+		for (sizet i=0; i!=20000; ++i)
+			html.Add("<tr class=\"msg\"><td class=\"from\"><a href=\"/contact?id=").UInt(i * 7919 % 10007).Add("\">Sender ").UInt(i % 97)
+				.Add("</a></td><td class=\"subject\"><a href=\"/msg?id=").UInt(i).Add("\">Re: Subject number ").UInt(i % 389)
+				.Add("</a></td><td class=\"date\">2017-0").UInt(1 + (i % 9)).Add("-1").UInt(i % 10).Add("</td></tr>\r\n");
+		html.Add("</table></body></html>\r\n");
+
+		enum { NrRuns = 10 };
+		Str out;
+		LONG64 startTicks = Ticks();
+		for (sizet i=0; i!=NrRuns; ++i)
+		{
+			out.Clear();
+			DeflateEncoder::Compress(html, out, DeflateEncoder::Format::Gzip);
+		}
+		LONG64 elapsedTicks = Ticks() - startTicks;
+
+		double seconds = ((double) PickMax<LONG64>(elapsedTicks, 1)) / ((double) TicksPerSec());
+		double mbPerSec = ((((double) html.Len()) * NrRuns) / seconds) / 1e6;
+		Console::Out(Str("DeflateEncoder: ").UInt(html.Len()).Add(" bytes of HTML compressed to ").UInt(out.Len()).Add(" bytes, ")
+			.UInt((uint64) mbPerSec).Add(" MB/s\r\n"));
+	}
+
+} // anon
+
+
+void DeflateTests()
+{
+	CorrectnessTests();
+	Benchmark();
+}
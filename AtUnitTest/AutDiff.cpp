@@ -162,6 +162,99 @@ void DiffTest(Seq linesOld, Seq linesNew, Seq desc, Diff::DiffParams const& diff
 }
 
 
+namespace
+{
+	// Deterministic, so that benchmark runs are comparable
+	struct BenchRandom
+	{
+		uint64 m_state { 0x9E3779B97F4A7C15ULL };
+		uint64 Next(uint64 mod) { m_state = (m_state * 6364136223846793005ULL) + 1442695040888963407ULL; return (m_state >> 17) % mod; }
+	};
+
+
+	// Lines resemble source code: mostly distinct, with some frequently repeated lines such as braces and blank lines
+	void AddBenchLine(Str& text, BenchRandom& rnd)
+	{
+		switch (rnd.Next(8))
+		{
+		case 0:  text.Add("\n"); break;
+		case 1:  text.Add("}\n"); break;
+		default: text.Add("x = f(").UInt(rnd.Next(UINT64_MAX)).Add(");\n"); break;
+		}
+	}
+
+
+	void SplitBenchLines(Seq text, Vec<Diff::InputUnit>& input)
+	{
+		sizet seqNr {};
+		text.ForEachLine( [&] (Seq line) -> bool { input.Add(++seqNr, line); return true; } );
+	}
+
+
+	LONG64 TimedGenerate(Slice<Diff::InputUnit> inputOld, Slice<Diff::InputUnit> inputNew, Vec<Diff::DiffUnit>& diff, Diff::DiffParams const& diffParams)
+	{
+		LONG64 startTicks = Ticks();
+		Diff::Generate(inputOld, inputNew, diff, diffParams);
+		return Ticks() - startTicks;
+	}
+
+
+	void DiffBenchmark(Diff::DiffParams const& diffParams)
+	{
+		sizet const nrLinesList[] = { 10000, 100000, 1000000 };
+		for (sizet nrLines : nrLinesList)
+		{
+			// The new text has about one edit per 100 lines: a removed, added, or changed line
+			BenchRandom rnd;
+			Str oldText, newText;
+			oldText.ReserveExact(nrLines * 32);
+			newText.ReserveExact(nrLines * 33);
+
+			for (sizet i=0; i!=nrLines; ++i)
+			{
+				sizet lineStart = oldText.Len();
+				AddBenchLine(oldText, rnd);
+
+				switch (rnd.Next(300))
+				{
+				case 0:  break;
+				case 1:  AddBenchLine(newText, rnd); newText.Add(Seq(oldText).DropBytes(lineStart)); break;
+				case 2:  AddBenchLine(newText, rnd); break;
+				default: newText.Add(Seq(oldText).DropBytes(lineStart)); break;
+				}
+			}
+
+			Vec<Diff::InputUnit> inputOld, inputNew;
+			SplitBenchLines(oldText, inputOld);
+			SplitBenchLines(newText, inputNew);
+
+			Diff::DiffParams seqParams = diffParams;
+			seqParams.m_maxThreads = 1;
+			Vec<Diff::DiffUnit> seqDiff, parDiff;
+			LONG64 seqTicks = TimedGenerate(inputOld, inputNew, seqDiff, seqParams);
+			LONG64 parTicks = TimedGenerate(inputOld, inputNew, parDiff, diffParams);
+
+			if (seqDiff.Len() != parDiff.Len())
+				throw "Diff differs depending on number of threads";
+
+			for (sizet i=0; i!=seqDiff.Len(); ++i)
+				if (seqDiff[i].m_disposition != parDiff[i].m_disposition ||
+					seqDiff[i].m_inputUnit.m_seqNr != parDiff[i].m_inputUnit.m_seqNr)
+					throw "Diff differs depending on number of threads";
+
+			LONG64 const ticksPerMs = PickMax<LONG64>(TicksPerSec() / 1000, 1);
+			uint nrThreads = diffParams.m_maxThreads ? diffParams.m_maxThreads : PickMax<uint>(std::thread::hardware_concurrency(), 1);
+			Console::Out(Str().UInt(nrLines).Add(" lines, ").UInt(seqDiff.Len()).Add(" diff lines: 1 thread ")
+				.UInt((uint64) (seqTicks / ticksPerMs)).Add(" ms, ").UInt(nrThreads).Add(" threads ")
+				.UInt((uint64) (parTicks / ticksPerMs)).Add(" ms\r\n"));
+
+			CheckDiffCorrect(parDiff, inputOld, inputNew);
+		}
+	}
+
+} // anon
+
+
 void DiffTestSimple(Seq oldText, Seq newText, Diff::DiffParams const& diffParams)
 {
 	Str oldLines, newLines;
@@ -183,7 +276,7 @@ void DiffTests(Slice<Seq> args)
 {
 	Diff::DiffParams diffParams;
 
-	bool helpRequested {}, simpleInput {}, haveOldParam {}, haveNewParam {};
+	bool helpRequested {}, simpleInput {}, benchmark {}, threadsSet {}, haveOldParam {}, haveNewParam {};
 	Seq oldParam, newParam;
 
 	for (sizet i=2; i<args.Len(); ++i)
@@ -200,6 +293,14 @@ void DiffTests(Slice<Seq> args)
 				simpleInput = true;
 			else if (arg == "-nls")
 				diffParams.m_limitSteps = false;
+			else if (arg == "-bench")
+				benchmark = true;
+			else if (arg.StartsWithExact("-t"))
+			{
+				arg.DropBytes(2);
+				diffParams.m_maxThreads = arg.ReadNrUInt32Dec();
+				threadsSet = true;
+			}
 			else
 				{ Console::Err(Str::Join("Unrecognized switch: ", arg, "\r\n")); return; }
 		}
@@ -220,13 +321,22 @@ void DiffTests(Slice<Seq> args)
 	if (helpRequested)
 	{
 		Console::Out(
-			"Usage: AtUnitTest diff [<oldFile> <newFile> | -s <oldText> <newText>] [options]\r\n"
+			"Usage: AtUnitTest diff [<oldFile> <newFile> | -s <oldText> <newText> | -bench] [options]\r\n"
 			"Options:\r\n"
-			" -nls    Set DiffParams::m_limitSteps to false\r\n");
+			" -nls    Set DiffParams::m_limitSteps to false\r\n"
+			" -t<n>   Set DiffParams::m_maxThreads to n. 0 = number of logical processors\r\n"
+			" -bench  Compare single-threaded and multi-threaded performance on generated inputs. Uses -t0 unless -t is given\r\n");
 	}
 	else
 	{
-		if (!haveOldParam && !haveNewParam)
+		if (benchmark)
+		{
+			if (!threadsSet)
+				diffParams.m_maxThreads = 0;
+
+			DiffBenchmark(diffParams);
+		}
+		else if (!haveOldParam && !haveNewParam)
 		{
 			DiffTestSimple("",            "",        diffParams);
 			DiffTestSimple("",            "a",       diffParams);
@@ -0,0 +1,93 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	sizet DeltaRoundTrip(Seq oldText, Seq newText)
+	{
+		Str delta;
+		Diff::EncodeDelta(delta, oldText, newText, Diff::DiffParams());
+
+		Str forward, backward;
+		if (!Diff::ApplyDeltaForward(delta, oldText, forward)) throw "Diff delta: Forward application failed";
+		if (!Seq(forward).EqualExact(newText))                 throw "Diff delta: Forward application produced unexpected text";
+		if (!Diff::ApplyDeltaBackward(delta, newText, backward)) throw "Diff delta: Backward application failed";
+		if (!Seq(backward).EqualExact(oldText))                  throw "Diff delta: Backward application produced unexpected text";
+
+		// A delta applied to the wrong text, or truncated, must not produce the target text
+		if (!Seq(oldText).EqualExact(newText))
+		{
+			Str wrong;
+			if (Diff::ApplyDeltaForward(delta, newText, wrong) && Seq(wrong).EqualExact(newText))
+				throw "Diff delta: Delta applied to the wrong text";
+		}
+
+		for (sizet n=0; n!=delta.Len(); ++n)
+		{
+			Str truncated;
+			if (Diff::ApplyDeltaForward(Seq(delta).ReadBytes(n), oldText, truncated))
+				throw "Diff delta: Truncated delta applied";
+		}
+
+		return delta.Len();
+	}
+
+
+	void CorrectnessTests()
+	{
+		DeltaRoundTrip("", "");
+		DeltaRoundTrip("", "a\n");
+		DeltaRoundTrip("a\n", "");
+		DeltaRoundTrip("a\nb\nc\n", "a\nb\nc\n");
+		DeltaRoundTrip("a\nb\nc\n", "a\nB\nc\n");
+		DeltaRoundTrip("a\nb\nc", "a\nb\nc\n");
+		DeltaRoundTrip("a\nb\nc\n", "a\nc\n");
+		DeltaRoundTrip("a\nc\n", "a\nb1\nb2\nc\n");
+		DeltaRoundTrip("one\r\ntwo\r\nthree\r\n", "three\r\ntwo\r\none\r\n");
+		DeltaRoundTrip("The quick brown fox\njumps over\nthe lazy dog\n", "The quick red fox\njumps over\nthe lazy cat\n");
+		DeltaRoundTrip(Seq("\0\n\xFF\n\0", 5), Seq("\0\n\xFE\xFF\n", 5));
+
+		// A one-word change in a long line is stored as the changed bytes only
+		Str line;
+		line.Chars(1000, 'x');
+		Str oldText = Str::Join(line, "\nold word\n", line, "\n");
+		Str newText = Str::Join(line, "\nnew word\n", line, "\n");
+		if (DeltaRoundTrip(oldText, newText) > 20)
+			throw "Diff delta: Change was not narrowed to the bytes that differ";
+
+		Console::Out("Diff delta correctness: OK\r\n");
+	}
+
+
+	void SizeTest()
+	{
+		// A document resembling source code, edited in a few places
+		Str oldText, newText;
+		for (sizet i=0; i!=10000; ++i)
+		{
+			oldText.Add("\tvalue").UInt(i).Add(" = Compute(").UInt(i * 7919 % 10007).Add(");\r\n");
+
+			if ((i % 500) == 0)
+				newText.Add("\tvalue").UInt(i).Add(" = Compute(").UInt(i * 7919 % 10007).Add(", true);\r\n");
+			else if ((i % 1500) != 1)
+				newText.Add("\tvalue").UInt(i).Add(" = Compute(").UInt(i * 7919 % 10007).Add(");\r\n");
+
+			if ((i % 2000) == 2)
+				newText.Add("\t// Inserted line\r\n");
+		}
+
+		sizet deltaLen = DeltaRoundTrip(oldText, newText);
+		Console::Out(Str("Diff delta size: old text ").UInt(oldText.Len()).Add(" bytes, new text ").UInt(newText.Len())
+			.Add(" bytes, delta ").UInt(deltaLen).Add(" bytes\r\n"));
+	}
+
+} // anon
+
+
+void DiffDeltaTests()
+{
+	CorrectnessTests();
+	SizeTest();
+}
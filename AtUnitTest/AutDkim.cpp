@@ -141,10 +141,7 @@ void DkimTest(Slice<Seq> args)
 		else if (cmd.EqualInsensitive("verify"))
 		{
 			Str msg = loadFileByArg(4);
-			ParseTree pt { msg };
-			parseMsg(pt);
-
-			Dkim::SigVerifier verifier { pt };
+			Dkim::SigVerifier verifier { msg };
 			verifier.ReadSignatures();
 			Console::Out(Str("SigVerifier found ").UInt(verifier.Sigs().Len()).Add(" signatures\r\n"));
 
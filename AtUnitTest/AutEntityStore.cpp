@@ -70,6 +70,8 @@ namespace
 	ENTITY_DECL_FLD_K(Time,      timeAdded, KeyCat::Key_NonStr_Multi)
 	ENTITY_DECL_FLD_E(ItemState, state)
 	ENTITY_DECL_FIELD(ObjId,     userId)
+	ENTITY_DECL_INDEX(State)
+	ENTITY_DECL_INDEX(User)
 	ENTITY_DECL_CLOSE()
 
 	ENTITY_DEF_BEGIN(QueueItem)
@@ -78,6 +80,9 @@ namespace
 	ENTITY_DEF_FIELD(QueueItem, userId)
 	ENTITY_DEF_CLOSE(QueueItem)
 
+	ENTITY_DEF_INDEX2(QueueItem, State, KeyCat::Key_NonStr_Multi, state, timeAdded)
+	ENTITY_DEF_INDEX1(QueueItem, User,  KeyCat::Key_NonStr_Multi, userId)
+
 
 
 	// Globals
@@ -239,10 +244,13 @@ namespace
 				{
 					items.Clear();
 
-					m_q->EnumAllChildrenOfKind<QueueItem>( [&] (Rp<QueueItem> c) -> bool
+					EntityIndexKey scheduled { QueueItem::Index_State };
+					scheduled.Add(ItemState::Scheduled);
+
+					m_q->FindChildrenWithIndexKey<QueueItem>(scheduled, [&] (Rp<QueueItem> const& c) -> bool
 						{
-							if (c->f_state == ItemState::Scheduled)
-								items.Add(c);
+							EnsureThrow(c->f_state == ItemState::Scheduled);
+							items.Add(c);
 							return true;
 						} );
 
@@ -259,9 +267,10 @@ namespace
 				{
 					for (Rp<QueueItem> const& item : items)
 					{
-						Rp<User> user = g_store.GetEntityOfKind<User>(item->f_userId, ObjId::None);
+						Rp<User> user = g_store.GetEntityOfKindShared<User>(item->f_userId, ObjId::None);
 						if (user.Any())
 						{
+							user = g_store.Writable(user);
 							++(user->f_nrItemsProcessed);
 							user->Update();
 						}
@@ -272,6 +281,216 @@ namespace
 		}
 	}
 
+
+
+
+	// Secondary indexes
+
+	sizet CountByState(Queue& q, ItemState::E state)
+	{
+		EntityIndexKey key { QueueItem::Index_State };
+		key.Add(state);
+
+		sizet n {};
+		q.FindChildrenWithIndexKey<QueueItem>(key, [&] (Rp<QueueItem> const&) -> bool { ++n; return true; } );
+		return n;
+	}
+
+
+	void IndexTests()
+	{
+		g_store.RunTxExclusive( []
+			{
+				Rp<Queue> q = new Queue(g_store, ObjId::Root);
+				q->Insert_ParentExists();
+
+				ObjId userId1 { 1, 1 }, userId2 { 1, 2 };
+				Time t = Time::FromFt(1000);
+				for (uint i=0; i!=10; ++i)
+				{
+					Rp<QueueItem> item = new QueueItem(Entity::ChildOf, q.Ref());
+					item->f_timeAdded = t + Time::FromSeconds(i);
+					item->f_state = If((i % 2) == 0, ItemState::E, ItemState::Scheduled, ItemState::InProgress);
+					item->f_userId = If(i < 3, ObjId, userId1, userId2);
+					item->Insert_ParentExists();
+				}
+
+				if (CountByState(q.Ref(), ItemState::Scheduled)  != 5)	throw "Unexpected number of scheduled items after insert";
+				if (CountByState(q.Ref(), ItemState::InProgress) != 5)	throw "Unexpected number of in progress items after insert";
+
+				// Range over the second field of a composite index, in reverse order
+				EntityIndexKey first { QueueItem::Index_State }, beyondLast { QueueItem::Index_State };
+				first.Add(ItemState::Scheduled).Add(t + Time::FromSeconds(2));
+				beyondLast.Add(ItemState::Scheduled).Add(t + Time::FromSeconds(7));
+
+				Vec<Time> times;
+				q->FindChildrenByIndex<QueueItem, EnumDir::Reverse>(first, &beyondLast, [&] (Rp<QueueItem> const& c) -> bool
+					{ times.Add(c->f_timeAdded); return true; } );
+
+				if (times.Len() != 3 || times[0] != t + Time::FromSeconds(6) || times[2] != t + Time::FromSeconds(2))
+					throw "Unexpected result of index range query";
+
+				// Update moves the entry; remove drops it
+				Rp<QueueItem> item = q->FindChild<QueueItem>(t);
+				item->f_state = ItemState::InProgress;
+				item->Update();
+				if (CountByState(q.Ref(), ItemState::Scheduled) != 4)	throw "Unexpected number of scheduled items after update";
+
+				item->Remove();
+				if (CountByState(q.Ref(), ItemState::InProgress) != 5)	throw "Unexpected number of in progress items after remove";
+
+				EntityIndexKey byUser { QueueItem::Index_User };
+				byUser.Add(userId1);
+				sizet nrUser1 {};
+				q->FindChildrenWithIndexKey<QueueItem>(byUser, [&] (Rp<QueueItem> const&) -> bool { ++nrUser1; return true; } );
+				if (nrUser1 != 2)										throw "Unexpected number of items for user";
+
+				// Index entries are not visible as children, and are recreated by rebuild
+				sizet nrChildren {};
+				q->EnumAllChildren( [&] (EntityChildInfo const&) -> bool { ++nrChildren; return true; } );
+				if (nrChildren != 9)									throw "Unexpected number of children";
+
+				if (g_store.RebuildIndexes<QueueItem>(q->m_entityId) != 9)	throw "Unexpected number of items reindexed";
+				if (CountByState(q.Ref(), ItemState::Scheduled) != 4)	throw "Unexpected number of scheduled items after rebuild";
+
+				q->RemoveAllChildrenOfKind<QueueItem>();
+				if (CountByState(q.Ref(), ItemState::InProgress) != 0)	throw "Index entries remain after children removed";
+
+				q->Remove();
+			} );
+
+		Console::Out("Secondary index tests: OK\r\n");
+	}
+
+
+
+	// Field table format and projections
+
+	void FieldFormatTests()
+	{
+		g_store.RunTxExclusive( []
+			{
+				Rp<Queue> q = new Queue(g_store, ObjId::Root);
+				q->Insert_ParentExists();
+
+				// Half the items are stored in the legacy format, half in the field table format
+				Time t = Time::FromFt(1000);
+				for (uint i=0; i!=8; ++i)
+				{
+					g_store.SetWriteFieldTables(i >= 4);
+
+					Rp<QueueItem> item = new QueueItem(Entity::ChildOf, q.Ref());
+					item->f_timeAdded = t + Time::FromSeconds(i);
+					item->f_state = ItemState::Scheduled;
+					item->f_userId = ObjId { 1, i + 1 };
+					item->Insert_ParentExists();
+				}
+
+				// Subsequent stores, including conversion, use the field table format
+				g_store.SetWriteFieldTables(true);
+
+				// Fields outside the projection are skipped only for items in the field table format
+				EntityProjection const projection { QueueItem::Sample, { "state" } };
+				sizet nrItems {}, nrWithUserId {};
+				RpVec<QueueItem> items;
+				q->EnumAllChildrenOfKind<QueueItem>(projection, [&] (Rp<QueueItem> const& c) -> bool
+					{
+						++nrItems;
+						if (!c->IsProjected())							throw "Entity loaded with projection is not marked projected";
+						if (c->f_state != ItemState::Scheduled)			throw "Projected field was not decoded";
+						if (c->f_userId.Any())
+							++nrWithUserId;
+						items.Add(c);
+						return true;
+					} );
+
+				if (nrItems != 8)										throw "Unexpected number of items in projected scan";
+				if (nrWithUserId != 4)									throw "Unexpected number of items decoded in full by projected scan";
+
+				for (Rp<QueueItem> const& item : items)
+				{
+					item->Load(ObjId::None);
+					if (item->IsProjected() || !item->f_userId.Any())	throw "Entity not loaded in full";
+				}
+
+				if (g_store.ConvertChildrenFormat<QueueItem>(q->m_entityId) != 4)	throw "Unexpected number of items converted";
+				if (g_store.ConvertChildrenFormat<QueueItem>(q->m_entityId) != 0)	throw "Items converted twice";
+
+				nrWithUserId = 0;
+				q->EnumAllChildrenOfKind<QueueItem>(projection, [&] (Rp<QueueItem> const& c) -> bool
+					{ if (c->f_userId.Any()) ++nrWithUserId; return true; } );
+				if (nrWithUserId != 0)									throw "Fields outside projection decoded after conversion";
+
+				Rp<QueueItem> item = q->FindChild<QueueItem>(t + Time::FromSeconds(2));
+				if (!item.Any() || item->f_userId != ObjId(1, 3))		throw "Converted item has unexpected content";
+
+				q->RemoveAllChildrenOfKind<QueueItem>();
+				q->Remove();
+			} );
+
+		g_store.SetWriteFieldTables(false);
+		Console::Out("Field table format and projection tests: OK\r\n");
+	}
+
+
+
+	// Shared entity cache
+
+	void SharedEntityCacheTests()
+	{
+		ObjId usersId, userId;
+		g_store.RunTxExclusive( [&]
+			{
+				Rp<Users> users = new Users(g_store, ObjId::Root);
+				users->Insert_ParentExists();
+				usersId = users->m_entityId;
+
+				Rp<User> user = new User(Entity::ChildOf, users.Ref());
+				user->f_name = "shared";
+				user->Insert_ParentExists();
+				userId = user->m_entityId;
+			} );
+
+		EntityStore::EntityCacheStats before = g_store.GetEntityCacheStats(Storage::Stats::Keep);
+
+		// Unchanged content is decoded once, and the same entity is returned to later transactions
+		Rp<User> first, second;
+		g_store.RunTxExclusive( [&] { first  = g_store.GetEntityOfKindShared<User>(userId, ObjId::None); } );
+		g_store.RunTxExclusive( [&] { second = g_store.GetEntityOfKindShared<User>(userId, ObjId::None); } );
+		if (!first->IsShared())									throw "Entity from cache is not marked shared";
+		if (first.Ptr() != second.Ptr())						throw "Shared entity was not reused";
+
+		// A transaction that modifies the entity gets a private copy, and the shared entity is unaffected
+		g_store.RunTxExclusive( [&]
+			{
+				Rp<User> user = g_store.GetEntityOfKindShared<User>(userId, ObjId::None);
+				Rp<User> writable = g_store.Writable(user);
+				if (writable.Ptr() == user.Ptr() || writable->IsShared())	throw "Writable did not return a private copy";
+
+				writable->f_nrItemsQueued = 7;
+				writable->Update();
+			} );
+
+		if (first->f_nrItemsQueued != 0)						throw "Shared entity was modified";
+
+		// Changed content is not served from the cache
+		Rp<User> third;
+		g_store.RunTxExclusive( [&]
+			{
+				third = g_store.GetEntityOfKindShared<User>(userId, ObjId::None);
+				g_store.RemoveEntity(userId);
+				g_store.RemoveEntity(usersId);
+			} );
+
+		if (third.Ptr() == first.Ptr() || third->f_nrItemsQueued != 7)	throw "Shared entity is stale after update";
+
+		EntityStore::EntityCacheStats after = g_store.GetEntityCacheStats(Storage::Stats::Keep);
+		if (after.m_nrHits   - before.m_nrHits   != 2)			throw "Unexpected number of shared entity cache hits";
+		if (after.m_nrMisses - before.m_nrMisses != 2)			throw "Unexpected number of shared entity cache misses";
+
+		Console::Out("Shared entity cache tests: OK\r\n");
+	}
+
 } // anon
 
 
@@ -310,6 +529,10 @@ void EntityStoreTests(Slice<Seq> args)
 			g_store.SetWritePlanTest(true, writeFailOdds);
 		g_store.Init();
 
+		IndexTests();
+		FieldFormatTests();
+		SharedEntityCacheTests();
+
 		g_store.RunTxExclusive( []
 			{
 				g_users = g_store.InitCategoryParent<Users>();
@@ -373,6 +596,15 @@ void EntityStoreTests(Slice<Seq> args)
 		addStat("nrCommitTx:             ", stats.m_nrCommitTx             );
 		addStat("nrAbortTx:              ", stats.m_nrAbortTx              );
 
+		EntityStore::EntityCacheStats cacheStats = g_store.GetEntityCacheStats(Storage::Stats::Keep);
+		uint64 nrLookups = cacheStats.m_nrHits + cacheStats.m_nrMisses;
+		double hitRate = If(!nrLookups, double, 0.0, 100.0 * ((double) cacheStats.m_nrHits) / ((double) nrLookups));
+
+		addStat("entityCacheHits:        ", NumCast<sizet>(cacheStats.m_nrHits)      );
+		addStat("entityCacheMisses:      ", NumCast<sizet>(cacheStats.m_nrMisses)    );
+		addStat("entityCacheEvictions:   ", NumCast<sizet>(cacheStats.m_nrEvictions) );
+		msg.Add("entityCacheHitRate:     ").Dbl(hitRate, 1).Add("%\r\n");
+
 		Console::Out(msg);
 	}
 	catch (Exception const& e)
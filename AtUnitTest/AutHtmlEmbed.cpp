@@ -95,7 +95,8 @@ void HtmlEmbedTest(Args& args)
 	bool               needNewline {};
 	ParseTree::Storage ptStorage;
 
-	sizet nrFiles {}, nrMsgParseFail {}, nrUnsupCt {}, nrMptParseFail {}, nrHtmlNotFound {}, nrHtmlDecodeFail {}, nrHtmlParseFail {}, nrPartFail {};
+	sizet nrFiles {}, nrMsgParseFail {}, nrUnsupCt {}, nrMptParseFail {}, nrHtmlNotFound {}, nrHtmlDecodeFail {}, nrHtmlParseFail {}, nrPartFail {}, nrStreamMismatch {};
+	ULONGLONG treeTicks {}, streamTicks {};
 
 	while (inFiles.Next())
 	{
@@ -172,14 +173,31 @@ void HtmlEmbedTest(Args& args)
 						if (!outBaseName.n)
 							outBaseName = "msg";
 
+						// The streaming transform must produce the same output as the parse tree transform, and fail in the same cases
+						AutEmbedCx streamCx { pinStore, outBaseName };
+						HtmlBuilder streamHtml { htmlPartContent.m_decoded.n };
+						ULONGLONG startTicks = GetTickCount64();
+						bool streamed = Html::StreamTransform(htmlPartContent.m_decoded).ToEmbeddableHtml(streamHtml, streamCx);
+						streamTicks += GetTickCount64() - startTicks;
+
 						AutEmbedCx embedCx { pinStore, outBaseName };
 						HtmlBuilder embedHtml { htmlPartContent.m_decoded.n };
+						startTicks = GetTickCount64();
 						Html::Transform transform { htmlPartContent.m_decoded };
-						if (!transform.Parse())
+						bool parsed = transform.Parse();
+						treeTicks += GetTickCount64() - startTicks;
+
+						if (!parsed)
 						{
 							if (needNewline) { Console::Out("\r\n"); needNewline = false; }
 							Console::Err(Str(result.m_fileName).Add(": HTML content part could not be parsed\r\n"));
 							++nrHtmlParseFail;
+
+							if (streamed)
+							{
+								Console::Err(Str(result.m_fileName).Add(": streaming transform succeeded where parse failed\r\n"));
+								++nrStreamMismatch;
+							}
 						}
 						else
 						{
@@ -191,8 +209,17 @@ void HtmlEmbedTest(Args& args)
 								Console::Out(s);
 							}
 
+							startTicks = GetTickCount64();
 							transform.ToEmbeddableHtml(embedHtml, embedCx);
+							treeTicks += GetTickCount64() - startTicks;
 							Seq embedHtmlSeq = embedHtml.Final();
+
+							if (!streamed || streamHtml.Final() != embedHtmlSeq)
+							{
+								if (needNewline) { Console::Out("\r\n"); needNewline = false; }
+								Console::Err(Str(result.m_fileName).Add(": streaming transform output differs\r\n"));
+								++nrStreamMismatch;
+							}
 					
 							Seq title = "(No subject)";
 							if (msg.m_subject.Any())
@@ -304,5 +331,7 @@ void HtmlEmbedTest(Args& args)
 		.UInt(nrHtmlNotFound)   .Add(" HTML content part not found\r\n")
 		.UInt(nrHtmlDecodeFail) .Add(" HTML decode failures\r\n")
 		.UInt(nrHtmlParseFail)  .Add(" HTML parse failures\r\n")
-		.UInt(nrPartFail)       .Add(" part finding/decoding failures\r\n"));
+		.UInt(nrPartFail)       .Add(" part finding/decoding failures\r\n")
+		.UInt(nrStreamMismatch) .Add(" streaming transform mismatches\r\n")
+		.Add("Parse tree transform: ").UInt(treeTicks).Add(" ms, streaming transform: ").UInt(streamTicks).Add(" ms\r\n"));
 }
@@ -9,8 +9,10 @@
 #include "AtBCrypt.h"
 #include "AtCrc32.h"
 #include "AtCrypt.h"
+#include "AtDeflate.h"
 #include "AtConsole.h"
 #include "AtDiff.h"
+#include "AtDiffDelta.h"
 #include "AtDkim.h"
 #include "AtDllNtDll.h"
 #include "AtEllipticCurve.h"
@@ -19,20 +21,29 @@
 #include "AtFile.h"
 #include "AtHeap.h"
 #include "AtHtmlTransform.h"
+#include "AtIpFairThrottle.h"
+#include "AtIpRangeIndex.h"
 #include "AtImfReadWrite.h"
+#include "AtLoginThrottle.h"
 #include "AtMap.h"
 #include "AtMarkdownTransform.h"
 #include "AtMimeReadWrite.h"
+#include "AtMpFixed.h"
 #include "AtMpUInt.h"
 #include "AtPath.h"
+#include "AtPwHash.h"
+#include "AtPwHashService.h"
 #include "AtSchannel.h"
+#include "AtSlabAlloc.h"
 #include "AtSmtpReceiver.h"
 #include "AtSocketConnector.h"
 #include "AtSocketReader.h"
 #include "AtSocketWriter.h"
 #include "AtStopCtl.h"
 #include "AtStr.h"
+#include "AtTaskScheduler.h"
 #include "AtTextBuilder.h"
+#include "AtTextLog.h"
 #include "AtTime.h"
 #include "AtUriGrammar.h"
 #include "AtUtfWin.h"
@@ -0,0 +1,195 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+#include <random>
+
+
+namespace
+{
+
+	uint64 Rand64(std::mt19937& mt) { return (((uint64) mt()) << 32) | mt(); }
+
+	uint32 RandKey(std::mt19937& mt, uint32) { return mt(); }
+	Ip6Key RandKey(std::mt19937& mt, Ip6Key) { return Ip6Key(Rand64(mt), Rand64(mt)); }
+
+	Ip6Key NextKey(Ip6Key k) { return Ip6Key(k.m_hi + (k.m_lo == UINT64_MAX), k.m_lo + 1); }
+	uint32 NextKey(uint32 k) { return k + 1; }
+
+	Ip6Key PrevKey(Ip6Key k) { return Ip6Key(k.m_hi - (k.m_lo == 0), k.m_lo - 1); }
+	uint32 PrevKey(uint32 k) { return k - 1; }
+
+
+	// Generates sorted distinct boundaries, and uses every other interval between them as a range, so that there are gaps
+	template <class Key>
+	void MakeRanges(std::mt19937& mt, sizet nrRanges, Vec<Key>& firsts, Vec<Key>& lasts)
+	{
+		Vec<Key> bounds;
+		bounds.ReserveExact(2 * nrRanges);
+		for (sizet i=0; i!=2*nrRanges; ++i)
+			bounds.Add(RandKey(mt, Key()));
+
+		std::sort(bounds.begin(), bounds.end());
+		Key* newEnd = std::unique(bounds.begin(), bounds.end());
+		bounds.ResizeExact((sizet) (newEnd - bounds.begin()) & ~((sizet) 1));
+
+		firsts.Clear();
+		lasts.Clear();
+		for (sizet i=0; i+1<bounds.Len(); i+=2)
+		{
+			firsts.Add(bounds[i]);
+			lasts.Add(bounds[i+1]);
+		}
+	}
+
+
+	template <class Key>
+	sizet RefFind(Slice<Key> firsts, Slice<Key> lasts, Key key)
+	{
+		Key const* it = std::upper_bound(firsts.begin(), firsts.end(), key);
+		if (it == firsts.begin())
+			return SIZE_MAX;
+
+		sizet i = (sizet) (it - firsts.begin()) - 1;
+		if (lasts[i] < key)
+			return SIZE_MAX;
+
+		return i;
+	}
+
+
+	template <class Key>
+	void IpRangeIndexCorrectnessTest(char const* desc, std::mt19937& mt, sizet nrRanges)
+	{
+		Vec<Key> firsts, lasts;
+		MakeRanges<Key>(mt, nrRanges, firsts, lasts);
+
+		IpRangeIndex<Key, sizet> index;
+		for (sizet i=0; i!=firsts.Len(); ++i)
+			index.Add(firsts[i], lasts[i], i);
+		index.Build();
+
+		// Boundaries of every range, and their neighbors, as well as the minimum and maximum keys, and random keys
+		Vec<Key> keys;
+		keys.Add(Key());
+		keys.Add(IpKeyMax(Key()));
+		for (sizet i=0; i!=firsts.Len(); ++i)
+		{
+			keys.Add(firsts[i]);
+			keys.Add(lasts[i]);
+			if (!(firsts[i] == Key()))            keys.Add(PrevKey(firsts[i]));
+			if (!(lasts[i] == IpKeyMax(Key())))   keys.Add(NextKey(lasts[i]));
+		}
+		for (sizet i=0; i!=1000; ++i)
+			keys.Add(RandKey(mt, Key()));
+
+		Vec<sizet const*> results;
+		results.ResizeExact(keys.Len());
+		index.FindBatch(keys.Ptr(), keys.Len(), results.Ptr());
+
+		for (sizet i=0; i!=keys.Len(); ++i)
+		{
+			sizet expected = RefFind<Key>(firsts, lasts, keys[i]);
+			sizet const* found = index.Find(keys[i]);
+
+			if (expected == SIZE_MAX)
+			{
+				if (found)          throw "IpRangeIndex found a range for a key not in any range";
+				if (results[i])     throw "IpRangeIndex batch found a range for a key not in any range";
+			}
+			else
+			{
+				if (!found)                 throw "IpRangeIndex did not find the range containing a key";
+				if (*found != expected)     throw "IpRangeIndex found the wrong range";
+				if (results[i] != found)    throw "IpRangeIndex batch result differs from single lookup";
+			}
+		}
+
+		Console::Out(Str(desc).Add(": ").UInt(index.Len()).Add(" ranges, ").UInt(keys.Len()).Add(" keys: OK\r\n"));
+	}
+
+
+	void OutRate(char const* desc, sizet nrLookups, Time elapsed, sizet nrFound)
+	{
+		uint64 const ms = PickMax<uint64>(elapsed.ToMilliseconds(), 1);
+		Console::Out(Str("  ").Add(desc).Add(": ").UInt((1000 * (uint64) nrLookups) / ms).Add(" lookups per second (")
+			.UInt(nrFound).Add(" found)\r\n"));
+	}
+
+
+	// Compares lookups using binary search over ranges in sorted order with lookups using the tree, one at a time and in batches
+	template <class Key>
+	void IpRangeIndexBenchmark(char const* desc, std::mt19937& mt, sizet nrRanges, sizet nrLookups)
+	{
+		Vec<Key> firsts, lasts;
+		MakeRanges<Key>(mt, nrRanges, firsts, lasts);
+
+		IpRangeIndex<Key, sizet> index;
+		for (sizet i=0; i!=firsts.Len(); ++i)
+			index.Add(firsts[i], lasts[i], i);
+		index.Build();
+
+		Vec<Key> keys;
+		keys.ReserveExact(nrLookups);
+		for (sizet i=0; i!=nrLookups; ++i)
+			keys.Add(RandKey(mt, Key()));
+
+		Console::Out(Str(desc).Add(": ").UInt(index.Len()).Add(" ranges, ").UInt(nrLookups).Add(" lookups\r\n"));
+
+		sizet nrFound {};
+		Time t = Time::NonStrictNow();
+		for (Key const& key : keys)
+			if (RefFind<Key>(firsts, lasts, key) != SIZE_MAX)
+				++nrFound;
+		OutRate("Binary search", nrLookups, Time::NonStrictNow() - t, nrFound);
+
+		nrFound = 0;
+		t = Time::NonStrictNow();
+		for (Key const& key : keys)
+			if (index.Find(key))
+				++nrFound;
+		OutRate("Tree", nrLookups, Time::NonStrictNow() - t, nrFound);
+
+		Vec<sizet const*> results;
+		results.ResizeExact(nrLookups);
+		nrFound = 0;
+		t = Time::NonStrictNow();
+		index.FindBatch(keys.Ptr(), keys.Len(), results.Ptr());
+		for (sizet const* result : results)
+			if (result)
+				++nrFound;
+		OutRate("Tree, batch", nrLookups, Time::NonStrictNow() - t, nrFound);
+	}
+
+} // anon
+
+
+void IpRangeIndexTests(Slice<Seq> args)
+{
+	sizet nrRanges = 300000;
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrRanges = arg.ReadNrUInt32Dec();
+	}
+
+	if (!nrRanges)
+	{
+		Console::Err("Usage: AtUnitTest iprx [<nrRanges>]\r\n");
+		return;
+	}
+
+	std::mt19937 mt;
+
+	sizet const smallSizes[] = { 0, 1, 2, 3, 7, 8, 9, 100 };
+	for (sizet n : smallSizes)
+	{
+		IpRangeIndexCorrectnessTest<uint32>("IPv4", mt, n);
+		IpRangeIndexCorrectnessTest<Ip6Key>("IPv6", mt, n);
+	}
+
+	IpRangeIndexCorrectnessTest<uint32>("IPv4", mt, 10000);
+	IpRangeIndexCorrectnessTest<Ip6Key>("IPv6", mt, 10000);
+
+	IpRangeIndexBenchmark<uint32>("IPv4", mt, nrRanges, 4000000);
+	IpRangeIndexBenchmark<Ip6Key>("IPv6", mt, nrRanges / 4, 4000000);
+}
@@ -0,0 +1,252 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+
+namespace
+{
+
+	// JsonTestItem
+
+	ENTITY_DECL_BEGIN(JsonTestItem)
+	ENTITY_DECL_FIELD(uint64,      nr)
+	ENTITY_DECL_FIELD(Str,         name)
+	ENTITY_DECL_FIELD(Opt<double>, weight)
+	ENTITY_DECL_CLOSE()
+
+	ENTITY_DEF_BEGIN(JsonTestItem)
+	ENTITY_DEF_FIELD(JsonTestItem, nr)
+	ENTITY_DEF_FIELD(JsonTestItem, name)
+	ENTITY_DEF_FIELD(JsonTestItem, weight)
+	ENTITY_DEF_CLOSE(JsonTestItem)
+
+
+
+	// JsonTestEnt
+
+	ENTITY_DECL_BEGIN(JsonTestEnt)
+	ENTITY_DECL_FIELD(bool,                 flag)
+	ENTITY_DECL_FIELD(uint64,               u)
+	ENTITY_DECL_FIELD(int64,                s)
+	ENTITY_DECL_FIELD(double,               f)
+	ENTITY_DECL_FIELD(Time,                 t)
+	ENTITY_DECL_FIELD(ObjId,                id)
+	ENTITY_DECL_FIELD(Str,                  text)
+	ENTITY_DECL_FIELD(Str,                  bin)
+	ENTITY_DECL_FIELD(Opt<uint64>,          optU)
+	ENTITY_DECL_FIELD(Opt<Str>,             optText)
+	ENTITY_DECL_FIELD(Vec<int64>,           vecS)
+	ENTITY_DECL_FIELD(Vec<Str>,             vecText)
+	ENTITY_DECL_FIELD(EntOpt<JsonTestItem>, optItem)
+	ENTITY_DECL_FIELD(EntVec<JsonTestItem>, items)
+	ENTITY_DECL_CLOSE()
+
+	ENTITY_DEF_BEGIN(JsonTestEnt)
+	ENTITY_DEF_FIELD(JsonTestEnt, flag)
+	ENTITY_DEF_FIELD(JsonTestEnt, u)
+	ENTITY_DEF_FIELD(JsonTestEnt, s)
+	ENTITY_DEF_FIELD(JsonTestEnt, f)
+	ENTITY_DEF_FIELD(JsonTestEnt, t)
+	ENTITY_DEF_FIELD(JsonTestEnt, id)
+	ENTITY_DEF_FIELD(JsonTestEnt, text)
+	ENTITY_DEF_FIELD(JsonTestEnt, bin)
+	ENTITY_DEF_FIELD(JsonTestEnt, optU)
+	ENTITY_DEF_FIELD(JsonTestEnt, optText)
+	ENTITY_DEF_FIELD(JsonTestEnt, vecS)
+	ENTITY_DEF_FIELD(JsonTestEnt, vecText)
+	ENTITY_DEF_FIELD(JsonTestEnt, optItem)
+	ENTITY_DEF_FIELD(JsonTestEnt, items)
+	ENTITY_DEF_CLOSE(JsonTestEnt)
+
+
+
+	// Helpers
+
+	void InitTestEnt(JsonTestEnt& e, sizet nrItems)
+	{
+		e.f_flag = true;
+		e.f_u = UINT64_MAX;
+		e.f_s = INT64_MIN;
+		e.f_f = 0.1;
+		e.f_t = Time::FromFt(131000000000000000ULL);
+		e.f_id = ObjId(12345, 678);
+		e.f_text = "Tab\t, quote \", backslash \\, non-ASCII \xC5\xA1\xC4\x8D\xC5\xBE, astral \xF0\x9F\x98\x80";
+		e.f_bin.Set(Seq("\x00\x01\xFE\xFF", 4));
+		e.f_optText.Init("optional");
+		e.f_vecS.Add(-1);
+		e.f_vecS.Add(INT64_MAX);
+		e.f_vecText.Add("a");
+		e.f_vecText.Add("");
+		e.f_optItem.Init().f_nr = 7;
+
+		for (sizet i=0; i!=nrItems; ++i)
+		{
+			JsonTestItem& item = e.f_items.Add();
+			item.f_nr = i;
+			item.f_name.Set("Item number ").UInt(i);
+			if ((i % 3) != 0)
+				item.f_weight.Init((double) i / 7.0);
+		}
+	}
+
+
+	Str TreeDecode(Entity& e, Seq json)
+	{
+		ParseTree pt { json };
+		if (!pt.Parse(Json::C_Json))
+			return Str("Grammar: ").Obj(pt, ParseTree::BestAttempt);
+
+		ParseNode const* objNode = pt.Root().FlatFind(Json::id_Object);
+		if (!objNode)
+			return Str("Grammar: not an object");
+
+		try { e.JsonDecode(*objNode, nullptr); }
+		catch (Json::DecodeErr const& x) { return Str(x.what()); }
+		return Str();
+	}
+
+
+	Str StreamDecode(Entity& e, Seq json)
+	{
+		try { e.JsonDecode(json, nullptr); }
+		catch (Json::DecodeErr const& x) { return Str(x.what()); }
+		return Str();
+	}
+
+
+	void JsonStreamRoundTripTest()
+	{
+		JsonTestEnt orig { Entity::Contained };
+		InitTestEnt(orig, 100);
+
+		Str json;
+		orig.JsonEncode(json);
+
+		JsonTestEnt decoded { Entity::Contained };
+		Str err = StreamDecode(decoded, json);
+		if (err.Any())
+		{
+			Console::Out(Str("Stream decode failed: ").Add(err).Add("\r\n"));
+			throw "Stream decode of encoded entity failed";
+		}
+
+		Str json2;
+		decoded.JsonEncode(json2);
+		if (json != json2)
+			throw "Stream decoded entity does not re-encode to the same JSON";
+
+		Console::Out("Stream decode round trip: OK\r\n");
+	}
+
+
+	void JsonStreamErrorParityTest()
+	{
+		// Inputs that match the JSON grammar, but fail to decode. Both decoders must report the same error at the same location
+		char const* const inputs[] =
+			{
+				"{ \"nope\": 1 }",
+				"{\r\n\t\"u\": -1 }",
+				"{\r\n\t\"u\": \"1\" }",
+				"{ \"s\": 1.5e+300 }",
+				"{ \"flag\": null }",
+				"{ \"t\": 1 }",
+				"{ \"t\": \"2020-01-01\" }",
+				"{ \"id\": 5 }",
+				"{ \"id\": \"xyz\" }",
+				"{ \"text\": \"h:0g\" }",
+				"{ \"text\": \"\\uDC00\" }",
+				"{ \"text\": \"\\uD800\" }",
+				"{ \"text\": \"\\uD800x\" }",
+				"{ \"text\": \"\\uD800\\u0041\" }",
+				"{ \"vecS\": [ 1,\r\n  \"two\" ] }",
+				"{ \"optItem\": { \"nr\": true } }",
+				"{ \"items\": [ {}, { \"nr\":\r\n\t\t \"\xC5\xA1\" } ] }",
+				"{ \"text\": \"\xC5\xA1\xE4\xB8\xAD\", \"u\": true }",
+				"{ \"items\": [ {}, { \"\xC5\xA1\xC5\xA1\": 1 } ] }",
+			};
+
+		for (char const* z : inputs)
+		{
+			JsonTestEnt e1 { Entity::Contained };
+			JsonTestEnt e2 { Entity::Contained };
+			Str treeErr   = TreeDecode(e1, z);
+			Str streamErr = StreamDecode(e2, z);
+
+			if (treeErr.StartsWithExact("Grammar: "))
+				Console::Out(Str("(skipped, not grammatical) ").Add(z).Add("\r\n"));
+			else if (treeErr != streamErr)
+			{
+				Console::Out(Str("Input: ").Add(z).Add("\r\nTree:   ").Add(treeErr).Add("\r\nStream: ").Add(streamErr).Add("\r\n"));
+				throw "Stream decoder error does not match tree decoder error";
+			}
+		}
+
+		// Syntax errors are detected by the stream decoder when it reaches them
+		char const* const malformed[] = { "", "{", "{ \"u\" 1 }", "{ \"u\": 1, }", "{ \"u\": 01 }", "{ \"text\": \"abc }", "{} x", "[ 1 ]" };
+		for (char const* z : malformed)
+		{
+			JsonTestEnt e { Entity::Contained };
+			if (!StreamDecode(e, z).Any())
+			{
+				Console::Out(Str("Input: ").Add(z).Add("\r\n"));
+				throw "Stream decoder accepted malformed input";
+			}
+		}
+
+		Console::Out("Stream decode error parity: OK\r\n");
+	}
+
+
+	void JsonStreamBenchmark(sizet nrItems)
+	{
+		JsonTestEnt orig { Entity::Contained };
+		InitTestEnt(orig, nrItems);
+
+		Str json;
+		orig.JsonEncode(json);
+
+		enum { NrRuns = 5 };
+		Time treeElapsed, streamElapsed;
+
+		for (uint run=0; run!=NrRuns; ++run)
+		{
+			JsonTestEnt e1 { Entity::Contained };
+			Time t1 = Time::NonStrictNow();
+			if (TreeDecode(e1, json).Any())
+				throw "Tree decode failed";
+			Time t2 = Time::NonStrictNow();
+
+			JsonTestEnt e2 { Entity::Contained };
+			if (StreamDecode(e2, json).Any())
+				throw "Stream decode failed";
+			Time t3 = Time::NonStrictNow();
+
+			treeElapsed   = treeElapsed   + (t2 - t1);
+			streamElapsed = streamElapsed + (t3 - t2);
+		}
+
+		uint64 treeUs   = PickMax<uint64>(treeElapsed.ToMicroseconds(),   1);
+		uint64 streamUs = PickMax<uint64>(streamElapsed.ToMicroseconds(), 1);
+		uint64 totalBytes = json.Len() * NrRuns;
+
+		Console::Out(Str("Decoding ").UInt(json.Len()).Add(" bytes of JSON with ").UInt(nrItems).Add(" items, ").UInt(NrRuns).Add(" runs:\r\n")
+			.Add("ParseTree:     ").Obj(treeElapsed,   TimeFmt::DurationMilliseconds).Add(", ").UInt(totalBytes / treeUs  ).Add(" MB/s\r\n")
+			.Add("StreamDecoder: ").Obj(streamElapsed, TimeFmt::DurationMilliseconds).Add(", ").UInt(totalBytes / streamUs).Add(" MB/s\r\n"));
+	}
+
+} // anon
+
+
+void JsonTests(Slice<Seq> args)
+{
+	sizet nrItems = 100000;
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrItems = arg.ReadNrUInt32Dec();
+	}
+
+	JsonStreamRoundTripTest();
+	JsonStreamErrorParityTest();
+	JsonStreamBenchmark(nrItems);
+}
@@ -19,21 +19,33 @@ int wmain(int argc, wchar_t const* const* argv)
 				"  bcrp - BCrypt\r\n"
 				"  boot - BootTime\r\n"
 				"  chri - CharInfo\r\n"
+				"  csv  - CsvReader, FileLoader\r\n"
+				"  defl - DeflateEncoder\r\n"
 				"  diff - Diff\r\n"
+				"  dlta - Diff delta\r\n"
 				"  dkim - Dkim\r\n"
 				"  addr - EmailAddress\r\n"
 				"  ents - EntityStore\r\n"
 				"  htme - HtmlEmbed\r\n"
+				"  thrt - IpFairThrottle, LoginThrottle\r\n"
+				"  iprx - IpRangeIndex\r\n"
+				"  json - Json\r\n"
 				"  lrge - LargeEntities\r\n"
 				"  map  - Map\r\n"
 				"  mkdn - Markdown\r\n"
 				"  mpui - MpUInt\r\n"
 				"  mltp - Multipart\r\n"
+				"  pwhs - PwHash\r\n"
 				"  rsas - RsaSigner\r\n"
 				"  schc - SchannelClient\r\n"
+				"  slab - SlabAlloc\r\n"
 				"  smtr - SmtpReceiver\r\n"
+				"  smed - SmtpReceiver, event-driven\r\n"
 				"  uris - Uri\r\n"
+				"  tsch - TaskScheduler\r\n"
 				"  text - TextBuilder\r\n"
+				"  tlog - TextLog\r\n"
+				"  time - Time\r\n"
 				"  werr - WinErr\r\n");
 		}
 		else if (0 == _wcsicmp(argv[1], L"core"))	// Can't use Seq if that's what we're testing
@@ -53,20 +65,32 @@ int wmain(int argc, wchar_t const* const* argv)
 			else if (cmd.EqualInsensitive("bcrp")) { BCryptTests        ();                              }
 			else if (cmd.EqualInsensitive("boot")) { BootTime           ();                              }
 			else if (cmd.EqualInsensitive("chri")) { CharInfoTest       (args);                          }
+			else if (cmd.EqualInsensitive("csv" )) { CsvTests           (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("defl")) { DeflateTests       ();                              }
 			else if (cmd.EqualInsensitive("diff")) { DiffTests          (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("dlta")) { DiffDeltaTests     ();                              }
 			else if (cmd.EqualInsensitive("dkim")) { DkimTest           (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("addr")) { EmailAddressTest   (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("ents")) { EntityStoreTests   (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("htme")) { HtmlEmbedTest      (args);                          }
+			else if (cmd.EqualInsensitive("thrt")) { ThrottleTests      (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("iprx")) { IpRangeIndexTests  (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("json")) { JsonTests          (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("lrge")) { LargeEntitiesTests ();                              }
 			else if (cmd.EqualInsensitive("map" )) { MapTests           ();                              }
 			else if (cmd.EqualInsensitive("mkdn")) { MarkdownTests      (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("mpui")) { MpUIntTests        ();                              }
 			else if (cmd.EqualInsensitive("mltp")) { MultipartTests     ();                              }
+			else if (cmd.EqualInsensitive("pwhs")) { PwHashTests        (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("rsas")) { RsaSignerTests     ();                              }
+			else if (cmd.EqualInsensitive("tsch")) { TaskSchedulerTests (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("text")) { TextBuilderTests   ();                              }
+			else if (cmd.EqualInsensitive("tlog")) { TextLogTests       (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("time")) { TimeTests          (args.ConvertAll().Converted()); }
 			else if (cmd.EqualInsensitive("schc")) { SchannelClientTest (args.ConvertAll().Converted()); }
+			else if (cmd.EqualInsensitive("slab")) { SlabAllocTests     ();                              }
 			else if (cmd.EqualInsensitive("smtr")) { SmtpReceiverTest   ();                              }
+			else if (cmd.EqualInsensitive("smed")) { SmtpEvDrivenTest   ();                              }
 			else if (cmd.EqualInsensitive("uris")) { UriTests           ();                              }
 			else if (cmd.EqualInsensitive("werr")) { WinErrTest         (args.ConvertAll().Converted()); }
 			else throw Args::Err("Unrecognized command");
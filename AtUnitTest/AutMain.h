@@ -2,6 +2,10 @@
 
 enum class Display { No, Yes };
 
+// High resolution timing for benchmarks
+inline LONG64 Ticks       () { LARGE_INTEGER li; QueryPerformanceCounter   (&li); return li.QuadPart; }
+inline LONG64 TicksPerSec () { LARGE_INTEGER li; QueryPerformanceFrequency (&li); return li.QuadPart; }
+
 void CoreTests          ();
 
 void ActvTests          ();
@@ -10,19 +14,31 @@ void BaseXYTests        ();
 void BCryptTests        ();
 void BootTime           ();
 void CharInfoTest       (Args& args);
+void CsvTests           (Slice<Seq> args);
+void DeflateTests       ();
 void DiffTests          (Slice<Seq> args);
+void DiffDeltaTests     ();
 void DkimTest           (Slice<Seq> args);
 void EmailAddressTest   (Slice<Seq> args);
 void EntityStoreTests   (Slice<Seq> args);
 void HtmlEmbedTest      (Args& args);
+void IpRangeIndexTests  (Slice<Seq> args);
+void JsonTests          (Slice<Seq> args);
 void LargeEntitiesTests ();
 void MapTests           ();
 void MarkdownTests      (Slice<Seq> args);
 void MpUIntTests        ();
 void MultipartTests     ();
+void PwHashTests        (Slice<Seq> args);
 void RsaSignerTests     ();
 void SchannelClientTest (Slice<Seq> args);
+void SlabAllocTests     ();
+void SmtpEvDrivenTest   ();
 void SmtpReceiverTest   ();
+void TaskSchedulerTests (Slice<Seq> args);
 void TextBuilderTests   ();
+void TextLogTests       (Slice<Seq> args);
+void ThrottleTests      (Slice<Seq> args);
+void TimeTests          (Slice<Seq> args);
 void UriTests           ();
 void WinErrTest         (Slice<Seq> args);
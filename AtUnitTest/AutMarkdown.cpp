@@ -40,6 +40,69 @@ void MarkdownTest(Seq srcText)
 }
 
 
+void RenderCacheTest()
+{
+	Seq const srcText = "*a __c__ b* `code` c\r\n"
+						"\r\n"
+						"1. a\r\n"
+						"2. b\r\n";
+
+	Markdown::Transform xform { srcText };
+	if (!xform.Parse())
+		throw "RenderCacheTest: Parsing failed";
+
+	HtmlBuilder expectHtml { HtmlBuilder::Fragment };
+	expectHtml.Div();
+	xform.ToHtml(expectHtml);
+	expectHtml.EndDiv();
+
+	ObjId const owner1 { 1, 1 }, owner2 { 1, 2 };
+	RenderCache cache;
+	for (uint i=0; i!=2; ++i)
+	{
+		HtmlBuilder html { HtmlBuilder::Fragment };
+		html.Div();
+		if (!Markdown::CachedToHtml(cache, srcText, false, owner1, 1, html))
+			throw "RenderCacheTest: CachedToHtml failed";
+		html.EndDiv();
+
+		if (!Seq(html.Final()).EqualExact(expectHtml.Final()))
+			throw "RenderCacheTest: Cached HTML differs";
+	}
+
+	Str text;
+	HtmlBuilder htmlPermitLinks { HtmlBuilder::Fragment }, htmlVersion2 { HtmlBuilder::Fragment }, htmlOwner2 { HtmlBuilder::Fragment };
+	if (!Markdown::CachedToText(cache, srcText, owner1, 1, text) ||
+		!Markdown::CachedToHtml(cache, srcText, true, owner1, 1, htmlPermitLinks) ||
+		!Markdown::CachedToHtml(cache, srcText, false, owner1, 2, htmlVersion2) ||
+		!Markdown::CachedToHtml(cache, srcText, false, owner2, 1, htmlOwner2))
+		throw "RenderCacheTest: Caching failed";
+
+	RenderCache::Stats stats = cache.GetStats();
+	if (stats.m_nrFragments != 5 || stats.m_nrHits != 1 || stats.m_nrMisses != 5)
+		throw "RenderCacheTest: Unexpected entries after rendering";
+
+	// Only owner1's version 1 is removed. The same version chosen by owner2 is unaffected
+	cache.RemoveVersion(owner1, 1);
+	if (cache.GetStats().m_nrFragments != 2)
+		throw "RenderCacheTest: Unexpected entries after RemoveVersion";
+
+	// Bound the cache so it holds MaxFragmentFraction text fragments. Adding one more must evict the least recently used
+	RenderCache smallCache { RenderCache::MaxFragmentFraction * (text.Len() + 1) };
+	auto render = [&] (uint64 version) { Str out; Markdown::CachedToText(smallCache, srcText, owner1, version, out); };
+	for (uint64 version=1; version<=RenderCache::MaxFragmentFraction; ++version)
+		render(version);
+	render(1);
+	render(RenderCache::MaxFragmentFraction + 1);
+
+	auto inSmallCache = [&] (uint64 version) { return smallCache.Find(RenderCacheKey(srcText, RenderKind::MarkdownText, 0, owner1, version), [] (Seq) {}); };
+	if (smallCache.GetStats().m_nrFragments != RenderCache::MaxFragmentFraction || !inSmallCache(1) || inSmallCache(2))
+		throw "RenderCacheTest: Unexpected eviction";
+
+	Console::Out("RenderCache: OK\r\n");
+}
+
+
 void MarkdownTests(Slice<Seq> args)
 {
 	if (args.Len() > 2)
@@ -172,5 +235,7 @@ void MarkdownTests(Slice<Seq> args)
 						">\t More list\r\n"
 						"> \t   New list item paragraph\r\n"
 						"> \tNo longer in list");
+
+		RenderCacheTest();
 	}
 }
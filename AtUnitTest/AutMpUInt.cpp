@@ -2,6 +2,206 @@
 #include "AutMain.h"
 
 
+namespace
+{
+	// Square-and-multiply with a long division after each multiplication. This is how PowModM worked before it used Montgomery
+	// arithmetic, and serves as the reference for correctness checks, and the baseline for benchmarks
+	MpUInt SlowPowModM(MpUInt const& base, MpUInt const& exp, MpUInt const& m)
+	{
+		MpUInt result { 1 }, b, q, r;
+		base.DivM(m, q, b);
+
+		sizet expBits = exp.NrBits();
+		for (sizet i=0; i!=expBits; ++i)
+		{
+			if (((exp.GetByte(i / 8) >> (i % 8)) & 1) != 0)
+			{
+				result.MulM(b).DivM(m, q, r);
+				result.Swap(r);
+			}
+
+			b.MulM(b).DivM(m, q, r);
+			b.Swap(r);
+		}
+
+		return result;
+	}
+
+
+	MpUInt RandomMpUInt(BCrypt::Rng const& rng, sizet nrBytes)
+	{
+		Str buf;
+		rng.SetBufRandom(buf, nrBytes);
+		return MpUInt(buf);
+	}
+
+
+	MpUInt RandomOddMpUInt(BCrypt::Rng const& rng, sizet nrBytes)
+	{
+		MpUInt m = RandomMpUInt(rng, nrBytes);
+		if (!m.IsOdd())
+			m.Inc();
+		return m;
+	}
+
+
+	MpUInt RandomMpUIntBelow(BCrypt::Rng const& rng, MpUInt const& m)
+	{
+		MpUInt q, r;
+		RandomMpUInt(rng, m.NrBytes() + 8).DivM(m, q, r);
+		return r;
+	}
+
+
+	void ReportOps(Seq desc, sizet nrOps, Time elapsed)
+	{
+		uint64 elapsedUs = PickMax<uint64>(elapsed.ToMicroseconds(), 1);
+		Console::Out(Str::Join(desc, ": ").UInt(nrOps).Add(" ops in ").Obj(elapsed, TimeFmt::DurationMilliseconds)
+			.Add(", ").UInt((nrOps * 1000000ULL) / elapsedUs).Add(" ops/sec\r\n"));
+	}
+
+
+	void PowModCorrectnessTest(BCrypt::Rng const& rng)
+	{
+		sizet const modBytes[] = { 1, 7, 8, 9, 31, 32, 33, 66, 128, 256, 512 };
+		sizet nrTested {};
+
+		for (sizet nrBytes : modBytes)
+			for (uint i=0; i!=10; ++i)
+			{
+				MpUInt m = RandomMpUInt(rng, nrBytes);
+				bool const wantOdd = ((i % 5) != 0);
+				if (m.IsOdd() != wantOdd)
+					m.Inc();
+				if (m <= 1U)
+					continue;
+
+				// Exponents are kept short enough for the reference to finish quickly with 4096-bit moduli
+				MpUInt base = RandomMpUInt(rng, nrBytes + 4);
+				MpUInt exp = RandomMpUInt(rng, rng.GenRandomNr32((uint32) PickMin<sizet>(nrBytes, 32)) + 1);
+				if (base.IsZero() || exp.IsZero())
+					continue;
+
+				if (base.PowModM(exp, m) != SlowPowModM(base, exp, m))		throw ZLitErr("PowModM does not match reference");
+
+				uint32 expS = rng.GenRandomNr32(100000) + 1;
+				if (base.PowModS(expS, m) != SlowPowModM(base, expS, m))	throw ZLitErr("PowModS does not match reference");
+
+				++nrTested;
+			}
+
+		Console::Out(Str().UInt(nrTested).Add(" PowModM and PowModS results checked\r\n"));
+	}
+
+
+	void P256FieldCorrectnessTest(BCrypt::Rng const& rng)
+	{
+		MpUInt p, q, r;
+		P256Field::Prime().Get(p);
+		MpUInt pm1 = p.SubM(MpUInt(1));
+
+		enum { NrChecks = 10000 };
+		for (uint i=0; i!=NrChecks; ++i)
+		{
+			MpUInt a = If(i < 3, MpUInt, pm1, RandomMpUIntBelow(rng, p));
+			MpUInt b = If(i < 2, MpUInt, pm1, RandomMpUIntBelow(rng, p));
+			P256Field::Elem ae { a }, be { b }, re;
+			MpUInt result;
+
+			P256Field::Mul(ae, be, re);
+			re.Get(result);
+			a.MulM(b).DivM(p, q, r);
+			if (result != r)										throw ZLitErr("P256Field::Mul does not match MulM and DivM");
+
+			P256Field::Add(ae, be, re);
+			re.Get(result);
+			a.AddM(b).DivM(p, q, r);
+			if (result != r)										throw ZLitErr("P256Field::Add does not match AddM and DivM");
+
+			P256Field::Sub(ae, be, re);
+			re.Get(result);
+			result.AddM(b).DivM(p, q, r);
+			if (r != a)												throw ZLitErr("P256Field::Sub does not match AddM and DivM");
+		}
+
+		Console::Out(Str().UInt(NrChecks).Add(" P256Field results checked\r\n"));
+	}
+
+
+	void ModMulBenchmark(BCrypt::Rng const& rng, MpUInt const& m, sizet nrOps)
+	{
+		MpUInt a = RandomMpUIntBelow(rng, m);
+		MpUInt b = RandomMpUIntBelow(rng, m);
+		Console::Out(Str("Modular multiplication, ").UInt(m.NrBits()).Add("-bit modulus:\r\n"));
+
+		MpUInt acc = a, q, r;
+		Time t1 = Time::NonStrictNow();
+		for (sizet i=0; i!=nrOps; ++i)
+		{
+			acc.MulM(b).DivM(m, q, r);
+			acc.Swap(r);
+		}
+		Time t2 = Time::NonStrictNow();
+		ReportOps("Before, MulM and DivM  ", nrOps, t2 - t1);
+
+		MpMont mont { m };
+		MpMont::Elem ae { a }, be { b }, accMont;
+		mont.ToMont(ae, accMont);
+		mont.ToMont(be, be);
+		t1 = Time::NonStrictNow();
+		for (sizet i=0; i!=nrOps; ++i)
+			mont.Mul(accMont, be, accMont);
+		t2 = Time::NonStrictNow();
+		ReportOps("After, MpMont::Mul     ", nrOps, t2 - t1);
+
+		MpMont::Elem resultMont;
+		MpUInt result;
+		mont.FromMont(accMont, resultMont);
+		resultMont.Get(result);
+		if (result != acc)											throw ZLitErr("MpMont::Mul chain does not match MulM and DivM chain");
+
+		if (P256Field::IsPrime(m))
+		{
+			P256Field::Elem acc256 { a }, b256 { b };
+			t1 = Time::NonStrictNow();
+			for (sizet i=0; i!=nrOps; ++i)
+				P256Field::Mul(acc256, b256, acc256);
+			t2 = Time::NonStrictNow();
+			ReportOps("After, P256Field::Mul  ", nrOps, t2 - t1);
+
+			acc256.Get(result);
+			if (result != acc)										throw ZLitErr("P256Field::Mul chain does not match MulM and DivM chain");
+		}
+	}
+
+
+	void PowModBenchmark(BCrypt::Rng const& rng, sizet nrBytes, sizet nrOpsBefore, sizet nrOpsAfter)
+	{
+		MpUInt m = RandomOddMpUInt(rng, nrBytes);
+		MpUInt base = RandomMpUIntBelow(rng, m);
+		MpUInt exp = RandomMpUInt(rng, nrBytes);
+		Console::Out(Str("PowModM, ").UInt(m.NrBits()).Add("-bit modulus and exponent:\r\n"));
+
+		MpUInt before, after;
+		Time t1 = Time::NonStrictNow();
+		for (sizet i=0; i!=nrOpsBefore; ++i)
+			before = SlowPowModM(base, exp, m);
+		Time t2 = Time::NonStrictNow();
+		ReportOps("Before, MulM and DivM  ", nrOpsBefore, t2 - t1);
+
+		t1 = Time::NonStrictNow();
+		for (sizet i=0; i!=nrOpsAfter; ++i)
+			after = base.PowModM(exp, m);
+		t2 = Time::NonStrictNow();
+		ReportOps("After, Montgomery      ", nrOpsAfter, t2 - t1);
+
+		if (before != after)										throw ZLitErr("PowModM does not match reference");
+	}
+
+} // anon
+
+
+
 void MpUIntTests()
 {
 	try
@@ -146,6 +346,38 @@ void MpUIntTests()
 
 			endTicks = GetTickCount64();
 			Console::Out(Str().UInt(nrKeysTested).Add(" points decompressed in ").UInt(endTicks - startTicks).Add(" ms\r\n"));
+
+			// Point decompression as it was done before P256Field and MpMont, for comparison
+			MpUInt const& p = nistp256.mc_prime;
+			startTicks = GetTickCount64();
+
+			for (PreparedKey const& pk : keys)
+			{
+				MpUInt q, rhs;
+				pk.m_x.PowModS(3, p).AddM(pk.m_x.MulM(nistp256.mc_a)).AddM(nistp256.mc_b).DivM(p, q, rhs);
+				yCmp = SlowPowModM(rhs, nistp256.mc_ident, p);
+				if (((yCmp.GetByte(0) & 1) == 1) != pk.m_yOdd)
+					yCmp = p.SubM(yCmp);
+				EnsureThrow(yCmp == pk.m_y);
+			}
+
+			endTicks = GetTickCount64();
+			Console::Out(Str().UInt(nrKeysTested).Add(" points decompressed using MulM and DivM in ").UInt(endTicks - startTicks).Add(" ms\r\n"));
+		}
+
+		{
+			BCrypt::Rng rng;
+
+			PowModCorrectnessTest(rng);
+			P256FieldCorrectnessTest(rng);
+
+			MpUInt p256Prime;
+			P256Field::Prime().Get(p256Prime);
+			ModMulBenchmark(rng, p256Prime, 200000);
+			ModMulBenchmark(rng, RandomOddMpUInt(rng, 256), 20000);
+
+			PowModBenchmark(rng, 32, 100, 1000);
+			PowModBenchmark(rng, 256, 2, 20);
 		}
 	}
 	catch (Exception const& e)
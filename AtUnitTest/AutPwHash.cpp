@@ -0,0 +1,132 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	void OutMetrics(PwHashService& service)
+	{
+		PwHashService::Metrics m = service.GetMetrics();
+		uint64 avgWaitUs = m.m_totalWaitTime.ToMicroseconds() / PickMax<uint64>(m.m_nrDone + m.m_nrExpired, 1);
+		uint64 avgHashUs = m.m_totalHashTime.ToMicroseconds() / PickMax<uint64>(m.m_nrDone, 1);
+
+		Console::Out(Str("Threads: ").UInt(m.m_nrThreads).Add(", queue depth: ").UInt(m.m_queueDepth).Add(", peak: ").UInt(m.m_peakQueueDepth)
+			.Add(", done: ").UInt(m.m_nrDone).Add(", overloaded: ").UInt(m.m_nrOverloaded).Add(", expired: ").UInt(m.m_nrExpired).Add("\r\n")
+			.Add("Wait avg ").UInt(avgWaitUs / 1000).Add(" ms, max ").Obj(m.m_maxWaitTime, TimeFmt::DurationMilliseconds)
+			.Add("; hash avg ").UInt(avgHashUs / 1000).Add(" ms, max ").Obj(m.m_maxHashTime, TimeFmt::DurationMilliseconds).Add("\r\n"));
+	}
+
+
+	void PwHashVerifyTest()
+	{
+		Str hash = PwHash::Generate("correct horse");
+		if (!PwHash::Verify("correct horse", hash))		throw "PwHash::Verify rejected the correct password";
+		if ( PwHash::Verify("wrong horse",   hash))		throw "PwHash::Verify accepted a wrong password";
+		PwHash::DummyVerify("anything");
+
+		Console::Out("PwHash Verify and DummyVerify: OK\r\n");
+	}
+
+
+	void PwHashBatchTest(uint nrThreads, sizet nrJobs)
+	{
+		Str hash = PwHash::Generate("batch");
+
+		Rp<StopCtl> stopCtl { new StopCtl };
+		PwHashService service { nrJobs };
+		service.Start(stopCtl, nrThreads);
+		OnExit stopService = [&] { stopCtl->Stop("Test done"); stopCtl->WaitAll(); };
+
+		Vec<PwHashService::Job> jobs;
+		jobs.ResizeExact(nrJobs);
+		for (sizet i=0; i!=nrJobs; ++i)
+		{
+			PwHashService::Job& job = jobs[i];
+			job.m_pw = If((i % 3) == 0, Seq, "wrong", "batch");
+			job.m_pwHash = hash;
+			job.m_dummy = ((i % 5) == 4);
+		}
+
+		Time t1 = Time::NonStrictNow();
+		service.Process(jobs.Ptr(), jobs.Len(), Time::NonStrictNow() + Time::FromMinutes(5));
+		Time elapsed = Time::NonStrictNow() - t1;
+
+		for (sizet i=0; i!=nrJobs; ++i)
+		{
+			PwHashService::Job const& job = jobs[i];
+			if (job.m_status != PwHashService::Status::Done)		throw "Batch job not done";
+			if (!job.m_dummy && job.m_match != ((i % 3) != 0))		throw "Batch job has unexpected result";
+		}
+
+		Console::Out(Str("Batch of ").UInt(nrJobs).Add(" hashes on ").UInt(nrThreads).Add(" threads in ").Obj(elapsed, TimeFmt::DurationMilliseconds).Add("\r\n"));
+		OutMetrics(service);
+	}
+
+
+	void PwHashAdmissionTest()
+	{
+		enum { MaxQueueDepth = 4 };
+		Rp<StopCtl> stopCtl { new StopCtl };
+		PwHashService service { MaxQueueDepth };
+		service.Start(stopCtl, 1);
+		OnExit stopService = [&] { stopCtl->Stop("Test done"); stopCtl->WaitAll(); };
+
+		// A batch larger than the queue is rejected as a whole, without computing
+		PwHashService::Job jobs[MaxQueueDepth + 1];
+		service.Process(jobs, MaxQueueDepth + 1, Time::Max());
+		for (PwHashService::Job const& job : jobs)
+			if (job.m_status != PwHashService::Status::Overloaded)	throw "Oversized batch was not rejected";
+
+		// Jobs whose deadline has passed before they start are expired, without computing
+		PwHashService::Job job;
+		job.m_dummy = true;
+		service.Process(job, Time::NonStrictNow() - Time::FromSeconds(1));
+		if (job.m_status != PwHashService::Status::Expired)			throw "Job past deadline did not expire";
+
+		Console::Out("PwHashService admission control: OK\r\n");
+		OutMetrics(service);
+	}
+
+
+	void PwHashStopTest()
+	{
+		Rp<StopCtl> stopCtl { new StopCtl };
+		PwHashService service;
+		service.Start(stopCtl, 1);
+		stopCtl->Stop("Test done");
+		stopCtl->WaitAll();
+
+		// After the workers have exited, jobs are computed on the calling thread
+		PwHashService::Job job;
+		job.m_dummy = true;
+		service.Process(job, Time::Max());
+		if (job.m_status != PwHashService::Status::Done)				throw "Job after stop was not computed";
+
+		Console::Out("PwHashService stop: OK\r\n");
+	}
+
+} // anon
+
+
+void PwHashTests(Slice<Seq> args)
+{
+	uint nrThreads = PwHashService::NrPhysicalCores();
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrThreads = arg.ReadNrUInt32Dec();
+	}
+
+	if (!nrThreads)
+	{
+		Console::Err("Usage: AtUnitTest pwhs [<nrThreads>]\r\n");
+		return;
+	}
+
+	PwHashVerifyTest();
+	PwHashAdmissionTest();
+	PwHashStopTest();
+	PwHashBatchTest(1, 8);
+	PwHashBatchTest(nrThreads, 8 * nrThreads);
+}
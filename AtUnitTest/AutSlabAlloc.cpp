@@ -0,0 +1,126 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+#include <random>
+
+
+namespace
+{
+
+	void CorrectnessTests()
+	{
+		Vec<byte*> blocks;
+		Vec<sizet> sizes;
+		for (sizet n=1; n<=3*SlabAlloc::MaxSlabBlockBytes; n+=(n<256 ? 1 : 37))
+		{
+			byte* p = SlabAlloc::Alloc<byte>(n);
+			if (((uintptr_t) p) % 16)
+				throw "SlabAlloc: Block is not aligned to 16 bytes";
+
+			memset(p, (byte) n, n);
+			blocks.Add(p);
+			sizes.Add(n);
+		}
+
+		for (sizet i=0; i!=blocks.Len(); ++i)
+		{
+			for (sizet j=0; j!=sizes[i]; ++j)
+				if (blocks[i][j] != (byte) sizes[i])
+					throw "SlabAlloc: Block content was overwritten";
+
+			SlabAlloc::Free(blocks[i]);
+		}
+
+		// A block in the 112-byte class can grow in place to the size of its class, but not beyond
+		byte* p = SlabAlloc::Alloc<byte>(100);
+		if (!SlabAlloc::ReAllocInPlace<byte>(p, 112) || SlabAlloc::ReAllocInPlace<byte>(p, 113))
+			throw "SlabAlloc: Unexpected ReAllocInPlace result";
+		SlabAlloc::Free(p);
+
+		Console::Out("SlabAlloc correctness: OK\r\n");
+	}
+
+
+	void ArenaTests()
+	{
+		MemArena arena { "Test" };
+		{
+			SlabAlloc::ArenaScope arenaScope { arena };
+			Vec<Str> strs;
+			for (uint i=0; i!=10000; ++i)
+				strs.Add().Add("String number ").UInt(i);
+		}
+
+		MemArena::Stats stats = arena.GetStats();
+		if (stats.m_nrAllocs == 0 || stats.m_nrAllocs != stats.m_nrFrees || stats.m_bytesLive != 0 || stats.m_bytesPeak <= 0)
+			throw "SlabAlloc: Unexpected arena statistics";
+
+		Console::Out(Str("MemArena: ").SInt(stats.m_nrAllocs).Add(" allocations, peak ").SInt(stats.m_bytesPeak).Add(" bytes\r\n"));
+	}
+
+
+	// Each thread allocates blocks, then frees blocks allocated by another thread
+	template <class Alloc>
+	uint64 CrossThreadRun(uint nrThreads, uint nrBlocksPerThread)
+	{
+		Vec<Vec<byte*>> blocks(nrThreads);
+
+		auto runPhase = [&] (std::function<void(uint)> phase)
+			{
+				std::vector<std::thread> threads;
+				for (uint t=0; t!=nrThreads; ++t)
+					threads.emplace_back(phase, t);
+
+				for (std::thread& th : threads)
+					th.join();
+			};
+
+		LONG64 startTicks = Ticks();
+
+		runPhase( [&] (uint t)
+			{
+				std::mt19937 threadMt { t };
+				blocks[t].ReserveExact(nrBlocksPerThread);
+				for (uint i=0; i!=nrBlocksPerThread; ++i)
+				{
+					sizet n = 1 + (threadMt() % 400);
+					byte* p = Alloc::template Alloc<byte>(n);
+					p[0] = p[n-1] = (byte) t;
+					blocks[t].Add(p);
+				}
+			} );
+
+		runPhase( [&] (uint t)
+			{
+				for (byte* p : blocks[(t + 1) % nrThreads])
+					Alloc::Free(p);
+			} );
+
+		return (uint64) (Ticks() - startTicks);
+	}
+
+
+	void Benchmark()
+	{
+		uint const nrThreads = PickMax<uint>(std::thread::hardware_concurrency(), 1);
+		uint const nrBlocksPerThread = 500000;
+
+		uint64 memTicks  = CrossThreadRun<Mem>       (nrThreads, nrBlocksPerThread);
+		uint64 slabTicks = CrossThreadRun<SlabAlloc> (nrThreads, nrBlocksPerThread);
+
+		uint64 const nrOps = 2 * ((uint64) nrThreads) * nrBlocksPerThread;
+		auto opsPerSec = [&] (uint64 ticks) -> uint64 { return (uint64) ((((double) nrOps) * TicksPerSec()) / PickMax<uint64>(ticks, 1)); };
+
+		Console::Out(Str("Allocations and cross-thread frees, ").UInt(nrThreads).Add(" threads: Mem ").UInt(opsPerSec(memTicks))
+			.Add(" ops/s, SlabAlloc ").UInt(opsPerSec(slabTicks)).Add(" ops/s\r\n"));
+	}
+
+} // anon
+
+
+void SlabAllocTests()
+{
+	CorrectnessTests();
+	ArenaTests();
+	Benchmark();
+}
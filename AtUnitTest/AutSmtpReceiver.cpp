@@ -153,3 +153,151 @@ void SmtpReceiverTest()
 					.Add(e.what()).Add("\r\n"));
 	}
 }
+
+
+
+// SmtpEvDrivenTest
+
+// A receiver in event-driven mode, listening on a loopback port. Each session is parked after the greeting, and again after
+// each batch of commands, so every command the test sends is read by a session resumed from the reactor
+
+class AutEventDrivenReceiver : public SmtpReceiver
+{
+public:
+	enum { Port = 52525 };
+
+	void WorkPool_LogEvent(WORD eventType, Seq text) override final
+		{ Console::Out(Str(LogEventType::Desc(eventType)).Add(": ").Add(text).SetEndExact("\r\n")); }
+
+	void SmtpReceiver_GetCfg(SmtpReceiverCfg& cfg) const override final
+	{
+		static Str s_token = Token::Generate();
+
+		EmailSrvBinding& b = cfg.f_bindings.Clear().Add();
+		b.f_token = s_token;
+		b.f_intf = "127.0.0.1";
+		b.f_port = Port;
+
+		cfg.f_computerName = "127.0.0.1";
+		cfg.f_maxInMsgKb = 1000;
+	}
+
+	SmtpReceiveInstruction SmtpReceiver_OnMailFrom_NoAuth(SockAddr const&, Schannel&, Seq, EhloHost const&, Seq, Rp<SmtpReceiverAuthCx>&) override final
+		{ return SmtpReceiveInstruction::Refuse(550, "Not accepting mail"); }
+};
+
+
+namespace
+{
+
+	void ConnectClient(Socket& sk)
+	{
+		SockAddr sa;
+		sa.Parse("127.0.0.1").SetPort(AutEventDrivenReceiver::Port);
+
+		// The receiver binds its listening socket after it starts
+		for (uint attempt=0; ; ++attempt)
+		{
+			sk.Create(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			if (connect(sk.GetSocket(), &sa.m_sa.sa, sa.m_saLen) == 0)
+				break;
+
+			sk.Close();
+			if (attempt == 50)
+				throw "Could not connect to event-driven receiver";
+
+			Sleep(100);
+		}
+
+		sk.SetRecvTimeout(10);
+	}
+
+
+	void SendLines(Socket& sk, Seq lines)
+	{
+		if (send(sk.GetSocket(), (char const*) lines.p, NumCast<int>(lines.n), 0) != (int) lines.n)
+			throw "Error sending to event-driven receiver";
+	}
+
+
+	// Returns the reply codes of nrReplies complete replies. A reply that does not arrive within the receive timeout means
+	// the session was not resumed
+	Str ReadReplies(Socket& sk, uint nrReplies)
+	{
+		Str received, codes;
+		while (true)
+		{
+			Seq reader = received;
+			uint nrComplete {};
+			codes.Clear();
+			while (true)
+			{
+				Seq line = reader.ReadToString("\r\n");
+				if (!reader.StripPrefixExact("\r\n"))
+					break;
+
+				if (line.n >= 4 && line.p[3] == ' ')
+				{
+					codes.IfAny(" ").Add(Seq(line.p, 3));
+					++nrComplete;
+				}
+			}
+
+			if (nrComplete >= nrReplies)
+				return codes;
+
+			char buf[1000];
+			int n = recv(sk.GetSocket(), buf, sizeof(buf), 0);
+			if (n <= 0)
+				throw "Event-driven receiver did not reply";
+
+			received.Add(Seq(buf, (sizet) n));
+		}
+	}
+
+} // anon
+
+
+void SmtpEvDrivenTest()
+{
+	enum { NrClients = 20 };
+
+	SockInit sockInit;
+	Crypt::Initializer cryptInit;
+
+	Rp<StopCtl> stopCtl { new StopCtl };
+	ThreadPtr<AutEventDrivenReceiver> receiver { Thread::Create };
+	receiver->SetEventDriven(1);
+	receiver->Start(stopCtl);
+
+	OnExit stopReceiver = [&] { stopCtl->Stop("Test completed"); stopCtl->WaitAll(); };
+
+	// Idle connections do not hold work pool threads
+	Vec<Socket> clients(NrClients);
+	for (Socket& sk : clients)
+	{
+		ConnectClient(sk);
+		if (!Seq(ReadReplies(sk, 1)).EqualExact("220"))
+			throw "Unexpected greeting";
+	}
+
+	// Let the sessions park before sending the next command
+	Sleep(200);
+	for (Socket& sk : clients)
+		SendLines(sk, "EHLO client\r\n");
+
+	for (Socket& sk : clients)
+		if (!Seq(ReadReplies(sk, 1)).EqualExact("250"))
+			throw "Unexpected reply to EHLO";
+
+	// Pipelined commands: the first is read after resuming, the others from the buffer
+	Sleep(200);
+	for (Socket& sk : clients)
+		SendLines(sk, "HELO client\r\nRSET\r\nQUIT\r\n");
+
+	for (Socket& sk : clients)
+		if (!Seq(ReadReplies(sk, 3)).EqualExact("250 250 221"))
+			throw "Unexpected replies to pipelined commands";
+
+	Console::Out(Str("SmtpReceiver event-driven: ").UInt(NrClients).Add(" sessions parked and resumed: OK\r\n"));
+}
@@ -0,0 +1,247 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	void PriorityAndBacklogTest()
+	{
+		Event stopEvent { Event::CreateManual };
+		int tasks[4] {};
+
+		{
+			TaskScheduler scheduler;
+			scheduler.Init(1, 10, BacklogPolicy::Reject);
+			uint worker = scheduler.AttachWorker();
+
+			scheduler.Enqueue(&tasks[0], TaskPriority::Low,    stopEvent.Handle());
+			scheduler.Enqueue(&tasks[1], TaskPriority::Normal, stopEvent.Handle());
+			scheduler.Enqueue(&tasks[2], TaskPriority::High,   stopEvent.Handle(), worker);
+
+			if (scheduler.TryDequeue(worker) != &tasks[2]) throw "TaskScheduler did not dequeue high priority task first";
+			if (scheduler.TryDequeue(worker) != &tasks[1]) throw "TaskScheduler did not dequeue normal priority task second";
+			if (scheduler.TryDequeue(worker) != &tasks[0]) throw "TaskScheduler did not dequeue low priority task last";
+			if (scheduler.TryDequeue(worker) != nullptr)   throw "TaskScheduler dequeued a task from empty queues";
+
+			scheduler.DetachWorker(worker);
+		}
+
+		{
+			TaskScheduler scheduler;
+			scheduler.Init(2, 2, BacklogPolicy::Reject);
+			if (!scheduler.Enqueue(&tasks[0], TaskPriority::Normal, stopEvent.Handle())) throw "TaskScheduler rejected a task below backlog limit";
+			if (!scheduler.Enqueue(&tasks[1], TaskPriority::Normal, stopEvent.Handle())) throw "TaskScheduler rejected a task at backlog limit";
+			if ( scheduler.Enqueue(&tasks[2], TaskPriority::Normal, stopEvent.Handle())) throw "TaskScheduler accepted a task over backlog limit";
+
+			// Tasks enqueued with no worker attached, and tasks left by a worker that detaches, are taken by another worker
+			uint w1 = scheduler.AttachWorker();
+			if (!scheduler.TryDequeue(w1)) throw "TaskScheduler did not dequeue a task from the shared queue";
+			if (!scheduler.Enqueue(&tasks[3], TaskPriority::Normal, stopEvent.Handle(), w1)) throw "TaskScheduler rejected a task after room was made";
+			scheduler.DetachWorker(w1);
+
+			uint w2 = scheduler.AttachWorker();
+			sizet nrTaken {};
+			while (scheduler.TryDequeue(w2))
+				++nrTaken;
+			if (nrTaken != 2) throw "TaskScheduler lost tasks of a detached worker";
+			scheduler.DetachWorker(w2);
+		}
+
+		Console::Out("TaskScheduler priorities and backlog: OK\r\n");
+	}
+
+
+
+	// Baseline for comparison: a single queue under a mutex, as WorkPool used to have
+
+	class LockedQueue
+	{
+	public:
+		LockedQueue() { m_sem = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr); }
+		~LockedQueue() { CloseHandle(m_sem); }
+
+		void Enqueue(void* task)
+		{
+			{
+				Locker locker { m_mx };
+				m_tasks.push_back(task);
+			}
+
+			ReleaseSemaphore(m_sem, 1, nullptr);
+		}
+
+		void* Dequeue(HANDLE stopEvent)
+		{
+			if (Wait2(stopEvent, m_sem, INFINITE) == 0)
+				return nullptr;
+
+			Locker locker { m_mx };
+			void* task = m_tasks.front();
+			m_tasks.pop_front();
+			return task;
+		}
+
+	private:
+		Mutex             m_mx;
+		std::deque<void*> m_tasks;
+		HANDLE            m_sem {};
+	};
+
+
+	struct BenchTask
+	{
+		LONG64 m_enqueuedTicks {};
+		LONG64 m_latencyTicks  {};
+	};
+
+
+	// Simulates a small amount of work per task
+	void ProcessTask(BenchTask& task, uint spin)
+	{
+		task.m_latencyTicks = Ticks() - task.m_enqueuedTicks;
+		for (uint volatile i=0; i!=spin; ++i) {}
+	}
+
+
+	void OutResults(char const* desc, Vec<BenchTask>& tasks, LONG64 elapsedTicks)
+	{
+		LONG64 const ticksPerSec = TicksPerSec();
+		LONG64 const ticksPerUs = PickMax<LONG64>(ticksPerSec / 1000000, 1);
+
+		Vec<LONG64> latencies;
+		latencies.ReserveExact(tasks.Len());
+		for (BenchTask const& task : tasks)
+			latencies.Add(task.m_latencyTicks);
+		std::sort(latencies.begin(), latencies.end());
+
+		uint64 const tasksPerSec = (uint64) ((((double) tasks.Len()) * ticksPerSec) / PickMax<LONG64>(elapsedTicks, 1));
+		Console::Out(Str("  ").Add(desc).Add(": ").UInt(tasksPerSec).Add(" tasks per second, latency median ")
+			.UInt((uint64) (latencies[latencies.Len() / 2] / ticksPerUs)).Add(" us, 99th percentile ")
+			.UInt((uint64) (latencies[(latencies.Len() * 99) / 100] / ticksPerUs)).Add(" us\r\n"));
+	}
+
+
+	void SchedulerBenchmark(uint nrWorkers, uint nrProducers, Vec<BenchTask>& tasks, uint spin)
+	{
+		TaskScheduler scheduler;
+		scheduler.Init(nrWorkers, SIZE_MAX, BacklogPolicy::Block);
+		Event stopEvent { Event::CreateManual };
+		LONG64 volatile nrDone {};
+		LONG64 const nrTasks = (LONG64) tasks.Len();
+
+		std::vector<std::thread> threads;
+		for (uint w=0; w!=nrWorkers; ++w)
+			threads.emplace_back( [&] ()
+				{
+					uint worker = scheduler.AttachWorker();
+					while (true)
+					{
+						void* task = scheduler.TryDequeue(worker);
+						if (task)
+						{
+							ProcessTask(*(BenchTask*) task, spin);
+							if (InterlockedIncrement64(&nrDone) == nrTasks)
+								stopEvent.Signal();
+						}
+						else if (scheduler.WaitForTask(stopEvent.Handle(), INFINITE) == 0)
+							break;
+					}
+					scheduler.DetachWorker(worker);
+				} );
+
+		LONG64 startTicks = Ticks();
+		for (uint p=0; p!=nrProducers; ++p)
+			threads.emplace_back( [&, p] ()
+				{
+					for (sizet i=p; i<tasks.Len(); i+=nrProducers)
+					{
+						tasks[i].m_enqueuedTicks = Ticks();
+						scheduler.Enqueue(&tasks[i], TaskPriority::Normal, stopEvent.Handle());
+					}
+				} );
+
+		for (std::thread& th : threads)
+			th.join();
+
+		OutResults("Work stealing scheduler", tasks, Ticks() - startTicks);
+		Console::Out(Str("    Stolen: ").UInt(scheduler.NrStolen()).Add("\r\n"));
+	}
+
+
+	void LockedQueueBenchmark(uint nrWorkers, uint nrProducers, Vec<BenchTask>& tasks, uint spin)
+	{
+		LockedQueue queue;
+		Event stopEvent { Event::CreateManual };
+		LONG64 volatile nrDone {};
+		LONG64 const nrTasks = (LONG64) tasks.Len();
+
+		std::vector<std::thread> threads;
+		for (uint w=0; w!=nrWorkers; ++w)
+			threads.emplace_back( [&] ()
+				{
+					while (true)
+					{
+						void* task = queue.Dequeue(stopEvent.Handle());
+						if (!task)
+							break;
+
+						ProcessTask(*(BenchTask*) task, spin);
+						if (InterlockedIncrement64(&nrDone) == nrTasks)
+							stopEvent.Signal();
+					}
+				} );
+
+		LONG64 startTicks = Ticks();
+		for (uint p=0; p!=nrProducers; ++p)
+			threads.emplace_back( [&, p] ()
+				{
+					for (sizet i=p; i<tasks.Len(); i+=nrProducers)
+					{
+						tasks[i].m_enqueuedTicks = Ticks();
+						queue.Enqueue(&tasks[i]);
+					}
+				} );
+
+		for (std::thread& th : threads)
+			th.join();
+
+		OutResults("Single locked queue", tasks, Ticks() - startTicks);
+	}
+
+} // anon
+
+
+void TaskSchedulerTests(Slice<Seq> args)
+{
+	uint nrWorkers = PickMax<uint>(std::thread::hardware_concurrency(), 2);
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrWorkers = arg.ReadNrUInt32Dec();
+	}
+
+	if (!nrWorkers)
+	{
+		Console::Err("Usage: AtUnitTest tsch [<nrWorkers>]\r\n");
+		return;
+	}
+
+	PriorityAndBacklogTest();
+
+	enum { NrTasks = 1000000 };
+	Vec<BenchTask> tasks;
+	tasks.ResizeExact(NrTasks);
+
+	uint const nrProducersList[] = { 1, 4 };
+	uint const spinList[] = { 0, 1000 };
+	for (uint nrProducers : nrProducersList)
+		for (uint spin : spinList)
+		{
+			Console::Out(Str().UInt(nrWorkers).Add(" workers, ").UInt(nrProducers).Add(" producers, ").UInt(NrTasks)
+				.Add(" tasks, ").UInt(spin).Add(" spins per task\r\n"));
+
+			SchedulerBenchmark(nrWorkers, nrProducers, tasks, spin);
+			LockedQueueBenchmark(nrWorkers, nrProducers, tasks, spin);
+		}
+}
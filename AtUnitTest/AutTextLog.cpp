@@ -0,0 +1,135 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+namespace
+{
+
+	class TestLog : public TextLog
+	{
+	public:
+		void Write(Seq entry) { TzInfo tzi; WriteEntry(Time::StrictNow(), tzi, entry); }
+	};
+
+
+	Str MakeEntry(uint threadNr, uint entryNr)
+	{
+		Str entry;
+		entry.ReserveExact(100).Add("<entry thread=\"").UInt(threadNr, 10, 3).Add("\" nr=\"").UInt(entryNr, 10, 6).Add("\" />\r\n");
+		return entry;
+	}
+
+
+	void OutStats(TextLog::AsyncStats const& s)
+	{
+		Console::Out(Str("Entries: ").UInt(s.m_nrEntries).Add(", writes: ").UInt(s.m_nrWrites).Add(", bytes: ").UInt(s.m_nrBytes)
+			.Add(", dropped: ").UInt(s.m_nrDropped).Add(", blocked: ").UInt(s.m_nrBlocked).Add(", write errors: ").UInt(s.m_nrWriteErrors).Add("\r\n"));
+	}
+
+
+	void TextLogWriteTest(uint flags, TextLog::AsyncParams const& asyncParams, uint nrThreads, uint nrEntriesPerThread)
+	{
+		TestLog log;
+		log.Init("AutTextLog", flags, asyncParams);
+
+		uint64 nrBytes {};
+		for (uint i=0; i!=nrEntriesPerThread; ++i)
+			nrBytes += MakeEntry(0, i).Len();
+		nrBytes *= nrThreads;
+
+		std::vector<std::thread> threads;
+		threads.reserve(nrThreads);
+
+		Time t1 = Time::NonStrictNow();
+		for (uint t=0; t!=nrThreads; ++t)
+			threads.emplace_back( [&log, t, nrEntriesPerThread] ()
+				{
+					for (uint i=0; i!=nrEntriesPerThread; ++i)
+						log.Write(MakeEntry(t, i));
+				} );
+
+		for (std::thread& th : threads)
+			th.join();
+
+		Time queued = Time::NonStrictNow() - t1;
+		log.Flush();
+		Time written = Time::NonStrictNow() - t1;
+
+		Console::Out(Str(If(0 != (flags & TextLog::Flags::Async), Seq, "Async", "Sync"))
+			.Add(": ").UInt(nrThreads).Add(" threads x ").UInt(nrEntriesPerThread).Add(" entries, queued in ").Obj(queued, TimeFmt::DurationMilliseconds)
+			.Add(", written in ").Obj(written, TimeFmt::DurationMilliseconds).Add("\r\n"));
+
+		if (0 != (flags & TextLog::Flags::Async))
+		{
+			TextLog::AsyncStats s = log.GetAsyncStats();
+			OutStats(s);
+
+			uint64 const nrEntries = ((uint64) nrThreads) * nrEntriesPerThread;
+			if (s.m_nrWriteErrors)										throw "Async TextLog reported write errors";
+			if (s.m_nrEntries + s.m_nrDropped != nrEntries)				throw "Async TextLog lost entries";
+			if (!s.m_nrDropped && s.m_nrBytes != nrBytes)				throw "Async TextLog wrote unexpected number of bytes";
+			if (asyncParams.m_overflow == TextLog::AsyncParams::Overflow::Block && s.m_nrDropped)
+																		throw "Async TextLog dropped entries with the Block policy";
+		}
+	}
+
+
+	void TextLogShutdownTest()
+	{
+		// Entries queued before destruction are written by the destructor
+		Str logPath;
+		uint64 nrBytes {};
+		{
+			TestLog log;
+			log.Init("AutTextLog", TextLog::Flags::CreateUnique | TextLog::Flags::Async);
+			logPath = log.CurLogPath();
+
+			for (uint i=0; i!=1000; ++i)
+			{
+				Str entry = MakeEntry(0, i);
+				nrBytes += entry.Len();
+				log.Write(entry);
+			}
+		}
+
+		if (File().Open(logPath, File::OpenArgs::DefaultRead()).GetSize() != nrBytes)
+			throw "Async TextLog did not write queued entries on destruction";
+
+		Console::Out("Async TextLog flush on shutdown: OK\r\n");
+	}
+
+} // anon
+
+
+void TextLogTests(Slice<Seq> args)
+{
+	uint nrThreads = 8;
+	uint nrEntriesPerThread = 10000;
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrThreads = arg.ReadNrUInt32Dec();
+	}
+
+	if (!nrThreads)
+	{
+		Console::Err("Usage: AtUnitTest tlog [<nrThreads>]\r\n");
+		return;
+	}
+
+	TextLog::AsyncParams blockParams;
+
+	TextLog::AsyncParams dropParams;
+	dropParams.m_maxEntries = 64;
+	dropParams.m_overflow = TextLog::AsyncParams::Overflow::Drop;
+
+	TextLog::AsyncParams smallParams;
+	smallParams.m_maxEntries = 64;
+	smallParams.m_maxWriteBytes = 4096;
+
+	TextLogWriteTest(TextLog::Flags::AutoRollover,                         blockParams, nrThreads, nrEntriesPerThread / 10);
+	TextLogWriteTest(TextLog::Flags::AutoRollover | TextLog::Flags::Async, blockParams, nrThreads, nrEntriesPerThread);
+	TextLogWriteTest(TextLog::Flags::AutoRollover | TextLog::Flags::Async, smallParams, nrThreads, nrEntriesPerThread);
+	TextLogWriteTest(TextLog::Flags::AutoRollover | TextLog::Flags::Async, dropParams,  nrThreads, nrEntriesPerThread);
+	TextLogShutdownTest();
+}
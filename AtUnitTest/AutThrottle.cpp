@@ -0,0 +1,200 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+#include <random>
+
+
+namespace
+{
+
+	enum { MaxHoldsBySingleIp = 8, MaxHoldsGlobal = 1024 };
+
+	void InitThrottle(IpFairThrottle& throttle)
+	{
+		throttle.SetMaxHoldsBySingleIp(MaxHoldsBySingleIp);
+		throttle.SetMaxHoldsGlobal(MaxHoldsGlobal);
+	}
+
+
+	sizet AcquireAll(IpFairThrottle& throttle, SockAddr const& sa, Time durationUntilExpire, Vec<IpFairThrottle::HoldLocator>& hls)
+	{
+		sizet nrAcquired {};
+		while (true)
+		{
+			IpFairThrottle::HoldLocator hl;
+			if (!throttle.TryAcquireHold(sa, durationUntilExpire, hl))
+				return nrAcquired;
+
+			hls.Add(hl);
+			if (++nrAcquired > MaxHoldsGlobal)
+				throw "IpFairThrottle did not limit holds by a single IP";
+		}
+	}
+
+
+	void IpFairThrottleTest()
+	{
+		IpFairThrottle throttle;
+		InitThrottle(throttle);
+
+		SockAddr sa4, sa6;
+		sa4.Parse("192.0.2.1");
+		sa6.Parse("2001:db8::1");
+
+		// A single IP gets exactly the holds of one bucket in each of the 4 levels
+		SockAddr const* addrs[] = { &sa4, &sa6 };
+		for (SockAddr const* sa : addrs)
+		{
+			Vec<IpFairThrottle::HoldLocator> hls;
+			if (AcquireAll(throttle, *sa, Time::Max(), hls) != MaxHoldsBySingleIp)
+				throw "Unexpected number of holds for a single IP address";
+
+			for (IpFairThrottle::HoldLocator const& hl : hls)
+				if (!throttle.ReleaseHold(hl))
+					throw "IpFairThrottle did not find a hold to release";
+
+			for (IpFairThrottle::HoldLocator const& hl : hls)
+				if (throttle.ReleaseHold(hl))
+					throw "IpFairThrottle released a hold twice";
+		}
+
+		// Expired holds are cleared when a bucket is full, and can no longer be released
+		Vec<IpFairThrottle::HoldLocator> hls;
+		if (AcquireAll(throttle, sa4, Time::FromMilliseconds(200), hls) != MaxHoldsBySingleIp)
+			throw "Unexpected number of expiring holds";
+
+		Sleep(300);
+		IpFairThrottle::HoldLocator hl;
+		if (!throttle.TryAcquireHold(sa4, hl))
+			throw "IpFairThrottle did not clear expired holds";
+
+		sizet nrReleased {};
+		for (IpFairThrottle::HoldLocator const& x : hls)
+			if (throttle.ReleaseHold(x))
+				++nrReleased;
+
+		if (nrReleased >= MaxHoldsBySingleIp)	throw "IpFairThrottle released expired holds after clearing them";
+		if (!throttle.ReleaseHold(hl))			throw "IpFairThrottle did not release hold acquired after clearing expired holds";
+
+		Console::Out("IpFairThrottle: OK\r\n");
+	}
+
+
+	void LoginThrottleTest()
+	{
+		LoginThrottle throttle;
+
+		if (throttle.HaveRecentFailure("user", "192.0.2.1"))			throw "LoginThrottle reported a failure before any were added";
+
+		throttle.AddLoginFailure("User", "192.0.2.1");
+		if (!throttle.HaveRecentFailure("uSER", "192.0.2.2"))			throw "LoginThrottle did not match user name case-insensitively";
+		if (!throttle.HaveRecentFailure("other", "192.0.2.1"))			throw "LoginThrottle did not match address";
+		if ( throttle.HaveRecentFailure("other", "192.0.2.2"))			throw "LoginThrottle matched unrelated user name and address";
+		if ( throttle.HaveRecentFailure("192.0.2.1", "User"))			throw "LoginThrottle matched user name against address";
+
+		Sleep((LoginThrottle::ThrottleSeconds * 1000) + 100);
+		if (throttle.HaveRecentFailure("user", "192.0.2.1"))			throw "LoginThrottle reported an expired failure";
+
+		Console::Out("LoginThrottle: OK\r\n");
+	}
+
+
+	// Simulates a burst of connections, each of which acquires a hold, checks for login failures, and releases its hold.
+	// Most connections come from a large population of addresses; one in four comes from a single attacking subnet.
+	void AcceptStormBenchmark(uint nrThreads, uint nrConnectionsPerThread)
+	{
+		IpFairThrottle ipThrottle;
+		InitThrottle(ipThrottle);
+		LoginThrottle loginThrottle;
+
+		enum { NrAddrs = 65536 };
+		Vec<SockAddr> addrs;
+		Vec<Str> addrStrs;
+		addrs.ReserveExact(NrAddrs);
+		addrStrs.ReserveExact(NrAddrs);
+
+		std::mt19937 mt;
+		for (sizet i=0; i!=NrAddrs; ++i)
+		{
+			uint32 ip4Nr = If((i % 4) == 0, uint32, 0xC6336400U | (mt() & 0xFF), mt());
+			addrs.Add().SetIp4(ip4Nr, 0);
+			addrStrs.Add().Obj(addrs.Last(), SockAddr::AddrOnly);
+		}
+
+		LONG64 volatile nrAccepted {};
+		LONG64 volatile nrRejected {};
+		LONG64 volatile nrThrottled {};
+
+		Time startTime = Time::NonStrictNow();
+
+		std::vector<std::thread> threads;
+		for (uint t=0; t!=nrThreads; ++t)
+			threads.emplace_back( [&, t] ()
+				{
+					std::mt19937 threadMt { t };
+					Str userName;
+					for (uint i=0; i!=nrConnectionsPerThread; ++i)
+					{
+						sizet addrIndex = threadMt() % NrAddrs;
+
+						IpFairThrottle::HoldLocator hl;
+						if (!ipThrottle.TryAcquireHold(addrs[addrIndex], hl))
+						{
+							InterlockedIncrement64(&nrRejected);
+							continue;
+						}
+
+						InterlockedIncrement64(&nrAccepted);
+
+						userName.Clear().Add("user").UInt(threadMt() % 1000);
+						if (loginThrottle.HaveRecentFailure(userName, addrStrs[addrIndex]))
+							InterlockedIncrement64(&nrThrottled);
+						else if ((threadMt() % 8) == 0)
+							loginThrottle.AddLoginFailure(userName, addrStrs[addrIndex]);
+
+						EnsureThrow(ipThrottle.ReleaseHold(hl));
+					}
+				} );
+
+		for (std::thread& th : threads)
+			th.join();
+
+		Time elapsed = Time::NonStrictNow() - startTime;
+		uint64 const nrConnections = ((uint64) nrThreads) * nrConnectionsPerThread;
+		uint64 const ms = PickMax<uint64>(elapsed.ToMilliseconds(), 1);
+
+		Console::Out(Str("Accept storm: ").UInt(nrThreads).Add(" threads x ").UInt(nrConnectionsPerThread).Add(" connections in ")
+			.Obj(elapsed, TimeFmt::DurationMilliseconds).Add(", ").UInt((1000 * nrConnections) / ms).Add(" connections per second\r\n")
+			.Add("Accepted: ").UInt((uint64) nrAccepted).Add(", rejected: ").UInt((uint64) nrRejected)
+			.Add(", throttled logins: ").UInt((uint64) nrThrottled).Add("\r\n"));
+
+		// All holds were released, so a single IP again gets all of its holds
+		Vec<IpFairThrottle::HoldLocator> hls;
+		if (AcquireAll(ipThrottle, addrs[0], Time::Max(), hls) != MaxHoldsBySingleIp)
+			throw "IpFairThrottle holds were lost or leaked during accept storm";
+	}
+
+} // anon
+
+
+void ThrottleTests(Slice<Seq> args)
+{
+	uint nrThreads = 2 * PickMax<uint>(std::thread::hardware_concurrency(), 1);
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		nrThreads = arg.ReadNrUInt32Dec();
+	}
+
+	if (!nrThreads)
+	{
+		Console::Err("Usage: AtUnitTest thrt [<nrThreads>]\r\n");
+		return;
+	}
+
+	Crypt::Initializer cryptInit;
+
+	IpFairThrottleTest();
+	LoginThrottleTest();
+	AcceptStormBenchmark(nrThreads, 200000);
+}
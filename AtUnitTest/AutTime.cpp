@@ -0,0 +1,132 @@
+#include "AutIncludes.h"
+#include "AutMain.h"
+
+
+void StrictNowContentionTest(sizet nrThreads, sizet nrCallsPerThread)
+{
+	Vec<Vec<uint64>> results;
+	results.ResizeExact(nrThreads);
+	for (Vec<uint64>& r : results)
+		r.ResizeExact(nrCallsPerThread);
+
+	std::vector<std::thread> threads;
+	threads.reserve(nrThreads);
+
+	Time timeBefore = Time::NonStrictNow();
+
+	for (sizet t=0; t!=nrThreads; ++t)
+	{
+		uint64* p = results[t].Ptr();
+		threads.emplace_back( [p, nrCallsPerThread] ()
+			{
+				for (sizet i=0; i!=nrCallsPerThread; ++i)
+					p[i] = Time::StrictNow().ToFt();
+			} );
+	}
+
+	for (std::thread& th : threads)
+		th.join();
+
+	Time elapsed = Time::NonStrictNow() - timeBefore;
+
+	Vec<uint64> all;
+	all.ReserveExact(nrThreads * nrCallsPerThread);
+	for (Vec<uint64> const& r : results)
+	{
+		for (sizet i=1; i<r.Len(); ++i)
+			if (r[i] <= r[i-1])
+				throw "StrictNow: values returned to a single thread are not strictly increasing";
+
+		for (uint64 v : r)
+			all.Add(v);
+	}
+
+	std::sort(all.begin(), all.end());
+	for (sizet i=1; i<all.Len(); ++i)
+		if (all[i] == all[i-1])
+			throw "StrictNow: duplicate value returned";
+
+	uint64 totalCalls = nrThreads * nrCallsPerThread;
+	uint64 elapsedUs = PickMax<uint64>(elapsed.ToMicroseconds(), 1);
+	Console::Out(Str("StrictNow, ").UInt(nrThreads).Add(" threads: ").UInt(totalCalls).Add(" unique values in ")
+		.Obj(elapsed, TimeFmt::DurationMilliseconds).Add(", ").UInt((totalCalls * 1000000ULL) / elapsedUs).Add(" calls/sec\r\n"));
+}
+
+
+void TimeSourceCostTest(Seq desc, std::function<Time()> now, sizet nrCalls)
+{
+	uint64 sink {};
+	Time timeBefore = Time::NonStrictNow();
+	for (sizet i=0; i!=nrCalls; ++i)
+		sink += now().ToFt();
+	Time elapsed = Time::NonStrictNow() - timeBefore;
+
+	uint64 elapsedUs = PickMax<uint64>(elapsed.ToMicroseconds(), 1);
+	Console::Out(Str::Join(desc, ": ").UInt(nrCalls).Add(" calls in ").Obj(elapsed, TimeFmt::DurationMilliseconds)
+		.Add(", ").UInt((nrCalls * 1000000ULL) / elapsedUs).Add(" calls/sec")
+		.Add(" (checksum ").UInt(sink & 0xFF).Add(")\r\n"));
+}
+
+
+void FastNowTest()
+{
+	Console::Out(Str("FastNow uses TSC: ").Add(Time::FastNowUsesTsc() ? "yes" : "no").Add("\r\n"));
+
+	// FastNow is an approximation: TSCs of different cores may be slightly out of sync, and the thread may move between cores.
+	// Readings are therefore compared with a tolerance, rather than exactly
+	int64 const toleranceUs = 1000;
+	int64 const maxDriftUs = 1000000;
+
+	for (uint i=0; i!=5; ++i)
+	{
+		if (i)
+			Sleep(200);
+
+		Time fast = Time::FastNow();
+		Time precise = Time::NonStrictNow();
+		int64 diffUs = (((int64) fast.ToFt()) - ((int64) precise.ToFt())) / 10;
+		Console::Out(Str("FastNow - NonStrictNow: ").SInt(diffUs).Add(" us\r\n"));
+
+		if (diffUs > maxDriftUs || diffUs < -maxDriftUs)
+			throw "FastNow: value differs too much from NonStrictNow";
+	}
+
+	Time prev = Time::FastNow();
+	for (uint i=0; i!=1000000; ++i)
+	{
+		Time t = Time::FastNow();
+		if ((((int64) prev.ToFt()) - ((int64) t.ToFt())) / 10 > toleranceUs)
+			throw "FastNow: value decreased within a single thread";
+		if (t > prev)
+			prev = t;
+	}
+
+	enum { NrCalls = 10000000 };
+	TimeSourceCostTest("NonStrictNow", [] { return Time::NonStrictNow(); }, NrCalls);
+	TimeSourceCostTest("StrictNow   ", [] { return Time::StrictNow();    }, NrCalls);
+	TimeSourceCostTest("FastNow     ", [] { return Time::FastNow();      }, NrCalls);
+}
+
+
+void TimeTests(Slice<Seq> args)
+{
+	sizet maxThreads = PickMax<sizet>(std::thread::hardware_concurrency(), 1);
+	if (args.Len() > 2)
+	{
+		Seq arg = args[2];
+		maxThreads = arg.ReadNrUInt32Dec();
+	}
+
+	if (!maxThreads)
+	{
+		Console::Err("Usage: AtUnitTest time [<maxThreads>]\r\n");
+		return;
+	}
+
+	FastNowTest();
+
+	enum { NrCallsPerThread = 1000000 };
+	for (sizet nrThreads=1; nrThreads<maxThreads; nrThreads*=2)
+		StrictNowContentionTest(nrThreads, NrCallsPerThread);
+	StrictNowContentionTest(maxThreads, NrCallsPerThread);
+}
@@ -81,4 +81,17 @@ void UriTests()
 	ParseTree::Storage storage;
 	Vec<Seq> foundUris;
 	FindAndCheckUris(c_text, c_prefixes, &storage, foundUris, expectUris, Display::Yes);
+
+	// Without explicit storage, trees use the per-thread storage. After the first pass, buckets are reused rather than allocated
+	FindAndCheckUris(c_text, c_prefixes, nullptr, foundUris, expectUris, Display::No);
+	ParseTree::ThreadStats before = ParseTree::GetThreadStats();
+	FindAndCheckUris(c_text, c_prefixes, nullptr, foundUris, expectUris, Display::No);
+	ParseTree::ThreadStats const& after = ParseTree::GetThreadStats();
+
+	if (after.m_nrTrees == before.m_nrTrees || after.m_nrBucketsAllocated != before.m_nrBucketsAllocated)
+		throw "ParseTree per-thread storage: buckets were not reused";
+
+	Console::Out(Str("ParseTree per-thread storage: ").UInt(after.m_nrTrees - before.m_nrTrees).Add(" trees, ")
+		.UInt(after.m_nrNodes - before.m_nrNodes).Add(" nodes, ").UInt(after.m_nrBucketsReused - before.m_nrBucketsReused).Add(" buckets reused, ")
+		.UInt(after.m_maxBucketsPerTree).Add(" max buckets per tree\r\n"));
 }
@@ -20,7 +20,7 @@ namespace At
 		EnsureThrow(m_pipeName.Any());
 
 		// Init log
-		m_requestLog.Init(Str(BhtpnServer_LogNamePrefix()).Add("BhtpnLog"), TextLog::Flags::AutoRollover);
+		m_requestLog.Init(Str(BhtpnServer_LogNamePrefix()).Add("BhtpnLog"), TextLog::Flags::AutoRollover | TextLog::Flags::Async);
 
 		// Init pipe name
 		m_sddlStr = 
@@ -86,8 +86,9 @@ namespace At
 				}
 			}
 
-			// Enqueue pipe
-			EnqueueWorkItem(workItem);
+			// Enqueue pipe. If the backlog is full, the work item is freed, which closes the pipe instance
+			if (!EnqueueWorkItem(workItem))
+				workItem.Set(nullptr);
 		}
 	}
 
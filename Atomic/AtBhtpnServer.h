@@ -19,12 +19,17 @@ namespace At
 	class BhtpnServer : public WebServer<BhtpnServerThread, BhtpnServerWorkItem>
 	{
 	public:
+		// Connections accepted while the backlog is full are closed
+		BhtpnServer() { SetMaxBacklog(MaxBacklog, BacklogPolicy::Reject); }
+
 		void GenPipeName();
 		void GrantAccessToProcessOwner(bool v) { m_grantAccessToProcessOwner = v; }
 
 		Seq GetPipeName() const { return m_pipeName; }
 
 	private:
+		enum { MaxBacklog = 1000 };
+
 		bool m_grantAccessToProcessOwner {};
 
 		Str m_sddlStr;
@@ -109,6 +109,9 @@ namespace At
 		}
 
 
+		sizet Size() const { return m_entriesByKey.size(); }
+
+
 		void PruneEntries(sizet targetSize, Time maxAge)
 		{
 			Time now = Time::StrictNow();
@@ -44,9 +44,9 @@ namespace At
 	#define CRC32_SHIFTED(c) (c >> 8)
 
 
-	uint32 Crc32(Seq s)
+	uint32 Crc32(Seq s, uint32 prevCrc)
 	{
-		uint32 crc = UINT32_MAX;
+		uint32 crc = prevCrc ^ UINT32_MAX;
 
 		while (s.n && ((((sizet) s.p) % 4) != 0))
 			crc = c_crc32Table[CRC32_INDEX(crc) ^ s.ReadByte()] ^ CRC32_SHIFTED(crc);
@@ -4,5 +4,6 @@
 
 namespace At
 {
-	uint32 Crc32(Seq s);
+	// To calculate the CRC of data that is available in pieces, pass the result for the preceding pieces as prevCrc
+	uint32 Crc32(Seq s, uint32 prevCrc = 0);
 }
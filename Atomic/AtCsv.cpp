@@ -23,7 +23,7 @@ namespace At
 
 	void CsvReader::SkipLines(sizet nrLines)
 	{	
-		Str discarded;
+		Seq discarded;
 		while (nrLines-- > 0)
 			m_lineReader.ReadLine(discarded);
 	}
@@ -77,6 +77,75 @@ namespace At
 	}
 
 
+	bool CsvReader::ReadRecord(Vec<Seq>& record, sizet& nrFields)
+	{
+		nrFields = 0;
+
+		do
+		{
+			Seq line;
+			if (!m_lineReader.ReadLine(line))
+				return false;
+	
+			Seq remaining { line };
+			while (remaining.n)
+			{
+				if (record.Len() <= nrFields)
+					record.Add();
+
+				Seq& field { record[nrFields] };
+				field = remaining.ReadToFirstByteOf(m_delims);
+				if (remaining.n)
+				{
+					if (remaining.p[0] == m_fieldDelim)
+						remaining.DropByte();
+					else if (m_commentDelim != 0 && remaining.p[0] == m_commentDelim)
+						remaining.DropBytes(remaining.n);
+					else
+					{
+						// Field is quoted. If the closing quote is on the same line, and is not an escaped quote, there is nothing to unescape
+						remaining.DropByte();
+
+						Seq reader { remaining };
+						Seq chunk { reader.ReadToByte('"') };
+						if (reader.n && !reader.DropByte().StartsWithByte('"'))
+						{
+							field = chunk;
+							remaining = reader;
+							SkipAfterQuotedField(remaining);
+						}
+						else
+						{
+							while (m_scratch.Len() <= nrFields)
+								m_scratch.Add();
+
+							Str& scratch { m_scratch[nrFields] };
+							scratch.Clear();
+							while (!ParseField(true, scratch, remaining))
+							{
+								if (!m_lineReader.ReadLine(line))
+									break;
+								remaining = line;
+							}
+
+							field = scratch;
+						}
+					}
+				}
+
+				++nrFields;
+			}
+		}
+		while (nrFields == 0);
+
+		// Clear any columns not present in this record	
+		for (sizet i=nrFields; i!=record.Len(); ++i)
+			record[i] = Seq();
+
+		return true;
+	}
+
+
 	bool CsvReader::ParseField(bool resume, Str& outField, Seq& remaining)
 	{
 		if (!resume)
@@ -141,33 +210,40 @@ namespace At
 			}
 
 			// Quote char not escaped, expect next field
-			remaining.DropToFirstByteNotOf(" \t");
-			if (!remaining.n)
-			{
-				// Quoted field ended, and has no following field
-				return true;
-			}
-		
-			if (remaining.p[0] == m_fieldDelim)
-			{
-				// Quoted field ended, and does have a following field
-				remaining.DropByte();
-				return true;
-			}
+			SkipAfterQuotedField(remaining);
+			return true;
+		}
+	}
 
-			if (m_commentDelim != 0 && remaining.p[0] == m_commentDelim)
-			{
-				// Quoted field ended and followed by comment
-				remaining.DropBytes(remaining.n);
-				return true;
-			}
 
-			Str msg;
-			msg.Set("Expecting either field delimiter or new line at line ").UInt(m_lineReader.LineNr());
-			if (Path().Any())
-				msg.Add(" in CSV file ").Add(Path());
-			throw InputErr(msg);
+	void CsvReader::SkipAfterQuotedField(Seq& remaining)
+	{
+		remaining.DropToFirstByteNotOf(" \t");
+		if (!remaining.n)
+		{
+			// Quoted field ended, and has no following field
+			return;
 		}
+		
+		if (remaining.p[0] == m_fieldDelim)
+		{
+			// Quoted field ended, and does have a following field
+			remaining.DropByte();
+			return;
+		}
+
+		if (m_commentDelim != 0 && remaining.p[0] == m_commentDelim)
+		{
+			// Quoted field ended and followed by comment
+			remaining.DropBytes(remaining.n);
+			return;
+		}
+
+		Str msg;
+		msg.Set("Expecting either field delimiter or new line at line ").UInt(m_lineReader.LineNr());
+		if (Path().Any())
+			msg.Add(" in CSV file ").Add(Path());
+		throw InputErr(msg);
 	}
 
 }
@@ -30,11 +30,17 @@ namespace At
 		// Throws InputErr if line could not be parsed.
 		bool ReadRecord(Vec<Str>& record, sizet& nrFields);
 
+		// Same as above, but does not copy fields. A field points into the content being read, unless it is quoted and
+		// contains escaped quotes or line breaks. Such a field is unescaped into a buffer owned by the reader, which is reused
+		// for the same field of the next record. Fields are therefore valid only until the next call.
+		bool ReadRecord(Vec<Seq>& record, sizet& nrFields);
+
 	private:
 		LineReader m_lineReader;
 		char       m_fieldDelim;
 		char       m_commentDelim;
 		char       m_delims[4];
+		Vec<Str>   m_scratch;
 
 		void Init(char fieldDelim, char commentDelim);
 
@@ -42,6 +48,9 @@ namespace At
 		// If false is returned, ParseField should be called again with the next line,
 		// but setting resume=true, and passing the same field of the same output record.
 		bool ParseField(bool resume, Str& outField, Seq& remaining);
+
+		// Called after the closing quote of a quoted field. Skips to the next field, or throws InputErr if there is none.
+		void SkipAfterQuotedField(Seq& remaining);
 	};
 
 }
@@ -33,45 +33,45 @@ namespace At
 				if (cmd == c_zCmdSaveEntity)
 				{
 					m_editedEntityJson = req.PostNvp("entityJson");
-					ParseTree pt { m_editedEntityJson };
-					if (!pt.Parse(Json::C_Json))
-						AddPageErr(Str("Entity JSON does not match grammar: ").Obj(pt, ParseTree::BestAttempt));
-					else
+
+					Str prevKey;
+					m_entity->EncodeKey(prevKey);
+
+					bool decoded {};
+					try
 					{
-						ParseNode const* parseNode = pt.Root().FlatFind(Json::id_Object);
-						if (!parseNode)
+						Json::StreamDecoder decoder { m_editedEntityJson };
+						if (decoder.PeekType() != Json::ValType::Object)
 							AddPageErr("Entity JSON is not an object");
 						else
 						{
-							Str prevKey;
-							m_entity->EncodeKey(prevKey);
-
-							bool decoded {};
-							try { m_entity->JsonDecode(*parseNode, nullptr); decoded = true; }
-							catch (Json::DecodeErr const& e) { AddPageErr(Str("Error decoding entity JSON: ").Add(e.what())); }
+							m_entity->JsonDecode(decoder, nullptr);
+							decoder.DecodeEnd();
+							decoded = true;
+						}
+					}
+					catch (Json::DecodeErr const& e) { AddPageErr(Str("Error decoding entity JSON: ").Add(e.what())); }
 
-							if (decoded)
-							{
-								bool dupKey {};
-								if (m_entity->UniqueKey() && m_entity->m_parentId.Any())
-								{
-									Str newKey;
-									m_entity->EncodeKey(newKey);
+					if (decoded)
+					{
+						bool dupKey {};
+						if (m_entity->UniqueKey() && m_entity->m_parentId.Any())
+						{
+							Str newKey;
+							m_entity->EncodeKey(newKey);
 
-									if (newKey != prevKey && store.ChildWithSameKeyExists(m_entity->m_parentId, m_entity.Ref()))
-										dupKey = true;
-								}
+							if (newKey != prevKey && store.ChildWithSameKeyExists(m_entity->m_parentId, m_entity.Ref()))
+								dupKey = true;
+						}
 
-								if (dupKey)
-									AddPageErr("Entity key must be unique and parent already contains a child with the same key");
-								else
-								{
-									m_entity->Update();
+						if (dupKey)
+							AddPageErr("Entity key must be unique and parent already contains a child with the same key");
+						else
+						{
+							m_entity->Update();
 
-									SetRedirectResponse(HttpStatus::SeeOther, Str(DAP_Env_MountPath()).Add("browse?entityId=").UrlEncode(Str::From(entityId)));
-									return ReqResult::Done;
-								}
-							}
+							SetRedirectResponse(HttpStatus::SeeOther, Str(DAP_Env_MountPath()).Add("browse?entityId=").UrlEncode(Str::From(entityId)));
+							return ReqResult::Done;
 						}
 					}
 				}
@@ -117,133 +117,150 @@ namespace At
 		Entity::JsonIds jsonIds;
 		jsonIds.Add(Entity::JsonId { ".", m_entity->m_entityId });
 
-		ParseTree pt { content };
-		if (!pt.Parse(Json::C_Json))
-			AddPageErr(Str("Import script does not match JSON grammar: ").Obj(pt, ParseTree::BestAttempt));
-		else
+		// The script is decoded and executed in one pass, without first constructing a ParseTree. If a syntax error
+		// is encountered after some instructions have been executed, the page error causes the transaction to be aborted
+		Json::StreamDecoder decoder { content };
+
+		auto locStr = [&] (char const* what, sizet pos) -> Str
+			{
+				sizet row, col;
+				decoder.RowCol(pos, row, col);
+				return Str(what).Add(" at row ").UInt(row).Add(", column ").UInt(col);
+			};
+
+		sizet instrPos {};
+		bool inInstruction {};
+
+		try
 		{
-			ParseNode const* parseNode = pt.Root().FlatFind(Json::id_Array);
-			if (!parseNode)
+			if (decoder.PeekType() != Json::ValType::Array)
 				AddPageErr("Import script must be a JSON array containing instructions");
 			else
 			{
-				for (ParseNode const& childNode : *parseNode)
-					if (childNode.IsType(Json::id_Value))
+				decoder.DecodeArray([&] ()
 					{
-						if (!childNode.IsType(Json::id_Object))
-							AddPageErr(Str::From(childNode, ParseNode::TagRowCol).Add(": Expecting JSON object representing an instruction"));
-						else
+						instrPos = decoder.ValuePos();
+						if (decoder.PeekType() != Json::ValType::Object)
 						{
-							try
-							{
-								enum InstructionState { ExpectInstruction, ExpectJsonIdOpt, ExpectEntity, ExpectEnd };
-								InstructionState state { ExpectInstruction };
-
-								enum InstructionType { InstrUnknown, InstrFind, InstrRemove, InstrInsert };
-								InstructionType instructionType;
+							AddPageErr(locStr("Value", instrPos).Add(": Expecting JSON object representing an instruction"));
+							return;
+						}
 
-								Str jsonId;
-								Rp<Entity> e;
+						inInstruction = true;
 
-								Json::DecodeObject(childNode, [&] (ParseNode const& nameParser, Seq name, ParseNode const& valueParser) -> bool
-									{
-										if (state == ExpectInstruction)
-										{
-											if (!name.EqualExact("i"))
-												throw Json::DecodeErr(nameParser, "Expected instruction 'i'");
+						enum InstructionState { ExpectInstruction, ExpectJsonIdOpt, ExpectEntity, ExpectEnd };
+						InstructionState state { ExpectInstruction };
 
-											Str instructionStr;
-											Json::DecodeString(valueParser, instructionStr);
+						enum InstructionType { InstrUnknown, InstrFind, InstrRemove, InstrInsert };
+						InstructionType instructionType;
 
-											Seq instructionSeq = instructionStr;
-											     if (instructionSeq.EqualExact("find"   )) instructionType = InstrFind;
-											else if (instructionSeq.EqualExact("remove" )) instructionType = InstrRemove;
-											else if (instructionSeq.EqualExact("insert" )) instructionType = InstrInsert;
-											else
-												throw Json::DecodeErr(valueParser, "Unrecognized instruction");
+						Str jsonId;
+						Rp<Entity> e;
 
-											state = ExpectJsonIdOpt;
-										}
-										else if (state == ExpectJsonIdOpt)
-										{
-											if (!name.EqualExact("j"))
-											{
-												if (instructionType == InstrInsert)
-												{
-													if (name.EqualExact("e"))
-														goto DecodeEntity;
-													else
-														throw Json::DecodeErr(nameParser, "Expected JSON ID 'j' or entity 'e'");
-												}
-
-												throw Json::DecodeErr(nameParser, "Expected JSON ID 'j'");
-											}
-
-											Json::DecodeString(valueParser, jsonId);
-											state = ExpectEntity;
-										}
-										else if (state == ExpectEntity)
-										{
-										DecodeEntity:
-											if (!name.EqualExact("e"))
-												throw Json::DecodeErr(nameParser, "Expected entity 'e'");
-
-											Entity::JsonDecodeDynEntity(valueParser, e, &store, &jsonIds);
-											state = ExpectEnd;
-										}
-										else
-											throw Json::DecodeErr(nameParser, "Expected end of JSON object");
+						decoder.DecodeObject([&] (sizet namePos, Seq name) -> bool
+							{
+								if (state == ExpectInstruction)
+								{
+									if (!name.EqualExact("i"))
+										throw decoder.Err(namePos, "Expected instruction 'i'");
 
-										return true;
-									} );
+									sizet valuePos = decoder.ValuePos();
+									Str instructionStr;
+									decoder.DecodeString(instructionStr);
 
-								if (instructionType == InstrFind)
-								{
-									if (!jsonId.Any())
-										throw Json::DecodeErr(childNode, "Find instruction requires JSON ID 'j' to which to assign the found entity ID");
+									Seq instructionSeq = instructionStr;
+									     if (instructionSeq.EqualExact("find"   )) instructionType = InstrFind;
+									else if (instructionSeq.EqualExact("remove" )) instructionType = InstrRemove;
+									else if (instructionSeq.EqualExact("insert" )) instructionType = InstrInsert;
+									else
+										throw decoder.Err(valuePos, "Unrecognized instruction");
 
-									ObjId entityId = store.FindChildIdWithSameKey(e->m_parentId, e.Ref());
-									jsonIds.Add(Entity::JsonId { jsonId, entityId });
+									state = ExpectJsonIdOpt;
 								}
-								else if (instructionType == InstrRemove)
+								else if (state == ExpectJsonIdOpt)
 								{
-									if (!jsonId.Any())
-										throw Json::DecodeErr(childNode, "Remove instruction requires JSON ID 'j' of entity to remove");
-
-									Entity::JsonIds::ConstIt it = jsonIds.Find(jsonId);
-									if (!it.Any())
-										throw Json::DecodeErr(childNode, "Could not find the specified entity JSON ID");
-
-									if (it->m_objId.Any())
+									if (!name.EqualExact("j"))
 									{
-										store.RemoveEntityChildren(it->m_objId);
-										store.RemoveEntity(it->m_objId);
-										++m_nrEntitiesRemoved;
+										if (instructionType == InstrInsert)
+										{
+											if (name.EqualExact("e"))
+												goto DecodeEntity;
+											else
+												throw decoder.Err(namePos, "Expected JSON ID 'j' or entity 'e'");
+										}
+
+										throw decoder.Err(namePos, "Expected JSON ID 'j'");
 									}
+
+									decoder.DecodeString(jsonId);
+									state = ExpectEntity;
 								}
-								else if (instructionType == InstrInsert)
+								else if (state == ExpectEntity)
 								{
-									if (e->UniqueKey() && store.ChildWithSameKeyExists(e->m_parentId, e.Ref()))
-										throw Json::DecodeErr(childNode, "Inserting this entity would violate a unique key constraint");
-						
-									e->Insert_ParentExists();
-									++m_nrEntitiesInserted;
+								DecodeEntity:
+									if (!name.EqualExact("e"))
+										throw decoder.Err(namePos, "Expected entity 'e'");
 
-									if (jsonId.Any())
-										jsonIds.Add(Entity::JsonId { jsonId, e->m_entityId });
+									Entity::JsonDecodeDynEntity(decoder, e, &store, &jsonIds);
+									state = ExpectEnd;
 								}
 								else
-									EnsureThrow(!"Unrecognized instruction type");
-							}
-							catch (Json::DecodeErr const& e)
+									throw decoder.Err(namePos, "Expected end of JSON object");
+
+								return true;
+							} );
+
+						if (instructionType == InstrFind)
+						{
+							if (!jsonId.Any())
+								throw decoder.Err(instrPos, "Find instruction requires JSON ID 'j' to which to assign the found entity ID");
+
+							ObjId entityId = store.FindChildIdWithSameKey(e->m_parentId, e.Ref());
+							jsonIds.Add(Entity::JsonId { jsonId, entityId });
+						}
+						else if (instructionType == InstrRemove)
+						{
+							if (!jsonId.Any())
+								throw decoder.Err(instrPos, "Remove instruction requires JSON ID 'j' of entity to remove");
+
+							Entity::JsonIds::ConstIt it = jsonIds.Find(jsonId);
+							if (!it.Any())
+								throw decoder.Err(instrPos, "Could not find the specified entity JSON ID");
+
+							if (it->m_objId.Any())
 							{
-								AddPageErr(Str::From(childNode, ParseNode::TagRowCol).Add(": Error decoding import script instruction: ").Add(e.what()));
-								break;
+								store.RemoveEntityChildren(it->m_objId);
+								store.RemoveEntity(it->m_objId);
+								++m_nrEntitiesRemoved;
 							}
 						}
-					}
+						else if (instructionType == InstrInsert)
+						{
+							if (e->UniqueKey() && store.ChildWithSameKeyExists(e->m_parentId, e.Ref()))
+								throw decoder.Err(instrPos, "Inserting this entity would violate a unique key constraint");
+						
+							e->Insert_ParentExists();
+							++m_nrEntitiesInserted;
+
+							if (jsonId.Any())
+								jsonIds.Add(Entity::JsonId { jsonId, e->m_entityId });
+						}
+						else
+							EnsureThrow(!"Unrecognized instruction type");
+
+						inInstruction = false;
+					} );
+
+				decoder.DecodeEnd();
 			}
 		}
+		catch (Json::DecodeErr const& e)
+		{
+			if (inInstruction)
+				AddPageErr(locStr("Object", instrPos).Add(": Error decoding import script instruction: ").Add(e.what()));
+			else
+				AddPageErr(Str("Error decoding import script: ").Add(e.what()));
+		}
 	}
 
 
@@ -1,3 +1,5 @@
+'use strict';
+
 {
     const editLink = Elem('editLink');
     const entityJson = Elem('entityJson');
@@ -0,0 +1,306 @@
+#include "AtIncludes.h"
+#include "AtDeflate.h"
+
+#include "AtCrc32.h"
+#include "AtEncode.h"
+#include "AtInitOnFirstUse.h"
+
+
+namespace At
+{
+	namespace
+	{
+
+		uint16 const c_lenBase  [29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		byte   const c_lenExtra [29] = { 0, 0, 0, 0, 0, 0, 0,  0,  1,  1,  1,  1,  2,  2,  2,  2,  3,  3,  3,  3,  4,  4,  4,   4,   5,   5,   5,   5,   0 };
+
+		uint16 const c_distBase  [30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		byte   const c_distExtra [30] = { 0, 0, 0, 0, 1, 1, 2,  2,  3,  3,  4,  4,  5,  5,   6,   6,   7,   7,   8,   8,    9,    9,   10,   10,   11,   11,   12,    12,    13,    13 };
+
+
+		// Fixed Huffman codes (RFC 1951, section 3.2.6), bit-reversed so they can be written least significant bit first
+		struct FixedCodes
+		{
+			uint16 m_litCode  [288];
+			byte   m_litLen   [288];
+			uint16 m_distCode [30];
+			byte   m_lenSym   [259];		// Length -> index into c_lenBase
+			byte   m_distSym  [32769];		// Distance -> index into c_distBase
+		};
+
+		LONG volatile g_deflate_initFlag {};
+		FixedCodes g_deflate_fixedCodes;
+
+
+		uint16 ReverseBits(uint code, uint nrBits)
+		{
+			uint reversed {};
+			for (uint i=0; i!=nrBits; ++i)
+				reversed |= ((code >> i) & 1U) << (nrBits - 1 - i);
+			return (uint16) reversed;
+		}
+
+
+		void InitFixedCodes()
+		{
+			FixedCodes& fc = g_deflate_fixedCodes;
+
+			for (uint lit=0; lit!=288; ++lit)
+			{
+				uint code, nrBits;
+				     if (lit < 144) { code = 0x030 + lit;         nrBits = 8; }
+				else if (lit < 256) { code = 0x190 + (lit - 144); nrBits = 9; }
+				else if (lit < 280) { code = lit - 256;           nrBits = 7; }
+				else                { code = 0x0C0 + (lit - 280); nrBits = 8; }
+
+				fc.m_litCode[lit] = ReverseBits(code, nrBits);
+				fc.m_litLen[lit] = (byte) nrBits;
+			}
+
+			for (uint i=0; i!=30; ++i)
+				fc.m_distCode[i] = ReverseBits(i, 5);
+
+			// Length 258 has its own symbol, even though the preceding symbol could also encode it
+			for (uint i=0; i!=29; ++i)
+				for (uint len=c_lenBase[i]; len < c_lenBase[i] + (1U << c_lenExtra[i]) && len <= 258; ++len)
+					fc.m_lenSym[len] = (byte) i;
+			fc.m_lenSym[258] = 28;
+
+			for (uint i=0; i!=30; ++i)
+				for (uint dist=c_distBase[i]; dist < c_distBase[i] + (1U << c_distExtra[i]); ++dist)
+					fc.m_distSym[dist] = (byte) i;
+		}
+
+
+		uint32 Adler32(uint32 adler, Seq data)
+		{
+			uint32 a = adler & 0xFFFF;
+			uint32 b = adler >> 16;
+
+			while (data.n)
+			{
+				// 5552 is the largest number of bytes for which the sums cannot overflow before the modulo
+				Seq piece = data.ReadBytes(5552);
+				for (byte c : piece)
+				{
+					a += c;
+					b += a;
+				}
+
+				a %= 65521;
+				b %= 65521;
+			}
+
+			return (b << 16) | a;
+		}
+
+
+		inline uint Hash4(byte const* p)
+		{
+			uint32 v;
+			memcpy(&v, p, 4);
+			return (v * 2654435761U) >> (32 - 14);
+		}
+
+	} // anon
+
+
+	DeflateEncoder::DeflateEncoder(Enc& out, Format format)
+		: m_out(out), m_format(format)
+	{
+		static_assert(HashBits == 14, "Hash4 must produce HashBits bits");
+		InitOnFirstUse(&g_deflate_initFlag, InitFixedCodes);
+
+		m_buf.ResizeExact(BufSize);
+		m_hashHeads.ResizeExact(1U << HashBits, 0);
+
+		switch (m_format)
+		{
+		case Format::Raw:
+			break;
+
+		case Format::Zlib:
+			// CM = 8 (deflate), CINFO = 7 (32 KB window), FLEVEL = 0 (fastest), FCHECK makes the 16-bit value a multiple of 31
+			m_out.Byte(0x78).Byte(0x01);
+			m_checksum = 1;
+			break;
+
+		case Format::Gzip:
+			// ID1, ID2, CM = 8 (deflate), FLG = 0, MTIME = 0 (not available), XFL = 0, OS = 255 (unknown)
+			m_out.Add(Seq("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\xFF", 10));
+			break;
+
+		default:
+			EnsureThrow(!"Unsupported DeflateEncoder format");
+		}
+
+		// All input is encoded in a single non-final block using fixed Huffman codes (BTYPE = 01). Finish adds an empty final block
+		PutBits(0, 1);
+		PutBits(1, 2);
+	}
+
+
+	void DeflateEncoder::Write(Seq data)
+	{
+		EnsureThrow(!m_finished);
+
+		if (m_format == Format::Zlib)
+			m_checksum = Adler32(m_checksum, data);
+		else if (m_format == Format::Gzip)
+		{
+			m_checksum = Crc32(data, m_checksum);
+			m_totalIn += (uint32) data.n;
+		}
+
+		while (data.n)
+		{
+			Seq piece = data.ReadBytes(BufSize - m_bufLen);
+			memcpy(m_buf.Ptr() + m_bufLen, piece.p, piece.n);
+			m_bufLen += piece.n;
+
+			if (m_bufLen == BufSize)
+			{
+				EncodeBuffered(false);
+				Slide();
+			}
+		}
+	}
+
+
+	void DeflateEncoder::Finish()
+	{
+		EnsureThrow(!m_finished);
+		m_finished = true;
+
+		EncodeBuffered(true);
+		PutLiteral(256);
+
+		PutBits(1, 1);
+		PutBits(1, 2);
+		PutLiteral(256);
+		FlushBits();
+
+		if (m_format == Format::Zlib)
+			EncodeUInt32(m_out, m_checksum);
+		else if (m_format == Format::Gzip)
+		{
+			EncodeUInt32LE(m_out, m_checksum);
+			EncodeUInt32LE(m_out, m_totalIn);
+		}
+	}
+
+
+	void DeflateEncoder::EncodeBuffered(bool final)
+	{
+		byte const* const buf = m_buf.Ptr();
+		sizet const end = m_bufLen;
+
+		// Unless this is the final input, leave enough input unencoded that a match found later would not have to be cut short
+		sizet const limit = final ? end : (end > (sizet) MaxMatch ? end - MaxMatch : 0);
+
+		sizet pos = m_encPos;
+		while (pos < limit)
+		{
+			if (pos + MinMatch <= end)
+			{
+				uint32& head = m_hashHeads[Hash4(buf + pos)];
+				sizet cand = head;
+				head = (uint32) (pos + 1);
+
+				if (cand && pos + 1 - cand <= WindowSize)
+				{
+					byte const* p = buf + pos;
+					byte const* c = buf + cand - 1;
+					sizet maxLen = PickMin<sizet>(MaxMatch, end - pos);
+					sizet len {};
+					while (len != maxLen && p[len] == c[len])
+						++len;
+
+					if (len >= MinMatch)
+					{
+						PutMatch((uint) len, (uint) (pos + 1 - cand));
+
+						sizet hashEnd = PickMin<sizet>(pos + len, end - MinMatch + 1);
+						for (sizet i=pos+1; i<hashEnd; ++i)
+							m_hashHeads[Hash4(buf + i)] = (uint32) (i + 1);
+
+						pos += len;
+						continue;
+					}
+				}
+			}
+
+			PutLiteral(buf[pos]);
+			++pos;
+		}
+
+		m_encPos = pos;
+	}
+
+
+	void DeflateEncoder::Slide()
+	{
+		// Keep the last WindowSize bytes of encoded input, so that later input can refer to them
+		if (m_encPos > WindowSize)
+		{
+			sizet shift = m_encPos - WindowSize;
+			memmove(m_buf.Ptr(), m_buf.Ptr() + shift, m_bufLen - shift);
+			m_bufLen -= shift;
+			m_encPos -= shift;
+
+			for (uint32& head : m_hashHeads)
+				head = (head > shift) ? (uint32) (head - shift) : 0;
+		}
+	}
+
+
+	void DeflateEncoder::PutBits(uint bits, uint nrBits)
+	{
+		m_bitBuf |= ((uint64) bits) << m_nrBits;
+		m_nrBits += nrBits;
+
+		if (m_nrBits >= 32)
+		{
+			EncodeUInt32LE(m_out, (uint32) m_bitBuf);
+			m_bitBuf >>= 32;
+			m_nrBits -= 32;
+		}
+	}
+
+
+	void DeflateEncoder::PutLiteral(uint lit)
+	{
+		FixedCodes const& fc = g_deflate_fixedCodes;
+		PutBits(fc.m_litCode[lit], fc.m_litLen[lit]);
+	}
+
+
+	void DeflateEncoder::PutMatch(uint len, uint dist)
+	{
+		FixedCodes const& fc = g_deflate_fixedCodes;
+
+		uint lenSym = fc.m_lenSym[len];
+		PutBits(fc.m_litCode[257 + lenSym], fc.m_litLen[257 + lenSym]);
+		if (c_lenExtra[lenSym])
+			PutBits(len - c_lenBase[lenSym], c_lenExtra[lenSym]);
+
+		uint distSym = fc.m_distSym[dist];
+		PutBits(fc.m_distCode[distSym], 5);
+		if (c_distExtra[distSym])
+			PutBits(dist - c_distBase[distSym], c_distExtra[distSym]);
+	}
+
+
+	void DeflateEncoder::FlushBits()
+	{
+		while (m_nrBits)
+		{
+			m_out.Byte((byte) m_bitBuf);
+			m_bitBuf >>= 8;
+			m_nrBits = (m_nrBits > 8) ? (m_nrBits - 8) : 0;
+		}
+
+		m_bitBuf = 0;
+	}
+
+}
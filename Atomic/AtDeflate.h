@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AtStr.h"
+#include "AtVec.h"
+
+
+namespace At
+{
+
+	// A self-contained DEFLATE encoder (RFC 1951), tuned for speed over ratio. It is meant for content that is compressed once and
+	// sent once, such as HTTP responses. Matches are found with a single hash probe per position, and all output is encoded using
+	// the fixed Huffman codes, so there are no code tables to build and no need to buffer a whole block. The ratio is lower than that
+	// of zlib's default level, but output can be decoded by any inflater.
+	//
+	// Input can be written in any number of pieces. Output is appended to the Enc as input is processed. Finish must be called after
+	// the last piece is written.
+
+	class DeflateEncoder : public NoCopy
+	{
+	public:
+		// Raw = RFC 1951; Zlib = RFC 1950, used by the HTTP "deflate" content coding; Gzip = RFC 1952, used by the "gzip" content coding
+		enum class Format { Raw, Zlib, Gzip };
+
+		DeflateEncoder(Enc& out, Format format);
+
+		void Write(Seq data);
+		void Finish();
+
+		static void Compress(Seq data, Enc& out, Format format) { DeflateEncoder enc { out, format }; enc.Write(data); enc.Finish(); }
+
+	private:
+		enum { WindowSize = 32768, BlockSize = 131072, BufSize = WindowSize + BlockSize, HashBits = 14, MinMatch = 4, MaxMatch = 258 };
+
+		Enc&        m_out;
+		Format      m_format;
+		bool        m_finished {};
+
+		Vec<byte>   m_buf;				// Up to WindowSize bytes already encoded, followed by input not yet encoded
+		sizet       m_bufLen {};
+		sizet       m_encPos {};
+		Vec<uint32> m_hashHeads;		// For each hash value, m_buf position of the most recent occurrence plus one, or zero
+
+		uint64      m_bitBuf {};
+		uint        m_nrBits {};
+
+		uint32      m_checksum {};		// Zlib: Adler-32. Gzip: CRC-32
+		uint32      m_totalIn {};		// Gzip: input size modulo 2^32
+
+		void EncodeBuffered(bool final);
+		void Slide();
+
+		void PutBits(uint bits, uint nrBits);
+		void PutLiteral(uint lit);
+		void PutMatch(uint len, uint dist);
+		void FlushBits();
+	};
+
+}
@@ -1,7 +1,11 @@
 #include "AtIncludes.h"
 #include "AtDiff.h"
 
-#include "AtMap.h"
+#include "AtCrypt.h"
+#include "AtInitOnFirstUse.h"
+#include "AtMutex.h"
+#include "AtTaskScheduler.h"
+#include "AtThread.h"
 
 
 namespace At
@@ -33,34 +37,227 @@ namespace At
 			};
 
 
-			struct UniqueUnitMapEntry
+			LONG volatile g_diff_initFlag {};
+			uint64 g_diff_fnvHashSeed {};
+
+
+			// A ParallelFor call queues one task per helper thread it can use. A helper that takes a task after the calling thread
+			// has finished the work returns without running the worker, so the calling thread waits only for helpers already running
+
+			struct ParallelForJob : RefCountable
+			{
+				std::function<void (uint)> m_worker;
+
+				void RunHelper()
+				{
+					uint thread;
+					{
+						Locker locker { m_mx };
+						if (m_closed)
+							return;
+
+						thread = ++m_nextThread;
+						++m_nrActive;
+					}
+
+					m_worker(thread);
+
+					Locker locker { m_mx };
+					if (!--m_nrActive && m_closed)
+						m_doneEvent.Signal();
+				}
+
+				// Called by the thread that queued the job, after it has run the worker itself. Returns when no helper is running the worker
+				void Close()
+				{
+					{
+						Locker locker { m_mx };
+						m_closed = true;
+						if (!m_nrActive)
+							return;
+					}
+
+					m_doneEvent.WaitIndefinite();
+				}
+
+			private:
+				Mutex m_mx;
+				bool  m_closed     {};
+				uint  m_nextThread {};
+				uint  m_nrActive   {};
+				Event m_doneEvent  { Event::CreateManual };
+			};
+
+
+			// Helper threads shared by all diffs in the process, so that a diff does not create and join threads of its own.
+			// Threads are started as needed, up to MaxThreads, and wait for tasks until the process exits. The pool is never freed,
+			// because its threads may still be waiting when static objects are destroyed.
+
+			class ParallelForPool : public NoCopy
 			{
-				Seq         m_value;
-				UniqueUnit* m_uniqueUnit;
+			public:
+				enum : uint { MaxThreads = 64 };
+
+				ParallelForPool() { m_scheduler.Init(MaxThreads, SIZE_MAX, BacklogPolicy::Block); }
+
+				// Starts threads so that the pool has at least nrHelpers, up to MaxThreads, and queues a task for each
+				void Enqueue(ParallelForJob& job, uint nrHelpers)
+				{
+					nrHelpers = PickMin<uint>(nrHelpers, MaxThreads);
+
+					{
+						Locker locker { m_mx };
+						while (m_nrThreads < nrHelpers)
+						{
+							ThreadPtr<PoolThread> thread { Thread::Create };
+							thread->SetPool(this);
+							thread->Start(m_stopCtl);
+							++m_nrThreads;
+						}
+					}
+
+					for (uint i=0; i!=nrHelpers; ++i)
+					{
+						// The reference is released by the pool thread that takes the task
+						job.AddRef();
+						EnsureThrow(m_scheduler.Enqueue(&job, TaskPriority::Normal, m_stopCtl->StopEvent().Handle()));
+					}
+				}
+
+			private:
+				class PoolThread : public Thread
+				{
+				public:
+					void SetPool(ParallelForPool* pool) { EnsureThrow(!Started()); m_pool = pool; }
+
+				private:
+					ParallelForPool* m_pool {};
+
+					void ThreadMain() override final { m_pool->PoolThreadMain(StopEvent()); }
+				};
+
+				Mutex         m_mx;
+				uint          m_nrThreads {};		// Protected by m_mx
+				TaskScheduler m_scheduler;
+				Rp<StopCtl>   m_stopCtl   { new StopCtl };
 
-				UniqueUnitMapEntry(Seq value) : m_value(value) {}
-				Seq Key() const { return m_value; }
+				void PoolThreadMain(Event& stopEvent)
+				{
+					uint worker = m_scheduler.AttachWorker();
+					OnExit detach = [&] { m_scheduler.DetachWorker(worker); };
+
+					while (true)
+					{
+						void* task = m_scheduler.TryDequeue(worker);
+						if (task)
+						{
+							Rp<ParallelForJob> job { (ParallelForJob*) task };
+							job->Release();
+							job->RunHelper();
+						}
+						else if (m_scheduler.WaitForTask(stopEvent.Handle(), INFINITE) == 0)
+							break;
+					}
+				}
 			};
 
-			using UniqueUnitMap = Map<UniqueUnitMapEntry>;
+
+			LONG volatile g_diff_poolInitFlag {};
+			ParallelForPool* g_diff_pool {};
+
+
+			// Calls func(thread, i) for each i in [0, n), using the calling thread and up to (nrThreads - 1) threads from ParallelForPool.
+			// The thread argument is in [0, nrThreads), and differs between calls that may run concurrently.
+			// Rethrows the first exception thrown by func after all threads have stopped.
+			template <class F>
+			void ParallelFor(uint nrThreads, sizet n, F func)
+			{
+				std::atomic<sizet> next { 0 };
+				std::atomic<bool> failed { false };
+				std::exception_ptr firstException;
+				Mutex exceptionMx;
+
+				auto worker = [&] (uint thread)
+					{
+						try
+						{
+							while (!failed)
+							{
+								sizet i = next++;
+								if (i >= n)
+									break;
+								func(thread, i);
+							}
+						}
+						catch (...)
+						{
+							Locker locker { exceptionMx };
+							if (!firstException)
+								firstException = std::current_exception();
+							failed = true;
+						}
+					};
+
+				if (nrThreads <= 1 || n <= 1)
+					worker(0);
+				else
+				{
+					InitOnFirstUse(&g_diff_poolInitFlag, [] ()
+						{ g_diff_pool = new ParallelForPool; } );
+
+					Rp<ParallelForJob> job { new ParallelForJob };
+					job->m_worker = worker;
+					g_diff_pool->Enqueue(job.Ref(), (uint) PickMin<sizet>(nrThreads, n) - 1);
+
+					worker(0);
+					job->Close();
+				}
+
+				if (firstException)
+					std::rethrow_exception(firstException);
+			}
 
 
 			struct UniqueUnitView
 			{
-				UniqueUnitMap   m_uum;
 				Vec<Occurrence> m_occurrencesOld;
 				Vec<Occurrence> m_occurrencesNew;
 
-				void Build(Slice<InputUnit> inputOld, Slice<InputUnit> inputNew)
+				void Build(Slice<InputUnit> inputOld, Slice<InputUnit> inputNew, uint nrThreads)
 				{
-					m_uniqueUnitStorage.FixReserve(inputOld.Len() + inputNew.Len());
+					InitOnFirstUse(&g_diff_initFlag, [] ()
+						{ g_diff_fnvHashSeed = Crypt::GenRandomNr(UINT64_MAX); } );
+
+					sizet const nrUnits = inputOld.Len() + inputNew.Len();
+					m_uniqueUnitStorage.FixReserve(nrUnits);
 					m_occurrencesOld.FixReserve(inputOld.Len());
 					m_occurrencesNew.FixReserve(inputNew.Len());
 
+					// Hash all units up front, in parallel for large inputs. Interning then compares full values only when hashes match
+					Vec<uint64> hashesOld, hashesNew;
+					hashesOld.ResizeExact(inputOld.Len());
+					hashesNew.ResizeExact(inputNew.Len());
+					sizet const nrChunks = (nrUnits + HashChunkSize - 1) / HashChunkSize;
+					ParallelFor(nrThreads, nrChunks, [&] (uint, sizet chunk)
+						{
+							for (sizet i=chunk*HashChunkSize, end=PickMin<sizet>(i + HashChunkSize, nrUnits); i!=end; ++i)
+								if (i < inputOld.Len())
+									hashesOld[i] = inputOld[i].m_value.FnvHash64(g_diff_fnvHashSeed);
+								else
+									hashesNew[i - inputOld.Len()] = inputNew[i - inputOld.Len()].m_value.FnvHash64(g_diff_fnvHashSeed);
+						} );
+
+					// Open addressing with linear probing. The table is kept at most half full
+					sizet nrSlots = 2;
+					while (nrSlots < 2*nrUnits)
+						nrSlots <<= 1;
+					m_slots.ResizeExact(nrSlots);
+					m_slotMask = nrSlots - 1;
+
 					for (sizet i=0; i!=inputOld.Len(); ++i)
 					{
 						InputUnit const& iu = inputOld[i];
-						UniqueUnit* uu = FindOrAddUniqueUnit(iu);
+						UniqueUnit* uu = FindOrAddUniqueUnit(iu, hashesOld[i]);
 						uu->m_isInOld = true;
 						m_occurrencesOld.Add(&iu, uu);
 					}
@@ -68,23 +265,40 @@ namespace At
 					for (sizet i=0; i!=inputNew.Len(); ++i)
 					{
 						InputUnit const& iu = inputNew[i];
-						UniqueUnit* uu = FindOrAddUniqueUnit(iu);
+						UniqueUnit* uu = FindOrAddUniqueUnit(iu, hashesNew[i]);
 						uu->m_isInNew = true;
 						m_occurrencesNew.Add(&iu, uu);
 					}
 				}
 
 			private:
+				enum { HashChunkSize = 16384 };
+
+				struct Slot
+				{
+					uint64      m_hash {};
+					UniqueUnit* m_uu   {};
+				};
+
 				Vec<UniqueUnit> m_uniqueUnitStorage;
+				Vec<Slot>       m_slots;
+				sizet           m_slotMask {};
 
-				UniqueUnit* FindOrAddUniqueUnit(InputUnit const& iu)
+				UniqueUnit* FindOrAddUniqueUnit(InputUnit const& iu, uint64 hash)
 				{
-					bool added {};
-					UniqueUnitMapEntry entry { iu.m_value };
-					UniqueUnitMap::It it = m_uum.FindOrAdd(added, std::move(entry));
-					if (added)
-						it->m_uniqueUnit = &m_uniqueUnitStorage.Add(iu.m_value);
-					return it->m_uniqueUnit;
+					for (sizet i=((sizet) hash) & m_slotMask; ; i=(i+1) & m_slotMask)
+					{
+						Slot& slot = m_slots[i];
+						if (!slot.m_uu)
+						{
+							slot.m_hash = hash;
+							slot.m_uu = &m_uniqueUnitStorage.Add(iu.m_value);
+							return slot.m_uu;
+						}
+
+						if (slot.m_hash == hash && slot.m_uu->m_value == iu.m_value)
+							return slot.m_uu;
+					}
 				}
 			};
 
@@ -166,89 +380,44 @@ namespace At
 					EnsureThrow(m_xAxis.Any() == m_yAxis.Any());
 					if (m_xAxis.Any())
 					{
-						m_nrDiags = m_xAxis.Len() + m_yAxis.Len() + 3;
-						m_diagMin = -(NumCast<ptrdiff>(m_yAxis.Len() + 1));
-
 						// Set maximum number of steps to approximate square root of input size, but not less than 4000
 						m_maxNrSteps = 1;
-						for (sizet v=m_nrDiags; v; v>>=2)
+						for (sizet v=m_xAxis.Len() + m_yAxis.Len() + 3; v; v>>=2)
 							m_maxNrSteps <<= 1;
 						if (m_maxNrSteps < 4000)
 							m_maxNrSteps = 4000;
-
-						m_diagsFwd.ResizeExact(m_nrDiags);
-						m_diagsBwd.ResizeExact(m_nrDiags);
 					}
 				}
 
-				void Process(Vec<DiffUnit>& diff, DiffParams const& params)
+				void Process(Vec<DiffUnit>& diff, DiffParams const& params, uint nrThreads)
 				{
 					if (m_xAxis.Any())
 					{
-						Vec<Section> sections;
-						{
-							Coord ofs { 0, 0 };
-							Coord end { NumCast<ptrdiff>(m_xAxis.Len()), NumCast<ptrdiff>(m_yAxis.Len()) };
-							sections.Add(ofs, ofs, end, end, params.m_limitSteps);
-						}
+						Coord ofs { 0, 0 };
+						Coord end { NumCast<ptrdiff>(m_xAxis.Len()), NumCast<ptrdiff>(m_yAxis.Len()) };
+						Section whole { ofs, ofs, end, end, params.m_limitSteps };
 
-						do
+						Scratch scratch;
+						if (nrThreads <= 1 || m_xAxis.Len() + m_yAxis.Len() < ParallelMinAxisUnits)
+							SolveSection(whole, scratch, diff);
+						else
 						{
-							Section& s = sections.First();
+							// Each section is solved the same way regardless of what other sections there are, so sections can be solved
+							// independently, and their output concatenated in order. The result is the same as when solving sequentially
+							Vec<Section> sections;
+							SplitForParallel(whole, SectionsPerThread * nrThreads, scratch, sections);
 
-							// Skip leading snake, if any
-							while (s.ofs.x != s.end.x && s.ofs.y != s.end.y && UU_X(s.ofs.x) == UU_Y(s.ofs.y))
-								{ ++(s.ofs.x); ++(s.ofs.y); }
+							Vec<Vec<DiffUnit>> results;
+							results.ResizeExact(sections.Len());
+							Vec<Scratch> scratches;
+							scratches.ResizeExact(nrThreads);
 
-							// Skip trailing snake, if any
-							while (s.end.x != s.ofs.x && s.end.y != s.ofs.y && UU_X(s.end.x - 1) == UU_Y(s.end.y - 1))
-								{ --(s.end.x); --(s.end.y); }
-
-							// Trivial deletion?
-							if (s.ofs.y == s.end.y)
-							{
-								EmitLeadSnake(diff, s);
-
-								while (s.ofs.x != s.end.x)
-								{
-									AxisUnit const& au = m_xAxis.m_axisUnits[(sizet) s.ofs.x];
-									for (sizet pos=au.m_leadPos; pos<=au.m_unitPos; ++pos)
-										diff.Add(DiffDisposition::Removed, *(*m_xAxis.m_occurrences)[pos].m_iu);
-									++s.ofs.x;
-								}
-
-								EmitTrailSnake(diff, s);
-								sections.Erase(0, 1);
-							}
-
-							// Trivial insertion?
-							else if (s.ofs.x == s.end.x)
-							{
-								EmitLeadSnake(diff, s);
-
-								while (s.ofs.y != s.end.y)
-								{
-									AxisUnit const& au = m_yAxis.m_axisUnits[(sizet) s.ofs.y];
-									for (sizet pos=au.m_leadPos; pos<=au.m_unitPos; ++pos)
-										diff.Add(DiffDisposition::Added, *(*m_yAxis.m_occurrences)[pos].m_iu);
-									++s.ofs.y;
-								}
-
-								EmitTrailSnake(diff, s);
-								sections.Erase(0, 1);
-							}
-
-							else
-							{
-								SplitPoint split;
-								FindSplitPoint(s, split);
+							ParallelFor(nrThreads, sections.Len(), [&] (uint thread, sizet i)
+								{ SolveSection(sections[i], scratches[thread], results[i]); } );
 
-								Coord end = s.end, trailSnakeEnd = s.trailSnakeEnd;
-								s = Section(s.leadSnakeOfs, s.ofs, split.ofs, split.ofs, split.limitSteps_left);
-								sections.Insert(1, split.ofs, split.ofs, end, trailSnakeEnd, split.limitSteps_right);
-							}
+							for (Vec<DiffUnit> const& result : results)
+								diff.AddSlice(result);
 						}
-						while (sections.Any());
 					}
 
 					// Add trailing occurrences that aren't part of either axis, so therefore are different
@@ -260,19 +429,39 @@ namespace At
 				}
 
 			private:
-				sizet        m_nrDiags {};
-				ptrdiff      m_diagMin {};
-				sizet        m_maxNrSteps {};
-				Vec<ptrdiff> m_diagsFwd;
-				Vec<ptrdiff> m_diagsBwd;
-
-				ptrdiff& FD_X(ptrdiff diag) { return m_diagsFwd[(sizet) (diag - m_diagMin)]; }
-				ptrdiff& BD_X(ptrdiff diag) { return m_diagsBwd[(sizet) (diag - m_diagMin)]; }
+				// Below this axis size, splitting the work between threads costs more than it saves
+				static sizet const ParallelMinAxisUnits = 20000;
+				static sizet const SectionsPerThread = 4;
+
+				sizet m_maxNrSteps {};
+
 				static ptrdiff Diag(ptrdiff x, ptrdiff y) { return x - y; }
 
 				UniqueUnit const* UU_X(ptrdiff x) const { return m_xAxis.m_axisUnits[(sizet) x].m_uu; }
 				UniqueUnit const* UU_Y(ptrdiff y) const { return m_yAxis.m_axisUnits[(sizet) y].m_uu; }
 
+				// Forward and backward x positions per diagonal. Sized for the section being split, so that each thread can have its own
+				struct Scratch
+				{
+					ptrdiff      m_diagMin {};
+					Vec<ptrdiff> m_diagsFwd;
+					Vec<ptrdiff> m_diagsBwd;
+
+					ptrdiff& FD_X(ptrdiff diag) { return m_diagsFwd[(sizet) (diag - m_diagMin)]; }
+					ptrdiff& BD_X(ptrdiff diag) { return m_diagsBwd[(sizet) (diag - m_diagMin)]; }
+
+					void Reset(ptrdiff dMin, ptrdiff dMax)
+					{
+						m_diagMin = dMin - 1;
+						sizet nrDiags = (sizet) (dMax - dMin + 3);
+						if (m_diagsFwd.Len() < nrDiags)
+						{
+							m_diagsFwd.ResizeExact(nrDiags);
+							m_diagsBwd.ResizeExact(nrDiags);
+						}
+					}
+				};
+
 				struct Coord
 				{
 					ptrdiff x {};
@@ -304,10 +493,120 @@ namespace At
 					}
 				};
 
-				void EmitLeadSnake  (Vec<DiffUnit>& diff, Section s) { EmitSnake(diff, s.leadSnakeOfs, s.ofs           ); }
-				void EmitTrailSnake (Vec<DiffUnit>& diff, Section s) { EmitSnake(diff, s.end,          s.trailSnakeEnd ); }
+				// Solves the section completely, appending its output to the diff. The output depends only on the section
+				void SolveSection(Section whole, Scratch& sc, Vec<DiffUnit>& diff) const
+				{
+					Vec<Section> sections;
+					sections.Add(whole);
+
+					do
+					{
+						Section& s = sections.First();
+						SkipSnakes(s);
 
-				void EmitSnake(Vec<DiffUnit>& diff, Coord ofs, Coord end)
+						// Trivial deletion?
+						if (s.ofs.y == s.end.y)
+						{
+							EmitLeadSnake(diff, s);
+
+							while (s.ofs.x != s.end.x)
+							{
+								AxisUnit const& au = m_xAxis.m_axisUnits[(sizet) s.ofs.x];
+								for (sizet pos=au.m_leadPos; pos<=au.m_unitPos; ++pos)
+									diff.Add(DiffDisposition::Removed, *(*m_xAxis.m_occurrences)[pos].m_iu);
+								++s.ofs.x;
+							}
+
+							EmitTrailSnake(diff, s);
+							sections.Erase(0, 1);
+						}
+
+						// Trivial insertion?
+						else if (s.ofs.x == s.end.x)
+						{
+							EmitLeadSnake(diff, s);
+
+							while (s.ofs.y != s.end.y)
+							{
+								AxisUnit const& au = m_yAxis.m_axisUnits[(sizet) s.ofs.y];
+								for (sizet pos=au.m_leadPos; pos<=au.m_unitPos; ++pos)
+									diff.Add(DiffDisposition::Added, *(*m_yAxis.m_occurrences)[pos].m_iu);
+								++s.ofs.y;
+							}
+
+							EmitTrailSnake(diff, s);
+							sections.Erase(0, 1);
+						}
+
+						else
+						{
+							SplitPoint split;
+							FindSplitPoint(s, sc, split);
+
+							Coord end = s.end, trailSnakeEnd = s.trailSnakeEnd;
+							s = Section(s.leadSnakeOfs, s.ofs, split.ofs, split.ofs, split.limitSteps_left);
+							sections.Insert(1, split.ofs, split.ofs, end, trailSnakeEnd, split.limitSteps_right);
+						}
+					}
+					while (sections.Any());
+				}
+
+				// Splits the section the same way SolveSection would, until there are at least nrTarget sections, or no section can be split further.
+				// The largest section is split first. Solving the resulting sections in order produces the same output as solving the whole section
+				void SplitForParallel(Section whole, sizet nrTarget, Scratch& sc, Vec<Section>& sections) const
+				{
+					Vec<bool> canSplit;
+					sections.Add(whole);
+					canSplit.Add(true);
+
+					while (sections.Len() < nrTarget)
+					{
+						sizet best = SIZE_MAX;
+						ptrdiff bestSize {};
+						for (sizet i=0; i!=sections.Len(); ++i)
+							if (canSplit[i])
+							{
+								Section const& s = sections[i];
+								ptrdiff size = (s.end.x - s.ofs.x) + (s.end.y - s.ofs.y);
+								if (best == SIZE_MAX || size > bestSize)
+									{ best = i; bestSize = size; }
+							}
+
+						if (best == SIZE_MAX)
+							break;
+
+						Section& s = sections[best];
+						SkipSnakes(s);
+						if (s.ofs.y == s.end.y || s.ofs.x == s.end.x)
+							canSplit[best] = false;
+						else
+						{
+							SplitPoint split;
+							FindSplitPoint(s, sc, split);
+
+							Coord end = s.end, trailSnakeEnd = s.trailSnakeEnd;
+							s = Section(s.leadSnakeOfs, s.ofs, split.ofs, split.ofs, split.limitSteps_left);
+							sections.Insert(best + 1, split.ofs, split.ofs, end, trailSnakeEnd, split.limitSteps_right);
+							canSplit.Insert(best + 1, true);
+						}
+					}
+				}
+
+				void SkipSnakes(Section& s) const
+				{
+					// Skip leading snake, if any
+					while (s.ofs.x != s.end.x && s.ofs.y != s.end.y && UU_X(s.ofs.x) == UU_Y(s.ofs.y))
+						{ ++(s.ofs.x); ++(s.ofs.y); }
+
+					// Skip trailing snake, if any
+					while (s.end.x != s.ofs.x && s.end.y != s.ofs.y && UU_X(s.end.x - 1) == UU_Y(s.end.y - 1))
+						{ --(s.end.x); --(s.end.y); }
+				}
+
+				void EmitLeadSnake  (Vec<DiffUnit>& diff, Section s) const { EmitSnake(diff, s.leadSnakeOfs, s.ofs           ); }
+				void EmitTrailSnake (Vec<DiffUnit>& diff, Section s) const { EmitSnake(diff, s.end,          s.trailSnakeEnd ); }
+
+				void EmitSnake(Vec<DiffUnit>& diff, Coord ofs, Coord end) const
 				{
 					ptrdiff x = ofs.x, y = ofs.y;
 					for (; x!=end.x; ++x, ++y)
@@ -332,7 +631,7 @@ namespace At
 					void Set(Coord ofs_, bool lsLeft, bool lsRight) { ofs = ofs_; limitSteps_left = lsLeft; limitSteps_right = lsRight; }
 				};
 
-				void FindSplitPoint(Section s, SplitPoint& split)
+				void FindSplitPoint(Section s, Scratch& sc, SplitPoint& split) const
 				{
 					ptrdiff const dMin = Diag(s.ofs.x, s.end.y);
 					ptrdiff const dMax = Diag(s.end.x, s.ofs.y);
@@ -340,8 +639,9 @@ namespace At
 					ptrdiff const bMid = Diag(s.end.x, s.end.y);
 					bool odd = (0 != ((fMid - bMid) & 1));
 
-					FD_X(fMid) = s.ofs.x;
-					BD_X(bMid) = s.end.x;
+					sc.Reset(dMin, dMax);
+					sc.FD_X(fMid) = s.ofs.x;
+					sc.BD_X(bMid) = s.end.x;
 
 					ptrdiff fMin = fMid, fMax = fMid;
 					ptrdiff bMin = bMid, bMax = bMid;
@@ -350,28 +650,28 @@ namespace At
 					{
 						// Make an edit step forward
 						if (fMin > dMin)
-							FD_X(--fMin - 1) = -1;
+							sc.FD_X(--fMin - 1) = -1;
 						else
 							++fMin;
 
 						if (fMax < dMax)
-							FD_X(++fMax + 1) = -1;
+							sc.FD_X(++fMax + 1) = -1;
 						else
 							--fMax;
 
 						for (ptrdiff diag = fMax; diag >= fMin; diag -= 2)
 						{
-							ptrdiff tLo = FD_X(diag - 1);
-							ptrdiff tHi = FD_X(diag + 1);
+							ptrdiff tLo = sc.FD_X(diag - 1);
+							ptrdiff tHi = sc.FD_X(diag + 1);
 							ptrdiff xStart = tLo < tHi ? tHi : tLo + 1;
 
 							ptrdiff x = xStart, y = xStart - diag;
 							while (x < s.end.x && y < s.end.y && UU_X(x) == UU_Y(y))
 								{ ++x; ++y; }
 
-							FD_X(diag) = x;
+							sc.FD_X(diag) = x;
 
-							if (odd && diag >= bMin && diag <= bMax && BD_X(diag) <= x)
+							if (odd && diag >= bMin && diag <= bMax && sc.BD_X(diag) <= x)
 							{
 								split.Set(Coord(x, y), false, false);
 								return;
@@ -380,28 +680,28 @@ namespace At
 
 						// Make an edit step backward
 						if (bMin > dMin)
-							BD_X(--bMin - 1) = PTRDIFF_MAX;
+							sc.BD_X(--bMin - 1) = PTRDIFF_MAX;
 						else
 							++bMin;
 
 						if (bMax < dMax)
-							BD_X(++bMax + 1) = PTRDIFF_MAX;
+							sc.BD_X(++bMax + 1) = PTRDIFF_MAX;
 						else
 							--bMax;
 
 						for (ptrdiff diag = bMax; diag >= bMin; diag -= 2)
 						{
-							ptrdiff tLo = BD_X(diag - 1);
-							ptrdiff tHi = BD_X(diag + 1);
+							ptrdiff tLo = sc.BD_X(diag - 1);
+							ptrdiff tHi = sc.BD_X(diag + 1);
 							ptrdiff xStart = tLo < tHi ? tLo : tHi - 1;
 
 							ptrdiff x = xStart, y = xStart - diag;
 							while (x > s.ofs.x && y > s.ofs.y && UU_X(x-1) == UU_Y(y-1))
 								{ --x; --y; }
 
-							BD_X(diag) = x;
+							sc.BD_X(diag) = x;
 
-							if (!odd && diag >= fMin && diag <= fMax && x <= FD_X(diag))
+							if (!odd && diag >= fMin && diag <= fMax && x <= sc.FD_X(diag))
 							{
 								split.Set(Coord(x, y), false, false);
 								return;
@@ -415,7 +715,7 @@ namespace At
 					ptrdiff fMaxXY = -1, fBestX {};
 					for (ptrdiff diag = fMax; diag >= fMin; diag -= 2)
 					{
-						ptrdiff x = PickMin(FD_X(diag), s.end.x);
+						ptrdiff x = PickMin(sc.FD_X(diag), s.end.x);
 						ptrdiff y = x - diag;
 						
 						if (y > s.end.y)
@@ -435,7 +735,7 @@ namespace At
 					ptrdiff bMinXY = PTRDIFF_MAX, bBestX {};
 					for (ptrdiff diag = bMax; diag >= bMin; diag -= 2)
 					{
-						ptrdiff x = PickMax(BD_X(diag), s.ofs.x);
+						ptrdiff x = PickMax(sc.BD_X(diag), s.ofs.x);
 						ptrdiff y = x - diag;
 
 						if (y < s.ofs.y)
@@ -515,12 +815,16 @@ namespace At
 
 			if (inputOld.Any())
 			{
+				uint nrThreads = params.m_maxThreads;
+				if (!nrThreads)
+					nrThreads = PickMax<uint>(std::thread::hardware_concurrency(), 1);
+
 				UniqueUnitView uuv;
-				uuv.Build(inputOld, inputNew);
+				uuv.Build(inputOld, inputNew, nrThreads);
 
 				Diagonalizer diag;
 				diag.Build(uuv);
-				diag.Process(diff, params);
+				diag.Process(diff, params, nrThreads);
 			}
 		}
 
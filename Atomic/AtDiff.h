@@ -21,6 +21,11 @@ namespace At
 		{
 			// Disable to find the minimal edit script, regardless of number of steps
 			bool m_limitSteps { true };
+
+			// Maximum number of threads to use for large inputs. 1 = solve sequentially; 0 = number of logical processors.
+			// Additional threads come from a pool shared by all calls to Generate in the process, at most 64 of them.
+			// The output does not depend on the number of threads
+			uint m_maxThreads { 1 };
 		};
 
 		enum class DiffDisposition { Unchanged, Added, Removed };
@@ -39,6 +44,7 @@ namespace At
 		// - Good worst-case performance: for large inputs, space/time cost is O(max(N,M)), but might not find best diff for large and complex inputs.
 		// - Does not use recursion: uses a sliding matrix that is limited in width for easy control of the quality/performance tradeoff.
 		// - Trivially handles common head and tail: the matrix algorithm is used between first and last difference in the inputs.
+		// - Can use multiple threads for large inputs, if enabled in DiffParams: units are hashed in parallel, and independent sections of the matrix are solved in parallel.
 		void Generate(Slice<InputUnit> inputOld, Slice<InputUnit> inputNew, Vec<DiffUnit>& diff, DiffParams const& params);
 
 	}
@@ -0,0 +1,210 @@
+#include "AtIncludes.h"
+#include "AtDiffDelta.h"
+
+#include "AtEncode.h"
+
+
+namespace At
+{
+	namespace Diff
+	{
+		namespace
+		{
+
+			// Lines include their line terminators, so that the byte ranges of consecutive lines are contiguous.
+			// Line starts are followed by the length of the text, so that line i spans [lineStarts[i], lineStarts[i+1]).
+			void SplitLines(Seq text, Vec<InputUnit>& input, Vec<sizet>& lineStarts)
+			{
+				Seq reader = text;
+				while (reader.n)
+				{
+					sizet lineStart = (sizet) (reader.p - text.p);
+					reader.DropToByte('\n').DropByte();
+					sizet lineEnd = (sizet) (reader.p - text.p);
+
+					input.Add(input.Len(), Seq(text.p + lineStart, lineEnd - lineStart));
+					lineStarts.Add(lineStart);
+				}
+
+				lineStarts.Add(text.n);
+			}
+
+
+			struct DeltaHunk
+			{
+				sizet m_copyLen;
+				Seq   m_removed;
+				Seq   m_added;
+
+				DeltaHunk(sizet copyLen, Seq removed, Seq added) : m_copyLen(copyLen), m_removed(removed), m_added(added) {}
+			};
+
+
+			class DeltaBuilder
+			{
+			public:
+				Vec<DeltaHunk> m_hunks;
+
+				void Unchanged(sizet n) { m_copyLen += n; }
+
+				void Changed(Seq removed, Seq added)
+				{
+					sizet prefixLen {};
+					while (prefixLen != removed.n && prefixLen != added.n && removed.p[prefixLen] == added.p[prefixLen])
+						++prefixLen;
+
+					removed.DropBytes(prefixLen);
+					added.DropBytes(prefixLen);
+					m_copyLen += prefixLen;
+
+					sizet suffixLen {};
+					while (suffixLen != removed.n && suffixLen != added.n && removed.p[removed.n - 1 - suffixLen] == added.p[added.n - 1 - suffixLen])
+						++suffixLen;
+
+					removed.n -= suffixLen;
+					added.n -= suffixLen;
+
+					if (removed.n || added.n)
+					{
+						m_hunks.Add(m_copyLen, removed, added);
+						m_copyLen = 0;
+					}
+
+					m_copyLen += suffixLen;
+				}
+
+			private:
+				sizet m_copyLen {};
+			};
+
+
+			bool ApplyDelta(Seq delta, Seq src, Enc& out, bool forward)
+			{
+				uint64 oldLen, newLen, nrHunks;
+				if (!DecodeVarUInt64(delta, oldLen)) return false;
+				if (!DecodeVarUInt64(delta, newLen)) return false;
+				if (!DecodeVarUInt64(delta, nrHunks)) return false;
+
+				uint64 const srcLen = forward ? oldLen : newLen;
+				uint64 const outLen = forward ? newLen : oldLen;
+				if (src.n != srcLen) return false;
+				if (outLen > src.n + delta.n) return false;		// Output consists only of bytes from the source and the delta
+
+				Enc::Meter meter = out.IncMeter((sizet) outLen);
+
+				for (uint64 i=0; i!=nrHunks; ++i)
+				{
+					uint64 copyLen;
+					Seq removed, added;
+					if (!DecodeVarUInt64(delta, copyLen)) return false;
+					if (!DecodeVarStr(delta, removed)) return false;
+					if (!DecodeVarStr(delta, added)) return false;
+
+					Seq from = forward ? removed : added;
+					Seq to   = forward ? added : removed;
+
+					if (copyLen > src.n) return false;
+					out.Add(src.ReadBytes((sizet) copyLen));
+
+					if (!src.StartsWithExact(from)) return false;
+					src.DropBytes(from.n);
+
+					if (meter.WrittenLen() + to.n > outLen) return false;
+					out.Add(to);
+				}
+
+				if (delta.n) return false;
+
+				out.Add(src);
+				return meter.Met();
+			}
+
+		}	// anon
+
+
+		void EncodeDelta(Enc& enc, Seq oldText, Seq newText, DiffParams const& params)
+		{
+			Vec<InputUnit> inputOld, inputNew;
+			Vec<sizet> startsOld, startsNew;
+			SplitLines(oldText, inputOld, startsOld);
+			SplitLines(newText, inputNew, startsNew);
+
+			Vec<DiffUnit> diff;
+			Generate(inputOld, inputNew, diff, params);
+
+			// Generate does not output unchanged lines. They are implied by gaps in sequence numbers
+			DeltaBuilder builder;
+			sizet oldPos {}, newPos {}, regionOld {}, regionNew {};
+
+			auto emitRegion = [&] ()
+				{
+					sizet nrOld = oldPos - regionOld;
+					sizet nrNew = newPos - regionNew;
+					if (nrOld == nrNew)
+					{
+						for (sizet i=0; i!=nrOld; ++i)
+						{
+							Seq lineOld = inputOld[regionOld + i].m_value;
+							Seq lineNew = inputNew[regionNew + i].m_value;
+							builder.Changed(lineOld, lineNew);
+						}
+					}
+					else
+					{
+						Seq blockOld { oldText.p + startsOld[regionOld], startsOld[oldPos] - startsOld[regionOld] };
+						Seq blockNew { newText.p + startsNew[regionNew], startsNew[newPos] - startsNew[regionNew] };
+						builder.Changed(blockOld, blockNew);
+					}
+				};
+
+			for (DiffUnit const& u : diff)
+			{
+				bool removed = (u.m_disposition == DiffDisposition::Removed);
+				EnsureThrow(removed || u.m_disposition == DiffDisposition::Added);
+
+				sizet nrSame = u.m_inputUnit.m_seqNr - (removed ? oldPos : newPos);
+				if (nrSame)
+				{
+					emitRegion();
+					builder.Unchanged(startsOld[oldPos + nrSame] - startsOld[oldPos]);
+					oldPos += nrSame;
+					newPos += nrSame;
+					regionOld = oldPos;
+					regionNew = newPos;
+				}
+
+				if (removed)
+					++oldPos;
+				else
+					++newPos;
+			}
+
+			emitRegion();
+
+			// Encode
+			sizet encodedSize = EncodeVarUInt64_Size(oldText.n) + EncodeVarUInt64_Size(newText.n) + EncodeVarUInt64_Size(builder.m_hunks.Len());
+			for (DeltaHunk const& hunk : builder.m_hunks)
+				encodedSize += EncodeVarUInt64_Size(hunk.m_copyLen) + EncodeVarStr_Size(hunk.m_removed.n) + EncodeVarStr_Size(hunk.m_added.n);
+
+			Enc::Meter meter = enc.IncMeter(encodedSize);
+
+			EncodeVarUInt64(enc, oldText.n);
+			EncodeVarUInt64(enc, newText.n);
+			EncodeVarUInt64(enc, builder.m_hunks.Len());
+
+			for (DeltaHunk const& hunk : builder.m_hunks)
+			{
+				EncodeVarUInt64 (enc, hunk.m_copyLen);
+				EncodeVarStr    (enc, hunk.m_removed);
+				EncodeVarStr    (enc, hunk.m_added);
+			}
+
+			EnsureThrow(meter.Met());
+		}
+
+
+		bool ApplyDeltaForward  (Seq delta, Seq oldText, Enc& newText) { return ApplyDelta(delta, oldText, newText, true  ); }
+		bool ApplyDeltaBackward (Seq delta, Seq newText, Enc& oldText) { return ApplyDelta(delta, newText, oldText, false ); }
+
+	}
+}
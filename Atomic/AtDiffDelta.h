@@ -0,0 +1,33 @@
+#pragma once
+
+#include "AtDiff.h"
+#include "AtEnc.h"
+
+
+namespace At
+{
+	namespace Diff
+	{
+
+		// A delta is a compact binary encoding of the differences between two versions of a text. It can be applied in either direction:
+		// to the old text to obtain the new text, or to the new text to obtain the old text. A history store can therefore keep one full
+		// version of a text, and a delta for each of the other versions.
+		//
+		// Texts are compared line by line using Generate. Where a block of removed lines is replaced with a block of added lines,
+		// the delta stores only the bytes that differ: lines are paired if the blocks have the same number of lines, and each pair
+		// (or the block as a whole, if not paired) is narrowed by excluding its common leading and trailing bytes.
+		//
+		// Format, using EncodeVarUInt64 and EncodeVarStr:
+		// - old text length, new text length, number of hunks
+		// - for each hunk: number of bytes to copy unchanged, bytes removed from old text, bytes added in new text
+		// - any bytes after the last hunk are copied unchanged
+
+		void EncodeDelta(Enc& enc, Seq oldText, Seq newText, DiffParams const& params);
+
+		// Return false if the delta is malformed, or if it was not created from the text to which it is being applied.
+		// In this case, output may have been partially written.
+		bool ApplyDeltaForward  (Seq delta, Seq oldText, Enc& newText);
+		bool ApplyDeltaBackward (Seq delta, Seq newText, Enc& oldText);
+
+	}
+}
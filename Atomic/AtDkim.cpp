@@ -79,92 +79,189 @@ namespace At
 			}
 
 
-			Seq CanonicalizeMessageBody_Simple(Seq body, Str& storage)
+			// Passes a canonicalized body to a hash in pieces, so that the canonicalized body is never stored in full.
+			// Bytes beyond maxLen are counted, but not hashed. Small pieces are collected into a buffer before being hashed.
+
+			class CanonBodyHasher : NoCopy
 			{
-				if (!body.EndsWithExact("\r\n"))
-					return storage.Clear().ReserveExact(body.n + 2).Add(body).Add("\r\n");
+			public:
+				CanonBodyHasher(Hash& hash, uint64 maxLen) : m_hash(hash), m_maxLen(maxLen) {}
 
-				while (body.EndsWithExact("\r\n\r\n"))
-					body.n -= 2;
-				return body;
-			}
+				void Add(Seq s)
+				{
+					uint64 toHash = PickMin<uint64>(s.n, m_maxLen - PickMin<uint64>(m_len, m_maxLen));
+					m_len += s.n;
+					if (toHash)
+						AddToHash(Seq(s.p, (sizet) toHash));
+				}
+
+				void Final() { Flush(); }
+
+				uint64 Len() const { return m_len; }
+
+			private:
+				enum { BufSize = 4096 };
+
+				Hash&  m_hash;
+				uint64 m_maxLen;
+				uint64 m_len    {};
+				sizet  m_bufLen {};
+				byte   m_buf[BufSize];
+
+				void AddToHash(Seq s)
+				{
+					if (m_bufLen + s.n > BufSize)
+						Flush();
+
+					if (s.n >= BufSize)
+						m_hash.Process(s);
+					else
+					{
+						memcpy(m_buf + m_bufLen, s.p, s.n);
+						m_bufLen += s.n;
+					}
+				}
+
+				void Flush()
+				{
+					if (m_bufLen)
+					{
+						m_hash.Process(Seq(m_buf, m_bufLen));
+						m_bufLen = 0;
+					}
+				}
+			};
 
 
-			Seq CanonicalizeMessageBody_Relaxed(Seq body, Str& storage)
+			void HashMessageBody_Simple(Seq body, CanonBodyHasher& out)
 			{
-				storage.Clear().ReserveExact(body.n);
+				if (!body.EndsWithExact("\r\n"))
+				{
+					out.Add(body);
+					out.Add("\r\n");
+				}
+				else
+				{
+					while (body.EndsWithExact("\r\n\r\n"))
+						body.n -= 2;
+					out.Add(body);
+				}
+			}
 
-				if (body.n)
+
+			void HashMessageBody_Relaxed(Seq body, CanonBodyHasher& out)
+			{
+				// Line breaks are output only when followed by a non-empty line, so that empty lines at the end of the body are ignored
+				sizet nrPendingCrlf {};
+				while (body.n)
 				{
-					do
+					Seq line = body.ReadToString("\r\n");
+					body.DropBytes(2);
+
+					bool appendWs {}, lineEmpty { true };
+					while (line.n)
 					{
-						Seq line = body.ReadToString("\r\n");
-						bool appendWs = false;
-						while (line.n)
+						Seq chunk = line.ReadToFirstByteOf(c_zWs);
+						if (chunk.n)
 						{
-							Seq chunk = line.ReadToFirstByteOf(c_zWs);
-							if (chunk.n)
+							if (lineEmpty)
 							{
-								if (appendWs)
-									storage.Ch(' ');
-								storage.Add(chunk);
+								for (; nrPendingCrlf; --nrPendingCrlf)
+									out.Add("\r\n");
+								lineEmpty = false;
 							}
 
-							line.DropToFirstByteNotOf(c_zWs);
-							appendWs = true;
+							if (appendWs)
+								out.Add(" ");
+							out.Add(chunk);
 						}
 
-						body.DropBytes(2);
-						storage.Add("\r\n");
+						line.DropToFirstByteNotOf(c_zWs);
+						appendWs = true;
 					}
-					while (body.n);
 
-					while (Seq(storage).EndsWithExact("\r\n\r\n"))
-						storage.ResizeExact(storage.Len() - 2);
+					++nrPendingCrlf;
 				}
 
-				return storage;
+				if (nrPendingCrlf)
+					out.Add("\r\n");
 			}
 
 		}	// anon
 
 
 
+		// HdrField
+
+		bool SplitMessage(Seq message, Vec<HdrField>& fields, Seq& body)
+		{
+			fields.Clear();
+
+			Seq reader = message;
+			while (reader.n && !reader.StartsWithExact("\r\n"))
+			{
+				Seq fieldStart = reader;
+
+				Seq name = reader.ReadToFirstByteOf(":\r\n");
+				if (!reader.StartsWithByte(':'))
+					return false;
+
+				while (name.n && (name.p[name.n - 1] == ' ' || name.p[name.n - 1] == '\t'))
+					--name.n;
+				if (!name.n)
+					return false;
+
+				for (sizet i=0; i!=name.n; ++i)
+					if (name.p[i] < 33 || name.p[i] > 126)
+						return false;
+
+				// Read to the end of the field, including any continuation lines
+				do
+				{
+					reader.DropToString("\r\n");
+					if (!reader.StartsWithExact("\r\n"))
+						return false;
+					reader.DropBytes(2);
+				}
+				while (reader.StartsWithByte(' ') || reader.StartsWithByte('\t'));
+
+				HdrField& field = fields.Add();
+				field.m_name = name;
+				field.m_field = Seq(fieldStart.p, (sizet) (reader.p - fieldStart.p));
+			}
+
+			body = reader.DropBytes(2);		// Empty if the header reaches the end of input
+			return true;
+		}
+
+
+
 		// SignMessage
 
 		void SignMessage(RsaSigner& signer, Seq sdid, Seq selector, Seq message, Str& sigField)
 		{
-			ParseTree pt { message };
-			if (!pt.Parse(C_message))
+			Vec<HdrField> fields;
+			Seq body;
+			if (!SplitMessage(message, fields, body))
 				throw InputErr("DkimSignMessage: Input message could not be parsed");
 
-			ParseNode const& messageFieldsNode = pt.Root().FrontFindRef(id_message_fields);
-			ParseNode const& mainFieldsNode = messageFieldsNode.FlatFindRef(id_main_fields);
-
-			struct FieldInfo
-			{
-				FieldInfo(Ruid const& type) : m_type(type) {}
-			
-				Ruid const& m_type;
-				bool        m_present {};
-			};
-
-			FieldInfo signFields[] =
-				{	id_orig_date, id_from, id_sender, id_reply_to,															// Imf::C_origin_field
-					id_to, id_cc, id_bcc,																					// Imf::C_dest_field
-					id_message_id, id_in_reply_to, id_references,															// Imf::C_id_field
-					id_subject, id_comments, id_keywords,																	// Imf::C_info_field
-					id_mime_version, id_content_type, id_content_enc, id_content_id, id_content_desc, id_content_disp };	// Mime::C_msg_header_field
+			char const* const c_signFieldNames[] =
+				{	"Date", "From", "Sender", "Reply-To",																	// Imf::C_origin_field
+					"To", "Cc", "Bcc",																						// Imf::C_dest_field
+					"Message-ID", "In-Reply-To", "References",																// Imf::C_id_field
+					"Subject", "Comments", "Keywords",																		// Imf::C_info_field
+					"MIME-Version", "Content-Type", "Content-Transfer-Encoding",											// Mime::C_msg_header_field
+					"Content-ID", "Content-Description", "Content-Disposition" };
 			
 			Vec<Seq> fieldsToSign;
 			fieldsToSign.ReserveExact(20);
 
-			for (ParseNode const& c : mainFieldsNode)
-				for (FieldInfo& fi : signFields)
-					if (c.IsType(fi.m_type))
+			for (HdrField const& field : fields)
+				for (char const* z : c_signFieldNames)
+					if (field.m_name.EqualInsensitive(z))
 					{
-						fi.m_present = true;
-						fieldsToSign.Add(c.SrcText());
+						fieldsToSign.Add(field.m_field);
+						break;
 					}
 
 			sigField.Clear().ReserveExact(1000)
@@ -174,15 +271,14 @@ namespace At
 			Str normFields;
 			SignMessage_CollectHeaderFields_Relaxed(fieldsToSign, sigField, normFields);
 
-			Seq body;
-			ParseNode const* bodyNode = pt.Root().FirstChild().FlatFind(id_body);
-			if (bodyNode)
-				body = bodyNode->SrcText();
-
-			Str normBodyStorage;
-			Seq normBody = CanonicalizeMessageBody_Relaxed(body, normBodyStorage);
+			Hash hash;
+			hash.Create(CALG_SHA_256);
+			CanonBodyHasher hasher { hash, UINT64_MAX };
+			HashMessageBody_Relaxed(body, hasher);
+			hasher.Final();
 
-			Str bh = Hash::HashOf(normBody, CALG_SHA_256);
+			Str bh;
+			hash.Final(bh);
 			sigField.Add(";\r\n  bh=");
 			Base64::MimeEncode(bh, sigField, Base64::Padding::Yes, Base64::NewLines::None());
 			sigField.Add(";\r\n  b=");
@@ -220,16 +316,23 @@ namespace At
 		void SigVerifier::ReadSignatures()
 		{
 			m_sigs.Clear();
+			m_bodyHashes.Clear();
 
-			ParseNode const& msgFieldsNode = m_pt.Root().FrontFindRef(id_message_fields);
-			for (ParseNode const& fieldsNode : msgFieldsNode)
-				for (ParseNode const& fieldNode : fieldsNode)
-					if (fieldNode.IsType(id_dkim_signature))
-						ReadSignature(msgFieldsNode, fieldNode);
+			if (!SplitMessage(m_message, m_fields, m_body))
+				throw InputErr("DkimSigVerifier: Message header could not be parsed");
+
+			// Only DKIM-Signature fields are parsed. A field that does not parse as a signature is ignored, as when parsing the whole message
+			for (HdrField const& field : m_fields)
+				if (field.m_name.EqualInsensitive("DKIM-Signature"))
+				{
+					ParseTree pt { field.m_field };
+					if (pt.Parse(C_dkim_signature))
+						ReadSignature(pt.Root().FirstChild());
+				}
 		}
 
 
-		bool SigVerifier::ReadSignature(ParseNode const& msgFieldsNode, ParseNode const& sigNode)
+		bool SigVerifier::ReadSignature(ParseNode const& sigNode)
 		{
 			SigInfo& sig = m_sigs.Add();
 			Seq encodedSigValue;
@@ -392,7 +495,7 @@ namespace At
 			if (!Seq(sig.m_bodyHashCalculated).ConstTimeEqualExact(sig.m_bodyHashEncoded))
 				return sig.SetFail("Encoded body hash does not match calculated");
 
-			ConstructSigInput(msgFieldsNode, sigNode, sig, encodedSigValue);
+			ConstructSigInput(sigNode.SrcText(), sig, encodedSigValue);
 			sig.m_state = SigState::Parsed;
 			return true;
 		}
@@ -400,66 +503,76 @@ namespace At
 
 		bool SigVerifier::CalculateBodyHash(SigInfo& sig)
 		{
-			// Canonicalize message body
-			Seq origBody;
-			ParseNode const* bodyNode = m_pt.Root().FirstChild().FlatFind(id_body);
-			if (bodyNode)
-				origBody = bodyNode->SrcText();
-
-			Str canonBodyStorage;
-			Seq canonBody;
-			     if (sig.m_bodyCanon == SigCanon::Simple  ) canonBody = CanonicalizeMessageBody_Simple  (origBody, canonBodyStorage);
-			else if (sig.m_bodyCanon == SigCanon::Relaxed ) canonBody = CanonicalizeMessageBody_Relaxed (origBody, canonBodyStorage);
-			else EnsureThrow(!"Unexpected body canonicalization algorithm");
+			auto sameLen = [] (Opt<uint64> const& a, Opt<uint64> const& b) -> bool
+				{ return a.Any() ? (b.Any() && a.Ref() == b.Ref()) : !b.Any(); };
 
-			// Determine how much of the canonicalized body to sign
-			Seq canonBodyReader = canonBody;
-			Seq bytesToHash;
-			if (!sig.m_bodyLenSigned.Any())
-				bytesToHash = canonBodyReader.ReadBytes(SIZE_MAX);
-			else
-			{
-				uint64 lenSigned64 = sig.m_bodyLenSigned.Ref();
-				if (lenSigned64 > canonBodyReader.n) return sig.SetFail("Specified body length exceeds canonicalized body size");
-				bytesToHash = canonBodyReader.ReadBytes((sizet) lenSigned64);
-			}
+			for (BodyHash const& bh : m_bodyHashes)
+				if (bh.m_canon == sig.m_bodyCanon && bh.m_alg == sig.m_alg && sameLen(bh.m_lenSigned, sig.m_bodyLenSigned))
+				{
+					if (bh.m_lenExceeded)
+						return sig.SetFail("Specified body length exceeds canonicalized body size");
+
+					sig.m_bodyLenUnsigned = bh.m_lenUnsigned;
+					sig.m_bodyHashCalculated = bh.m_hash;
+					return true;
+				}
 
-			sig.m_bodyLenUnsigned = canonBodyReader.n;
+			BodyHash& bh = m_bodyHashes.Add();
+			bh.m_canon = sig.m_bodyCanon;
+			bh.m_alg = sig.m_alg;
+			bh.m_lenSigned = sig.m_bodyLenSigned;
 
-			// Hash canonicalized body
 			ALG_ID algId {};
 			     if (sig.m_alg == SigAlg::RsaSha1   ) algId = CALG_SHA1;
 			else if (sig.m_alg == SigAlg::RsaSha256 ) algId = CALG_SHA_256;
 			else EnsureThrow(!"Unexpected signature algorithm");
 
-			sig.m_bodyHashCalculated = Hash::HashOf(bytesToHash, algId);
+			// Canonicalize and hash message body in one pass, hashing only as much of the canonicalized body as is signed
+			Hash hash;
+			hash.Create(algId);
+			uint64 lenSigned = sig.m_bodyLenSigned.Any() ? sig.m_bodyLenSigned.Ref() : UINT64_MAX;
+			CanonBodyHasher hasher { hash, lenSigned };
+
+			     if (sig.m_bodyCanon == SigCanon::Simple  ) HashMessageBody_Simple  (m_body, hasher);
+			else if (sig.m_bodyCanon == SigCanon::Relaxed ) HashMessageBody_Relaxed (m_body, hasher);
+			else EnsureThrow(!"Unexpected body canonicalization algorithm");
+
+			hasher.Final();
+
+			if (sig.m_bodyLenSigned.Any() && lenSigned > hasher.Len())
+			{
+				bh.m_lenExceeded = true;
+				return sig.SetFail("Specified body length exceeds canonicalized body size");
+			}
+
+			if (sig.m_bodyLenSigned.Any())
+				bh.m_lenUnsigned = (sizet) (hasher.Len() - lenSigned);
+
+			hash.Final(bh.m_hash);
+
+			sig.m_bodyLenUnsigned = bh.m_lenUnsigned;
+			sig.m_bodyHashCalculated = bh.m_hash;
 			return true;
 		}
 
 
-		void SigVerifier::ConstructSigInput(ParseNode const& msgFieldsNode, ParseNode const& sigNode, SigInfo& sig, Seq encodedSigValue)
+		void SigVerifier::ConstructSigInput(Seq origSigField, SigInfo& sig, Seq encodedSigValue)
 		{
-			// Build list of fields in message
-			struct FieldInfo { Seq m_name, m_field; };
-			Vec<FieldInfo> fields;
-
-			for (ParseNode const& fieldsNode : msgFieldsNode)
-				for (ParseNode const& fieldNode : fieldsNode)
-				{
-					FieldInfo& fi = fields.Add();
-					fi.m_name = fieldNode.FrontFindRef(id_field_name).SrcText();
-					fi.m_field = fieldNode.SrcText();
-				}
+			// Copy list of fields in message, so that fields can be cleared as they are used
+			Vec<HdrField> fields;
+			fields.ReserveExact(m_fields.Len());
+			for (HdrField const& field : m_fields)
+				fields.Add(field);
 
 			// Collect and canonicalize header fields
-			sig.m_sigInputToVerify.Clear().ReserveExact(msgFieldsNode.SrcText().n);
+			sig.m_sigInputToVerify.Clear().ReserveExact((sizet) (m_body.p - m_message.p));
 
 			for (Seq fieldName : sig.m_hdrsSigned)
 			{
 				// Search fields by name starting with last. If field not found, ignore (it is signed as a null input)
 				for (sizet i=fields.Len(); i!=0; )
 				{
-					FieldInfo& fi = fields[--i];
+					HdrField& fi = fields[--i];
 					if (fi.m_name.n && fi.m_name.EqualInsensitive(fieldName))
 					{
 						AddSigInputField(sig, fi.m_field);
@@ -474,7 +587,6 @@ namespace At
 			}
 
 			// Construct and append a version of the DKIM-Signature field with the signature value removed
-			Seq origSigField = sigNode.SrcText();
 			EnsureThrow(origSigField.p < encodedSigValue.p);
 			EnsureThrow(origSigField.p + origSigField.n >= encodedSigValue.p + encodedSigValue.n);
 
@@ -14,9 +14,27 @@ namespace At
 
 
 
+		// HdrField
+
+		// A header field located in a message without parsing its content. Used for signing and verification, which need only
+		// field names and source text, and the location of the body.
+
+		struct HdrField
+		{
+			Seq m_name;			// Field name without trailing whitespace
+			Seq m_field;		// Source text of the whole field, including the final CRLF
+		};
+
+		// Returns false if the header section contains a line that is neither a field nor a continuation of one. A message
+		// that consists of only the header, without an empty line after it, has an empty body. This is more permissive than
+		// Imf::C_message, which also checks the syntax of known fields.
+		bool SplitMessage(Seq message, Vec<HdrField>& fields, Seq& body);
+
+
+
 		// Signing
 
-		// Parses the message and produces a DKIM signature using the provided signing key and Signing Domain ID and selector.
+		// Locates header fields and body in the message and produces a DKIM signature using the provided signing key and Signing Domain ID and selector.
 		// Produces a string containing a DKIM-Signature field terminated by CRLF. This should be prepended to the message.
 		// Uses rsa-sha256.
 		//
@@ -104,12 +122,16 @@ namespace At
 		};
 
 
+		// Body hashes are calculated once for each distinct combination of body canonicalization, algorithm, and signed length,
+		// so that a message with several signatures over the same body is canonicalized and hashed only once.
+
 		class SigVerifier
 		{
 		public:
-			SigVerifier(ParseTree const& ptMessage) : m_pt(ptMessage) {}
+			SigVerifier(Seq message) : m_message(message) {}
 
-			// Parses message, calculates hashes, makes signatures available. Throws on failure.
+			// Locates header fields and body, parses DKIM-Signature fields, calculates hashes, makes signatures available.
+			// Throws on failure.
 			void ReadSignatures();
 
 			// Becomes available (initialized) if LoadMessage() is successful.
@@ -121,12 +143,25 @@ namespace At
 			void VerifySignatures();
 
 		private:
-			ParseTree const& m_pt;
+			struct BodyHash
+			{
+				SigCanon      m_canon        { SigCanon::Simple };
+				SigAlg        m_alg          { SigAlg::None };
+				Opt<uint64>   m_lenSigned;
+				bool          m_lenExceeded  {};
+				sizet         m_lenUnsigned  {};
+				Str           m_hash;										// Binary
+			};
+
+			Seq              m_message;
+			Vec<HdrField>    m_fields;
+			Seq              m_body;
+			Vec<BodyHash>    m_bodyHashes;
 			Vec<SigInfo>     m_sigs;
 
-			bool ReadSignature     (ParseNode const& msgFieldsNode, ParseNode const& sigNode);
+			bool ReadSignature     (ParseNode const& sigNode);
 			bool CalculateBodyHash (SigInfo& sig);
-			void ConstructSigInput (ParseNode const& msgFieldsNode, ParseNode const& sigNode, SigInfo& sig, Seq encodedSigValue);
+			void ConstructSigInput (Seq origSigField, SigInfo& sig, Seq encodedSigValue);
 			void AddSigInputField  (SigInfo& sig, Seq field);
 		};
 
@@ -17,9 +17,35 @@ namespace At
 
 	// EllipticCurve
 
+	EllipticCurve::EllipticCurve(EcParams const& params)
+		: mc_prime(params.Prime()), mc_ident(params.Ident()), mc_a(params.A()), mc_b(params.B())
+	{
+		if (P256Field::IsPrime(mc_prime))
+		{
+			m_isP256 = true;
+			m_p256_ident.Set(mc_ident);
+			m_p256_a.Set(mc_a);
+			m_p256_b.Set(mc_b);
+		}
+	}
+
+
 	void EllipticCurve::CalculateY(MpUInt const& x, bool yOdd, MpUInt& y)
 	{
-		y = x.PowModS(3, mc_prime).AddM(x.MulM(mc_a)).AddM(mc_b).PowModM(mc_ident, mc_prime);
+		if (m_isP256 && x < mc_prime)
+		{
+			// y = (x^3 + ax + b) ^ ident = ((x^2 + a) * x + b) ^ ident
+			P256Field::Elem xe { x }, t;
+			P256Field::Sqr(xe, t);
+			P256Field::Add(t, m_p256_a, t);
+			P256Field::Mul(t, xe, t);
+			P256Field::Add(t, m_p256_b, t);
+			P256Field::Pow(t, m_p256_ident, t);
+			t.Get(y);
+		}
+		else
+			y = x.PowModS(3, mc_prime).AddM(x.MulM(mc_a)).AddM(mc_b).PowModM(mc_ident, mc_prime);
+
 		bool odd = ((y.GetByte(0) & 1) == 1);
 		if (odd != yOdd)
 			y = mc_prime.SubM(y);
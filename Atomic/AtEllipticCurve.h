@@ -1,6 +1,6 @@
 #pragma once
 
-#include "AtMpUInt.h"
+#include "AtMpFixed.h"
 
 namespace At
 {
@@ -35,10 +35,16 @@ namespace At
 		MpUInt const mc_a;
 		MpUInt const mc_b;
 
-		EllipticCurve(EcParams const& params) : mc_prime(params.Prime()), mc_ident(params.Ident()), mc_a(params.A()), mc_b(params.B()) {}
+		EllipticCurve(EcParams const& params);
 
-		// In the current implementation using MpUInt, this is a relatively expensive operation: on the order of 6 ms using nistp256.
+		// For nistp256, uses P256Field with Solinas reduction. For other curves, uses MpUInt::PowModM, which uses Montgomery arithmetic.
 		void CalculateY(MpUInt const& x, bool yOdd, MpUInt& y);
+
+	private:
+		bool            m_isP256 {};
+		P256Field::Elem m_p256_ident;
+		P256Field::Elem m_p256_a;
+		P256Field::Elem m_p256_b;
 	};
 
 }
@@ -21,6 +21,25 @@ namespace At
 		return html.EndHtml().Final();
 	}
 
+
+	Str EncodeEmailTextBody_New(RenderCache& cache, Seq mkdnText, ObjId owner, uint64 version)
+	{
+		Str text;
+		text.ReserveExact(2 * mkdnText.n);
+		if (!Markdown::CachedToText(cache, mkdnText, owner, version, text))
+			throw InputErr("Email body could not be parsed as Markdown");
+		return text;
+	}
+
+
+	Str EncodeEmailHtmlBody_New(RenderCache& cache, Seq mkdnText, bool permitLinks, ObjId owner, uint64 version)
+	{
+		HtmlBuilder html { 2 * mkdnText.n };
+		if (!Markdown::CachedToHtml(cache, mkdnText, permitLinks, owner, version, html))
+			throw InputErr("Email body could not be parsed as Markdown");
+		return html.EndHtml().Final();
+	}
+
 /*
 	Str EncodeEmailTextBody_ReplyOrForward(Markdown::Transform const& mkdn, Imf::Message const& origMsg, Seq origText)
 	{
@@ -8,6 +8,10 @@ namespace At
 	Str EncodeEmailTextBody_New(Markdown::Transform const& mkdn);
 	Str EncodeEmailHtmlBody_New(Markdown::Transform const& mkdn);
 
+	// Reuse the rendering of a body that is sent repeatedly, e.g. to many recipients. Throw InputErr if the body cannot be parsed
+	Str EncodeEmailTextBody_New(RenderCache& cache, Seq mkdnText, ObjId owner, uint64 version);
+	Str EncodeEmailHtmlBody_New(RenderCache& cache, Seq mkdnText, bool permitLinks, ObjId owner, uint64 version);
+
 	Str EncodeEmailTextBody_ReplyOrForward(Markdown::Transform const& mkdn, Imf::Message const& origMsg, Seq origText);
 	Str EncodeEmailHtmlBody_ReplyOrForward(Markdown::Transform const& mkdn, Imf::Message const& origMsg, ParseNode const& origHtmlNode);
 }
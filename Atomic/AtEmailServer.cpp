@@ -11,18 +11,31 @@ namespace At
 
 	// EmailServer
 
+	template <class ThreadType>
+	void EmailServer<ThreadType>::ParkSession(AutoFree<EmailServerSession>& session)
+	{
+		EnsureThrow(EventDriven());
+		m_reactor.Park(session, EmailServer_RecvTimeoutMs);
+	}
+
+
 	template <class ThreadType>
 	void EmailServer<ThreadType>::WorkPool_Run()
 	{
 		SockInit sockInit;
 
+		if (EventDriven())
+			m_reactor.Start(GetStopCtl(), m_nrReactorThreads);
+
+		OnExit stopReactor = [&] { m_reactor.Stop(); };
+
 		struct Binding
 		{
 			Str    m_bindingToken;
 			Socket m_listener;
 		};
 
-		enum { NrBaseEvents = 2 };
+		enum { NrBaseEvents = 3 };
 		Vec<Binding> bindings;
 		Vec<HANDLE> waitHandles;
 		bool reloadBindings = true;
@@ -42,6 +55,7 @@ namespace At
 				waitHandles.ReserveExact(NrBaseEvents + bindings.Len());
 				waitHandles.Add(StopEvent().Handle());
 				waitHandles.Add(m_reloadBindingsTrigger.Handle());
+				waitHandles.Add(m_reactor.ReadyEvent().Handle());
 				EnsureThrow(NrBaseEvents == waitHandles.Len());
 
 				for (EmailSrvBinding const& esb : cfgBindings)
@@ -78,6 +92,20 @@ namespace At
 			DWORD rc = WaitHandles(NumCast<DWORD>(waitHandles.Len()), waitHandles.Ptr(), INFINITE);
 			if (rc == 0) return;
 			if (rc == 1) { reloadBindings = true; continue; }
+			if (rc == 2)
+			{
+				// Sessions parked in event-driven mode that have received input, or whose receive failed.
+				// These clients are already being served, so they take priority over new connections
+				AutoFree<EmailServerSession> session;
+				while (m_reactor.TakeReady(session))
+				{
+					AutoFree<EmailServerWorkItem> workItem = new EmailServerWorkItem;
+					workItem->m_session.Set(session.Dismiss());
+					if (!EnqueueWorkItem(workItem, TaskPriority::High))
+						workItem.Set(nullptr);		// Closes the connection
+				}
+				continue;
+			}
 			if (rc >= waitHandles.Len()) throw ErrWithCode<>(rc, "Unexpected return value from WaitForMultipleObjects");
 
 			Binding& b = bindings[rc - NrBaseEvents];
@@ -85,7 +113,8 @@ namespace At
 			b.m_listener.Accept(workItem->m_sk, workItem->m_saRemote);
 			workItem->m_bindingToken = b.m_bindingToken;
 
-			EnqueueWorkItem(workItem);
+			if (!EnqueueWorkItem(workItem))
+				workItem.Set(nullptr);		// Closes the connection
 		}
 	}
 
@@ -100,22 +129,38 @@ namespace At
 	void EmailServer_ClientLine::ReadLine(Reader& reader)
 	{
 		reader.SetExpireMs(EmailServer_RecvTimeoutMs);
-		reader.Read( [&] (Seq& avail) -> Reader::ReadInstr
-			{
-				Seq const line { avail.ReadToString("\r\n") };
-				if (avail.n)
-				{
-					m_line = line;
+		reader.Read( [&] (Seq& avail) -> Reader::ReadInstr { return ProcessLine(avail); } );
+	}
 
-					avail.DropBytes(2);
-					return Reader::ReadInstr::Done;
-				}
+
+	bool EmailServer_ClientLine::TryReadLine(Reader& reader)
+	{
+		if (reader.TryReadBuffered( [&] (Seq& avail) -> Reader::ReadInstr { return ProcessLine(avail); } ))
+			return true;
+
+		if (!reader.HaveNewDataToProcess())
+			return false;
+
+		ReadLine(reader);
+		return true;
+	}
+
+
+	Reader::ReadInstr EmailServer_ClientLine::ProcessLine(Seq& avail)
+	{
+		Seq const line { avail.ReadToString("\r\n") };
+		if (avail.n)
+		{
+			m_line = line;
+
+			avail.DropBytes(2);
+			return Reader::ReadInstr::Done;
+		}
 		
-				if (avail.n > EmailServer_MaxClientLineBytes)
-					throw EmailServer_Disconnect("Line too long");
+		if (avail.n > EmailServer_MaxClientLineBytes)
+			throw EmailServer_Disconnect("Line too long");
 
-				return Reader::ReadInstr::NeedMore;		
-			} );
+		return Reader::ReadInstr::NeedMore;		
 	}
 
 
@@ -125,6 +170,22 @@ namespace At
 	void EmailServer_ClientCmd::ReadCmd(Reader& reader)
 	{
 		ReadLine(reader);
+		ParseCmd();
+	}
+
+
+	bool EmailServer_ClientCmd::TryReadCmd(Reader& reader)
+	{
+		if (!TryReadLine(reader))
+			return false;
+
+		ParseCmd();
+		return true;
+	}
+
+
+	void EmailServer_ClientCmd::ParseCmd()
+	{
 		Seq lineReader = m_line;
 		m_cmd = lineReader.ReadToByte(' ') >> ToLower;
 		if (lineReader.n)
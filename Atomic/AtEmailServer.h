@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AtEmailEntities.h"
+#include "AtEmailServerReactor.h"
 #include "AtReader.h"
 #include "AtWorkPool.h"
 
@@ -15,6 +16,8 @@ namespace At
 		Socket   m_sk;
 		SockAddr m_saRemote;
 		Str      m_bindingToken;
+
+		AutoFree<EmailServerSession> m_session;		// Set when resuming a session that was parked in event-driven mode
 	};
 
 	
@@ -25,14 +28,30 @@ namespace At
 	class EmailServer : public WorkPool<ThreadType, EmailServerWorkItem>
 	{
 	public:
+		// New connections, and parked sessions that become ready, are closed if the backlog is full
+		EmailServer() { this->SetMaxBacklog(MaxBacklog, BacklogPolicy::Reject); }
+
 		// Usually after the email server has been started, signals it to reload bindings after a configuration change
 		void ReloadBindings() { m_reloadBindingsTrigger.Signal(); }
 
+		// If not called, each connection occupies a work pool thread until it ends. If called, must be called before the email server
+		// is started. In event-driven mode, a connection waiting for the client's next command is parked in an EmailServerReactor
+		// with the specified number of I/O threads, and occupies a work pool thread only while commands are processed.
+		void SetEventDriven(uint nrIoThreads) { EnsureThrow(!Started()); m_nrReactorThreads = nrIoThreads; }
+		bool EventDriven() const { return m_nrReactorThreads != 0; }
+
+		// Called by a work pool thread when a session in event-driven mode needs more input from the client. Takes ownership of the session
+		void ParkSession(AutoFree<EmailServerSession>& session);
+
 	protected:
 		virtual EntVec<EmailSrvBinding> const& EmailServer_GetCfgBindings() = 0;
 
 	private:
-		Event m_reloadBindingsTrigger { Event::CreateAuto };
+		enum { MaxBacklog = 1000 };
+
+		Event              m_reloadBindingsTrigger { Event::CreateAuto };
+		uint               m_nrReactorThreads      {};
+		EmailServerReactor m_reactor;
 
 		void WorkPool_Run() override final;
 	};
@@ -69,6 +88,14 @@ namespace At
 		Str m_line;
 
 		void ReadLine(Reader& reader);	
+
+		// Reads a line without waiting for input if the line has already been received. Returns false if more input is needed.
+		// If the reader holds received data that it has not yet processed, such as TLS records not yet decrypted, reads a line
+		// as ReadLine does. This may wait for the rest of a line the client is in the middle of sending.
+		bool TryReadLine(Reader& reader);
+
+	private:
+		Reader::ReadInstr ProcessLine(Seq& avail);
 	};
 
 
@@ -81,6 +108,10 @@ namespace At
 		Str m_params;
 
 		void ReadCmd(Reader& reader);	
+		bool TryReadCmd(Reader& reader);
+
+	private:
+		void ParseCmd();
 	};
 
 }
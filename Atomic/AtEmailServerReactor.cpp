@@ -0,0 +1,213 @@
+#include "AtIncludes.h"
+#include "AtEmailServerReactor.h"
+
+#include "AtWait.h"
+#include "AtWinErr.h"
+
+
+namespace At
+{
+
+	void EmailServerReactor::Start(Rp<StopCtl> const& stopCtl, uint nrIoThreads)
+	{
+		EnsureThrow(!m_running);
+		EnsureThrow(nrIoThreads != 0);
+
+		m_iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, nrIoThreads);
+		if (!m_iocp)
+			{ LastWinErr e; throw e.Make<>("EmailServerReactor: Error in CreateIoCompletionPort"); }
+
+		m_nextSweepTicks = (LONG64) (GetTickCount64() + SweepIntervalMs);
+		m_running = true;
+
+		for (uint i=0; i!=nrIoThreads; ++i)
+		{
+			ThreadPtr<IoThread> ioThread { Thread::Create };
+			ioThread->SetReactor(this);
+			m_ioThreads.push_back(ioThread);
+			ioThread->Start(stopCtl);
+		}
+	}
+
+
+	void EmailServerReactor::Stop()
+	{
+		{
+			Locker locker { m_mx };
+			if (!m_running)
+				return;
+
+			m_running = false;
+		}
+
+		for (sizet i=0; i!=m_ioThreads.size(); ++i)
+			PostQueuedCompletionStatus(m_iocp, 0, Key_Stop, nullptr);
+
+		// Waits for the thread handles rather than StopCtl::WaitAll, which would also wait for the owner's other threads
+		for (ThreadPtr<IoThread> const& ioThread : m_ioThreads)
+			if (ioThread->Started())
+				Wait1(ioThread->ThreadHandle(), INFINITE);
+
+		m_ioThreads.clear();
+
+		// Closing the sockets of sessions still parked completes their receives. The sessions can be freed after the completions are dequeued
+		for (EmailServerSession::Park* park : m_parked)
+			park->m_session->m_sk.Close();
+
+		while (m_parked.Any())
+		{
+			DWORD nrBytes {};
+			ULONG_PTR key {};
+			OVERLAPPED* ovl {};
+			GetQueuedCompletionStatus(m_iocp, &nrBytes, &key, &ovl, INFINITE);
+			if (ovl)
+			{
+				EmailServerSession::Park* park = (EmailServerSession::Park*) ovl;
+				RemoveParked(*park);
+				delete park->m_session;
+			}
+		}
+
+		while (!m_ready.empty())
+		{
+			delete m_ready.front();
+			m_ready.pop_front();
+		}
+
+		CloseHandle(m_iocp);
+		m_iocp = nullptr;
+	}
+
+
+	void EmailServerReactor::Park(AutoFree<EmailServerSession>& session, uint64 idleTimeoutMs)
+	{
+		EnsureThrow(session.Any());
+		EmailServerSession::Park& park = session->m_park;
+		SOCKET s = session->m_sk.GetSocket();
+
+		Locker locker { m_mx };
+		if (!m_running)
+		{
+			session.Set(nullptr);
+			return;
+		}
+
+		if (!park.m_associated)
+		{
+			if (!CreateIoCompletionPort((HANDLE) s, m_iocp, Key_Session, 0))
+			{
+				session.Set(nullptr);
+				return;
+			}
+
+			park.m_associated = true;
+		}
+
+		ZeroMemory(&park.m_ovl, sizeof(park.m_ovl));
+		park.m_session = session.Dismiss();
+		park.m_wb.buf = nullptr;
+		park.m_wb.len = 0;
+		park.m_expireTickCount = GetTickCount64() + idleTimeoutMs;
+		park.m_expired = false;
+		park.m_index = m_parked.Len();
+		m_parked.Add(&park);
+
+		// A receive that completes immediately still queues a completion packet
+		DWORD nrBytes {};
+		DWORD flags {};
+		if (WSARecv(s, &park.m_wb, 1, &nrBytes, &flags, &park.m_ovl, nullptr) != 0 && WSAGetLastError() != WSA_IO_PENDING)
+		{
+			// No completion packet will be queued. Resuming the session will encounter the error and end the connection
+			RemoveParked(park);
+			m_ready.push_back(park.m_session);
+			m_readyEvent.Signal();
+		}
+	}
+
+
+	bool EmailServerReactor::TakeReady(AutoFree<EmailServerSession>& session)
+	{
+		Locker locker { m_mx };
+		if (m_ready.empty())
+			return false;
+
+		session.Set(m_ready.front());
+		m_ready.pop_front();
+		return true;
+	}
+
+
+	void EmailServerReactor::IoThreadMain(Event& stopEvent)
+	{
+		while (true)
+		{
+			DWORD nrBytes {};
+			ULONG_PTR key {};
+			OVERLAPPED* ovl {};
+			BOOL ok = GetQueuedCompletionStatus(m_iocp, &nrBytes, &key, &ovl, SweepIntervalMs);
+			if (!ovl && ok && key == Key_Stop)
+				return;
+
+			// Whichever I/O thread first finds the sweep interval elapsed closes expired sessions
+			LONG64 nextSweepTicks = m_nextSweepTicks;
+			uint64 nowTicks = GetTickCount64();
+			if (nowTicks >= (uint64) nextSweepTicks &&
+				InterlockedCompareExchange64(&m_nextSweepTicks, (LONG64) (nowTicks + SweepIntervalMs), nextSweepTicks) == nextSweepTicks)
+			{
+				CloseExpired();
+			}
+
+			if (ovl)
+			{
+				// The receive completed successfully, failed, or was aborted by closing an expired session's socket
+				EmailServerSession::Park* park = (EmailServerSession::Park*) ovl;
+				AutoFree<EmailServerSession> expiredSession;
+
+				{
+					Locker locker { m_mx };
+					RemoveParked(*park);
+
+					if (park->m_expired)
+						expiredSession.Set(park->m_session);
+					else
+					{
+						m_ready.push_back(park->m_session);
+						m_readyEvent.Signal();
+					}
+				}
+			}
+
+			// Checked after a dequeued completion is handled, so that the parked session is not lost. Sessions still parked
+			// are freed by Stop
+			if (stopEvent.IsSignaled())
+				return;
+		}
+	}
+
+
+	void EmailServerReactor::CloseExpired()
+	{
+		uint64 nowTicks = GetTickCount64();
+
+		Locker locker { m_mx };
+		for (EmailServerSession::Park* park : m_parked)
+			if (!park->m_expired && nowTicks >= park->m_expireTickCount)
+			{
+				park->m_expired = true;
+				park->m_session->m_sk.Close();
+			}
+	}
+
+
+	void EmailServerReactor::RemoveParked(EmailServerSession::Park& park)
+	{
+		EnsureAbort(park.m_index < m_parked.Len());
+		EnsureAbort(m_parked[park.m_index] == &park);
+
+		EmailServerSession::Park* last = m_parked.Last();
+		m_parked[park.m_index] = last;
+		last->m_index = park.m_index;
+		m_parked.PopLast();
+	}
+
+}
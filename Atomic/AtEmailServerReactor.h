@@ -0,0 +1,122 @@
+#pragma once
+
+#include "AtAuto.h"
+#include "AtEvent.h"
+#include "AtMutex.h"
+#include "AtSchannel.h"
+#include "AtSocket.h"
+#include "AtSocketReader.h"
+#include "AtSocketWriter.h"
+#include "AtThread.h"
+
+
+namespace At
+{
+
+	// EmailServerSession
+
+	// Connection state that persists between client commands. In event-driven mode, a session that is waiting for the client's
+	// next command is parked in EmailServerReactor, and is resumed on a work pool thread when the client sends more data.
+
+	class EmailServerSession : public NoCopy
+	{
+	public:
+		EmailServerSession(Socket& sk, SockAddr const& saRemote, Seq bindingToken)
+			: m_sk(std::move(sk)), m_saRemote(saRemote), m_bindingToken(bindingToken)
+			, m_reader(m_sk.GetSocket()), m_writer(m_sk.GetSocket()) {}
+
+		virtual ~EmailServerSession() {}
+
+		Socket       m_sk;
+		SockAddr     m_saRemote;
+		Str          m_bindingToken;
+		SocketReader m_reader;
+		SocketWriter m_writer;
+		Schannel     m_conn    { &m_reader, &m_writer };
+		bool         m_greeted {};
+
+	private:
+		// Used by EmailServerReactor while the session is parked. The OVERLAPPED structure must be first
+		struct Park
+		{
+			OVERLAPPED          m_ovl;
+			EmailServerSession* m_session         {};
+			WSABUF              m_wb              {};
+			uint64              m_expireTickCount {};
+			sizet               m_index           {};
+			bool                m_expired         {};
+			bool                m_associated      {};
+		};
+
+		Park m_park;
+
+		friend class EmailServerReactor;
+	};
+
+
+
+	// EmailServerReactor
+
+	// Holds sessions waiting for the client to send data, so that idle connections do not occupy work pool threads.
+	// For each parked session, the reactor posts a zero-byte overlapped receive on a socket associated with an I/O completion port.
+	// The receive completes when the client sends data or closes the connection, without consuming any data. A small number of
+	// I/O threads dequeue completions and queue the sessions as ready, to be resumed by the work pool. A session that stays idle
+	// longer than its timeout is closed and freed, as a blocking read would have timed out and ended the connection.
+	// The receive does not consume data, so a resumed session must read the data with a blocking read. The data is in the socket,
+	// so the read completes without waiting for the client.
+	//
+	// Reads and writes of a resumed session remain ordinary overlapped operations waited on by the work pool thread.
+	// OvlReader and OvlWriter mark their events so that these operations do not queue packets to the completion port.
+
+	class EmailServerReactor : public NoCopy
+	{
+	public:
+		~EmailServerReactor() noexcept { Stop(); }
+
+		// The I/O threads are started with the owner's StopCtl, and also exit when it is stopped. Stop must still be called
+		// to free the sessions
+		void Start(Rp<StopCtl> const& stopCtl, uint nrIoThreads);
+		void Stop();
+
+		bool Running() const { return m_running; }
+
+		// Takes ownership of the session. If the reactor is not running, or the socket cannot be associated with the completion port,
+		// frees the session. If the receive cannot be posted, queues the session as ready, so that resuming it encounters the error
+		void Park(AutoFree<EmailServerSession>& session, uint64 idleTimeoutMs);
+
+		// Signaled when sessions become ready to resume. The caller of TakeReady takes ownership of a ready session
+		Event& ReadyEvent() { return m_readyEvent; }
+		bool TakeReady(AutoFree<EmailServerSession>& session);
+
+	private:
+		enum : ULONG_PTR { Key_Session = 1, Key_Stop = 2 };
+		enum : DWORD { SweepIntervalMs = 1000 };
+
+		class IoThread : public Thread
+		{
+		public:
+			void SetReactor(EmailServerReactor* reactor) { EnsureThrow(!Started()); m_reactor = reactor; }
+
+		private:
+			EmailServerReactor* m_reactor {};
+
+			void ThreadMain() override final { m_reactor->IoThreadMain(StopEvent()); }
+		};
+
+		HANDLE                           m_iocp           {};
+		std::vector<ThreadPtr<IoThread>> m_ioThreads;
+		Mutex                            m_mx;
+		bool volatile                    m_running        {};
+		Vec<EmailServerSession::Park*>   m_parked;
+		std::deque<EmailServerSession*>  m_ready;
+		Event                            m_readyEvent     { Event::CreateAuto };
+		LONG64 volatile                  m_nextSweepTicks {};
+
+		void IoThreadMain(Event& stopEvent);
+		void CloseExpired();
+
+		// Must be called with m_mx locked
+		void RemoveParked(EmailServerSession::Park& park);
+	};
+
+}
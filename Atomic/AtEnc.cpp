@@ -209,6 +209,16 @@ namespace At
 	}
 
 
+	Enc& Enc::DblShortest(double v)
+	{
+		byte buf[Dbl2Buf_Shortest_MaxBytes];
+		Seq t { buf, Dbl2Buf_Shortest(v, buf) };
+		EnsureAbort(t.n <= Dbl2Buf_Shortest_MaxBytes);
+
+		return Add(t);
+	}
+
+
 	Enc& Enc::ErrCode(int64 v)
 	{
 		if (v >= INT32_MIN && v < INT16_MIN)
@@ -134,6 +134,7 @@ namespace At
 		Enc& UInt(uint64 v, uint base=10, uint zeroPadWidth=0, CharCase charCase=CharCase::Upper, uint spacePadWidth=0);
 		Enc& SInt(int64 v, AddSign::E addSign=AddSign::IfNeg, uint base=10, uint zeroPadWidth=0, CharCase charCase=CharCase::Upper);
 		Enc& Dbl (double v, uint prec=4);
+		Enc& DblShortest(double v);		// Shortest representation that reads back as the same value. See Dbl2Buf_Shortest
 
 		Enc& ErrCode(int64 v);
 		Enc& TzOffset(int64 v) { return SInt(v, AddSign::Always, 10, 4); }
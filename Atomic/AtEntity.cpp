@@ -50,6 +50,98 @@ namespace At
 
 
 
+	// EntityIndexInfo
+
+	EntityIndexInfo::EntityIndexInfo(uint32 kind, char const* kindName, char const* indexName, KeyCat::E keyCat,
+			EntityFieldInfo const* fields, std::initializer_list<sizet> fieldOffsets)
+		: m_kind(kind), m_indexName(indexName), m_indexId(Crc32(Str::Join(kindName, ".", indexName))), m_keyCat(keyCat)
+	{
+		EnsureThrow(KeyCat::IsKey(keyCat));
+		EnsureThrow(fieldOffsets.size() <= MaxFields);
+
+		bool haveStr {};
+		for (sizet offset : fieldOffsets)
+		{
+			EntityFieldInfo const* efi = fields;
+			while (!efi->IsPastEnd() && efi->m_offset != offset)
+				++efi;
+
+			EnsureThrow(!efi->IsPastEnd());
+			EnsureThrow(FieldType::IsIndexable(efi->m_fieldType) || efi->m_fieldType == FieldType::Bool || efi->m_fieldType == FieldType::Enum);
+
+			if (efi->m_fieldType == FieldType::Str)
+				haveStr = true;
+
+			m_fields[m_nrFields++] = efi;
+		}
+
+		EnsureThrow(m_nrFields != 0);
+		if (haveStr)
+			EnsureThrow(KeyCat::IsStrKey(keyCat));
+		else
+			EnsureThrow(KeyCat::IsNonStrKey(keyCat));
+
+		AddEntityIndex(*this);
+	}
+
+
+
+	// EntityIndexKey
+
+	void EntityIndexKey::OnAdd(uint fieldType)
+	{
+		EnsureThrow(m_nrValues < m_index.m_nrFields);
+		EnsureThrow(m_index.m_fields[m_nrValues]->m_fieldType == fieldType);
+		++m_nrValues;
+	}
+
+
+	Str EntityIndexKey::BeyondPrefix(Seq encodedPrefix)
+	{
+		// Field values are encoded so that no encoded value is a prefix of another. Keys of all entries whose values begin with
+		// the prefix therefore begin with the encoded prefix. Increment the prefix as a big-endian number
+		Str key { encodedPrefix };
+		while (key.Any())
+		{
+			if (key.Last() != 0xFF)
+			{
+				++(key.Last());
+				return key;
+			}
+
+			key.PopLast();
+		}
+
+		return TreeStore::KeyBeyondLast;
+	}
+
+
+
+	// EntityProjection
+
+	EntityProjection::EntityProjection(Entity const& sample, std::initializer_list<char const*> fieldNames)
+		: m_kind(sample.GetKind())
+	{
+		for (char const* fieldName : fieldNames)
+		{
+			EntityFieldInfo const* efi = sample.GetFieldByName(fieldName);
+			EnsureThrow(efi != nullptr);
+
+			sizet pos {}, foundPos { SIZE_MAX };
+			sample.ForEachFieldInEncodingOrder( [&] (EntityFieldInfo const* x) -> bool
+				{
+					if (x == efi) { foundPos = pos; return false; }
+					++pos;
+					return true;
+				} );
+
+			EnsureThrow(foundPos != SIZE_MAX);
+			m_fields.Add(Field { foundPos, efi });
+		}
+	}
+
+
+
 	// Entity
 
 	Entity::Entity(EntityStore* store, uint32 kind, char const* kindName, uint32 nrFields, EntityFieldInfo const* fields, EntityFieldInfo const* key, ObjId parentId)
@@ -115,10 +207,11 @@ namespace At
 	}
 
 
-	void Entity::Load(ObjId refObjId)
+	void Entity::Load(ObjId refObjId, EntityProjection const* projection)
 	{
 		EnsureThrow(m_store != nullptr);
 		EnsureThrow(m_entityId != ObjId::None);
+		EnsureThrow(!m_shared);
 
 		TreeStore::Node node;
 		node.m_nodeId = m_entityId;
@@ -127,21 +220,16 @@ namespace At
 
 		m_parentId = node.m_parentId;
 		m_hasChildrenState = node.m_hasChildren ? HasChildrenState::Yes : HasChildrenState::No;
-	
-		Seq data { node.m_data };
-	
-		uint32 kind;
-		EnsureAbort(DecodeUInt32(data, kind));
-		EnsureAbort(kind == m_kind);
-	
-		DecodeFieldsE(data);
-		EnsureAbort(data.n == 0);
+
+		DecodeNodeDataE(node.m_data, projection);
 	}
 
 
 	void Entity::Put(PutType::E putType, ObjId parentRefObjId)
 	{
 		EnsureThrow(m_store != nullptr);
+		EnsureThrow(!m_shared);
+		EnsureThrow(!m_projected);
 		EnsureThrow((putType == PutType::New) == (m_entityId == ObjId::None));
 
 		TreeStore::Node node;
@@ -151,17 +239,27 @@ namespace At
 		EncodeKey(node.m_key);
 		EnsureThrow(keyMeter.Met());
 
-		Enc::Meter dataMeter = node.m_data.FixMeter(4 + EncodeFields_Size());
-		EncodeUInt32(node.m_data, m_kind);
-		EncodeFields(node.m_data);
+		bool fieldTable = m_store->m_writeFieldTables;
+		Enc::Meter dataMeter = node.m_data.FixMeter(EncodeNodeData_Size(fieldTable));
+		EncodeNodeData(node.m_data, fieldTable);
 		EnsureThrow(dataMeter.Met());
 
+		// Unique index violations are detected before the store is modified, so that the application can recover from
+		// EntityStore::UniqueIndexViolation
+		Vec<EntityIndexInfo const*> const* indexes = GetEntityIndexes(m_kind);
+
 		if (putType == PutType::New)
 		{
 			// Insert new entity
 			EnsureThrow(m_parentId != ObjId::None);
+			if (indexes)
+				m_store->CheckUniqueIndexes(*this, nullptr, *indexes);
+
 			m_store->m_treeStore.InsertNode(node, parentRefObjId, HaveKey() && UniqueKey());
 			m_entityId = node.m_nodeId;
+
+			if (indexes)
+				m_store->UpdateIndexEntries(nullptr, this, *indexes);
 		}
 		else
 		{
@@ -170,8 +268,19 @@ namespace At
 				EnsureThrow(m_entityId == ObjId::Root);
 			else
 			{
+				Rp<Entity> stored;
+				if (indexes)
+				{
+					stored = m_store->GetEntity(m_entityId, ObjId::None, m_kind);
+					EnsureThrow(stored.Any());
+					m_store->CheckUniqueIndexes(*this, stored.Ptr(), *indexes);
+				}
+
 				node.m_nodeId = m_entityId;
 				m_store->m_treeStore.ReplaceNode(node, HaveKey() && UniqueKey());
+
+				if (indexes)
+					m_store->UpdateIndexEntries(stored.Ptr(), this, *indexes);
 			}
 		}
 
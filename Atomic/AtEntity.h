@@ -5,6 +5,7 @@
 #include "AtEncode.h"
 #include "AtEntityKinds.h"
 #include "AtJsonReadWrite.h"
+#include "AtJsonStream.h"
 #include "AtMap.h"
 #include "AtNumCvt.h"
 #include "AtOpt.h"
@@ -59,6 +60,12 @@ namespace At
 	//
 	// When decoding entities stored by a previous version that did not encode the newer fields, their values will be left at defaults.
 	// Older application versions, however, will NOT be able to read entities that encode new fields.
+	//
+	// EntityStore stores the fields of an entity in one of two formats. In the legacy format, the fields follow one another, so that
+	// decoding any field requires decoding all preceding fields. In the field table format, the fields are preceded by a table of their
+	// end offsets, in encoding order, so that a scan using EntityProjection can decode only the fields it needs. Both formats are read.
+	// Which format is written is selected with EntityStore::SetWriteFieldTables. Existing entities are converted when they are next
+	// stored, or using EntityStore::ConvertChildrenFormat. Application versions that predate the field table format cannot read it.
 
 
 	struct FieldType
@@ -217,9 +224,37 @@ namespace At
 
 
 
-	struct EntityChildInfo;
+	// A secondary index on one or more fields of an entity kind, declared using ENTITY_DECL_INDEX and ENTITY_DEF_INDEX1 to 3.
+	// Index entries are stored among the children of the same parent as the indexed entities, after all child entities in key order.
+	// An index therefore covers the children of one parent, in the same way as the key field. The key of an entry consists of
+	// the index prefix, the encoded field values, and the entity ID. Entries are maintained by Entity::Put and EntityStore::RemoveEntity
+	// in the same transaction as the entity, and are queried with EntityStore::FindChildrenByIndex.
+	//
+	// KeyCat determines whether the index is unique, and for indexes that include Str fields, whether they are case sensitive.
+	// An index added to an existing entity kind has no entries for existing entities until EntityStore::RebuildIndexes is used.
+
+	struct EntityIndexInfo
+	{
+		enum { MaxFields = 3 };
+
+		EntityIndexInfo(uint32 kind, char const* kindName, char const* indexName, KeyCat::E keyCat,
+			EntityFieldInfo const* fields, std::initializer_list<sizet> fieldOffsets);
+
+		bool Unique() const { return KeyCat::IsUniqueKey(m_keyCat); }
+
+		uint32                 const m_kind          {};
+		char const*            const m_indexName     {};
+		uint32                 const m_indexId       {};
+		KeyCat::E              const m_keyCat        { KeyCat::None };
+		sizet                        m_nrFields      {};
+		EntityFieldInfo const*       m_fields[MaxFields] {};
+	};
 
-	enum { Entity_JsonFloatPrec = 8 };		// If defined within Entity class, causes compilation errors when used with lambdas in VS 2010
+
+
+	struct EntityChildInfo;
+	class EntityIndexKey;
+	class EntityProjection;
 
 	class Entity : public RefCountable
 	{
@@ -261,20 +296,38 @@ namespace At
 		void JsonDecodeFieldValue(ParseNode const& p, EntityFieldInfo const& efi, JsonIds* jsonIds);
 		void JsonDecode(ParseNode const& p, JsonIds* jsonIds);
 
+		// Decode directly from JSON source text without constructing a ParseTree. Errors are reported at the same locations
+		void JsonDecodeFieldValue(Json::StreamDecoder& d, EntityFieldInfo const& efi, JsonIds* jsonIds);
+		void JsonDecode(Json::StreamDecoder& d, JsonIds* jsonIds);
+		void JsonDecode(Seq json, JsonIds* jsonIds);
+
 		// Used to encode both dynamic-type entities embedded as part of other entities (jsonIds == nullptr),
 		// and dynamic-type entities that are part of an import script (jsonIds != nullptr).
 		// For embedded entities, expects a JSON object with members "k" (kind, string) followed by "v" (entity value, JSON object).
 		// For import script entities, expects additional member "p" (parent, string) before "k". Parent must be found in jsonIds.
 		static void JsonDecodeDynEntity(ParseNode const& p, Rp<Entity>& o, EntityStore* storePtr, JsonIds* jsonIds);
+		static void JsonDecodeDynEntity(Json::StreamDecoder& d, Rp<Entity>& o, EntityStore* storePtr, JsonIds* jsonIds);
 
 		void ReInitFields();
 
+		// A shared entity was obtained from EntityStore::GetEntityShared, and may be in use by other threads at the same time.
+		// It must not be modified. To modify it, obtain a private copy using EntityStore::Writable
+		bool IsShared() const { return m_shared; }
+
+		// A projected entity was loaded with an EntityProjection, and has only the fields of the projection decoded.
+		// It must not be stored. To modify it, load it in full using Load
+		bool IsProjected() const { return m_projected; }
+
+		// Returns the kind of entity stored in TreeStore node data of either format
+		static bool DecodeNodeKind     (Seq data, uint32& kind);
+		static bool IsFieldTableFormat (Seq data);
+
 		// Can only be used if the entity was loaded through Load() or FindChildren()
 		bool HasChildren() const { EnsureThrow(m_hasChildrenState != HasChildrenState::Unknown); return m_hasChildrenState != HasChildrenState::No; }
 
 		struct PutType { enum E { New, Existing }; };
 
-		void       Load           (ObjId refObjId);
+		void       Load           (ObjId refObjId, EntityProjection const* projection = nullptr);
 		void       Put            (PutType::E putType, ObjId parentRefObjId);
 		ChildCount RemoveChildren ();
 		void       Remove         ();		// Entity to be removed must not have children
@@ -332,6 +385,13 @@ namespace At
 			m_store->EnumAllChildrenOfKind<ChildType, ContainerType, Direction>(m_entityId, container);
 		}
 
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void EnumAllChildrenOfKind(EntityProjection const& projection, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(m_store != nullptr);
+			m_store->EnumAllChildrenOfKind<ChildType, Direction>(m_entityId, projection, onMatch);
+		}
+
 		template <class ChildType>
 		ChildCount RemoveAllChildrenOfKind()
 		{
@@ -353,6 +413,14 @@ namespace At
 			m_store->FindChildren<ChildType, Direction>(m_entityId, keyFirst, keyBeyondLast, onMatch);
 		}
 
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildren(typename ChildType::KeyType const& keyFirst, typename ChildType::KeyType const* keyBeyondLast,
+			EntityProjection const& projection, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(m_store != nullptr);
+			m_store->FindChildren<ChildType, Direction>(m_entityId, keyFirst, keyBeyondLast, projection, onMatch);
+		}
+
 		template <class ChildType>
 		Rp<ChildType> FindChild(typename ChildType::KeyType const& key)
 		{
@@ -374,6 +442,20 @@ namespace At
 			return m_store->GetLastChildInfoOfKind<ChildType>(m_entityId, foundKey, foundId, foundBucketId);
 		}
 
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildrenByIndex(EntityIndexKey const& keyFirst, EntityIndexKey const* keyBeyondLast, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(m_store != nullptr);
+			m_store->FindChildrenByIndex<ChildType, Direction>(m_entityId, keyFirst, keyBeyondLast, onMatch);
+		}
+
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildrenWithIndexKey(EntityIndexKey const& key, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(m_store != nullptr);
+			m_store->FindChildrenWithIndexKey<ChildType, Direction>(m_entityId, key, onMatch);
+		}
+
 		static uint64 NextKey(uint64 v)     { return SatAdd<uint64>(v, 1); }
 		static int64  NextKey(int64 v)      { return SatAdd<int64>(v, 1); }
 		static Time   NextKey(Time v)       { return ++v; }
@@ -392,6 +474,38 @@ namespace At
 
 		struct HasChildrenState { enum E { Unknown, Yes, No }; };
 		HasChildrenState::E m_hasChildrenState;
+		bool                m_shared    {};
+		bool                m_projected {};
+
+		// Calls f for each field in the order in which fields are encoded: by version, and in order of declaration within a version.
+		// Stops if f returns false
+		template <class F>
+		void ForEachFieldInEncodingOrder(F f) const
+		{
+			uint currentVersion {};
+			while (true)
+			{
+				uint lowestNextVersion = UINT_MAX;
+				for (EntityFieldInfo const* efi=m_fields; !efi->IsPastEnd(); ++efi)
+				{
+					if (efi->m_version > currentVersion)
+					{
+						if (lowestNextVersion > efi->m_version)
+							lowestNextVersion = efi->m_version;
+					}
+					else if (efi->m_version == currentVersion)
+					{
+						if (!f(efi))
+							return;
+					}
+				}
+
+				if (lowestNextVersion == UINT_MAX)
+					return;
+
+				currentVersion = lowestNextVersion;
+			}
+		}
 
 	protected:
 		enum { MaxJsonUInt32DescLen = 1 + DescEnum_MaxTypeNameLen + 1 + DescEnum_MaxDescLen + 1 };
@@ -407,6 +521,16 @@ namespace At
 		static void   JsonDecodeStrValue        (ParseNode const& p, StrType& field);
 		static void   JsonDecodeDynEntityOrNull (ParseNode const& p, Rp<Entity>& o);
 
+		static ObjId  JsonDecodeObjId           (Json::StreamDecoder& d, JsonIds* jsonIds);
+		static uint32 JsonDecodeUInt32WDesc     (Json::StreamDecoder& d);
+		template <class StrType>
+		static void   JsonDecodeStrValue        (Json::StreamDecoder& d, StrType& field);
+		static void   JsonDecodeDynEntityOrNull (Json::StreamDecoder& d, Rp<Entity>& o);
+
+		static char const* JsonDecodeObjIdStr   (Seq s, JsonIds* jsonIds, ObjId& objId);
+		template <class StrType>
+		static char const* JsonDecodeStrContent (Seq s, StrType& field);
+
 	protected:
 		struct FldEncDisp { enum E { AsField, AsKey }; };
 
@@ -474,6 +598,10 @@ namespace At
 
 		uint EncodeOptFieldPresence(Enc& enc, EntityFieldInfo const* efi, uint currentlyEncodingVersion, uint lowestNextVersion) const;
 
+		// Encodes the kind and the fields, as stored in a TreeStore node, in the field table format or the legacy format
+		sizet EncodeNodeData_Size (bool fieldTable) const;
+		void  EncodeNodeData      (Enc& enc, bool fieldTable) const;
+
 		template <class ET,
 			typename std::enable_if_t<!std::is_same<typename ET::KeyType, Str>::value, int> = 0>		// Use this version for all ET::KeyType except Str
 		static void EncodeKey(Enc& enc, typename ET::KeyType const& v)
@@ -518,8 +646,20 @@ namespace At
 		sizet EncodeKey_Size () const { return 4 + (HaveKey() ? EncodeField_Size(m_key, FldEncDisp::AsKey) : 0); }
 		void  EncodeKey      (Enc& enc) const;
 
+		// Index entry key without the entity ID is used to check unique indexes
+		static void  EncodeIndexPrefix           (Enc& enc, EntityIndexInfo const& index);
+		void         EncodeIndexEntryKey         (Enc& enc, EntityIndexInfo const& index, bool withEntityId = true) const;
+		static ObjId DecodeIndexEntryEntityId    (Seq encodedKey);
+
 	protected:
 		static void EncodeEmptyKey (Enc& enc, uint32 kind);
+
+		static void EncodeIndexVal (Enc& enc, uint64 v, KeyCat::E                          ) { EncodeVarUInt64(enc, v); }
+		static void EncodeIndexVal (Enc& enc, int64  v, KeyCat::E                          ) { EncodeVarSInt64(enc, v); }
+		static void EncodeIndexVal (Enc& enc, double v, KeyCat::E                          ) { EncodeSortDouble(enc, v); }
+		static void EncodeIndexVal (Enc& enc, Time   v, KeyCat::E                          ) { EncodeVarUInt64(enc, v.ToFt()); }
+		static void EncodeIndexVal (Enc& enc, ObjId  v, KeyCat::E                          ) { EncodeVarUInt64(enc, v.m_uniqueId); EncodeVarUInt64(enc, v.m_index); }
+		static void EncodeIndexVal (Enc& enc, Seq    v, KeyCat::E kc                       ) { if (KeyCat::IsInsensitiveKey(kc)) EncodeSortStr(enc, Str().Lower(v)); else EncodeSortStr(enc, v); }
  
 		static void DecodeValE(Seq& s, bool&   v, FldEncDisp::E    ) { uint b; EnsureThrow(DecodeByte(s, b)); v = (b != 0) && (b != '0'); }
 		static void DecodeValE(Seq& s, Entity& v, FldEncDisp::E    ) { uint64 n; EnsureThrow(DecodeVarUInt64(s, n)); v.DecodeFieldsE(s, NumCast<sizet>(n)); }
@@ -558,12 +698,80 @@ namespace At
 		void DecodeFieldE(Seq& s, EntityFieldInfo const* efi, FldEncDisp::E fed);
 		void DecodeFieldsE(Seq& s, sizet nrFieldsToDecode = SIZE_MAX);
 
+		// Decodes node data of either format. If a projection is passed, and the data is in the field table format, decodes only its fields
+		void DecodeNodeDataE(Seq data, EntityProjection const* projection);
+
 		friend struct EntityChildInfo;
+		friend class EntityIndexKey;
+		friend class EntityProjection;
 		friend class EntityStore;
 	};
 
 
 
+	// A value, or the leading part of a value, of a secondary index. Used to query the index with EntityStore::FindChildrenByIndex.
+	// Values must be added in the order of the fields of the index, and their types must match the types of the fields.
+
+	class EntityIndexKey
+	{
+	public:
+		EntityIndexKey(EntityIndexInfo const& index) : m_index(index) { Entity::EncodeIndexPrefix(m_encoded, index); }
+
+		EntityIndexKey& Add(bool   v) { OnAdd(FieldType::Bool);  Entity::EncodeVal      (m_encoded, v, Entity::FldEncDisp::AsKey); return *this; }
+		EntityIndexKey& Add(uint64 v) { OnAdd(FieldType::UInt);  Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(int64  v) { OnAdd(FieldType::SInt);  Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(double v) { OnAdd(FieldType::Float); Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(Time   v) { OnAdd(FieldType::Time);  Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(ObjId  v) { OnAdd(FieldType::ObjId); Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(Seq    v) { OnAdd(FieldType::Str);   Entity::EncodeIndexVal (m_encoded, v, m_index.m_keyCat); return *this; }
+		EntityIndexKey& Add(char const* z) { return Add(Seq(z)); }
+
+		template <class T, std::enable_if_t<std::is_enum<T>::value, int> = 0>
+		EntityIndexKey& Add(T v) { OnAdd(FieldType::Enum); Entity::EncodeIndexVal(m_encoded, (uint64) v, m_index.m_keyCat); return *this; }
+
+		EntityIndexInfo const& Index   () const { return m_index; }
+		Seq                    Encoded () const { return m_encoded; }
+
+		// Returns the smallest encoded key that is greater than the encoded keys of all entries whose values begin with this key
+		Str EncodedBeyondPrefix() const { return BeyondPrefix(m_encoded); }
+
+		static Str BeyondPrefix(Seq encodedPrefix);
+
+	private:
+		EntityIndexInfo const& m_index;
+		sizet                  m_nrValues {};
+		Str                    m_encoded;
+
+		void OnAdd(uint fieldType);
+	};
+
+
+
+	// A subset of the fields of an entity kind, for scans that need only some of the fields. Fields not in the projection are left
+	// at their defaults. For entities stored in the field table format, the other fields are skipped without being decoded. Entities
+	// in the legacy format are decoded in full. A projection is typically constructed once, as a function-local static.
+
+	class EntityProjection : public NoCopy
+	{
+	public:
+		struct Field
+		{
+			sizet                  m_pos {};		// Position of the field in encoding order
+			EntityFieldInfo const* m_efi {};
+		};
+
+		EntityProjection(Entity const& sample, std::initializer_list<char const*> fieldNames);
+
+		uint32            Kind   () const { return m_kind; }
+		Vec<Field> const& Fields () const { return m_fields; }
+
+	private:
+		uint32     m_kind {};
+		Vec<Field> m_fields;
+	};
+
+
+
 	template <class T> inline T&       FieldRef(Entity& e,       sizet offset) { return *((T*) (((byte*) &e) + offset)); }
 	template <class T> inline T const& FieldRef(Entity const& e, sizet offset) { return *((T*) (((byte*) &e) + offset)); }
 
@@ -736,6 +944,7 @@ namespace At
 	#define ENTITY_DECL_FLD_E(TYPE, FLD)				TYPE::E f_##FLD; using ET_##FLD = TYPE;
 	#define ENTITY_DECL_FLD_K(TYPE, FLD, KC)			TYPE    f_##FLD; enum { KC_##FLD = (KC) }; At::EntityKeyReturnType<TYPE>::Type Key() const { return f_##FLD; } \
 														using KeyType = TYPE;
+	#define ENTITY_DECL_INDEX(IDX)						static At::EntityIndexInfo const Index_##IDX;
 	#define ENTITY_DECL_CLOSE()						};
 
 
@@ -756,6 +965,15 @@ namespace At
 													ENT const ENT::Sample; \
 													uint32 g_entityAdded##ENT = At::AddEntityKind(ENT::Sample, ENT::Create);
 
+	// Secondary indexes are defined after ENTITY_DEF_CLOSE
+	#define ENTITY_INDEX_FLD(ENT, FLD)				At::FieldOffsetOf(((ENT const*) nullptr)->f_##FLD)
+	#define ENTITY_DEF_INDEX1(ENT, IDX, KC, F1)			At::EntityIndexInfo const ENT::Index_##IDX { ENT::Kind, #ENT, #IDX, (KC), ENT::Fields, \
+														{ ENTITY_INDEX_FLD(ENT, F1) } };
+	#define ENTITY_DEF_INDEX2(ENT, IDX, KC, F1, F2)		At::EntityIndexInfo const ENT::Index_##IDX { ENT::Kind, #ENT, #IDX, (KC), ENT::Fields, \
+														{ ENTITY_INDEX_FLD(ENT, F1), ENTITY_INDEX_FLD(ENT, F2) } };
+	#define ENTITY_DEF_INDEX3(ENT, IDX, KC, F1, F2, F3)	At::EntityIndexInfo const ENT::Index_##IDX { ENT::Kind, #ENT, #IDX, (KC), ENT::Fields, \
+														{ ENTITY_INDEX_FLD(ENT, F1), ENTITY_INDEX_FLD(ENT, F2), ENTITY_INDEX_FLD(ENT, F3) } };
+
 
 
 	template <class T>
@@ -3,6 +3,67 @@
 
 namespace At
 {
+	namespace
+	{
+		// The field table holds the end offset of each field, relative to the start of field data, with the smallest width that fits
+		uint FieldTable_OffsetWidth(sizet dataSize)
+		{
+			if (dataSize <= 0xFFU)   return 1;
+			if (dataSize <= 0xFFFFU) return 2;
+			EnsureThrow(dataSize <= UINT32_MAX);
+			return 4;
+		}
+
+
+		struct FieldTable
+		{
+			sizet m_nrFields {};
+			uint  m_width    {};
+			Seq   m_offsets;
+			Seq   m_data;
+
+			void DecodeE(Seq s)
+			{
+				uint64 nrFields;
+				EnsureThrow(DecodeVarUInt64(s, nrFields));
+				m_nrFields = NumCast<sizet>(nrFields);
+
+				EnsureThrow(DecodeByte(s, m_width));
+				EnsureThrow(m_width == 1 || m_width == 2 || m_width == 4);
+				EnsureThrow(s.n / m_width >= m_nrFields);
+
+				m_offsets = s.ReadBytes(m_nrFields * m_width);
+				m_data = s;
+			}
+
+			sizet EndOffset(sizet pos) const
+			{
+				Seq s { m_offsets.p + (pos * m_width), m_width };
+				uint v {};
+				uint32 v32 {};
+				switch (m_width)
+				{
+				case 1:  DecodeByte(s, v); return v;
+				case 2:  DecodeUInt16(s, v); return v;
+				default: DecodeUInt32(s, v32); return v32;
+				}
+			}
+
+			// Field data is empty for an optional field that is not present
+			Seq Field(sizet pos) const
+			{
+				EnsureThrow(pos < m_nrFields);
+				sizet start = If(pos == 0, sizet, 0, EndOffset(pos - 1));
+				sizet end = EndOffset(pos);
+				EnsureThrow(start <= end);
+				EnsureThrow(end <= m_data.n);
+				return Seq(m_data.p + start, end - start);
+			}
+		};
+	}
+
+
+
 	// Encode
 
 	sizet Entity::EncodeOptDyn_Size(Rp<Entity> const& o)
@@ -270,6 +331,61 @@ namespace At
 	}
 
 
+	sizet Entity::EncodeNodeData_Size(bool fieldTable) const
+	{
+		if (!fieldTable || !m_nrFields)
+			return 4 + EncodeFields_Size();
+
+		sizet dataSize {};
+		for (EntityFieldInfo const* efi=m_fields; !efi->IsPastEnd(); ++efi)
+			dataSize += EncodeField_Size(efi, FldEncDisp::AsField);
+
+		return 8 + EncodeVarUInt64_Size(m_nrFields) + 1 + (m_nrFields * FieldTable_OffsetWidth(dataSize)) + dataSize;
+	}
+
+
+	void Entity::EncodeNodeData(Enc& enc, bool fieldTable) const
+	{
+		// An entity with no fields is encoded the same in both formats, except that the legacy format is shorter
+		if (!fieldTable || !m_nrFields)
+		{
+			EncodeUInt32(enc, m_kind);
+			EncodeFields(enc);
+			return;
+		}
+
+		sizet dataSize {};
+		for (EntityFieldInfo const* efi=m_fields; !efi->IsPastEnd(); ++efi)
+			dataSize += EncodeField_Size(efi, FldEncDisp::AsField);
+
+		uint width = FieldTable_OffsetWidth(dataSize);
+
+		EncodeUInt32(enc, EntityKind::FieldTable);
+		EncodeUInt32(enc, m_kind);
+		EncodeVarUInt64(enc, m_nrFields);
+		EncodeByte(enc, (byte) width);
+
+		// Each field is encoded separately, with no optional field presence bytes. An optional field that is not present is empty
+		sizet endOffset {};
+		ForEachFieldInEncodingOrder( [&] (EntityFieldInfo const* efi) -> bool
+			{
+				endOffset += EncodeField_Size(efi, FldEncDisp::AsField);
+				switch (width)
+				{
+				case 1:  EncodeByte(enc, (byte) endOffset); break;
+				case 2:  EncodeUInt16(enc, (uint) endOffset); break;
+				default: EncodeUInt32(enc, (uint32) endOffset); break;
+				}
+				return true;
+			} );
+
+		EnsureThrow(endOffset == dataSize);
+
+		ForEachFieldInEncodingOrder( [&] (EntityFieldInfo const* efi) -> bool
+			{ EncodeField(enc, efi, FldEncDisp::AsField); return true; } );
+	}
+
+
 	void Entity::EncodeKey(Enc& enc) const
 	{
 		Enc::Meter meter = enc.IncMeter(EncodeKey_Size());
@@ -288,6 +404,57 @@ namespace At
 	}
 
 
+	void Entity::EncodeIndexPrefix(Enc& enc, EntityIndexInfo const& index)
+	{
+		Enc::Meter meter = enc.IncMeter(8);
+		EncodeUInt32(enc, EntityKind::IndexEntries);
+		EncodeUInt32(enc, index.m_indexId);
+		EnsureThrow(meter.Met());
+	}
+
+
+	void Entity::EncodeIndexEntryKey(Enc& enc, EntityIndexInfo const& index, bool withEntityId) const
+	{
+		EnsureThrow(index.m_kind == m_kind);
+		EncodeIndexPrefix(enc, index);
+
+		for (sizet i=0; i!=index.m_nrFields; ++i)
+		{
+			EntityFieldInfo const* efi = index.m_fields[i];
+			switch (efi->m_fieldType)
+			{
+			case FieldType::Bool:		EncodeVal      (enc,          FieldRef<bool  >(*this, efi->m_offset), FldEncDisp::AsKey); break;
+			case FieldType::Enum:		EncodeIndexVal (enc, (uint64) FieldRef<uint32>(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::UInt:		EncodeIndexVal (enc,          FieldRef<uint64>(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::SInt:		EncodeIndexVal (enc,          FieldRef<int64 >(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::Float:		EncodeIndexVal (enc,          FieldRef<double>(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::Time:		EncodeIndexVal (enc,          FieldRef<Time  >(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::ObjId:		EncodeIndexVal (enc,          FieldRef<ObjId >(*this, efi->m_offset), index.m_keyCat); break;
+			case FieldType::Str:		EncodeIndexVal (enc,          FieldRef<Str   >(*this, efi->m_offset), index.m_keyCat); break;
+			default:					EnsureThrow(!"Unsupported index field type");
+			}
+		}
+
+		// The entity ID makes the key of each entry unique, also in a multi-value index
+		if (withEntityId)
+		{
+			EnsureThrow(m_entityId.Any());
+			m_entityId.EncodeBin(enc);
+		}
+	}
+
+
+	ObjId Entity::DecodeIndexEntryEntityId(Seq encodedKey)
+	{
+		EnsureThrow(encodedKey.n >= 8 + ObjId::EncodedSize);
+		encodedKey.DropBytes(encodedKey.n - ObjId::EncodedSize);
+
+		ObjId entityId;
+		EnsureThrow(entityId.DecodeBin(encodedKey));
+		return entityId;
+	}
+
+
 
 	// Decode
 
@@ -434,4 +601,82 @@ namespace At
 			currentlyDecodingVersion = lowestNextVersion;
 		}
 	}
+
+
+	bool Entity::DecodeNodeKind(Seq data, uint32& kind)
+	{
+		if (!DecodeUInt32(data, kind))
+			return false;
+
+		if (kind == EntityKind::FieldTable)
+			return DecodeUInt32(data, kind);
+
+		return true;
+	}
+
+
+	bool Entity::IsFieldTableFormat(Seq data)
+	{
+		uint32 kind;
+		return DecodeUInt32(data, kind) && kind == EntityKind::FieldTable;
+	}
+
+
+	void Entity::DecodeNodeDataE(Seq data, EntityProjection const* projection)
+	{
+		if (projection)
+			EnsureThrow(projection->Kind() == m_kind);
+
+		uint32 kind;
+		EnsureThrow(DecodeUInt32(data, kind));
+
+		if (kind != EntityKind::FieldTable)
+		{
+			// Legacy format. Every field has to be decoded to find the next one
+			EnsureThrow(kind == m_kind);
+			DecodeFieldsE(data);
+			EnsureThrow(data.n == 0);
+		}
+		else
+		{
+			EnsureThrow(DecodeUInt32(data, kind));
+			EnsureThrow(kind == m_kind);
+
+			FieldTable table;
+			table.DecodeE(data);
+			ReInitFields();
+
+			auto decodeField = [&] (sizet pos, EntityFieldInfo const* efi)
+				{
+					Seq s = table.Field(pos);
+					if (s.n || !FieldType::IsOptional(efi->m_fieldType))
+					{
+						DecodeFieldE(s, efi, FldEncDisp::AsField);
+						EnsureThrow(s.n == 0);
+					}
+				};
+
+			// Data stored by a previous version can have fewer fields. Newer fields are left at defaults
+			if (projection)
+			{
+				for (EntityProjection::Field const& field : projection->Fields())
+					if (field.m_pos < table.m_nrFields)
+						decodeField(field.m_pos, field.m_efi);
+			}
+			else
+			{
+				sizet pos {};
+				ForEachFieldInEncodingOrder( [&] (EntityFieldInfo const* efi) -> bool
+					{
+						if (pos == table.m_nrFields)
+							return false;
+
+						decodeField(pos++, efi);
+						return true;
+					} );
+			}
+		}
+
+		m_projected = (projection != nullptr);
+	}
 }
@@ -81,7 +81,7 @@ namespace At
 		case FieldType::Enum:     JsonEncodeEnumValue(a, FieldRef<uint32>(*this, efi.m_offset), efi);					break;
 		case FieldType::UInt:     a.UInt(FieldRef<uint64>(*this, efi.m_offset));										break;
 		case FieldType::SInt:     a.SInt(FieldRef<int64>(*this, efi.m_offset));											break;
-		case FieldType::Float:    a.Dbl(FieldRef<double>(*this, efi.m_offset), Entity_JsonFloatPrec);					break;
+		case FieldType::Float:    a.DblShortest(FieldRef<double>(*this, efi.m_offset));									break;
 		case FieldType::Time:     Json::EncodeTime(a, FieldRef<Time>(*this, efi.m_offset));                             break;
 		case FieldType::ObjId:    a.Ch('"').Obj(FieldRef<ObjId>(*this, efi.m_offset)).Ch('"');							break;
 		case FieldType::Str:      JsonEncodeStrValue(a, FieldRef<Str>(*this, efi.m_offset));							break;
@@ -91,7 +91,7 @@ namespace At
 		case FieldType::OptBool:  { Opt<bool>     const& o(FieldRef<Opt<bool    >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.Add(If(o.Ref(), Seq, "true", "false"));                break; } 
 		case FieldType::OptUInt:  { Opt<uint64>   const& o(FieldRef<Opt<uint64  >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.UInt(o.Ref());                                         break; } 
 		case FieldType::OptSInt:  { Opt<int64>    const& o(FieldRef<Opt<int64   >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.SInt(o.Ref());                                         break; } 
-		case FieldType::OptFloat: { Opt<double>   const& o(FieldRef<Opt<double  >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.Dbl(o.Ref());                                          break; } 
+		case FieldType::OptFloat: { Opt<double>   const& o(FieldRef<Opt<double  >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.DblShortest(o.Ref());                                  break; } 
 		case FieldType::OptTime:  { Opt<Time>     const& o(FieldRef<Opt<Time    >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else Json::EncodeTime(a, o.Ref());                            break; } 
 		case FieldType::OptObjId: { Opt<ObjId>    const& o(FieldRef<Opt<ObjId   >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else a.Ch('"').Obj(o.Ref()).Ch('"');                          break; } 
 		case FieldType::OptStr:   { Opt<Str>      const& o(FieldRef<Opt<Str     >>(*this, efi.m_offset)); if (!o.Any()) a.Add("null"); else JsonEncodeStrValue(a, o.Ref());                          break; } 
@@ -101,7 +101,7 @@ namespace At
 		case FieldType::VecBool:  { Vec<bool>     const& v(FieldRef<Vec<bool    >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.Add(If(v[i], Seq, "true", "false")); } ); break; }
 		case FieldType::VecUInt:  { Vec<uint64>   const& v(FieldRef<Vec<uint64  >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.UInt(v[i]);                          } ); break; }
 		case FieldType::VecSInt:  { Vec<int64>    const& v(FieldRef<Vec<int64   >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.SInt(v[i]);                          } ); break; }
-		case FieldType::VecFloat: { Vec<double>   const& v(FieldRef<Vec<double  >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.Dbl(v[i], Entity_JsonFloatPrec);     } ); break; }
+		case FieldType::VecFloat: { Vec<double>   const& v(FieldRef<Vec<double  >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.DblShortest(v[i]);                  } ); break; }
 		case FieldType::VecTime:  { Vec<Time>     const& v(FieldRef<Vec<Time    >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { Json::EncodeTime(a, v[i]);             } ); break; }
 		case FieldType::VecObjId: { Vec<ObjId>    const& v(FieldRef<Vec<ObjId   >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { a.Ch('"').Obj(v[i]).Ch('"');           } ); break; }
 		case FieldType::VecStr:   { Vec<Str>      const& v(FieldRef<Vec<Str     >>(*this, efi.m_offset)); Json::EncodeArray(a, v.Len(), [&] (Enc& a, sizet i) { JsonEncodeStrValue(a, v[i]);           } ); break; }
@@ -147,23 +147,33 @@ namespace At
 		Str s;
 		Json::DecodeString(p, s);
 
+		ObjId objId;
+		char const* err = JsonDecodeObjIdStr(s, jsonIds, objId);
+		if (err)
+			throw Json::DecodeErr(p, err);
+
+		return objId;
+	}
+
+
+	char const* Entity::JsonDecodeObjIdStr(Seq s, JsonIds* jsonIds, ObjId& objId)
+	{
 		if (jsonIds)
 		{
 			JsonIds::ConstIt it = jsonIds->Find(s);
 			if (!it.Any())
-				throw Json::DecodeErr(p, "Could not find JSON ID");
+				return "Could not find JSON ID";
 
-			return it->m_objId;
+			objId = it->m_objId;
 		}
 		else
 		{
 			Seq reader { s };
-			ObjId objId;
 			if (!objId.ReadStr(reader) || reader.n != 0)
-				throw Json::DecodeErr(p, "Expected ObjId");
-
-			return objId;
+				return "Expected ObjId";
 		}
+
+		return nullptr;
 	}
 
 
@@ -207,6 +217,15 @@ namespace At
 		Str s;
 		Json::DecodeString(p, s);
 
+		char const* err = JsonDecodeStrContent(s, field);
+		if (err)
+			throw Json::DecodeErr(p, err);
+	}
+
+
+	template <class StrType>
+	char const* Entity::JsonDecodeStrContent(Seq s, StrType& field)
+	{
 		Seq reader { s };
 		if (reader.StartsWithExact("h:"))
 		{
@@ -219,10 +238,10 @@ namespace At
 				field.Byte((byte) c);
 
 			if (reader.n != 0)
-				throw Json::DecodeErr(p, "Hex string contains non-hex characters");
+				return "Hex string contains non-hex characters";
 
 			if (field.Len() != nrBytes)
-				throw Json::DecodeErr(p, "Hex string too long to store in this field");
+				return "Hex string too long to store in this field";
 		}
 		else
 		{
@@ -232,8 +251,10 @@ namespace At
 			field.Set(reader);
 
 			if (field.Len() != reader.n)
-				throw Json::DecodeErr(p, "String too long to store in this field");
+				return "String too long to store in this field";
 		}
+
+		return nullptr;
 	}
 
 
@@ -371,6 +392,222 @@ namespace At
 
 
 
+	// Entity - Stream decode
+
+	ObjId Entity::JsonDecodeObjId(Json::StreamDecoder& d, JsonIds* jsonIds)
+	{
+		sizet pos = d.ValuePos();
+		if (d.PeekType() != Json::ValType::String)
+			if (jsonIds)
+				throw d.Err(pos, "Expected string containing JSON ID");
+			else
+				throw d.Err(pos, "Expected string containing ObjId");
+
+		Str s;
+		d.DecodeString(s);
+
+		ObjId objId;
+		char const* err = JsonDecodeObjIdStr(s, jsonIds, objId);
+		if (err)
+			throw d.Err(pos, err);
+
+		return objId;
+	}
+
+
+	uint32 Entity::JsonDecodeUInt32WDesc(Json::StreamDecoder& d)
+	{
+		sizet pos = d.ValuePos();
+		uint64 v {};
+		if (d.PeekType() == Json::ValType::Number)
+			v = d.DecodeUInt();
+		else
+		{
+			int index {};
+			d.DecodeArray([&] ()
+				{
+					sizet valuePos = d.ValuePos();
+					if (index == 0)
+						v = d.DecodeUInt();
+					else if (index == 1)
+					{
+						if (d.PeekType() != Json::ValType::String)  throw d.Err(valuePos, "Expected string description of uint32 value");
+						if (d.SkipString().n > MaxJsonUInt32DescLen) throw d.Err(valuePos, "String description of uint32 value is too long");
+					}
+					else
+						throw d.Err(valuePos, "Expected end of uint32-with-description array");
+
+					++index;
+				} );
+		}
+
+		if (v > UINT32_MAX)
+			throw d.Err(pos, "Numeric value is too large");
+
+		return (uint32) v;
+	}
+
+
+	template <class StrType>
+	void Entity::JsonDecodeStrValue(Json::StreamDecoder& d, StrType& field)
+	{
+		sizet pos = d.ValuePos();
+		if (d.PeekType() != Json::ValType::String)
+			throw d.Err(pos, "Expected string");
+
+		Str s;
+		d.DecodeString(s);
+
+		char const* err = JsonDecodeStrContent(s, field);
+		if (err)
+			throw d.Err(pos, err);
+	}
+
+
+	void Entity::JsonDecodeDynEntity(Json::StreamDecoder& d, Rp<Entity>& o, EntityStore* storePtr, JsonIds* jsonIds)
+	{
+		sizet pos = d.ValuePos();
+		if (d.PeekType() != Json::ValType::Object)
+			throw d.Err(pos, "Expected object");
+
+		enum DynEntityState { ExpectParent, ExpectJsonId, ExpectKind, ExpectValue, ExpectEnd };
+		DynEntityState state { ExpectParent };
+		ObjId parentId;
+
+		if (!jsonIds)
+			state = ExpectKind;
+
+		d.DecodeObject([&] (sizet namePos, Seq name) -> bool
+			{
+				if (state == ExpectParent)
+				{
+					if (!name.EqualExact("p"))
+						throw d.Err(namePos, "Expected entity parent 'p'");
+
+					Str parentJsonId;
+					d.DecodeString(parentJsonId);
+					JsonIds::ConstIt it = jsonIds->Find(parentJsonId);
+					if (!it.Any())
+						throw d.Err(namePos, "Could not find entity parent JSON ID");
+
+					parentId = it->m_objId;
+					state = ExpectKind;
+				}
+				else if (state == ExpectKind)
+				{
+					if (!name.EqualExact("k"))
+						throw d.Err(namePos, "Expected entity kind 'k'");
+					
+					sizet valuePos = d.ValuePos();
+					Str kindName;
+					d.DecodeString(kindName);
+					uint32 kind = Crc32(kindName);
+
+					EntityCreator creator { GetEntityCreator(kind) };
+					if (!creator)
+						throw d.Err(valuePos, "Unrecognized entity kind");
+
+					o.Set(creator(storePtr, parentId));
+					state = ExpectValue;
+				}
+				else if (state == ExpectValue)
+				{
+					if (!name.EqualExact("v"))
+						throw d.Err(namePos, "Expected entity value 'v'");
+
+					o->JsonDecode(d, jsonIds);
+					state = ExpectEnd;
+				}
+				else
+					throw d.Err(namePos, "Expected end of JSON object");
+
+				return true;
+			} );
+
+		if (state != ExpectEnd)
+			throw d.Err(pos, "Incomplete JSON entity encoding");
+	}
+
+
+	void Entity::JsonDecodeDynEntityOrNull(Json::StreamDecoder& d, Rp<Entity>& o)
+	{
+		if (d.TryDecodeNull())
+			o.Clear();
+		else
+			JsonDecodeDynEntity(d, o, nullptr, nullptr);
+	}
+
+
+	void Entity::JsonDecodeFieldValue(Json::StreamDecoder& d, EntityFieldInfo const& efi, JsonIds* jsonIds)
+	{
+		switch (efi.m_fieldType)
+		{
+		case FieldType::Entity:   FieldRef<Entity>(*this, efi.m_offset).JsonDecode(d, jsonIds);        break;
+		case FieldType::Bool:     FieldRef<bool  >(*this, efi.m_offset) = d.DecodeBool          ();    break;
+		case FieldType::Enum:     FieldRef<uint32>(*this, efi.m_offset) = JsonDecodeUInt32WDesc (d);   break;
+		case FieldType::UInt:     FieldRef<uint64>(*this, efi.m_offset) = d.DecodeUInt          ();    break;
+		case FieldType::SInt:     FieldRef<int64 >(*this, efi.m_offset) = d.DecodeSInt          ();    break;
+		case FieldType::Float:    FieldRef<double>(*this, efi.m_offset) = d.DecodeFloat         ();    break;
+		case FieldType::Time:     FieldRef<Time  >(*this, efi.m_offset) = d.DecodeTime          ();    break;
+		case FieldType::ObjId:    FieldRef<ObjId >(*this, efi.m_offset) = JsonDecodeObjId(d, jsonIds); break;
+		case FieldType::Str:      JsonDecodeStrValue(d, FieldRef<Str>(*this, efi.m_offset));           break;
+
+		case FieldType::OptDyn:   { Rp<Entity>&    o(FieldRef<Rp<Entity   >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else JsonDecodeDynEntity(d, o, nullptr, nullptr); break; }
+		case FieldType::OptEnt:   { EntOptBase&    o(FieldRef<EntOptBase   >(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init().JsonDecode(d, jsonIds);             break; }
+		case FieldType::OptBool:  { Opt<bool  >&   o(FieldRef<Opt<bool    >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = d.DecodeBool  ();               break; }
+		case FieldType::OptUInt:  { Opt<uint64>&   o(FieldRef<Opt<uint64  >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = d.DecodeUInt  ();               break; }
+		case FieldType::OptSInt:  { Opt<int64 >&   o(FieldRef<Opt<int64   >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = d.DecodeSInt  ();               break; }
+		case FieldType::OptFloat: { Opt<double>&   o(FieldRef<Opt<double  >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = d.DecodeFloat ();               break; }
+		case FieldType::OptTime:  { Opt<Time  >&   o(FieldRef<Opt<Time    >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = d.DecodeTime  ();               break; }
+		case FieldType::OptObjId: { Opt<ObjId >&   o(FieldRef<Opt<ObjId   >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else o.Init() = JsonDecodeObjId(d, jsonIds);      break; }
+		case FieldType::OptStr:   { Opt<Str   >&   o(FieldRef<Opt<Str     >>(*this, efi.m_offset)); if (d.TryDecodeNull()) o.Clear(); else JsonDecodeStrValue(d, o.Init());             break; }
+
+		case FieldType::VecDyn:   { RpVec<Entity>& v(FieldRef<RpVec<Entity>>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { JsonDecodeDynEntityOrNull(d, v.Add()); } ); break; }
+		case FieldType::VecEnt:   { EntVecBase&    v(FieldRef<EntVecBase   >(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add().JsonDecode(d, jsonIds);        } ); break; }
+		case FieldType::VecBool:  { Vec<bool  >&   v(FieldRef<Vec<bool    >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = d.DecodeBool  ();          } ); break; }
+		case FieldType::VecUInt:  { Vec<uint64>&   v(FieldRef<Vec<uint64  >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = d.DecodeUInt  ();          } ); break; }
+		case FieldType::VecSInt:  { Vec<int64 >&   v(FieldRef<Vec<int64   >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = d.DecodeSInt  ();          } ); break; }
+		case FieldType::VecFloat: { Vec<double>&   v(FieldRef<Vec<double  >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = d.DecodeFloat ();          } ); break; }
+		case FieldType::VecTime:  { Vec<Time  >&   v(FieldRef<Vec<Time    >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = d.DecodeTime  ();          } ); break; }
+		case FieldType::VecObjId: { Vec<ObjId >&   v(FieldRef<Vec<ObjId   >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { v.Add() = JsonDecodeObjId(d, jsonIds); } ); break; }
+		case FieldType::VecStr:   { Vec<Str   >&   v(FieldRef<Vec<Str     >>(*this, efi.m_offset)); v.Clear(); d.DecodeArray([&] { JsonDecodeStrValue(d, v.Add());        } ); break; }
+
+		default:
+			EnsureThrow(!"Unrecognized field type");
+		}
+	}
+
+
+	void Entity::JsonDecode(Json::StreamDecoder& d, JsonIds* jsonIds)
+	{
+		d.DecodeObject([&] (sizet namePos, Seq name) -> bool
+			{
+				bool fieldFound = false;
+				for (EntityFieldInfo const* efi=m_fields; !efi->IsPastEnd(); ++efi)
+					if (name.EqualExact(efi->m_fieldName))
+					{
+						JsonDecodeFieldValue(d, *efi, jsonIds);
+						fieldFound = true;
+						break;
+					}
+
+				if (!fieldFound)
+					throw d.Err(namePos, Str("No field with this name found in entity of type ").Add(m_kindName));
+
+				return true;
+			} );
+	}
+
+
+	void Entity::JsonDecode(Seq json, JsonIds* jsonIds)
+	{
+		Json::StreamDecoder d { json };
+		JsonDecode(d, jsonIds);
+		d.DecodeEnd();
+	}
+
+
+
 	// EntityChildInfo
 
 	Str EntityChildInfo::JsonEncodeKey() const
@@ -380,7 +617,7 @@ namespace At
 		case FieldType::PastEnd:	return "null";
 		case FieldType::UInt:		return Str().UInt(u_keyUInt);
 		case FieldType::SInt:		return Str().SInt(u_keySInt);
-		case FieldType::Float:		return Str().Dbl(u_keyFloat, Entity_JsonFloatPrec);
+		case FieldType::Float:		return Str().DblShortest(u_keyFloat);
 		case FieldType::Time:		return Str().Ch('"').Obj(m_keyTime, TimeFmt::IsoMicroZ, 'T').Ch('"');
 		case FieldType::ObjId:		return Str().Ch('"').Obj(m_keyObjId).Ch('"');
 		case FieldType::Str:		{ Str s; Entity::JsonEncodeStrValue(s, m_keyStr); return s; }
@@ -22,6 +22,7 @@ namespace At
 	};
 
 	std::map<uint32, EntityKindEntry> g_entityKinds;
+	std::map<uint32, Vec<EntityIndexInfo const*>> g_entityIndexes;
 	bool g_entityKindsAccessed = false;
 	
 
@@ -58,6 +59,8 @@ namespace At
 	{
 		uint32 kind = sample.GetKind();
 		EnsureThrow(kind != EntityKind::Unknown);
+		EnsureThrow(kind != EntityKind::IndexEntries);
+		EnsureThrow(kind != EntityKind::FieldTable);
 		EnsureThrow(!g_entityKindsAccessed);
 		EnsureThrow(g_entityKinds.find(kind) == g_entityKinds.end());
 		g_entityKinds.insert(std::make_pair(kind, EntityKindEntry(sample, creator)));
@@ -103,4 +106,28 @@ namespace At
 		EnsureThrow(creator != nullptr);
 		return creator;
 	}
+
+
+	void AddEntityIndex(EntityIndexInfo const& index)
+	{
+		EnsureThrow(!g_entityKindsAccessed);
+
+		Vec<EntityIndexInfo const*>& indexes = g_entityIndexes[index.m_kind];
+		for (EntityIndexInfo const* x : indexes)
+			EnsureThrow(x->m_indexId != index.m_indexId);
+
+		indexes.Add(&index);
+	}
+
+
+	Vec<EntityIndexInfo const*> const* GetEntityIndexes(uint32 kind)
+	{
+		g_entityKindsAccessed = true;
+
+		std::map<uint32, Vec<EntityIndexInfo const*>>::const_iterator it = g_entityIndexes.find(kind);
+		if (it == g_entityIndexes.end())
+			return nullptr;
+
+		return &(it->second);
+	}
 }
@@ -5,12 +5,16 @@
 namespace At
 {
 	struct EntityFieldInfo;
+	struct EntityIndexInfo;
 	class Entity;
 	class EntityStore;
 
 	typedef Rp<Entity> (*EntityCreator)(EntityStore* entityStore, ObjId parentId);
 
-	struct EntityKind { enum E { Unknown = 0 }; };
+	// IndexEntries is not a kind of entity. Keys of secondary index entries, stored among the children of a parent entity, begin with it.
+	// This keeps index entries after all child entities in key order.
+	// FieldTable is not a kind of entity. Entity data stored in the field table format begins with it, followed by the actual kind.
+	struct EntityKind { enum E : uint32 { Unknown = 0, FieldTable = 0xFFFFFFFEU, IndexEntries = 0xFFFFFFFFU }; };
 
 
 	uint32 VerifyEntityFields(EntityFieldInfo const* efi, EntityFieldInfo const*& key);
@@ -21,4 +25,7 @@ namespace At
 
 	EntityCreator TryGetEntityCreator(uint32 kind);		// Returns nullptr if entity kind not found
 	EntityCreator GetEntityCreator(uint32 kind);		// Asserts if entity kind not found
+
+	void AddEntityIndex(EntityIndexInfo const& index);
+	Vec<EntityIndexInfo const*> const* GetEntityIndexes(uint32 kind);		// Returns nullptr if entity kind has no secondary indexes
 }
@@ -44,13 +44,97 @@ namespace At
 
 	// EntityStore
 
+	bool EntityStore::SharedEntity::Matches(TreeStore::Node const& node) const
+	{
+		return m_parentId == node.m_parentId &&
+			m_contentObjId == node.m_contentObjId &&
+			m_hasChildren == node.m_hasChildren &&
+			Seq(m_data).EqualExact(node.m_data);
+	}
+
+
 	Rp<Entity> EntityStore::GetEntity(ObjId entityId, ObjId refObjId, uint32 expectedKind)
 	{
 		TreeStore::Node node;
 		node.m_nodeId = entityId;
 		if (!m_treeStore.GetNodeById(node, refObjId))
 			return Rp<Entity>();
-	
+
+		return DecodeEntity(node, expectedKind);
+	}
+
+
+	Rp<Entity> EntityStore::GetEntityShared(ObjId entityId, ObjId refObjId, uint32 expectedKind)
+	{
+		TreeStore::Node node;
+		node.m_nodeId = entityId;
+		if (!m_treeStore.GetNodeById(node, refObjId))
+			return Rp<Entity>();
+
+		// The ObjectStore commit number of an object is not retained after the object is evicted from memory, so it does not identify
+		// the version of the object over the lifetime of the store. The cache entry is instead validated against the node content
+		{
+			Locker locker { m_mxEntityCache };
+			SharedEntity const* se = m_entityCache.FindEntry(entityId);
+			if (se && se->Matches(node))
+			{
+				++m_entityCacheStats.m_nrHits;
+				if (expectedKind != EntityKind::Unknown)
+					EnsureThrow(se->m_entity->GetKind() == expectedKind);
+				return se->m_entity;
+			}
+
+			++m_entityCacheStats.m_nrMisses;
+		}
+
+		Rp<Entity> entity = DecodeEntity(node, expectedKind);
+		entity->m_shared = true;
+
+		{
+			Locker locker { m_mxEntityCache };
+			SharedEntity& se = m_entityCache.FindOrInsertEntry(entityId);
+			se.m_data.Swap(node.m_data);
+			se.m_parentId = node.m_parentId;
+			se.m_contentObjId = node.m_contentObjId;
+			se.m_hasChildren = node.m_hasChildren;
+			se.m_entity = entity;
+
+			sizet nrEntriesBefore = m_entityCache.Size();
+			m_entityCache.PruneEntries(m_entityCacheTarget, m_entityCacheMaxAge);
+			m_entityCacheStats.m_nrEvictions += nrEntriesBefore - m_entityCache.Size();
+		}
+
+		return entity;
+	}
+
+
+	void EntityStore::SetEntityCacheParams(sizet target, Time maxAge)
+	{
+		Locker locker { m_mxEntityCache };
+		m_entityCacheTarget = target;
+		m_entityCacheMaxAge = maxAge;
+
+		sizet nrEntriesBefore = m_entityCache.Size();
+		m_entityCache.PruneEntries(m_entityCacheTarget, m_entityCacheMaxAge);
+		m_entityCacheStats.m_nrEvictions += nrEntriesBefore - m_entityCache.Size();
+	}
+
+
+	EntityStore::EntityCacheStats EntityStore::GetEntityCacheStats(Stats::Action action)
+	{
+		Locker locker { m_mxEntityCache };
+		EntityCacheStats stats = m_entityCacheStats;
+		stats.m_nrEntries = m_entityCache.Size();
+
+		if (action == Stats::Clear)
+			m_entityCacheStats = EntityCacheStats();
+
+		return stats;
+	}
+
+
+	Rp<Entity> EntityStore::DecodeEntity(TreeStore::Node const& node, uint32 expectedKind)
+	{
 		Rp<Entity> entity;
 		if (!node.m_data.Any())
 		{
@@ -59,19 +143,16 @@ namespace At
 		}
 		else
 		{
-			Seq data { node.m_data };
-	
 			uint32 kind;
-			EnsureThrow(DecodeUInt32(data, kind));
+			EnsureThrow(Entity::DecodeNodeKind(node.m_data, kind));
 			if (expectedKind != EntityKind::Unknown)
 				EnsureThrow(kind == expectedKind);
 	
 			entity.Set(GetEntityCreator(kind)(this, node.m_parentId));
-			entity->DecodeFieldsE(data);
-			EnsureThrow(data.n == 0);
+			entity->DecodeNodeDataE(node.m_data, nullptr);
 		}
 
-		entity->m_entityId = entityId;
+		entity->m_entityId = node.m_nodeId;
 		entity->m_contentObjId = node.m_contentObjId;
 		entity->m_hasChildrenState = node.m_hasChildren ? Entity::HasChildrenState::Yes : Entity::HasChildrenState::No;
 		return entity;
@@ -82,8 +163,12 @@ namespace At
 	void EntityStore::EnumAllChildren(ObjId parentId, std::function<bool (EntityChildInfo const&)> onMatch)
 	{
 		EnsureThrow(parentId != ObjId::None);
+		// Secondary index entries follow all child entities in key order, and are not enumerated
+		Str keyBeyondLast;
+		Entity::EncodeEmptyKey(keyBeyondLast, EntityKind::IndexEntries);
+
 		Entity const* kindSample = nullptr;
-		m_treeStore.EnumAllChildren(parentId,
+		m_treeStore.FindChildren<Direction>(parentId, Seq(), keyBeyondLast,
 			[&] (Seq encodedKey, ObjId objId, ObjId bucketId) -> bool
 				{ return onMatch(EntityChildInfo(encodedKey, objId, bucketId, kindSample)); } );
 	}
@@ -138,4 +223,175 @@ namespace At
 		return foundId;
 	}
 
+
+	void EntityStore::RemoveEntity(ObjId entityId)
+	{
+		// If the entity is of a kind with secondary indexes, its index entries are removed with it
+		TreeStore::Node node;
+		node.m_nodeId = entityId;
+		if (m_treeStore.GetNodeById(node, ObjId::None))
+		{
+			uint32 kind;
+			if (Entity::DecodeNodeKind(node.m_data, kind))
+			{
+				Vec<EntityIndexInfo const*> const* indexes = GetEntityIndexes(kind);
+				if (indexes)
+				{
+					Rp<Entity> stored = GetEntity(entityId, ObjId::None, kind);
+					UpdateIndexEntries(stored.Ptr(), nullptr, *indexes);
+				}
+			}
+		}
+
+		m_treeStore.RemoveNode(entityId);
+	}
+
+
+	sizet EntityStore::RebuildIndexes(ObjId parentId, uint32 kind)
+	{
+		Vec<EntityIndexInfo const*> const* indexes = GetEntityIndexes(kind);
+		if (!indexes)
+			return 0;
+
+		Vec<EntityAndRefObjId> children;
+		EnumAllChildrenOfKind(parentId, kind, [&] (EntityChildInfo const& info) -> bool { children.Add(info); return true; } );
+
+		Vec<Rp<Entity>> entities;
+		entities.ReserveExact(children.Len());
+		for (EntityAndRefObjId const& child : children)
+		{
+			Rp<Entity> e = GetEntity(child.m_entityId, child.m_refObjId, kind);
+			EnsureThrow(e.Any());
+			entities.Add(std::move(e));
+		}
+
+		// Detect duplicates among the children before the existing entries are removed, so that a violation leaves the store unmodified
+		for (EntityIndexInfo const* index : *indexes)
+			if (index->Unique())
+			{
+				Vec<Str> keys;
+				keys.ReserveExact(entities.Len());
+				for (Rp<Entity> const& e : entities)
+					e->EncodeIndexEntryKey(keys.Add(), *index, false);
+
+				std::sort(keys.begin(), keys.end(), [] (Str const& a, Str const& b) { return Seq(a).Compare(b, CaseMatch::Exact) < 0; } );
+				for (sizet i=1; i<keys.Len(); ++i)
+					if (Seq(keys[i-1]).EqualExact(keys[i]))
+						throw UniqueIndexViolation(*index, entities.First()->GetKindName());
+			}
+
+		RemoveAllIndexEntries(parentId, kind);
+
+		for (Rp<Entity> const& e : entities)
+			UpdateIndexEntries(nullptr, e.Ptr(), *indexes);
+
+		return entities.Len();
+	}
+
+
+	sizet EntityStore::ConvertChildrenFormat(ObjId parentId, uint32 kind)
+	{
+		Vec<EntityAndRefObjId> children;
+		EnumAllChildrenOfKind(parentId, kind, [&] (EntityChildInfo const& info) -> bool { children.Add(info); return true; } );
+
+		sizet nrConverted {};
+		for (EntityAndRefObjId const& child : children)
+		{
+			TreeStore::Node node;
+			node.m_nodeId = child.m_entityId;
+			EnsureThrow(m_treeStore.GetNodeById(node, child.m_refObjId));
+
+			if (Entity::IsFieldTableFormat(node.m_data) != m_writeFieldTables)
+			{
+				Rp<Entity> e = DecodeEntity(node, kind);
+				e->Update();
+				++nrConverted;
+			}
+		}
+
+		return nrConverted;
+	}
+
+
+	void EntityStore::CheckUniqueIndexes(Entity const& e, Entity const* stored, Vec<EntityIndexInfo const*> const& indexes)
+	{
+		for (EntityIndexInfo const* index : indexes)
+			if (index->Unique())
+			{
+				Str values;
+				e.EncodeIndexEntryKey(values, *index, false);
+
+				if (stored)
+				{
+					Str storedValues;
+					stored->EncodeIndexEntryKey(storedValues, *index, false);
+					if (Seq(values).EqualExact(storedValues))
+						continue;
+				}
+
+				bool conflict {};
+				m_treeStore.FindChildren(e.m_parentId, values, EntityIndexKey::BeyondPrefix(values),
+					[&] (Seq key, ObjId, ObjId) -> bool
+						{ conflict = (Entity::DecodeIndexEntryEntityId(key) != e.m_entityId); return !conflict; } );
+
+				if (conflict)
+					throw UniqueIndexViolation(*index, e.GetKindName());
+			}
+	}
+
+
+	void EntityStore::UpdateIndexEntries(Entity const* stored, Entity const* updated, Vec<EntityIndexInfo const*> const& indexes)
+	{
+		for (EntityIndexInfo const* index : indexes)
+		{
+			Str storedKey, updatedKey;
+			if (stored)  stored ->EncodeIndexEntryKey(storedKey,  *index);
+			if (updated) updated->EncodeIndexEntryKey(updatedKey, *index);
+
+			if (stored && updated && Seq(storedKey).EqualExact(updatedKey))
+				continue;
+
+			if (stored)
+			{
+				// The entry is missing if the index was added after the entity was stored, and the index has not been rebuilt
+				ObjId entryId;
+				m_treeStore.FindChildren(stored->m_parentId, storedKey, TreeStore::NextKey(storedKey),
+					[&] (Seq, ObjId id, ObjId) -> bool { entryId = id; return false; } );
+
+				if (entryId.Any())
+					m_treeStore.RemoveNode(entryId);
+			}
+
+			if (updated)
+			{
+				// The parent was read by this transaction when the entity was inserted or loaded
+				TreeStore::Node entry;
+				entry.m_parentId = updated->m_parentId;
+				entry.m_key = updatedKey;
+				m_treeStore.InsertNode(entry, ObjId::None, true);
+			}
+		}
+	}
+
+
+	sizet EntityStore::RemoveAllIndexEntries(ObjId parentId, uint32 kind)
+	{
+		Vec<EntityIndexInfo const*> const* indexes = GetEntityIndexes(kind);
+		if (!indexes)
+			return 0;
+
+		Vec<ObjId> entryIds;
+		for (EntityIndexInfo const* index : *indexes)
+		{
+			EntityIndexKey prefix { *index };
+			m_treeStore.FindChildren(parentId, prefix.Encoded(), prefix.EncodedBeyondPrefix(),
+				[&] (Seq, ObjId id, ObjId) -> bool { entryIds.Add(id); return true; } );
+		}
+
+		for (ObjId entryId : entryIds)
+			m_treeStore.RemoveNode(entryId);
+
+		return entryIds.Len();
+	}
+
 }
@@ -65,6 +65,18 @@ namespace At
 	class EntityStore : public Storage
 	{
 	public:
+		// Thrown by Entity::Put and EntityStore::RebuildIndexes if an entity has the same values in the fields of a unique index
+		// as another child of the same parent. It is thrown before the store is modified, so the application can catch it and
+		// report the conflict
+		struct UniqueIndexViolation : public StrErr
+		{
+			EntityIndexInfo const& m_index;
+
+			UniqueIndexViolation(EntityIndexInfo const& index, Seq kindName)
+				: StrErr(Str::Join("Unique index ", index.m_indexName, " of entity kind ", kindName, " already has an entry with the same values"))
+				, m_index(index) {}
+		};
+
 		EntityStore() : Storage(&m_treeStore) {}
 
 		// - If expectedKind != EntityKind::Unknown, returns null if node not found; throws if node is empty, or has an entity of incorrect kind.
@@ -81,7 +93,7 @@ namespace At
 		Rp<Entity> GetEntity(ObjId entityId, ObjId refObjId, uint32 expectedKind);
 
 		ChildCount RemoveEntityChildren (ObjId entityId) { return m_treeStore.RemoveNodeChildren (entityId); }
-		void       RemoveEntity         (ObjId entityId) {        m_treeStore.RemoveNode         (entityId); }
+		void       RemoveEntity         (ObjId entityId);
 
 		// Warning: this method is error prone because it requires choosing the correct refObjId.
 		// Retrieving an entity using the incorrect refObjId may cause subtle inconsistencies and errors.
@@ -94,6 +106,41 @@ namespace At
 		Rp<EntityType> GetEntityOfKind(EntityAndRefObjId const& ids)
 			{ return GetEntityOfKind<EntityType>(ids.m_entityId, ids.m_refObjId); }
 
+		// Like GetEntity, but uses a store-wide cache of decoded entities, shared between transactions and threads. Intended for
+		// entities that are read often and change rarely, such as configuration. The node is retrieved as with GetEntity, so the read
+		// is recorded by the current transaction, and conflicts are detected as usual. A cached entity is returned only if it was
+		// decoded from the same node content; otherwise, the entity is decoded and replaces the cache entry. The returned entity
+		// is shared, and must not be modified: see Entity::IsShared and Writable.
+		Rp<Entity> GetEntityShared(ObjId entityId, ObjId refObjId, uint32 expectedKind);
+
+		template <class EntityType>
+		Rp<EntityType> GetEntityOfKindShared(ObjId entityId, ObjId refObjId)
+			{ return GetEntityShared(entityId, refObjId, EntityType::Kind).DynamicCast<EntityType>(); }
+
+		// Copy-on-write. Returns the entity if it is not shared. Otherwise, decodes a private copy that can be modified and stored.
+		// The shared entity must have been obtained by the current transaction.
+		template <class EntityType>
+		Rp<EntityType> Writable(Rp<EntityType> const& e)
+		{
+			if (!e->IsShared())
+				return e;
+
+			// The node has been read by the current transaction. If it was since changed by another commit, this throws RetryTxException
+			return GetEntity(e->m_entityId, ObjId::None, e->GetKind()).DynamicCast<EntityType>();
+		}
+
+		struct EntityCacheStats
+		{
+			uint64 m_nrHits      {};
+			uint64 m_nrMisses    {};
+			uint64 m_nrEvictions {};
+			sizet  m_nrEntries   {};
+		};
+
+		// May be called at any time. Entries in excess of the target number, and entries not accessed within maxAge, are evicted.
+		void             SetEntityCacheParams (sizet target, Time maxAge);
+		EntityCacheStats GetEntityCacheStats  (Stats::Action action);
+
 		template <EnumDir Direction = EnumDir::Forward>
 		void EnumAllChildren(ObjId parentId, std::function<bool (EntityChildInfo const&)> onMatch);
 		
@@ -133,6 +180,20 @@ namespace At
 		}
 
 		
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void EnumAllChildrenOfKind(ObjId parentId, EntityProjection const& projection, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnumAllChildrenOfKind_EncodedKeysAndIds<ChildType, Direction>(parentId,
+				[&] (Seq, ObjId childId, ObjId bucketId) -> bool
+				{
+					Rp<ChildType> child { new ChildType(*this, parentId) };
+					child->m_entityId = childId;
+					child->Load(bucketId, &projection);
+					return onMatch(child);
+				} );
+		}
+
+		
 		template <class ChildType, class ContainerType, EnumDir Direction = EnumDir::Forward>
 		void EnumAllChildrenOfKind(ObjId parentId, ContainerType& container)
 		{
@@ -181,6 +242,7 @@ namespace At
 				m_treeStore.RemoveNode(childId);
 			}
 
+			RemoveAllIndexEntries(parentId, ChildType::Kind);
 			return childCount;
 		}
 
@@ -200,6 +262,22 @@ namespace At
 		}
 
 
+		// Decodes only the fields of the projection. See EntityProjection
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildren(ObjId parentId, typename ChildType::KeyType const& keyFirst, typename ChildType::KeyType const* keyBeyondLast,
+			EntityProjection const& projection, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			FindChildren_EncodedKeysAndIds<ChildType, Direction>(parentId, keyFirst, keyBeyondLast,
+				[&] (Seq, ObjId childId, ObjId bucketId) -> bool
+				{
+					Rp<ChildType> child(new ChildType(*this, parentId));
+					child->m_entityId = childId;
+					child->Load(bucketId, &projection);
+					return onMatch(child);
+				} );
+		}
+
+
 		template <class ChildType, EnumDir Direction = EnumDir::Forward>
 		void FindChildren_EncodedKeysAndIds(ObjId parentId, typename ChildType::KeyType const& keyFirst, typename ChildType::KeyType const* keyBeyondLast,
 			std::function<bool (Seq, ObjId, ObjId)> onMatch)
@@ -274,6 +352,94 @@ namespace At
 		}
 
 
+		// Finds children whose values in the index of keyFirst are in the range [keyFirst, keyBeyondLast).
+		// If keyBeyondLast is null, the range continues to the end of the index. The keys can specify values for leading fields only.
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildrenByIndex(ObjId parentId, EntityIndexKey const& keyFirst, EntityIndexKey const* keyBeyondLast,
+			std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(keyFirst.Index().m_kind == ChildType::Kind);
+
+			Str encodedKeyBeyondLast;
+			if (keyBeyondLast)
+			{
+				EnsureThrow(&keyBeyondLast->Index() == &keyFirst.Index());
+				encodedKeyBeyondLast = keyBeyondLast->Encoded();
+			}
+			else
+				encodedKeyBeyondLast = EntityIndexKey::BeyondPrefix(EntityIndexKey(keyFirst.Index()).Encoded());
+
+			FindChildIdsByIndex<Direction>(parentId, keyFirst.Encoded(), encodedKeyBeyondLast,
+				[&] (ObjId childId, ObjId refObjId) -> bool
+				{
+					Rp<ChildType> child { new ChildType(*this, parentId) };
+					child->m_entityId = childId;
+					child->Load(refObjId);
+					return onMatch(child);
+				} );
+		}
+
+
+		// Finds children whose values in the index of the key begin with the values in the key
+		template <class ChildType, EnumDir Direction = EnumDir::Forward>
+		void FindChildrenWithIndexKey(ObjId parentId, EntityIndexKey const& key, std::function<bool (Rp<ChildType> const&)> onMatch)
+		{
+			EnsureThrow(key.Index().m_kind == ChildType::Kind);
+
+			FindChildIdsByIndex<Direction>(parentId, key.Encoded(), key.EncodedBeyondPrefix(),
+				[&] (ObjId childId, ObjId refObjId) -> bool
+				{
+					Rp<ChildType> child { new ChildType(*this, parentId) };
+					child->m_entityId = childId;
+					child->Load(refObjId);
+					return onMatch(child);
+				} );
+		}
+
+
+		template <class ChildType>
+		Rp<ChildType> FindChildWithIndexKey(ObjId parentId, EntityIndexKey const& key)
+		{
+			Rp<ChildType> child;
+			FindChildrenWithIndexKey<ChildType>(parentId, key, [&] (Rp<ChildType> const& c) -> bool { child = c; return false; } );
+			return child;
+		}
+
+
+		// Calls onMatch with the entity ID of each child found, and the refObjId with which to load it
+		template <EnumDir Direction = EnumDir::Forward>
+		void FindChildIdsByIndex(ObjId parentId, Seq encodedKeyFirst, Seq encodedKeyBeyondLast, std::function<bool (ObjId, ObjId)> onMatch)
+		{
+			EnsureThrow(parentId != ObjId::None);
+			m_treeStore.FindChildren<Direction>(parentId, encodedKeyFirst, encodedKeyBeyondLast,
+				[&] (Seq key, ObjId, ObjId bucketId) -> bool
+					{ return onMatch(Entity::DecodeIndexEntryEntityId(key), bucketId); } );
+		}
+
+
+		// Removes all entries of the secondary indexes of ChildType under the parent, and recreates them from the children.
+		// Use after adding an index to an entity kind for which entities already exist. Runs in the current transaction,
+		// so for a parent with many children, use RunTxExclusive. Returns the number of children indexed.
+		template <class ChildType>
+		sizet RebuildIndexes(ObjId parentId) { return RebuildIndexes(parentId, ChildType::Kind); }
+
+		sizet RebuildIndexes(ObjId parentId, uint32 kind);
+
+
+		// Selects the format in which Entity::Put stores fields: the field table format if true, or the legacy format, which is the default.
+		// Both formats are read regardless. The field table format is opt-in because application versions that predate it cannot read it,
+		// so a store written in it cannot be rolled back to such a version. May be called before Init().
+		void SetWriteFieldTables(bool writeFieldTables) { m_writeFieldTables = writeFieldTables; }
+		bool WriteFieldTables() const { return m_writeFieldTables; }
+
+		// Stores again each child of ChildType under the parent that is not in the format selected by SetWriteFieldTables. Runs in
+		// the current transaction, so for a parent with many children, use RunTxExclusive. Returns the number of children converted.
+		template <class ChildType>
+		sizet ConvertChildrenFormat(ObjId parentId) { return ConvertChildrenFormat(parentId, ChildType::Kind); }
+
+		sizet ConvertChildrenFormat(ObjId parentId, uint32 kind);
+
+
 		// A common usage pattern is to have entities with no fields to act as parents, so that things aren't
 		// stored directly under ObjId::Root. This method helps create such entities, if they aren't created yet.
 		template <class EntityType>
@@ -343,6 +509,30 @@ namespace At
 
 	private:
 		TreeStore m_treeStore;
+		bool      m_writeFieldTables {};
+
+		struct SharedEntity
+		{
+			Str        m_data;
+			ObjId      m_parentId;
+			ObjId      m_contentObjId;
+			bool       m_hasChildren {};
+			Rp<Entity> m_entity;
+
+			bool Matches(TreeStore::Node const& node) const;
+		};
+
+		Mutex                      m_mxEntityCache;
+		Cache<ObjId, SharedEntity> m_entityCache;				// Protected by m_mxEntityCache
+		sizet                      m_entityCacheTarget { 10000 };
+		Time                       m_entityCacheMaxAge { Time::FromMinutes(10) };
+		EntityCacheStats           m_entityCacheStats;			// Protected by m_mxEntityCache
+
+		Rp<Entity> DecodeEntity(TreeStore::Node const& node, uint32 expectedKind);
+
+		void  CheckUniqueIndexes    (Entity const& e, Entity const* stored, Vec<EntityIndexInfo const*> const& indexes);
+		void  UpdateIndexEntries    (Entity const* stored, Entity const* updated, Vec<EntityIndexInfo const*> const& indexes);
+		sizet RemoveAllIndexEntries (ObjId parentId, uint32 kind);
 
 		friend class Entity;
 	};
@@ -160,4 +160,52 @@ namespace At
 		return s;
 	}
 
+
+
+	// FileLoader
+
+	FileLoader::FileLoader(Seq path, Mode mode) : m_path(path)
+	{
+		File file;
+		file.Open(path, File::OpenArgs::DefaultRead());
+
+		if (mode == Mode::Read)
+		{
+			file.ReadAllInto(m_buffer);
+			m_content = m_buffer;
+			return;
+		}
+
+		uint64 size = file.GetSize();
+		if (size > SIZE_MAX)
+			throw StrErr(Str("FileLoader: File is too large to map: \"").Add(path).Add("\""));
+
+		// A mapping cannot be created for an empty file
+		if (!size)
+			return;
+
+		m_hMapping = CreateFileMappingW(file.Handle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_hMapping)
+			{ LastWinErr e; throw e.Make<>(Str("FileLoader: Error in CreateFileMapping for \"").Add(path).Add("\"")); }
+
+		m_pView = MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!m_pView)
+		{
+			LastWinErr e;
+			CloseHandle(m_hMapping);
+			throw e.Make<>(Str("FileLoader: Error in MapViewOfFile for \"").Add(path).Add("\""));
+		}
+
+		m_content = Seq(m_pView, (sizet) size);
+	}
+
+
+	FileLoader::~FileLoader() noexcept
+	{
+		if (m_pView)
+			UnmapViewOfFile(m_pView);
+		if (m_hMapping)
+			CloseHandle(m_hMapping);
+	}
+
 }
@@ -127,18 +127,27 @@ namespace At
 
 
 	
-	class FileLoader
+	// Read loads the whole file into memory owned by the loader. Map maps the file into memory for the lifetime of the loader,
+	// so that a large file can be processed without copying it, and without reserving memory for all of it up front.
+	// Content of a mapped file is valid only as long as the file is not modified by another process.
+
+	class FileLoader : NoCopy
 	{
 	public:
-		FileLoader(Seq path) : m_path(path)
-			{ File().Open(path, File::OpenArgs::DefaultRead()).ReadAllInto(m_content); }
+		enum class Mode { Read, Map };
+
+		FileLoader(Seq path, Mode mode = Mode::Read);
+		~FileLoader() noexcept;
 
 		Seq Path    () const { return m_path;    }
 		Seq Content () const { return m_content; }
 
 	private:
-		Str m_path;
-		Str m_content;
+		Str         m_path;
+		Str         m_buffer;
+		HANDLE      m_hMapping {};
+		void const* m_pView    {};
+		Seq         m_content;
 	};
 
 }
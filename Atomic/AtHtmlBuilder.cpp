@@ -14,8 +14,25 @@ namespace At
 	}
 
 
+	StaticAsset const* HtmlBuilder::ExternalAsset(Seq content)
+	{
+		if (!g_staticAssets.External())
+			return nullptr;
+
+		return g_staticAssets.FindByContent(content);
+	}
+
+
 	HtmlBuilder& HtmlBuilder::AddCss(Seq cssBody)
 	{
+		if (StaticAsset const* asset = ExternalAsset(cssBody))
+		{
+			EnsureThrow(!m_cssDone);
+			if (!m_cssAssets.Contains(asset))
+				m_cssAssets.Add(asset);
+			return *this;
+		}
+
 		if (!m_css.Any())
 			m_css.ReserveExact(DefaultReserveCss);
 		else
@@ -32,17 +49,34 @@ namespace At
 		if (!m_js.Any())
 		{
 			m_jsScriptId = Token::Generate();
-			m_js.ReserveExact(DefaultReserveJs).Add(c_js_AtHtmlBuilder_Intro);
+			m_js.ReserveExact(DefaultReserveJs);
+			AddJsText(c_js_AtHtmlBuilder_Intro);
 			m_js.SetEndExact(" ").Add("const args = JSON.parse(Elem('").JsStrEncode(m_jsScriptId).Add("').dataset.args);");
 			m_json.Object();
 		}
 	}
 
 
+	void HtmlBuilder::AddJsText(Seq js)
+	{
+		if (StaticAsset const* asset = ExternalAsset(js))
+		{
+			if (!m_jsAssets.Contains( [asset] (JsAssetRef const& x) { return x.m_asset == asset; } ))
+			{
+				JsAssetRef& ref = m_jsAssets.Add();
+				ref.m_jsPos = m_js.Len();
+				ref.m_asset = asset;
+			}
+		}
+		else
+			m_js.SetEndExact(" ").Add(js);
+	}
+
+
 	void HtmlBuilder::AddJs(Seq jsBody)
 	{
 		OnAddJs();
-		m_js.SetEndExact(" ").Add(jsBody);
+		AddJsText(jsBody);
 	}
 
 
@@ -269,6 +303,15 @@ namespace At
 
 	HtmlBuilder& HtmlBuilder::EndHead()
 	{
+		for (StaticAsset const* asset : m_cssAssets)
+		{
+			Str href = Str::Join(g_staticAssets.UrlPrefix(), asset->m_fileName);
+			Link().Rel("stylesheet").Href(href).Integrity(asset->Integrity());
+		}
+
+		if (m_cssAssets.Any())
+			m_csp.AddStyleSrc(g_staticAssets.CspSource());
+
 		if (m_css.Any())
 		{
 			Style().Type("text/css");
@@ -290,12 +333,22 @@ namespace At
 		{
 			m_json.EndObject();
 
-			Script().Id(m_jsScriptId);
-			AddAttr("data-args", m_json.Final());
-			AddScriptOrStyleContent(m_js);
-			EndScript();
+			// Without external scripts, this outputs all of m_js as one inline script
+			bool argsAdded {};
+			sizet inlineStart {};
+			for (JsAssetRef const& ref : m_jsAssets)
+			{
+				AddInlineJs(Seq(m_js.Ptr() + inlineStart, ref.m_jsPos - inlineStart), argsAdded);
+				inlineStart = ref.m_jsPos;
 
-			m_csp.AddScriptSrc(CspBuilder::Sha256(m_js));
+				Str src = Str::Join(g_staticAssets.UrlPrefix(), ref.m_asset->m_fileName);
+				Script().Src(src).Integrity(ref.m_asset->Integrity()).EndScript();
+			}
+
+			AddInlineJs(Seq(m_js.Ptr() + inlineStart, m_js.Len() - inlineStart), argsAdded);
+
+			if (m_jsAssets.Any())
+				m_csp.AddScriptSrc(g_staticAssets.CspSource());
 		}
 
 		m_jsDone = true;
@@ -304,6 +357,35 @@ namespace At
 	}
 
 
+	void HtmlBuilder::AddInlineJs(Seq js, bool& argsAdded)
+	{
+		if (js.n)
+		{
+			// Strict mode applies per script. A script that follows an external one does not start with the intro, which enables it
+			Str strictJs;
+			if (!js.TrimLeft().StartsWithExact("'use strict';"))
+			{
+				strictJs.Set("'use strict';").Add(js);
+				js = strictJs;
+			}
+
+			// The first inline script defines "args" from its own data-args attribute
+			Script();
+			if (!argsAdded)
+			{
+				Id(m_jsScriptId);
+				AddAttr("data-args", m_json.Final());
+				argsAdded = true;
+			}
+
+			AddScriptOrStyleContent(js);
+			EndScript();
+
+			m_csp.AddScriptSrc(CspBuilder::Sha256(js));
+		}
+	}
+
+
 	void HtmlBuilder::AddAttr(Seq name)
 	{
 		EnsureThrow(m_state == HtmlState::Attrs);
@@ -323,7 +405,11 @@ namespace At
 		EnsureThrow(m_state == HtmlState::Attrs);
 		m_s.Ch('>');
 
-		Seq tag { m_tags.Last() };
+		// A fragment has no enclosing element until one is added
+		Seq tag;
+		if (m_tags.Any())
+			tag = m_tags.Last();
+
 		if (tag == "style" || tag == "script")
 			m_state = HtmlState::ScriptOrStyle;
 		else
@@ -359,6 +445,17 @@ namespace At
 	}
 
 
+	HtmlBuilder& HtmlBuilder::AddFragment(Seq fragment)
+	{
+		if (m_state == HtmlState::Attrs)
+			EndAttrs();
+
+		EnsureThrow(m_state == HtmlState::Elems);
+		m_s.Add(fragment);
+		return *this;
+	}
+
+
 	HtmlBuilder& HtmlBuilder::UIntBytes(uint64 v)
 	{
 		if (m_state == HtmlState::Attrs)
@@ -5,13 +5,14 @@
 #include "AtFormInputType.h"
 #include "AtJsonBuilder.h"
 #include "AtPostFormSecurity.h"
+#include "AtStaticAssets.h"
 #include "AtTagStack.h"
 
 
 namespace At
 {
 
-	namespace Html { class Transform; }
+	namespace Html { class Transform; class StreamTransform; }
 
 
 	struct HtmlState { enum E {
@@ -29,13 +30,20 @@ namespace At
 
 		// The reserve parameter can help reserve a large enough amount of memory upfront to avoid reallocations
 		HtmlBuilder(sizet reserveHtml = DefaultReserveHtml);
-		HtmlBuilder(EFragment, sizet reserveHtml = DefaultReserveHtml) { m_s.ReserveExact(reserveHtml); }
+		HtmlBuilder(EFragment, sizet reserveHtml = DefaultReserveHtml) : m_state(HtmlState::Elems) { m_s.ReserveExact(reserveHtml); }
 
 		Seq Final() const { EnsureThrow(!m_tags.Any()); return m_s; }
 
+		// For a builder constructed with Fragment. Completes a void element, if one was added last
+		Seq FinalFragment() { if (m_state == HtmlState::Attrs) EndAttrs(); return Final(); }
+
 		// Any styles and scripts added via AddCss and AddJs will be concatenated, included inline just before
 		// the end of the <head> element (for CSS) or the <body> element (for JS), and a hash of the resulting
 		// concatenation will be included in the CSP automatically.
+		//
+		// If g_staticAssets has an URL prefix, styles and scripts that are registered static assets are instead referenced
+		// as external resources, with the precomputed hash as the integrity attribute. External stylesheets are linked before
+		// any inline CSS. External scripts keep their order relative to inline scripts, which are split around them.
 		CspBuilder&       Csp()       { return m_csp; }
 		CspBuilder const& Csp() const { return m_csp; }
 
@@ -95,6 +103,7 @@ namespace At
 		HtmlBuilder& Href         (Seq value) { AddAttr("href",         value); return *this; }
 		HtmlBuilder& Id           (Seq value) { AddAttr("id",           value); return *this; }
 		HtmlBuilder& InputMode    (Seq value) { AddAttr("inputmode",    value); return *this; }
+		HtmlBuilder& Integrity    (Seq value) { AddAttr("integrity",    value); return *this; }
 		HtmlBuilder& LabelAttr    (Seq value) { AddAttr("label",        value); return *this; }
 		HtmlBuilder& List         (Seq value) { AddAttr("list",         value); return *this; }
 		HtmlBuilder& MinAttr      (Seq value) { AddAttr("min",          value); return *this; }
@@ -128,6 +137,7 @@ namespace At
 		HtmlBuilder& T(Seq text) { return T(text, Html::CharRefs::Render); }
 		HtmlBuilder& T(Seq text, Html::CharRefs charRefs);
 		HtmlBuilder& AddTextUnescaped(Seq text);
+		HtmlBuilder& AddFragment(Seq fragment);		// Splices in element content obtained from FinalFragment, e.g. via a RenderCache. Not escaped
 		HtmlBuilder& B(Seq text)          { return B().T(text).EndB(); }
 		HtmlBuilder& I(Seq text)          { return I().T(text).EndI(); }
 		HtmlBuilder& H1(Seq text)         { return H1().T(text).EndH1(); }
@@ -354,7 +364,21 @@ namespace At
 		bool            m_jsHaveReloadElem  {};
 		bool            m_jsHavePopUpLinks  {};
 
+		// An external script, referenced before the inline script text that starts at m_jsPos in m_js
+		struct JsAssetRef
+		{
+			sizet              m_jsPos {};
+			StaticAsset const* m_asset {};
+		};
+
+		Vec<StaticAsset const*> m_cssAssets;
+		Vec<JsAssetRef>         m_jsAssets;
+
+		static StaticAsset const* ExternalAsset(Seq content);
+
 		void OnAddJs();
+		void AddJsText(Seq js);
+		void AddInlineJs(Seq js, bool& argsAdded);
 		void AddScriptOrStyleContent(Seq text);
 
 		void AddAttr(Seq name);
@@ -370,6 +394,7 @@ namespace At
 		void GenUniqueId(Str& id);
 
 		friend class Html::Transform;
+		friend class Html::StreamTransform;
 	};
 
 }
@@ -1,3 +1,5 @@
+'use strict';
+
 {
     const elems = document.getElementsByClassName('popUpLink');
     for (let i = 0; i < elems.length; ++i) {
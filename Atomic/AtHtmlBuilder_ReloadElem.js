@@ -1,3 +1,5 @@
+'use strict';
+
 function ReloadReqHandler(req, outElemId, statusElemId, method, url, retryMs) {
 	if (req.readyState == 4) {
 		if (req.status == 200 || req.status == 203 || req.status == 503) {
@@ -998,6 +998,189 @@ namespace At
 			};
 
 
+		// PolicyHash
+
+		namespace Internal
+		{
+			// Perfect hash over the tags in c_elemInfo, and over the tags in each attribute list, including c_globalAttrInfo. Each key is
+			// a tag together with the table it belongs to. A key is hashed first to a bucket; each bucket has a displacement, chosen so that
+			// the keys of all buckets land in distinct slots. A lookup computes one hash, and compares the tag in one slot.
+			//
+			// The tables are fixed at compile time, but the displacements are found the first time a lookup is made. This takes a fraction
+			// of a millisecond, and does not require regenerating any constants when the tables are edited.
+
+			class PolicyHash : NoCopy
+			{
+			public:
+				PolicyHash();
+
+				// Matches the tag ASCII case-insensitively. Tags in the tables are lowercase
+				void const* Find(void const* table, Seq tag) const;
+
+			private:
+				struct Entry
+				{
+					uint64      m_table {};
+					Seq         m_tag;
+					void const* m_info  {};
+				};
+
+				sizet       m_slotMask  {};
+				sizet       m_nrBuckets {};
+				Vec<uint64> m_displacements;
+				Vec<Entry>  m_slots;
+
+				static uint64 HashKey (uint64 table, Seq tag);
+				static uint64 Mix     (uint64 h, uint64 displacement);
+
+				sizet BucketOf (uint64 h) const { return (sizet) ((Mix(h, 0) >> 32) % m_nrBuckets); }
+				sizet SlotOf   (uint64 h, uint64 displacement) const { return (sizet) (Mix(h, displacement + 1) & m_slotMask); }
+			};
+
+
+			PolicyHash::PolicyHash()
+			{
+				struct Key
+				{
+					Entry  m_entry;
+					uint64 m_hash {};
+				};
+
+				Vec<Key> keys;
+				auto addKey = [&] (void const* table, char const* tagZ, void const* info)
+					{
+						Key& key = keys.Add();
+						key.m_entry.m_table = (uint64) (sizet) table;
+						key.m_entry.m_tag   = tagZ;
+						key.m_entry.m_info  = info;
+						key.m_hash          = HashKey(key.m_entry.m_table, key.m_entry.m_tag);
+
+						for (sizet i=0; i!=key.m_entry.m_tag.n; ++i)
+							EnsureAbort(ToLower(key.m_entry.m_tag.p[i]) == key.m_entry.m_tag.p[i]);
+					};
+
+				auto addAttrs = [&] (AttrInfo const* attrs)
+					{
+						for (AttrInfo const* ai=attrs; ai->m_tag; ++ai)
+							addKey(attrs, ai->m_tag, ai);
+					};
+
+				for (ElemInfo const* ei=c_elemInfo; ei->m_tag; ++ei)
+				{
+					addKey(c_elemInfo, ei->m_tag, ei);
+					if (ei->m_attrs)
+						addAttrs(ei->m_attrs);		// Lists shared by several elements are added more than once. Duplicates are skipped below
+				}
+
+				addAttrs(c_globalAttrInfo);
+
+				sizet nrSlots { 64 };
+				while (nrSlots < 2 * keys.Len())
+					nrSlots *= 2;
+
+				m_slotMask = nrSlots - 1;
+				m_nrBuckets = nrSlots / 4;
+
+				// Assign keys to buckets. Where a table contains a tag more than once, the first entry is used, same as with linear search
+				Vec<Vec<sizet>> buckets;
+				buckets.ResizeExact(m_nrBuckets);
+				for (sizet i=0; i!=keys.Len(); ++i)
+				{
+					Vec<sizet>& bucket = buckets[BucketOf(keys[i].m_hash)];
+					bool duplicate {};
+					for (sizet k : bucket)
+						if (keys[k].m_entry.m_table == keys[i].m_entry.m_table && keys[k].m_entry.m_tag.EqualExact(keys[i].m_entry.m_tag))
+							{ duplicate = true; break; }
+
+					if (!duplicate)
+						bucket.Add(i);
+				}
+
+				// Place larger buckets first, while there are more free slots
+				Vec<sizet> order;
+				order.ReserveExact(m_nrBuckets);
+				for (sizet b=0; b!=m_nrBuckets; ++b)
+					if (buckets[b].Any())
+						order.Add(b);
+
+				std::sort(order.begin(), order.end(), [&] (sizet x, sizet y) -> bool
+					{ return buckets[x].Len() > buckets[y].Len() || (buckets[x].Len() == buckets[y].Len() && x < y); } );
+
+				m_displacements.ResizeExact(m_nrBuckets);
+				m_slots.ResizeExact(nrSlots);
+
+				Vec<sizet> slots;
+				for (sizet b : order)
+				{
+					Vec<sizet> const& bucket = buckets[b];
+					for (uint64 displacement=0; ; ++displacement)
+					{
+						EnsureAbort(displacement != 1000000);
+
+						slots.Clear();
+						bool fits { true };
+						for (sizet k : bucket)
+						{
+							sizet slot { SlotOf(keys[k].m_hash, displacement) };
+							if (m_slots[slot].m_info || slots.Contains(slot))
+								{ fits = false; break; }
+
+							slots.Add(slot);
+						}
+
+						if (fits)
+						{
+							for (sizet i=0; i!=bucket.Len(); ++i)
+								m_slots[slots[i]] = keys[bucket[i]].m_entry;
+
+							m_displacements[b] = displacement;
+							break;
+						}
+					}
+				}
+			}
+
+
+			void const* PolicyHash::Find(void const* table, Seq tag) const
+			{
+				uint64 const tableKey { (uint64) (sizet) table };
+				uint64 const h { HashKey(tableKey, tag) };
+				Entry const& entry { m_slots[SlotOf(h, m_displacements[BucketOf(h)])] };
+				if (entry.m_table != tableKey || !tag.EqualInsensitive(entry.m_tag))
+					return nullptr;
+
+				return entry.m_info;
+			}
+
+
+			uint64 PolicyHash::HashKey(uint64 table, Seq tag)
+			{
+				// FNV-1a over the lowercased tag, as Seq::FnvHash64
+				uint64 const FnvPrime64 = 1099511628211ull;
+				uint64 v = (table ^ tag.n) * FnvPrime64;
+				for (sizet i=0; i!=tag.n; ++i)
+					v = (v ^ (uint64) ToLower(tag.p[i])) * FnvPrime64;
+				return v;
+			}
+
+
+			uint64 PolicyHash::Mix(uint64 h, uint64 displacement)
+			{
+				uint64 x = h ^ (displacement * 0x9E3779B97F4A7C15ull);
+				x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+				x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+				return x ^ (x >> 31);
+			}
+
+
+			PolicyHash const& GetPolicyHash()
+			{
+				static PolicyHash const s_policyHash;
+				return s_policyHash;
+			}
+		}
+
+
 		AttrInfo const* ElemInfo::FindAttrInfo_ByTagExact(Seq tagLower) const
 		{
 			if (m_attrs)
@@ -1013,6 +1196,17 @@ namespace At
 		}
 
 
+		AttrInfo const* ElemInfo::FindAttrInfo_ByTagInsens(Seq tag) const
+		{
+			PolicyHash const& policyHash { GetPolicyHash() };
+			if (m_attrs)
+				if (void const* info = policyHash.Find(m_attrs, tag))
+					return (AttrInfo const*) info;
+
+			return (AttrInfo const*) policyHash.Find(c_globalAttrInfo, tag);
+		}
+
+
 		ElemInfo const* FindElemInfo_ByTagExact(Seq tagLower)
 		{
 			for (ElemInfo const* ei=Html::c_elemInfo; ei->m_tag; ++ei)
@@ -1022,5 +1216,11 @@ namespace At
 			return nullptr;
 		}
 
+
+		ElemInfo const* FindElemInfo_ByTagInsens(Seq tag)
+		{
+			return (ElemInfo const*) GetPolicyHash().Find(c_elemInfo, tag);
+		}
+
 	}
 }
@@ -81,11 +81,17 @@ namespace At
 			EmbedFinalizer  m_finalizer;
 
 			AttrInfo const* FindAttrInfo_ByTagExact(Seq tagLower) const;
+
+			// Finds the same entry as FindAttrInfo_ByTagExact would find for the lowercased tag, using a perfect hash instead of scanning the lists
+			AttrInfo const* FindAttrInfo_ByTagInsens(Seq tag) const;
 		};
 
 		extern ElemInfo const c_elemInfo[];
 
 		// Returns nullptr if tag not found in c_elemInfo
 		ElemInfo const* FindElemInfo_ByTagExact(Seq tagLower);
+
+		// Finds the same entry as FindElemInfo_ByTagExact would find for the lowercased tag, using a perfect hash instead of scanning c_elemInfo
+		ElemInfo const* FindElemInfo_ByTagInsens(Seq tag);
 	}
 }
@@ -45,6 +45,7 @@ namespace At
 		DECL_RUID(SuspectChar)
 
 		extern char const* const c_htmlWsChars;
+		bool IsHtmlWsChar(uint c);
 
 		bool C_HtmlWs   (ParseNode& p);
 		bool C_CharRef  (ParseNode& p);
@@ -0,0 +1,480 @@
+#include "AtIncludes.h"
+#include "AtHtmlTokenizer.h"
+
+#include "AtUnicode.h"
+
+namespace At
+{
+	namespace Html
+	{
+		// Each function below corresponds to a rule in AtHtmlGrammar.cpp, and must accept exactly the same input.
+		// A function that succeeds advances the reader past the input it matched. A function that fails leaves the reader unchanged.
+
+		namespace
+		{
+			bool IsAnyChar        (uint  ) { return true; }
+			bool IsNonDashChar    (uint c) { return c != '-'; }
+			bool IsNonSqBrClose   (uint c) { return c != ']'; }
+			bool IsNonGrtrChar    (uint c) { return c != '>'; }
+			bool IsTextCharNoWs   (uint c) { return c != '<' && c != '&' && !IsHtmlWsChar(c); }
+			bool IsAttrNameChar   (uint c) { return !Unicode::IsControl(c) && !ZChr(" \"'/=>", c); }
+			bool IsAttrValUnqChar (uint c) { return !ZChr("\t\n\f\r \"'<=>`", c); }
+
+
+			bool ReadCharIf(Seq& s, CharCriterion pred)
+			{
+				Seq reader { s };
+				uint c { reader.ReadUtf8Char() };
+				if (c == UINT_MAX || !pred(c))
+					return false;
+
+				s = reader;
+				return true;
+			}
+
+			bool ReadCharsIf(Seq& s, CharCriterion pred)
+			{
+				if (!ReadCharIf(s, pred))
+					return false;
+
+				while (ReadCharIf(s, pred)) {}
+				return true;
+			}
+
+			bool ReadByteIs(Seq& s, uint b)
+			{
+				if (!s.StartsWithByte(b))
+					return false;
+
+				s.DropByte();
+				return true;
+			}
+
+			bool ReadBytesIf(Seq& s, CharCriterion pred, sizet minCount, sizet maxCount)
+			{
+				sizet i {};
+				while (i != maxCount && i != s.n && pred(s.p[i]))
+					++i;
+
+				if (i < minCount)
+					return false;
+
+				s.DropBytes(i);
+				return true;
+			}
+
+			// V_ByteNfbSeq
+			bool ReadByteNfbSeq(Seq& s, uint b, Seq other)
+			{
+				if (!s.StartsWithByte(b) || Seq(s.p + 1, s.n - 1).StartsWithExact(other))
+					return false;
+
+				s.DropByte();
+				return true;
+			}
+
+			Seq SeqBetween(Seq const& from, Seq const& to) { return Seq(from.p, (sizet) (to.p - from.p)); }
+
+
+			bool ReadWs(Seq& s) { return ReadCharsIf(s, IsHtmlWsChar); }
+
+			bool ReadText(Seq& s)
+			{
+				Seq reader { s };
+				while (true)
+				{
+					if (ReadCharIf(reader, IsTextCharNoWs))
+						continue;
+
+					// V_SpNfbWs: a single space is part of the text, unless it is followed by more whitespace
+					if (reader.StartsWithByte(' ') && (reader.n < 2 || !ZChr("\t\n\f\r ", reader.p[1])))
+						{ reader.DropByte(); continue; }
+
+					break;
+				}
+
+				if (reader.p == s.p)
+					return false;
+
+				s = reader;
+				return true;
+			}
+
+			bool ReadCharRef(Seq& s)
+			{
+				Seq reader { s };
+				if (ReadByteIs(reader, '&') && ReadBytesIf(reader, Ascii::IsAlphaNum, MinCharRefNameLen, MaxCharRefNameLen) && ReadByteIs(reader, ';'))
+					{ s = reader; return true; }
+
+				reader = s;
+				if (reader.StripPrefixExact("&#") && ReadBytesIf(reader, Ascii::IsDecDigit, 1, 7) && ReadByteIs(reader, ';'))
+					{ s = reader; return true; }
+
+				reader = s;
+				if (reader.StripPrefixInsensitive("&#x") && ReadBytesIf(reader, Ascii::IsHexDigit, 1, 6) && ReadByteIs(reader, ';'))
+					{ s = reader; return true; }
+
+				return false;
+			}
+
+			bool ReadComment(Seq& s)
+			{
+				Seq reader { s };
+				if (!reader.StripPrefixExact("<!--"))
+					return false;
+
+				while (ReadCharIf(reader, IsNonDashChar) || ReadByteNfbSeq(reader, '-', "->")) {}
+
+				if (!reader.StripPrefixExact("-->") && reader.n)
+					return false;
+
+				s = reader;
+				return true;
+			}
+
+			bool ReadCData(Seq& s, Seq& content)
+			{
+				Seq reader { s };
+				if (!reader.StripPrefixExact("<![CDATA["))
+					return false;
+
+				Seq contentStart { reader };
+				while (ReadCharIf(reader, IsNonSqBrClose) || ReadByteNfbSeq(reader, ']', "]>")) {}
+				Seq contentFound { SeqBetween(contentStart, reader) };
+
+				if (!reader.StripPrefixExact("]]>") && reader.n)
+					return false;
+
+				content = contentFound;
+				s = reader;
+				return true;
+			}
+
+			bool ReadQStr(Seq& s, Seq& content)
+			{
+				Seq reader { s };
+				uint delim { reader.FirstByte() };
+				if (delim != '\'' && delim != '"')
+					return false;
+
+				reader.DropByte();
+				Seq contentStart { reader };
+				while (true)
+				{
+					Seq charReader { reader };
+					uint c { charReader.ReadUtf8Char() };
+					if (c == UINT_MAX || c == delim)
+						break;
+
+					reader = charReader;
+				}
+				Seq contentFound { SeqBetween(contentStart, reader) };
+
+				if (!ReadByteIs(reader, delim) && reader.n)
+					return false;
+
+				content = contentFound;
+				s = reader;
+				return true;
+			}
+
+			// C_Ws_Attr
+			bool ReadWsAttr(Seq& s, Seq& name, bool& haveValue, Seq& value)
+			{
+				Seq reader { s };
+				if (!ReadWs(reader))
+					return false;
+
+				Seq nameStart { reader };
+				if (!ReadCharsIf(reader, IsAttrNameChar))
+					return false;
+
+				name = SeqBetween(nameStart, reader);
+				haveValue = false;
+				value = Seq();
+
+				// C_Eq_AttrVal is optional. It matches only if a value follows the equals sign, or the input ends
+				Seq eqReader { reader };
+				ReadWs(eqReader);
+				if (ReadByteIs(eqReader, '='))
+				{
+					ReadWs(eqReader);
+
+					Seq valueStart { eqReader };
+					if (ReadCharsIf(eqReader, IsAttrValUnqChar))
+					{
+						value = SeqBetween(valueStart, eqReader);
+						haveValue = true;
+						reader = eqReader;
+					}
+					else if (ReadQStr(eqReader, value))
+					{
+						haveValue = true;
+						reader = eqReader;
+					}
+					else if (!eqReader.n)
+						reader = eqReader;
+				}
+
+				s = reader;
+				return true;
+			}
+
+			// Matches a generic tag name if specialTag is empty
+			bool ReadTag(Seq& s, Seq specialTag)
+			{
+				if (specialTag.n)
+					return s.StripPrefixInsensitive(specialTag);
+
+				if (!s.StartsWithAnyOfType(Ascii::IsAlpha))
+					return false;
+
+				s.DropByte();
+				while (s.StartsWithAnyOfType(Ascii::IsAlphaNum))
+					s.DropByte();
+
+				return true;
+			}
+
+			bool ReadStartTag(Seq& s, Seq specialTag, Seq& name, Seq& attrs)
+			{
+				Seq reader { s };
+				if (!ReadByteIs(reader, '<'))
+					return false;
+
+				Seq nameStart { reader };
+				if (!ReadTag(reader, specialTag) && reader.n)
+					return false;
+
+				Seq nameFound { SeqBetween(nameStart, reader) };
+
+				Seq attrsStart { reader };
+				Seq attrName, attrValue;
+				bool haveValue;
+				while (ReadWsAttr(reader, attrName, haveValue, attrValue)) {}
+				Seq attrsFound { SeqBetween(attrsStart, reader) };
+
+				ReadWs(reader);
+				ReadByteIs(reader, '/');
+				if (!ReadByteIs(reader, '>') && reader.n)
+					return false;
+
+				name = nameFound;
+				attrs = attrsFound;
+				s = reader;
+				return true;
+			}
+
+			bool ReadEndTag(Seq& s, Seq specialTag, Seq& name)
+			{
+				Seq reader { s };
+				if (!reader.StripPrefixExact("</"))
+					return false;
+
+				Seq nameStart { reader };
+				if (!ReadTag(reader, specialTag))
+					return false;
+
+				Seq nameFound { SeqBetween(nameStart, reader) };
+
+				ReadWs(reader);
+				if (!ReadByteIs(reader, '>') && reader.n)
+					return false;
+
+				name = nameFound;
+				s = reader;
+				return true;
+			}
+
+			bool AtEndTagStart(Seq s, Seq specialTag) { return s.StripPrefixExact("</") && ReadTag(s, specialTag); }
+
+			bool ReadTrashTag(Seq& s)
+			{
+				Seq reader { s };
+				if (!ReadByteIs(reader, '<'))
+					return false;
+
+				if (!reader.StartsWithAnyOfType([] (uint c) -> bool { return Ascii::IsAlpha(c) || c=='!' || c=='/'; }))
+					return false;
+
+				reader.DropByte();
+				while (ReadCharIf(reader, IsNonGrtrChar)) {}
+
+				if (!ReadByteIs(reader, '>'))
+					return false;
+
+				s = reader;
+				return true;
+			}
+
+			// C_Script, C_Style
+			bool ReadRawTextElem(Seq& s, Seq specialTag)
+			{
+				Seq reader { s };
+				Seq name, attrs;
+				if (!ReadStartTag(reader, specialTag, name, attrs))
+					return false;
+
+				while (!AtEndTagStart(reader, specialTag) && ReadCharIf(reader, IsAnyChar)) {}
+
+				if (!ReadEndTag(reader, specialTag, name) && reader.n)
+					return false;
+
+				s = reader;
+				return true;
+			}
+
+			// C_Title, C_TextArea. Content is read again as RawText and CharRef tokens once the whole element is known to match
+			bool ReadRcdataElem(Seq& s, Seq specialTag, Token& startTag, Seq& content, bool& haveEnd, Token& endTag)
+			{
+				Seq reader { s };
+				Seq tokenStart { reader };
+				Seq name, attrs;
+				if (!ReadStartTag(reader, specialTag, name, attrs))
+					return false;
+
+				Seq startTagSrc { SeqBetween(tokenStart, reader) };
+
+				Seq contentStart { reader };
+				while (!AtEndTagStart(reader, specialTag) && (ReadCharRef(reader) || ReadCharIf(reader, IsAnyChar))) {}
+				Seq contentFound { SeqBetween(contentStart, reader) };
+
+				Seq endTagStart { reader };
+				Seq endName;
+				bool endFound { ReadEndTag(reader, specialTag, endName) };
+				if (!endFound && reader.n)
+					return false;
+
+				startTag.m_type    = TokenType::StartTag;
+				startTag.m_src     = startTagSrc;
+				startTag.m_name    = name;
+				startTag.m_attrs   = attrs;
+				startTag.m_content = Seq();
+
+				content = contentFound;
+				haveEnd = endFound;
+				if (endFound)
+				{
+					endTag.m_type    = TokenType::EndTag;
+					endTag.m_src     = SeqBetween(endTagStart, reader);
+					endTag.m_name    = endName;
+					endTag.m_attrs   = Seq();
+					endTag.m_content = Seq();
+				}
+
+				s = reader;
+				return true;
+			}
+
+		} // anon
+
+
+
+		// Tokenizer
+
+		bool Tokenizer::Next(Token& token)
+		{
+			if (m_inRcdata)
+			{
+				if (m_rcdata.n)
+				{
+					NextRcdata(token);
+					return true;
+				}
+
+				m_inRcdata = false;
+				if (m_haveRcdataEnd)
+				{
+					m_haveRcdataEnd = false;
+					token = m_rcdataEnd;
+					return true;
+				}
+			}
+
+			if (!m_remaining.n)
+				return false;
+
+			Seq reader { m_remaining };
+			token.m_name    = Seq();
+			token.m_attrs   = Seq();
+			token.m_content = Seq();
+
+			// Alternatives are tried in the order of C_Particle
+			     if (ReadWs      (reader)) token.m_type = TokenType::Ws;
+			else if (ReadText    (reader)) token.m_type = TokenType::Text;
+			else if (ReadCharRef (reader)) token.m_type = TokenType::CharRef;
+			else if (reader.StartsWithByte('<'))
+			{
+				     if (ReadComment     (reader                                )) token.m_type = TokenType::Comment;
+				else if (ReadCData       (reader, token.m_content               )) token.m_type = TokenType::CData;
+				else if (ReadRawTextElem (reader, "script"                      )) token.m_type = TokenType::RawTextElem;
+				else if (ReadRawTextElem (reader, "style"                       )) token.m_type = TokenType::RawTextElem;
+				else if (ReadRcdataElem  (reader, "title",    token, m_rcdata, m_haveRcdataEnd, m_rcdataEnd)) { m_inRcdata = true; }
+				else if (ReadRcdataElem  (reader, "textarea", token, m_rcdata, m_haveRcdataEnd, m_rcdataEnd)) { m_inRcdata = true; }
+				else if (ReadStartTag    (reader, Seq(), token.m_name, token.m_attrs)) token.m_type = TokenType::StartTag;
+				else if (ReadEndTag      (reader, Seq(), token.m_name           )) token.m_type = TokenType::EndTag;
+				else if (ReadTrashTag    (reader                                )) token.m_type = TokenType::TrashTag;
+				else
+				{
+					reader.DropByte();
+					token.m_type = TokenType::SuspectChar;
+				}
+			}
+			else if (reader.StartsWithByte('&'))
+			{
+				reader.DropByte();
+				token.m_type = TokenType::SuspectChar;
+			}
+			else
+			{
+				// Invalid UTF-8. The grammar does not accept it
+				m_failed = true;
+				return false;
+			}
+
+			if (!m_inRcdata)
+				token.m_src = SeqBetween(m_remaining, reader);
+
+			m_remaining = reader;
+			return true;
+		}
+
+
+		void Tokenizer::NextRcdata(Token& token)
+		{
+			Seq reader { m_rcdata };
+			if (ReadCharRef(reader))
+				token.m_type = TokenType::CharRef;
+			else
+			{
+				// The content was already matched, so it consists of valid characters, and contains no end tag
+				while (reader.n)
+				{
+					Seq charRefReader { reader };
+					if (ReadCharRef(charRefReader))
+						break;
+
+					reader.DropUtf8_MaxChars(1);
+				}
+
+				token.m_type = TokenType::RawText;
+			}
+
+			token.m_src     = SeqBetween(m_rcdata, reader);
+			token.m_name    = Seq();
+			token.m_attrs   = Seq();
+			token.m_content = Seq();
+			m_rcdata = reader;
+		}
+
+
+
+		// AttrReader
+
+		bool AttrReader::Next(Seq& name, bool& haveValue, Seq& value)
+		{
+			return ReadWsAttr(m_remaining, name, haveValue, value);
+		}
+
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "AtHtmlGrammar.h"
+
+namespace At
+{
+	namespace Html
+	{
+		// Tokenizer
+
+		// Splits an HTML document into the same particles as the grammar in AtHtmlGrammar.cpp, without building a parse tree.
+		// Tokens are produced one at a time, in a single pass over the input, so memory use does not depend on document size.
+		//
+		// Elements with special content rules are recognized as in the grammar. A "script" or "style" element is returned as a single
+		// RawTextElem token. A "title" or "textarea" element is returned as its StartTag token, followed by RawText and CharRef tokens
+		// for its content, followed by its EndTag token if present.
+
+		struct TokenType { enum E { None, Ws, Text, CharRef, Comment, CData, RawTextElem, RawText, StartTag, EndTag, TrashTag, SuspectChar }; };
+
+		struct Token
+		{
+			TokenType::E m_type {};
+			Seq          m_src;			// Source text of the whole token
+			Seq          m_name;		// StartTag, EndTag: tag name as it appears in the source
+			Seq          m_attrs;		// StartTag: source text of the attributes, to be read with AttrReader
+			Seq          m_content;		// CData: content without the CDATA markers
+		};
+
+
+		class Tokenizer : NoCopy
+		{
+		public:
+			Tokenizer(Seq srcText) : m_remaining(srcText) {}
+
+			// Returns false when the input is exhausted, or when the remaining input cannot be tokenized. The latter happens
+			// in the same cases in which parsing with C_Document fails, and Failed() then returns true.
+			bool Next(Token& token);
+			bool Failed() const { return m_failed; }
+
+		private:
+			Seq   m_remaining;
+			bool  m_failed         {};
+
+			// Set while returning the content of a "title" or "textarea" element
+			bool  m_inRcdata       {};
+			Seq   m_rcdata;
+			bool  m_haveRcdataEnd  {};
+			Token m_rcdataEnd;
+
+			void NextRcdata(Token& token);
+		};
+
+
+		class AttrReader : NoCopy
+		{
+		public:
+			AttrReader(Seq attrs) : m_remaining(attrs) {}
+
+			// Returns false if there are no more attributes. If the attribute has a value, sets haveValue and returns the value
+			// without quotes. Does not perform conversions or resolve character references, same as ReadAttrValue.
+			bool Next(Seq& name, bool& haveValue, Seq& value);
+
+		private:
+			Seq m_remaining;
+		};
+	}
+}
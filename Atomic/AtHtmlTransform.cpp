@@ -156,6 +156,127 @@ namespace At
 		}
 
 
+		bool StreamTransform::ToEmbeddableHtml(HtmlBuilder& html, EmbedCx& cx)
+		{
+			// C_Document requires at least one particle
+			if (!m_srcText.n)
+				return false;
+
+			bool haveText {};
+			bool haveWs {};
+			Str elemTagLower;
+
+			auto onText = [&] () { if (!haveText) haveText = true; else if (haveWs) { html.T(" "); haveWs = false; } };
+
+			Tokenizer tokenizer { m_srcText };
+			Token token;
+			while (tokenizer.Next(token))
+			{
+				switch (token.m_type)
+				{
+				case TokenType::Ws:
+					haveWs = true;
+					break;
+
+				case TokenType::Text:
+				case TokenType::RawText:
+					onText();
+					html.T(token.m_src);
+					break;
+
+				case TokenType::CharRef:
+					onText();
+					html.AddTextUnescaped(token.m_src);
+					break;
+
+				case TokenType::CData:
+					if (token.m_content.n)
+						html.T(token.m_content);
+					break;
+
+				case TokenType::Comment:
+				case TokenType::RawTextElem:		// These are "script" and "style" elements. Ignore all content
+				case TokenType::TrashTag:
+					break;
+
+				case TokenType::StartTag:
+					{
+						ElemInfo const* ei = FindElemInfo_ByTagInsens(token.m_name);
+						if (ei && ei->m_embedAction == EmbedAction::Allow)
+						{
+							// Tags are emitted as they appear in the tables, which is the same as lowercased
+								 if (ei->m_type == ElemType::Void    ) html.AddVoidElem    (ei->m_tag);
+							else if (ei->m_type == ElemType::NonVoid ) html.AddNonVoidElem (ei->m_tag);
+							else
+							{
+								Str msg; msg.Add("Unrecognized ElemType: ").Add(ei->m_tag).Ch(0);
+								EnsureFailWithDesc(OnFail::Throw, msg.CharPtr(), __FUNCTION__, __LINE__);
+							}
+
+							cx.OnNewElem();
+
+							AttrReader attrReader { token.m_attrs };
+							Seq attrName, attrValueOrig;
+							bool haveValue;
+							while (attrReader.Next(attrName, haveValue, attrValueOrig))
+							{
+								AttrInfo const* ai = ei->FindAttrInfo_ByTagInsens(attrName);
+								if (ai && ai->m_embedAction == EmbedAction::Allow)
+								{
+									if (!haveValue)
+										html.AddAttr(ai->m_tag);
+									else
+									{
+										Seq attrValueSan = ai->m_embedSanitizer(attrValueOrig, cx);
+										html.AddAttr(ai->m_tag, attrValueSan);
+									}
+								}
+							}
+
+							if (ei->m_finalizer != nullptr)
+								ei->m_finalizer(html, cx);
+						}
+						break;
+					}
+
+				case TokenType::EndTag:
+					elemTagLower.Clear().Lower(token.m_name);
+
+					// If the end tag does not correspond to an open tag, ignore it.
+					if (html.m_tags.Contains(elemTagLower))
+					{
+						// The end tag corresponds to an open tag. Close this tag, as well as any other unclosed tags in between.
+						while (html.m_tags.Any())
+						{
+							Seq tagToClose = html.m_tags.Last();
+							bool done = tagToClose.EqualExact(elemTagLower);
+							html.EndNonVoidElem(tagToClose);
+							if (done)
+								break;
+						}
+					}
+					break;
+
+				case TokenType::SuspectChar:
+					html.T(token.m_src);
+					break;
+
+				default:
+					EnsureThrow(!"Unrecognized HTML token type");
+				}
+			}
+
+			if (tokenizer.Failed())
+				return false;
+
+			// Close open tags
+			while (html.m_tags.Any())
+				html.EndNonVoidElem(html.m_tags.Last());
+
+			return true;
+		}
+
+
 		TextBuilder& Transform::ToText(TextBuilder& text, EmbedCx& /*cx*/)
 		{
 			// ...
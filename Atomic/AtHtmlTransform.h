@@ -3,6 +3,7 @@
 #include "AtHtmlBuilder.h"
 #include "AtHtmlEmbed.h"
 #include "AtHtmlGrammar.h"
+#include "AtHtmlTokenizer.h"
 #include "AtTextBuilder.h"
 
 
@@ -26,5 +27,21 @@ namespace At
 		private:
 			ParseTree m_tree;
 		};
+
+
+		// Produces the same output as Transform::ToEmbeddableHtml in a single pass over the source, without building a parse tree.
+		// Memory use does not depend on the size of the source, other than for the output. Suitable for large inbound email bodies.
+
+		class StreamTransform : NoCopy
+		{
+		public:
+			StreamTransform(Seq srcText) : m_srcText(srcText) {}
+
+			// Returns false in the same cases in which Transform::Parse would fail. Output is then incomplete, and should be discarded
+			bool ToEmbeddableHtml(HtmlBuilder& html, EmbedCx& cx);
+
+		private:
+			Seq m_srcText;
+		};
 	}
 }
@@ -164,7 +164,7 @@ namespace At
 		m_ipFairThrottle.SetMaxHoldsGlobal(128 * std::thread::hardware_concurrency());
 
 		// Init log
-		m_requestLog.Init(Str(HttpServer_LogNamePrefix()).Add("HttpLog"), TextLog::Flags::AutoRollover);
+		m_requestLog.Init(Str(HttpServer_LogNamePrefix()).Add("HttpLog"), TextLog::Flags::AutoRollover | TextLog::Flags::Async);
 
 		// Give application opportunity to call SyncUrls()
 		HttpServer_SyncUrls();
@@ -204,7 +204,8 @@ namespace At
 			else
 				throw WinErr<>(ulRet, "Error in HttpReceiveHttpRequest");
 
-			EnqueueWorkItem(workItem);
+			if (!EnqueueWorkItem(workItem))
+				HttpCancelHttpRequest(m_httpHandle, ((HTTP_REQUEST*) workItem->m_reqBuf.Ptr())->RequestId, 0);
 		}
 	}
 
@@ -22,7 +22,8 @@ namespace At
 	class HttpServer : public WebServer<HttpServerThread, HttpServerWorkItem>
 	{
 	protected:
-		HttpServer() : m_httpHandle(INVALID_HANDLE_VALUE), m_httpEvent(Event::CreateAuto) {}
+		// Requests received while the backlog is full are cancelled, as when the IP throttle rejects them
+		HttpServer() : m_httpHandle(INVALID_HANDLE_VALUE), m_httpEvent(Event::CreateAuto) { SetMaxBacklog(MaxBacklog, BacklogPolicy::Reject); }
 		~HttpServer();
 
 		// Can be called from any thread. Adds new URLs to listen on. Removes URLs not on the list. Does not touch unchanged URLs.
@@ -47,7 +48,7 @@ namespace At
 		bool           m_closed {};
 		Vec<UrlState>  m_urls;
 
-		enum { ReqBufSize = 65000 };
+		enum { ReqBufSize = 65000, MaxBacklog = 1000 };
 		HANDLE         m_httpHandle;
 		Event          m_httpEvent;
 		OVERLAPPED     m_ovl;
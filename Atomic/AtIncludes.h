@@ -114,6 +114,7 @@
 
 #include <eh.h>
 #include <intrin.h>
+#include <locale.h>
 #include <math.h>
 #include <process.h>
 #include <stddef.h>
@@ -29,22 +29,31 @@ namespace At
 		static_assert(sizeof(m_perLevelHashSeeds) == 4*sizeof(uint64), "Unexpected");
 		Crypt::GenRandom(m_perLevelHashSeeds, sizeof(m_perLevelHashSeeds));
 
-		// Initialize bucket vectors
+		// Initialize hold slots. All slots start out free
 		for (sizet iLevel=0; iLevel!=4; ++iLevel)
 		{
 			Level& level { m_levels[iLevel] };
-			level.m_buckets.ResizeExact(m_nrBucketsPerLevel);
-			for (Bucket& bucket : level.m_buckets)
-				bucket.m_holds.FixCap(m_maxHoldsPerBucket);
+			level.m_nrBuckets = m_nrBucketsPerLevel;
+			level.m_holds.ResizeExact(m_nrBucketsPerLevel * m_maxHoldsPerBucket);
 		}
 
 		m_inited = true;
 	}
 
 
+	void IpFairThrottle::CheckInit()
+	{
+		if (!m_inited)
+		{
+			Locker locker { m_initMx };
+			if (!m_inited)
+				Init();
+		}
+	}
+
+
 	bool IpFairThrottle::TryAcquireHold(SockAddr const& sa, Time durationUntilExpire, HoldLocator& hl)
 	{
-		Locker locker { m_mx };
 		CheckInit();
 
 		bool          success = TryAcquireHold_Inner(3, sa, durationUntilExpire, hl);
@@ -63,45 +72,62 @@ namespace At
 		else if (sa.IsIp6())                        ipHash = Ip6Hash(levelIndex, sa.GetIp6Hi());
 		else EnsureThrow(!"Unexpected address type");
 
-		Level&  level       { m_levels[levelIndex] };
-		sizet   bucketIndex { ipHash % level.m_buckets.Len() };
-		Bucket& bucket      { level.m_buckets[bucketIndex] };
+		Level& level       { m_levels[levelIndex] };
+		sizet  bucketIndex { ipHash % level.m_nrBuckets };
+		Hold*  holds       { level.BucketHolds(bucketIndex, m_maxHoldsPerBucket) };
 
 		Time now { Time::Min() };
-		if (bucket.m_holds.Len() >= m_maxHoldsPerBucket)
+		Hold* hold { TryClaimSlot(holds, m_maxHoldsPerBucket) };
+		if (!hold)
 		{
-			// Clear any expired holds
+			// Clear any expired holds. The expiry time is read after the ID, and is set only while the slot is reserved,
+			// so if the slot changed in between, the compare-and-swap fails
 			now = Time::StrictNow();
-			for (sizet i=0; i!=bucket.m_holds.Len(); )
-				if (now >= bucket.m_holds[i].m_timeExpires)
-					bucket.m_holds.Erase(i, 1);
-				else
-					++i;
+			for (sizet i=0; i!=m_maxHoldsPerBucket; ++i)
+			{
+				LONG64 id = holds[i].m_id;
+				if (id != SlotFree && id != SlotReserved && now >= holds[i].m_timeExpires)
+					InterlockedCompareExchange64(&holds[i].m_id, SlotFree, id);
+			}
 
-			if (bucket.m_holds.Len() >= m_maxHoldsPerBucket)
+			hold = TryClaimSlot(holds, m_maxHoldsPerBucket);
+			if (!hold)
 				return false;
 		}
 
-		Hold& hold { bucket.m_holds.Add() };
-		hold.m_id = m_nextHoldId++;
+		LONG64 holdId { InterlockedIncrement64(&m_lastHoldId) };
 		
 		if (durationUntilExpire == Time::Max())
-			hold.m_timeExpires = Time::Max();
+			hold->m_timeExpires = Time::Max();
 		else
 		{
 			if (now == Time::Min())
 				now = Time::StrictNow();
 
-			hold.m_timeExpires = now + durationUntilExpire;
+			hold->m_timeExpires = now + durationUntilExpire;
 		}
 
+		InterlockedExchange64(&hold->m_id, holdId);
+
 		hl.m_levelIndex  = levelIndex;
 		hl.m_bucketIndex = bucketIndex;
-		hl.m_holdId      = hold.m_id;
+		hl.m_holdId      = (uint64) holdId;
 		return true;
 	}
 
 
+	IpFairThrottle::Hold* IpFairThrottle::TryClaimSlot(Hold* holds, sizet nrHolds)
+	{
+		// On x86, reads of IDs may be torn. This is harmless: compare-and-swap fails if the slot was not actually free
+		for (sizet i=0; i!=nrHolds; ++i)
+			if (holds[i].m_id == SlotFree)
+				if (InterlockedCompareExchange64(&holds[i].m_id, SlotReserved, SlotFree) == SlotFree)
+					return &holds[i];
+
+		return nullptr;
+	}
+
+
 	uint32 IpFairThrottle::Ip4Hash(sizet levelIndex, uint32 ip4)
 	{
 		     if (levelIndex == 0) ip4 &= 0xFF000000;
@@ -136,19 +162,18 @@ namespace At
 
 	bool IpFairThrottle::ReleaseHold(HoldLocator hl)
 	{
-		Locker locker { m_mx };
 		EnsureThrow(m_inited);
 
 		EnsureThrow(hl.m_levelIndex < 4);
-		Level&  level  = m_levels[hl.m_levelIndex];
-		Bucket& bucket = level.m_buckets[hl.m_bucketIndex];
-
-		for (sizet i=0; i!=bucket.m_holds.Len(); ++i)
-			if (bucket.m_holds[i].m_id == hl.m_holdId)
-			{
-				bucket.m_holds.Erase(i, 1);
-				return true;
-			}
+		Level& level = m_levels[hl.m_levelIndex];
+		Hold*  holds = level.BucketHolds(hl.m_bucketIndex, m_maxHoldsPerBucket);
+
+		// The hold may have expired, and been cleared by another thread. Its ID is not reused, so it is then not found
+		LONG64 holdId = (LONG64) hl.m_holdId;
+		for (sizet i=0; i!=m_maxHoldsPerBucket; ++i)
+			if (holds[i].m_id == holdId)
+				if (InterlockedCompareExchange64(&holds[i].m_id, SlotFree, holdId) == holdId)
+					return true;
 
 		return false;
 	}
@@ -14,6 +14,9 @@ namespace At
 	// - An attacker who can vary 2 of 4 parts of their IP address (e.g. lowest 2 bytes IPv4, lowest 64 bits IPv6) can tie up ~50% of the server's resources.
 	// - An attacker who can vary 3 of 4 parts of their IP address can tie up ~75% of the server's resources.
 	// - An attacker has to be able to vary all parts of their IP address in order to tie up 100% of the server's resources.
+	//
+	// Acquiring and releasing holds is lock-free. Each bucket is a fixed array of hold slots, claimed and released using
+	// compare-and-swap, so threads serving unrelated addresses do not contend with each other.
 
 	class IpFairThrottle
 	{
@@ -52,20 +55,23 @@ namespace At
 		bool ReleaseHold(HoldLocator hl);
 
 	private:
-		struct Hold
-		{
-			uint64 m_id;
-			Time   m_timeExpires;
-		};
+		// A slot is free if its ID is zero. A thread claiming a slot first sets its ID to SlotReserved, then sets the expiry time,
+		// and then publishes the hold ID. Every change to an ID is made using compare-and-swap, and hold IDs are never reused,
+		// so a thread acting on a stale read of a slot fails the compare-and-swap instead of affecting another hold.
+		enum : LONG64 { SlotFree = 0, SlotReserved = -1 };
 
-		struct Bucket
+		struct Hold
 		{
-			Vec<Hold> m_holds;
+			LONG64 volatile m_id {};
+			Time            m_timeExpires;
 		};
 
 		struct Level
 		{
-			Vec<Bucket> m_buckets;
+			sizet     m_nrBuckets {};
+			Vec<Hold> m_holds;			// m_maxHoldsPerBucket consecutive slots per bucket
+
+			Hold* BucketHolds(sizet bucketIndex, sizet maxHoldsPerBucket) { EnsureThrow(bucketIndex < m_nrBuckets); return m_holds.Ptr() + (bucketIndex * maxHoldsPerBucket); }
 		};
 
 		// Set by user before init
@@ -73,18 +79,19 @@ namespace At
 		sizet  m_maxHoldsGlobal {};
 
 		// Set on init
-		bool   m_inited {};
-		sizet  m_nrBucketsPerLevel;
-		sizet  m_maxHoldsPerBucket;
-		uint64 m_perLevelHashSeeds[4];
+		bool volatile   m_inited {};
+		sizet           m_nrBucketsPerLevel;
+		sizet           m_maxHoldsPerBucket;
+		uint64          m_perLevelHashSeeds[4];
 
-		Mutex  m_mx;
-		uint64 m_nextHoldId {};
-		Level  m_levels[4];
+		Mutex           m_initMx;
+		LONG64 volatile m_lastHoldId {};
+		Level           m_levels[4];
 
-		void CheckInit() { if (!m_inited) Init(); }
+		void CheckInit();
 		void Init();
 		bool TryAcquireHold_Inner(sizet levelIndex, SockAddr const& sa, Time durationUntilExpire, HoldLocator& hl);
+		static Hold* TryClaimSlot(Hold* holds, sizet nrHolds);
 		uint32 Ip4Hash(sizet levelIndex, uint32 ip4);
 		uint32 Ip6Hash(sizet levelIndex, uint64 ip6hi);
 	};
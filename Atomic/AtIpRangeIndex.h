@@ -0,0 +1,226 @@
+#pragma once
+
+#include "AtEnsure.h"
+#include "AtNum.h"
+#include "AtVec.h"
+
+
+namespace At
+{
+
+	// IP address keys. Addresses compare as big-endian integers, so IPv6 addresses are held as two 64-bit integers,
+	// and a comparison costs two integer comparisons instead of a memcmp
+
+	inline uint32 Ip4Key(byte const* p) { return (((uint32) p[0]) << 24) | (((uint32) p[1]) << 16) | (((uint32) p[2]) << 8) | ((uint32) p[3]); }
+
+	struct Ip6Key
+	{
+		uint64 m_hi {};
+		uint64 m_lo {};
+
+		Ip6Key() = default;
+		Ip6Key(uint64 hi, uint64 lo) : m_hi(hi), m_lo(lo) {}
+		explicit Ip6Key(byte const* p) : m_hi(ReadHalf(p)), m_lo(ReadHalf(p + 8)) {}
+
+		bool operator== (Ip6Key const& x) const { return m_hi == x.m_hi && m_lo == x.m_lo; }
+		bool operator<  (Ip6Key const& x) const { return m_hi < x.m_hi || (m_hi == x.m_hi && m_lo <  x.m_lo); }
+		bool operator<= (Ip6Key const& x) const { return m_hi < x.m_hi || (m_hi == x.m_hi && m_lo <= x.m_lo); }
+
+	private:
+		static uint64 ReadHalf(byte const* p) { return (((uint64) Ip4Key(p)) << 32) | ((uint64) Ip4Key(p + 4)); }
+	};
+
+	inline uint32 IpKeyMax(uint32) { return UINT32_MAX; }
+	inline Ip6Key IpKeyMax(Ip6Key) { return Ip6Key(UINT64_MAX, UINT64_MAX); }
+
+
+
+	// IpRangeTree
+
+	// Finds, among non-overlapping ranges sorted by first key, the last range whose first key is less than or equal to a key.
+	// The caller then checks whether the key is also within the end of that range.
+	//
+	// First keys are stored in Eytzinger order: the root is at index 1, and the children of node k are at 2k and 2k+1.
+	// The top levels of the tree share a few cache lines, and the nodes a search visits next can be prefetched before they are needed.
+	// The tree is padded with maximum keys to a complete tree, so every search takes the same number of steps, and the index
+	// reached below the last level equals the number of first keys less than or equal to the key. This also allows FindBatch to
+	// advance several searches in lockstep, overlapping their memory accesses. The tree does not own its storage, so it can be
+	// used on a tree stored in a mapped file.
+
+	template <class Key>
+	class IpRangeTree
+	{
+	public:
+		enum : uint32 { None = UINT32_MAX };
+
+		// Builds the tree from first keys in ascending order. The tree length is a power of 2, at most twice the number of keys
+		static void Build(Slice<Key> firstKeys, Vec<Key>& tree)
+		{
+			EnsureThrow(firstKeys.Len() < None);
+
+			uint height {};
+			while (((sizet) 1 << height) <= firstKeys.Len())
+				++height;
+
+			sizet const size = (sizet) 1 << height;
+			tree.Clear().ResizeExact(size);
+			tree[0] = IpKeyMax(Key());
+
+			// In a complete tree, the in-order rank of node k at depth d follows from its position within the level
+			uint depth {};
+			for (sizet k=1; k!=size; ++k)
+			{
+				if (k == ((sizet) 2 << depth))
+					++depth;
+
+				sizet rank = ((2 * (k - ((sizet) 1 << depth)) + 1) << (height - 1 - depth)) - 1;
+				tree[k] = If(rank < firstKeys.Len(), Key, firstKeys[rank], IpKeyMax(Key()));
+			}
+		}
+
+		IpRangeTree() = default;
+		IpRangeTree(Slice<Key> tree, sizet nrRanges) { Set(tree, nrRanges); }
+
+		void Set(Slice<Key> tree, sizet nrRanges)
+		{
+			EnsureThrow(tree.Any() && (tree.Len() & (tree.Len() - 1)) == 0);
+			EnsureThrow(nrRanges < tree.Len());
+
+			m_tree = tree.begin();
+			m_size = tree.Len();
+			m_nrRanges = (uint32) nrRanges;
+			m_height = 0;
+			while (((sizet) 1 << m_height) < m_size)
+				++m_height;
+		}
+
+		// Returns the index of the candidate range in sorted order, or None if the key precedes all ranges
+		uint32 Find(Key key) const
+		{
+			sizet k = 1;
+			for (uint level=0; level!=m_height; ++level)
+			{
+				Prefetch(k);
+				k = 2*k + (m_tree[k] <= key);
+			}
+
+			return Result(k);
+		}
+
+		void FindBatch(Key const* keys, sizet nrKeys, uint32* results) const
+		{
+			enum { GroupSize = 8 };
+
+			for (sizet base=0; base<nrKeys; base+=GroupSize)
+			{
+				sizet const n = PickMin<sizet>(GroupSize, nrKeys - base);
+				sizet k[GroupSize];
+				for (sizet j=0; j!=n; ++j)
+					k[j] = 1;
+
+				for (uint level=0; level!=m_height; ++level)
+					for (sizet j=0; j!=n; ++j)
+					{
+						Prefetch(k[j]);
+						k[j] = 2*k[j] + (m_tree[k[j]] <= keys[base+j]);
+					}
+
+				for (sizet j=0; j!=n; ++j)
+					results[base+j] = Result(k[j]);
+			}
+		}
+
+	private:
+		// Descendants of node k that are a cache line of keys below it are adjacent, starting at k * PrefetchStride
+		enum { PrefetchStride = 64 / sizeof(Key) };
+
+		Key const* m_tree     {};
+		sizet      m_size     {};
+		uint32     m_nrRanges {};
+		uint       m_height   {};
+
+		void Prefetch(sizet k) const
+		{
+			if (k * PrefetchStride < m_size)
+				_mm_prefetch((char const*) (m_tree + k * PrefetchStride), _MM_HINT_T0);
+		}
+
+		uint32 Result(sizet k) const
+		{
+			// Padding keys are maximum keys, so a maximum key can count some of them
+			sizet nrLessOrEqual = PickMin<sizet>(k - m_size, m_nrRanges);
+			return If(nrLessOrEqual == 0, uint32, None, (uint32) (nrLessOrEqual - 1));
+		}
+	};
+
+
+
+	// IpRangeIndex
+
+	// Owns non-overlapping ranges of keys associated with values, and finds the range containing a key using IpRangeTree.
+	// Not copyable, because the search object refers to the tree owned by the index
+
+	template <class Key, class Val>
+	class IpRangeIndex : NoCopy
+	{
+	public:
+		// Ranges must be added in ascending order, and must not overlap. Call Build after adding ranges, before lookups
+		void Add(Key first, Key last, Val const& val)
+		{
+			EnsureThrow(!m_built);
+			EnsureThrow(first <= last);
+			EnsureThrow(!m_lasts.Any() || m_lasts.Last() < first);
+
+			m_firsts.Add(first);
+			m_lasts.Add(last);
+			m_vals.Add(val);
+		}
+
+		void Build()
+		{
+			IpRangeTree<Key>::Build(m_firsts, m_tree);
+			m_search.Set(m_tree, m_vals.Len());
+			m_built = true;
+		}
+
+		sizet Len() const { return m_vals.Len(); }
+
+		// Returns nullptr if no range contains the key
+		Val const* Find(Key key) const
+		{
+			EnsureThrow(m_built);
+			return Resolve(key, m_search.Find(key));
+		}
+
+		void FindBatch(Key const* keys, sizet nrKeys, Val const** results) const
+		{
+			EnsureThrow(m_built);
+
+			enum { ChunkSize = 256 };
+			uint32 candidates[ChunkSize];
+			for (sizet base=0; base<nrKeys; base+=ChunkSize)
+			{
+				sizet const n = PickMin<sizet>(ChunkSize, nrKeys - base);
+				m_search.FindBatch(keys + base, n, candidates);
+				for (sizet i=0; i!=n; ++i)
+					results[base+i] = Resolve(keys[base+i], candidates[i]);
+			}
+		}
+
+	private:
+		Vec<Key>         m_firsts;
+		Vec<Key>         m_lasts;
+		Vec<Val>         m_vals;
+		Vec<Key>         m_tree;
+		IpRangeTree<Key> m_search;
+		bool             m_built {};
+
+		Val const* Resolve(Key key, uint32 candidate) const
+		{
+			if (candidate == IpRangeTree<Key>::None || m_lasts[candidate] < key)
+				return nullptr;
+			return &m_vals[candidate];
+		}
+	};
+
+}
@@ -67,11 +67,87 @@ namespace At
 		// Decode
 
 		DecodeErr::DecodeErr(ParseNode const& p, Seq s)
-			: StrErr(Str("JSON decode error at row ").UInt(p.StartRow()).Add(", col ").UInt(p.StartCol()).Add(": ").Add(s))
+			: DecodeErr(p.StartRow(), p.StartCol(), s)
 		{
 		}
 
 
+		DecodeErr::DecodeErr(sizet row, sizet col, Seq s)
+			: StrErr(Str("JSON decode error at row ").UInt(row).Add(", col ").UInt(col).Add(": ").Add(s))
+		{
+		}
+
+
+		char const* DecodeUIntText(Seq text, uint64& v)
+		{
+			Seq reader { text };
+			v = reader.ReadNrUInt64Dec();
+			if (reader.n != 0)
+			{
+				reader = text;
+				double dv = reader.ReadDoubleExact();
+				if (reader.n != 0)
+					return "Unexpected number format";
+				if (dv < 0 || dv > (double) UINT64_MAX)
+					return "Expected unsigned number out of range";
+
+				v = (uint64) (dv + 0.5);
+			}
+
+			return nullptr;
+		}
+
+
+		char const* DecodeSIntText(Seq text, int64& v)
+		{
+			Seq reader { text };
+			v = reader.ReadNrSInt64Dec();
+			if (reader.n != 0)
+			{
+				reader = text;
+				double dv = reader.ReadDoubleExact();
+				if (reader.n != 0)
+					return "Unexpected number format";
+				if (dv < (double) INT64_MIN || dv > (double) INT64_MAX)
+					return "Expected signed number out of range";
+
+				v = (int64) If(dv >= 0.0, double, (dv + 0.5), (dv - 0.5));
+			}
+
+			return nullptr;
+		}
+
+
+		char const* DecodeFloatText(Seq text, double& v)
+		{
+			Seq reader { text };
+			v = reader.ReadDoubleExact();
+			if (reader.n != 0)
+				return "Unexpected number format";
+
+			return nullptr;
+		}
+
+
+		char const* DecodeTimeNr(Seq text)
+		{
+			if (!text.EqualExact("0"))
+				return "Date-time is encoded as a number and it is not 0";
+
+			return nullptr;
+		}
+
+
+		char const* DecodeTimeStr(Seq s, Time& v)
+		{
+			Seq reader { s };
+			if (!reader.ReadIsoStyleTimeStr(v) || !reader.EqualExact("Z"))
+				return "Expected ISO 8601-style UTC date or date-time";
+
+			return nullptr;
+		}
+
+
 		uint DecodeEscUnicode(ParseNode const& p)
 		{
 			if (!p.IsType(id_EscUnicode))
@@ -171,19 +247,10 @@ namespace At
 			if (!p.IsType(Json::id_Number))
 				throw Json::DecodeErr(p, "Expected number");
 
-			Seq    reader { p.SrcText() };
-			uint64 v      { reader.ReadNrUInt64Dec() };
-			if (reader.n != 0)
-			{
-				reader = p.SrcText();
-				double dv = reader.ReadDouble();
-				if (reader.n != 0)
-					throw Json::DecodeErr(p, "Unexpected number format");
-				if (dv < 0 || dv > (double) UINT64_MAX)
-					throw Json::DecodeErr(p, "Expected unsigned number out of range");
-
-				v = (uint64) (dv + 0.5);
-			}
+			uint64 v;
+			char const* err = DecodeUIntText(p.SrcText(), v);
+			if (err)
+				throw Json::DecodeErr(p, err);
 
 			return v;
 		}
@@ -194,19 +261,10 @@ namespace At
 			if (!p.IsType(Json::id_Number))
 				throw Json::DecodeErr(p, "Expected number");
 
-			Seq   reader { p.SrcText() };
-			int64 v      { reader.ReadNrSInt64Dec() };
-			if (reader.n != 0)
-			{
-				reader = p.SrcText();
-				double dv = reader.ReadDouble();
-				if (reader.n != 0)
-					throw Json::DecodeErr(p, "Unexpected number format");
-				if (dv < (double) INT64_MIN || dv > (double) INT64_MAX)
-					throw Json::DecodeErr(p, "Expected signed number out of range");
-
-				v = (int64) If(dv >= 0.0, double, (dv + 0.5), (dv - 0.5));
-			}
+			int64 v;
+			char const* err = DecodeSIntText(p.SrcText(), v);
+			if (err)
+				throw Json::DecodeErr(p, err);
 
 			return v;
 		}
@@ -217,24 +275,22 @@ namespace At
 			if (!p.IsType(Json::id_Number))
 				throw Json::DecodeErr(p, "Expected number");
 
-			Seq    reader { p.SrcText() };
-			double dv     { reader.ReadDouble() };
-			if (reader.n != 0)
-				throw Json::DecodeErr(p, "Unexpected number format");
+			double v;
+			char const* err = DecodeFloatText(p.SrcText(), v);
+			if (err)
+				throw Json::DecodeErr(p, err);
 
-			return dv;
+			return v;
 		}
 
 
 		Time DecodeTime(ParseNode const& p)
 		{
-			Time v;
+			Time        v;
+			char const* err;
 
 			if (p.IsType(Json::id_Number))
-			{
-				if (!p.SrcText().EqualExact("0"))
-					throw Json::DecodeErr(p, "Date-time is encoded as a number and it is not 0");
-			}
+				err = DecodeTimeNr(p.SrcText());
 			else
 			{
 				if (!p.IsType(Json::id_String))
@@ -242,12 +298,12 @@ namespace At
 
 				Str s;
 				Json::DecodeString(p, s);
-
-				Seq reader { s };
-				if (!reader.ReadIsoStyleTimeStr(v) || !reader.EqualExact("Z"))
-					throw Json::DecodeErr(p, "Expected ISO 8601-style UTC date or date-time");
+				err = DecodeTimeStr(s, v);
 			}
 
+			if (err)
+				throw Json::DecodeErr(p, err);
+
 			return v;
 		}
 
@@ -21,7 +21,19 @@ namespace At
 
 		// Decode
 
-		struct DecodeErr : public StrErr { DecodeErr(ParseNode const& p, Seq s); };
+		struct DecodeErr : public StrErr
+		{
+			DecodeErr(ParseNode const& p, Seq s);
+			DecodeErr(sizet row, sizet col, Seq s);
+		};
+
+		// Shared by the ParseTree-based decoder below and Json::StreamDecoder.
+		// Each function returns nullptr on success, or a description of the error.
+		char const* DecodeUIntText  (Seq text, uint64& v);
+		char const* DecodeSIntText  (Seq text, int64&  v);
+		char const* DecodeFloatText (Seq text, double& v);
+		char const* DecodeTimeNr    (Seq text);
+		char const* DecodeTimeStr   (Seq s,    Time&   v);
 
 		void   DecodeString (ParseNode const& p, Enc& enc);
 		bool   DecodeBool   (ParseNode const& p);
@@ -0,0 +1,624 @@
+#include "AtIncludes.h"
+#include "AtJsonStream.h"
+
+#include "AtUnicode.h"
+#include "AtUtf8.h"
+
+
+namespace At
+{
+	namespace Json
+	{
+		namespace
+		{
+			inline uint CountTrailingZeros64(uint64 x) noexcept
+			{
+				unsigned long i;
+			#ifdef _M_X64
+				_BitScanForward64(&i, x);
+				return (uint) i;
+			#else
+				if (_BitScanForward(&i, (unsigned long) x))
+					return (uint) i;
+				_BitScanForward(&i, (unsigned long) (x >> 32));
+				return 32 + (uint) i;
+			#endif
+			}
+
+
+			inline uint64 MoveMask(__m128i v, uint shift) noexcept
+			{
+				return ((uint64) (uint) _mm_movemask_epi8(v)) << shift;
+			}
+
+
+			// Sets one bit per byte of a 64-byte block for each character class of interest
+			void ClassifyBlock(byte const* p, uint64& quotes, uint64& backslashes, uint64& ops) noexcept
+			{
+				__m128i const chQuote      = _mm_set1_epi8('"');
+				__m128i const chBackslash  = _mm_set1_epi8('\\');
+				__m128i const chCurlyOpen  = _mm_set1_epi8('{');
+				__m128i const chCurlyClose = _mm_set1_epi8('}');
+				__m128i const chColon      = _mm_set1_epi8(':');
+				__m128i const chComma      = _mm_set1_epi8(',');
+				__m128i const bit5         = _mm_set1_epi8(0x20);
+
+				quotes = backslashes = ops = 0;
+				for (uint i=0; i!=4; ++i)
+				{
+					__m128i v = _mm_loadu_si128((__m128i const*) (p + (16*i)));
+
+					// Setting bit 5 maps '[' onto '{' and ']' onto '}', and no other byte onto either
+					__m128i f = _mm_or_si128(v, bit5);
+					__m128i o = _mm_or_si128(
+									_mm_or_si128(_mm_cmpeq_epi8(f, chCurlyOpen), _mm_cmpeq_epi8(f, chCurlyClose)),
+									_mm_or_si128(_mm_cmpeq_epi8(v, chColon),     _mm_cmpeq_epi8(v, chComma)));
+
+					quotes      |= MoveMask(_mm_cmpeq_epi8(v, chQuote),     16*i);
+					backslashes |= MoveMask(_mm_cmpeq_epi8(v, chBackslash), 16*i);
+					ops         |= MoveMask(o,                              16*i);
+				}
+			}
+
+
+			// Returns a mask of characters escaped by a preceding unescaped backslash. Runs of backslashes are rare
+			// in practice, so they are resolved one at a time. "carry" is 1 if the previous block ended with an
+			// unescaped backslash, and is updated for the next block.
+			uint64 FindEscaped(uint64 backslashes, uint64& carry) noexcept
+			{
+				uint64 escaped = carry;
+				backslashes &= ~escaped;
+				carry = 0;
+
+				while (backslashes)
+				{
+					uint i = CountTrailingZeros64(backslashes);
+					if (i == 63)
+						carry = 1;
+					else
+					{
+						uint64 next = 1ULL << (i + 1);
+						escaped |= next;
+						backslashes &= ~next;
+					}
+
+					backslashes &= backslashes - 1;
+				}
+
+				return escaped;
+			}
+
+
+			// Bit i of the result is the XOR of bits 0 through i of the input
+			inline uint64 PrefixXor(uint64 x) noexcept
+			{
+				x ^= x << 1;
+				x ^= x << 2;
+				x ^= x << 4;
+				x ^= x << 8;
+				x ^= x << 16;
+				x ^= x << 32;
+				return x;
+			}
+		}
+
+
+
+		// Structural index
+
+		void BuildStructuralIndex(Seq json, Vec<uint32>& index)
+		{
+			EnsureThrow(json.n < UINT32_MAX);
+
+			uint64 prevEscaped  {};		// 1 if the previous block ended with an unescaped backslash
+			uint64 prevInString {};		// All bits set if the previous block ended inside a string
+			byte   tail[64];
+
+			for (sizet base=0; base < json.n; base += 64)
+			{
+				byte const* block = json.p + base;
+				sizet remaining = json.n - base;
+				if (remaining < 64)
+				{
+					memset(tail, ' ', 64);
+					memcpy(tail, block, remaining);
+					block = tail;
+				}
+
+				uint64 quotes, backslashes, ops;
+				ClassifyBlock(block, quotes, backslashes, ops);
+
+				quotes &= ~FindEscaped(backslashes, prevEscaped);
+
+				// Opening quotes and string contents are set in this mask, closing quotes are not
+				uint64 inString = PrefixXor(quotes) ^ prevInString;
+				prevInString = 0ULL - (inString >> 63);
+
+				uint64 structural = (ops & ~inString) | quotes;
+				while (structural)
+				{
+					index.Add((uint32) (base + CountTrailingZeros64(structural)));
+					structural &= structural - 1;
+				}
+			}
+		}
+
+
+
+		// StreamDecoder
+
+		StreamDecoder::StreamDecoder(Seq json)
+			: m_json(json)
+		{
+			m_index.ReserveExact(json.n / 8);
+			BuildStructuralIndex(json, m_index);
+		}
+
+
+		sizet StreamDecoder::SkipWs()
+		{
+			while (m_pos < m_json.n && Ascii::IsWhitespace(m_json.p[m_pos]))
+				++m_pos;
+
+			return m_pos;
+		}
+
+
+		sizet StreamDecoder::ValuePos()
+		{
+			return SkipWs();
+		}
+
+
+		ValType StreamDecoder::PeekType()
+		{
+			sizet pos = SkipWs();
+			if (pos == m_json.n)
+				throw Err(pos, "Expected value, reached end of input");
+
+			byte c = m_json.p[pos];
+			switch (c)
+			{
+			case '"': return ValType::String;
+			case '[': return ValType::Array;
+			case '{': return ValType::Object;
+			case 't': return ValType::True;
+			case 'f': return ValType::False;
+			case 'n': return ValType::Null;
+			default:
+				if (c == '-' || Ascii::IsDecDigit(c))
+					return ValType::Number;
+
+				throw Err(pos, "Expected value");
+			}
+		}
+
+
+		bool StreamDecoder::TryDecodeNull()
+		{
+			sizet pos = SkipWs();
+			if (!Seq(m_json.p + pos, m_json.n - pos).StartsWithExact("null"))
+				return false;
+
+			m_pos = pos + 4;
+			return true;
+		}
+
+
+		Seq StreamDecoder::ReadStringContent(sizet& openPos)
+		{
+			openPos = SkipWs();
+			if (!AtStructural(openPos, '"'))
+				throw Err(openPos, "Expected string");
+
+			// Characters inside a string are not indexed, so the next index entry is the closing quote
+			if (m_indexPos + 1 >= m_index.Len())
+				throw Err(openPos, "Unterminated string");
+
+			sizet closePos = m_index[m_indexPos + 1];
+			m_indexPos += 2;
+			m_pos = closePos + 1;
+			return Seq(m_json.p + openPos + 1, closePos - openPos - 1);
+		}
+
+
+		void StreamDecoder::DecodeStringContent(Seq content, sizet contentPos, Enc* enc)
+		{
+			if (enc)
+				enc->ReserveInc(content.n);
+
+			byte const* p   { content.p };
+			byte const* end { content.p + content.n };
+
+			uint leadSurrogate {};
+			bool needTrailSurrogate {};
+
+			while (p != end)
+			{
+				sizet elemPos = contentPos + (sizet) (p - content.p);
+
+				if (*p != '\\')
+				{
+					if (needTrailSurrogate)
+						throw Err(elemPos, "Expected Unicode escape sequence with trail surrogate in surrogate pair");
+
+					byte const* runStart = p;
+					while (p != end && *p != '\\')
+					{
+						if (*p >= 32 && *p < 128)
+							++p;
+						else if (*p < 32)
+							throw Err(contentPos + (sizet) (p - content.p), "Unescaped control character in string");
+						else
+						{
+							Seq reader { p, (sizet) (end - p) };
+							uint c;
+							if (Utf8::ReadCodePoint(reader, c) != Utf8::ReadResult::OK)
+								throw Err(contentPos + (sizet) (p - content.p), "Invalid UTF-8 in string");
+							p = reader.p;
+						}
+					}
+
+					if (enc)
+						enc->Add(Seq(runStart, (sizet) (p - runStart)));
+				}
+				else
+				{
+					if (end - p < 2)
+						throw Err(elemPos, "Unrecognized string escape sequence");
+
+					byte e = p[1];
+					if (e == 'u')
+					{
+						if (end - p < 6 || !Ascii::IsHexDigit(p[2]) || !Ascii::IsHexDigit(p[3]) || !Ascii::IsHexDigit(p[4]) || !Ascii::IsHexDigit(p[5]))
+							throw Err(elemPos, "Invalid Unicode escape sequence");
+
+						uint c = Seq(p + 2, 4).ReadNrUInt16(16);
+						p += 6;
+
+						if (needTrailSurrogate)
+						{
+							if (c < 0xDC00 || c > 0xDFFF)
+								throw Err(elemPos, "Expected trail surrogate in surrogate pair");
+
+							if (enc)
+								enc->Utf8Char(0x010000 + (((leadSurrogate & 0x03FF) << 10) | (c & 0x03FF)));
+
+							needTrailSurrogate = false;
+						}
+						else if (c >= 0xD800 && c <= 0xDBFF)
+						{
+							leadSurrogate = c;
+							needTrailSurrogate = true;
+						}
+						else if (c >= 0xDC00 && c <= 0xDFFF)
+							throw Err(elemPos, "Unexpected trail surrogate");
+						else if (enc)
+							enc->Utf8Char(c);
+					}
+					else
+					{
+						if (needTrailSurrogate)
+							throw Err(elemPos, "Expected Unicode escape sequence with trail surrogate in surrogate pair");
+
+						byte c;
+						switch (e)
+						{
+						case '"' :	c = '"';  break;
+						case '\\':	c = '\\'; break;
+						case '/' :	c = '/';  break;
+						case 'b' :	c =  8;   break;
+						case 't' :	c =  9;   break;
+						case 'n' :	c = 10;   break;
+						case 'f' :	c = 12;   break;
+						case 'r' :	c = 13;   break;
+						default:	throw Err(elemPos, "Unrecognized string escape sequence");
+						}
+
+						if (enc)
+							enc->Byte(c);
+
+						p += 2;
+					}
+				}
+			}
+
+			if (needTrailSurrogate)
+				throw Err(contentPos + content.n, "String ends with an unterminated surrogate pair");
+		}
+
+
+		void StreamDecoder::DecodeString(Enc& enc)
+		{
+			sizet openPos;
+			Seq content = ReadStringContent(openPos);
+			DecodeStringContent(content, openPos + 1, &enc);
+		}
+
+
+		Seq StreamDecoder::SkipString()
+		{
+			sizet openPos;
+			Seq content = ReadStringContent(openPos);
+			DecodeStringContent(content, openPos + 1, nullptr);
+			return Seq(content.p - 1, content.n + 2);
+		}
+
+
+		bool StreamDecoder::DecodeBool()
+		{
+			sizet pos = SkipWs();
+			Seq rest { m_json.p + pos, m_json.n - pos };
+			if (rest.StartsWithExact("true"))  { m_pos = pos + 4; return true;  }
+			if (rest.StartsWithExact("false")) { m_pos = pos + 5; return false; }
+
+			throw Err(pos, "Expected true or false");
+		}
+
+
+		Seq StreamDecoder::ReadNumberText(sizet pos)
+		{
+			byte const* p { m_json.p };
+			sizet       n { m_json.n };
+			sizet       i { pos };
+
+			auto readDigits = [&] () -> bool
+				{
+					sizet digitsStart = i;
+					while (i < n && Ascii::IsDecDigit(p[i]))
+						++i;
+					return i != digitsStart;
+				};
+
+			if (i < n && p[i] == '-')
+				++i;
+
+			if (i < n && p[i] == '0')
+				++i;
+			else if (!readDigits())
+				throw Err(pos, "Expected number");
+
+			if (i < n && p[i] == '.')
+			{
+				++i;
+				if (!readDigits())
+					throw Err(pos, "Expected digits after decimal point in number");
+			}
+
+			if (i < n && (p[i] == 'e' || p[i] == 'E'))
+			{
+				++i;
+				if (i < n && (p[i] == '+' || p[i] == '-'))
+					++i;
+				if (!readDigits())
+					throw Err(pos, "Expected digits in number exponent");
+			}
+
+			m_pos = i;
+			return Seq(p + pos, i - pos);
+		}
+
+
+		uint64 StreamDecoder::DecodeUInt()
+		{
+			sizet pos = SkipWs();
+			uint64 v;
+			char const* err = DecodeUIntText(ReadNumberText(pos), v);
+			if (err)
+				throw Err(pos, err);
+
+			return v;
+		}
+
+
+		int64 StreamDecoder::DecodeSInt()
+		{
+			sizet pos = SkipWs();
+			int64 v;
+			char const* err = DecodeSIntText(ReadNumberText(pos), v);
+			if (err)
+				throw Err(pos, err);
+
+			return v;
+		}
+
+
+		double StreamDecoder::DecodeFloat()
+		{
+			sizet pos = SkipWs();
+			double v;
+			char const* err = DecodeFloatText(ReadNumberText(pos), v);
+			if (err)
+				throw Err(pos, err);
+
+			return v;
+		}
+
+
+		Time StreamDecoder::DecodeTime()
+		{
+			sizet       pos = SkipWs();
+			Time        v;
+			char const* err;
+
+			ValType type = PeekType();
+			if (type == ValType::Number)
+				err = DecodeTimeNr(ReadNumberText(pos));
+			else
+			{
+				if (type != ValType::String)
+					throw Err(pos, "Expected 0 or string containing ISO 8601-style UTC date or date-time");
+
+				Str s;
+				DecodeString(s);
+				err = DecodeTimeStr(s, v);
+			}
+
+			if (err)
+				throw Err(pos, err);
+
+			return v;
+		}
+
+
+		void StreamDecoder::SkipValue()
+		{
+			sizet pos = SkipWs();
+			switch (PeekType())
+			{
+			case ValType::String: SkipString(); break;
+			case ValType::Number: ReadNumberText(pos); break;
+			case ValType::True:
+			case ValType::False:  DecodeBool(); break;
+			case ValType::Array:  DecodeArray([] {}); break;
+			case ValType::Object: DecodeObject([] (sizet, Seq) -> bool { return true; } ); break;
+			default:
+				if (!TryDecodeNull())
+					throw Err(pos, "Expected value");
+			}
+		}
+
+
+		void StreamDecoder::EnterNested(sizet pos)
+		{
+			if (++m_depth > MaxDepth)
+				throw Err(pos, "Maximum nesting depth exceeded");
+
+			ConsumeStructural(pos);
+		}
+
+
+		void StreamDecoder::DecodeArray(std::function<void ()> decodeValue)
+		{
+			sizet pos = SkipWs();
+			if (!AtStructural(pos, '['))
+				throw Err(pos, "Expected array");
+
+			EnterNested(pos);
+
+			pos = SkipWs();
+			if (AtStructural(pos, ']'))
+				ConsumeStructural(pos);
+			else
+				while (true)
+				{
+					sizet valuePos      = SkipWs();
+					sizet valueIndexPos = m_indexPos;
+					decodeValue();
+					if (m_pos == valuePos && m_indexPos == valueIndexPos)
+						SkipValue();
+
+					pos = SkipWs();
+					if (AtStructural(pos, ',')) { ConsumeStructural(pos); continue; }
+					if (AtStructural(pos, ']')) { ConsumeStructural(pos); break; }
+
+					throw Err(pos, "Expected ',' or ']'");
+				}
+
+			--m_depth;
+		}
+
+
+		void StreamDecoder::DecodeObject(std::function<bool (sizet namePos, Seq name)> decodePair)
+		{
+			sizet pos = SkipWs();
+			if (!AtStructural(pos, '{'))
+				throw Err(pos, "Expected object");
+
+			EnterNested(pos);
+
+			pos = SkipWs();
+			if (AtStructural(pos, '}'))
+				ConsumeStructural(pos);
+			else
+			{
+				bool wantMore { true };
+				Str  nameBuf;
+
+				while (true)
+				{
+					// Names without escapes, which is nearly all of them, are passed to the callback without copying
+					sizet namePos;
+					Seq nameContent = ReadStringContent(namePos);
+					Seq name;
+					if (!nameContent.ContainsByte('\\'))
+					{
+						DecodeStringContent(nameContent, namePos + 1, nullptr);
+						name = nameContent;
+					}
+					else
+					{
+						nameBuf.Clear();
+						DecodeStringContent(nameContent, namePos + 1, &nameBuf);
+						name = nameBuf;
+					}
+
+					pos = SkipWs();
+					if (!AtStructural(pos, ':'))
+						throw Err(pos, "Expected ':'");
+					ConsumeStructural(pos);
+
+					sizet valuePos      = SkipWs();
+					sizet valueIndexPos = m_indexPos;
+					if (wantMore)
+						wantMore = decodePair(namePos, name);
+					if (m_pos == valuePos && m_indexPos == valueIndexPos)
+						SkipValue();
+
+					pos = SkipWs();
+					if (AtStructural(pos, ',')) { ConsumeStructural(pos); continue; }
+					if (AtStructural(pos, '}')) { ConsumeStructural(pos); break; }
+
+					throw Err(pos, "Expected ',' or '}'");
+				}
+			}
+
+			--m_depth;
+		}
+
+
+		void StreamDecoder::DecodeEnd()
+		{
+			sizet pos = SkipWs();
+			if (pos != m_json.n)
+				throw Err(pos, "Unexpected content after end of JSON value");
+		}
+
+
+		void StreamDecoder::RowCol(sizet pos, sizet& row, sizet& col) const
+		{
+			// Mirrors ParseNode::UpdateRowCol. Errors are rare, so row and column are not tracked during decoding
+			row = 1;
+			col = 1;
+
+			Seq reader { m_json.p, PickMin(pos, m_json.n) };
+			while (reader.n)
+			{
+				uint c;
+				if (Utf8::ReadCodePoint(reader, c) != Utf8::ReadResult::OK)
+				{
+					reader.DropByte();
+					++col;
+				}
+				else if (c == 10)
+				{
+					++row;
+					col = 1;
+				}
+				else if (c == 9)
+					col = ((((col - 1) / TabStop) + 1) * TabStop) + 1;
+				else
+					col += Unicode::CharInfo::Get(c).m_width;
+			}
+		}
+
+
+		DecodeErr StreamDecoder::Err(sizet pos, Seq s) const
+		{
+			sizet row, col;
+			RowCol(pos, row, col);
+			return DecodeErr(row, col, s);
+		}
+
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "AtJsonReadWrite.h"
+
+namespace At
+{
+	namespace Json
+	{
+		// Structural index
+
+		// Appends to "index" the byte offsets of all structural characters in "json": { } [ ] : , outside of strings,
+		// and the unescaped double quotes that open and close strings. Characters inside strings are not indexed.
+		// Classification is done with SSE2 on 64-byte blocks; escape and in-string state are carried across blocks.
+		// The input is not validated. Malformed input produces an index that StreamDecoder will reject.
+		void BuildStructuralIndex(Seq json, Vec<uint32>& index);
+
+
+
+		// StreamDecoder
+
+		// Decodes JSON directly from the source text, without constructing a ParseTree. Builds a structural index
+		// up front, then consumes values in document order as they are requested. The document is validated lazily
+		// as it is consumed: a syntax error is reported when decoding reaches it. Errors are thrown as DecodeErr,
+		// with row and column computed the same way as ParseNode::StartRow() and StartCol() for the same input.
+
+		enum class ValType { String, Number, True, False, Null, Array, Object };
+
+		class StreamDecoder : public NoCopy
+		{
+		public:
+			enum { MaxDepth = 1000, TabStop = 4 };
+
+			StreamDecoder(Seq json);
+
+			// Skips whitespace and returns the byte offset of the next value, for use with Err()
+			sizet   ValuePos     ();
+			ValType PeekType     ();
+			bool    TryDecodeNull();
+
+			void    DecodeString (Enc& enc);
+			bool    DecodeBool   ();
+			uint64  DecodeUInt   ();
+			int64   DecodeSInt   ();
+			double  DecodeFloat  ();
+			Time    DecodeTime   ();
+
+			// Validates the next string value and returns its source text, including the enclosing double quotes
+			Seq     SkipString   ();
+			void    SkipValue    ();
+
+			// The callback must consume the value, or leave it untouched, in which case the value is skipped
+			void DecodeArray(std::function<void ()> decodeValue);
+
+			// The callback must consume the value, or leave it untouched, in which case the value is skipped.
+			// If the callback returns false, the remaining pairs are validated and skipped.
+			void DecodeObject(std::function<bool (sizet namePos, Seq name)> decodePair);
+
+			// Verifies that nothing but whitespace follows the last decoded value
+			void DecodeEnd();
+
+			void      RowCol (sizet pos, sizet& row, sizet& col) const;
+			DecodeErr Err    (sizet pos, Seq s) const;
+
+		private:
+			Seq         m_json;
+			Vec<uint32> m_index;
+			sizet       m_indexPos {};
+			sizet       m_pos      {};
+			sizet       m_depth    {};
+
+			sizet SkipWs              ();
+			bool  AtStructural        (sizet pos, byte c) const { return m_indexPos < m_index.Len() && m_index[m_indexPos] == pos && m_json.p[pos] == c; }
+			void  ConsumeStructural   (sizet pos)               { ++m_indexPos; m_pos = pos + 1; }
+			void  EnterNested         (sizet pos);
+			Seq   ReadStringContent   (sizet& openPos);
+			void  DecodeStringContent (Seq content, sizet contentPos, Enc* enc);
+			Seq   ReadNumberText      (sizet pos);
+		};
+	}
+}
@@ -12,6 +12,19 @@ namespace At
 	bool LineReader::ReadLine(Str& outLine)
 	{
 		outLine.Clear();
+
+		Seq line;
+		if (!ReadLine(line))
+			return false;
+
+		outLine.Set(line);
+		return true;
+	}
+
+
+	bool LineReader::ReadLine(Seq& outLine)
+	{
+		outLine = Seq();
 		++m_lineNr;
 	
 		if (!m_remaining.n)
@@ -44,7 +57,7 @@ namespace At
 			m_lastLineEndCr = true;
 		}
 	
-		outLine.Set(origLine);
+		outLine = origLine;
 		return true;
 	}
 
@@ -22,6 +22,9 @@ namespace At
 		// Throws InputErr if line is longer than allowed.
 		bool ReadLine(Str& outLine);
 
+		// Same as above, but returns the line without copying it. The line points into the content being read.
+		bool ReadLine(Seq& outLine);
+
 		sizet LineNr() const { return m_lineNr; }
 		bool LastLineEndCr() const { return m_lastLineEndCr; }
 		bool LastLineEndLf() const { return m_lastLineEndLf; }
@@ -2,6 +2,7 @@
 #include "AtLocations.h"
 
 #include "AtCountries.h"
+#include "AtCrc32.h"
 #include "AtFile.h"
 #include "AtNumCvt.h"
 #include "AtPath.h"
@@ -26,8 +27,8 @@ namespace At
 		Rp<State> state;
 		GetState(state);
 
-		withPostalCodes = state->countriesWithPostalCodes;
-		noPostalCodes = state->countriesNoPostalCodes;
+		withPostalCodes.Clear().AddSlice(state->countriesWithPostalCodes);
+		noPostalCodes.Clear().AddSlice(state->countriesNoPostalCodes);
 	}
 
 
@@ -50,40 +51,60 @@ namespace At
 	
 		if (!sa.IsIp4())
 			return false;
+
 		uint32 ipNr = sa.GetIp4Nr();
+		return SetLocInfo(state.Ref(), ipNr, state->ipTree.Find(ipNr), locInfo);
+	}
 
-		// Find IpBlock containing this IP
-		IpBlock* first = state->pView;
-		IpBlock* last = state->pView + (state->nrIpBlocks - 1);
-		uint32 locId = 0;
-		while (true)
+
+	sizet Locations::LookupIpAddresses(Slice<SockAddr> addrs, Vec<LocInfo>& locInfos) const
+	{
+		locInfos.Clear().ResizeExact(addrs.Len());
+
+		Rp<State> state;
+		GetState(state);
+
+		enum { ChunkSize = 256 };
+		uint32 ipNrs[ChunkSize];
+		uint32 candidates[ChunkSize];
+		sizet nrFound {};
+
+		for (sizet base=0; base<addrs.Len(); base+=ChunkSize)
 		{
-			if (ipNr < first->ipFrom || ipNr > last->ipTo)
-				return false;
-	
-			if ((ipNr >= first->ipFrom) && (ipNr <= first->ipTo))
-				{ locId = first->locId; break; }
-		
-			if ((ipNr >= last->ipFrom) && (ipNr <= last->ipTo))
-				{ locId = last->locId; break; }
-		
-			sizet dist = (sizet) (last - first);
-			if (dist <= 1)
-				return false;
-		
-			IpBlock* mid = first + (dist/2);
-			if (ipNr < mid->ipFrom)
-				last = mid;
-			else
-				first = mid;
+			sizet const n = PickMin<sizet>(ChunkSize, addrs.Len() - base);
+			for (sizet i=0; i!=n; ++i)
+				ipNrs[i] = If(addrs[base+i].IsIp4(), uint32, addrs[base+i].GetIp4Nr(), 0);
+
+			state->ipTree.FindBatch(ipNrs, n, candidates);
+
+			for (sizet i=0; i!=n; ++i)
+				if (addrs[base+i].IsIp4() && SetLocInfo(state.Ref(), ipNrs[i], candidates[i], locInfos[base+i]))
+					++nrFound;
 		}
-	
-		// Found IpBlock, look up Location
-		Location& loc = state->locations[locId];
-		if (!MakeLocName(locInfo.name, loc.city->tlCountryCode.Code(), loc.city->tlRegionCode.Code(), loc.city->CityName()))
+
+		return nrFound;
+	}
+
+
+	bool Locations::SetLocInfo(State const& state, uint32 ipNr, uint32 candidate, LocInfo& locInfo) const
+	{
+		// The candidate is the last IpBlock starting at or before the IP. It contains the IP only if it also ends at or after it
+		if (candidate == IpRangeTree<uint32>::None)
+			return false;
+
+		IpBlock const& ipBlock = state.ipBlocks[candidate];
+		if (ipNr > ipBlock.ipTo || ipBlock.locId >= state.locations.Len())
+			return false;
+
+		SnapLocation const& loc = state.locations[ipBlock.locId];
+		if (loc.cityIndex == SnapNone)
+			return false;
+
+		SnapCity const& city = state.cities[loc.cityIndex];
+		if (!MakeLocName(locInfo.name, city.tlCountryCode.Code(), city.tlRegionCode.Code(), city.CityName()))
 			return false;
 	
-		locInfo.tlCountryCode = loc.city->tlCountryCode;
+		locInfo.tlCountryCode = city.tlCountryCode;
 		locInfo.latitude = loc.latitude;
 		locInfo.longitude = loc.longitude;
 		return true;
@@ -106,16 +127,19 @@ namespace At
 		   .Add(countryCode)
 		   .Add(postalCode);
 	
-		PostalCodes::const_iterator it = state->postalCodes.find(key);
-		if (it == state->postalCodes.end())
+		State const& s = state.Ref();
+		SnapPostalCode const* it = std::lower_bound(s.postalCodes.begin(), s.postalCodes.end(), key,
+			[&s] (SnapPostalCode const& x, Seq k) { return s.StrOf(x.key) < k; } );
+		if (it == s.postalCodes.end() || s.StrOf(it->key) != key)
 			return false;
 	
-		if (!MakeLocName(locInfo.name, it->second.city->tlCountryCode.Code(), it->second.city->tlRegionCode.Code(), it->second.city->CityName()))
+		SnapCity const& city = s.cities[it->cityIndex];
+		if (!MakeLocName(locInfo.name, city.tlCountryCode.Code(), city.tlRegionCode.Code(), city.CityName()))
 			return false;
 	
-		locInfo.tlCountryCode = it->second.city->tlCountryCode;
-		locInfo.latitude = it->second.Latitude();
-		locInfo.longitude = it->second.Longitude();
+		locInfo.tlCountryCode = city.tlCountryCode;
+		locInfo.latitude = it->latitude;
+		locInfo.longitude = it->longitude;
 		return true;
 	}
 
@@ -127,16 +151,18 @@ namespace At
 		Rp<State> state;
 		GetState(state);
 
-		Cities::const_iterator it = state->cities.find(cityKey);
-		if (it == state->cities.end())
+		State const& s = state.Ref();
+		SnapCity const* it = std::lower_bound(s.cities.begin(), s.cities.end(), cityKey,
+			[&s] (SnapCity const& x, Seq k) { return s.StrOf(x.key) < k; } );
+		if (it == s.cities.end() || s.StrOf(it->key) != cityKey)
 			return false;
 	
-		if (!MakeLocName(locInfo.name, it->second.tlCountryCode.Code(), it->second.tlRegionCode.Code(), it->second.CityName()))
+		if (!MakeLocName(locInfo.name, it->tlCountryCode.Code(), it->tlRegionCode.Code(), it->CityName()))
 			return false;
 	
-		locInfo.tlCountryCode = it->second.tlCountryCode;
-		locInfo.latitude = it->second.Latitude();
-		locInfo.longitude = it->second.Longitude();
+		locInfo.tlCountryCode = it->tlCountryCode;
+		locInfo.latitude = it->latitude;
+		locInfo.longitude = it->longitude;
 		return true;
 	}
 
@@ -145,37 +171,62 @@ namespace At
 		Seq countryCodeArg, Seq partialCityNameArg, Vec<CityMatch>& topMatches, sizet matchesToReturn) const
 	{
 		topMatches.Clear();
+		if (!matchesToReturn)
+			return;
 
 		Rp<State> state;
 		GetState(state);
-	
-		Str countryCode = ToUpper(countryCodeArg);
-		Str partialCityName = ToLower(partialCityNameArg);
 
-		Str cbnKey;
-		cbnKey.ReserveExact(countryCode.Len() + partialCityName.Len())
-			  .Add(countryCode)
-			  .Add(partialCityName);
-	
-		typedef std::multimap<sizet, CityMatch> Matches;
-		Matches matches;
-	
-		CitiesByName::const_iterator cbnIt = state->citiesByName.lower_bound(cbnKey);
-		for (; cbnIt != state->citiesByName.end() && Seq(cbnIt->first).StartsWithExact(cbnKey); ++cbnIt)
+		// Keys in citiesByName consist of a country code and a truncated city name, so a longer key cannot match
+		byte keyBuf[2 + MaxCityNameLen];
+		if (countryCodeArg.n + partialCityNameArg.n > sizeof(keyBuf))
+			return;
+
+		byte* pKey = keyBuf;
+		for (sizet i=0; i!=countryCodeArg.n;     ++i) *pKey++ = ToUpper(countryCodeArg.p[i]);
+		for (sizet i=0; i!=partialCityNameArg.n; ++i) *pKey++ = ToLower(partialCityNameArg.p[i]);
+		Seq key { keyBuf, (sizet) (pKey - keyBuf) };
+
+		State const& s = state.Ref();
+		SnapCityName const* first = std::lower_bound(s.cityNames.begin(), s.cityNames.end(), key,
+			[&s] (SnapCityName const& x, Seq k) { return s.StrOf(x.key) < k; } );
+		SnapCityName const* beyondLast = std::lower_bound(first, s.cityNames.end(), key,
+			[&s] (SnapCityName const& x, Seq k) { return s.StrOf(x.key).StartsWithExact(k); } );
+
+		sizet const nrMatches = (sizet) (beyondLast - first);
+		if (!nrMatches)
+			return;
+
+		uint32 const firstIndex = (uint32) (first - s.cityNames.begin());
+		if (nrMatches > CityCompletionListLen && matchesToReturn <= CityCompletionListLen && key.n >= 2)
 		{
-			City* city = cbnIt->second;
-			CityMatch match;
-			match.cityKey = MakeCityKey(city->tlCountryCode.Code(), city->tlRegionCode.Code(), city->CityName());		
-			if (MakeLocName(match.locName, city->tlCountryCode.Code(), city->tlRegionCode.Code(), city->CityName()))
-				matches.insert(std::make_pair(city->references, match));
+			// Prefix matches many cities, and includes a whole country code. Use the list of top cities computed when loading
+			SnapCityCompletions const* cc = std::lower_bound(s.cityCompletions.begin(), s.cityCompletions.end(), key,
+				[&s] (SnapCityCompletions const& x, Seq k) { return s.StrOf(x.prefix) < k; } );
+			if (cc == s.cityCompletions.end() || s.StrOf(cc->prefix) != key)
+				throw StrErr("Locations: Snapshot is missing city completions for a prefix");
+
+			topMatches.ReserveExact(PickMin<sizet>(cc->len, matchesToReturn));
+			for (uint32 i=0; i!=cc->len; ++i)
+				if (AddCityMatch(topMatches, s.cities[s.cityNames[s.cityCompletionPool[cc->first + i]].cityIndex]))
+					if (topMatches.Len() >= matchesToReturn)
+						break;
 		}
-
-		Matches::const_reverse_iterator mit = matches.rbegin();
-		for (; mit != matches.rend(); ++mit)
+		else
 		{
-			topMatches.Add(mit->second);
-			if (topMatches.Len() >= matchesToReturn)
-				break;
+			// Prefix matches few cities, or caller wants more than a precomputed list contains. Rank the matching cities
+			Vec<uint32> ranked;
+			ranked.ReserveExact(nrMatches);
+			for (uint32 i=0; i!=nrMatches; ++i)
+				ranked.Add(firstIndex + i);
+
+			std::sort(ranked.begin(), ranked.end(), [&s] (uint32 a, uint32 b) { return SnapCityNameRanksBefore(s, a, b); } );
+
+			topMatches.ReserveExact(PickMin<sizet>(nrMatches, matchesToReturn));
+			for (uint32 nameIndex : ranked)
+				if (AddCityMatch(topMatches, s.cities[s.cityNames[nameIndex].cityIndex]))
+					if (topMatches.Len() >= matchesToReturn)
+						break;
 		}
 	}
 
@@ -211,6 +262,20 @@ namespace At
 	}
 
 
+	bool Locations::AddCityMatch(Vec<CityMatch>& matches, SnapCity const& city) const
+	{
+		CityMatch& match = matches.Add();
+		if (!MakeLocName(match.locName, city.tlCountryCode.Code(), city.tlRegionCode.Code(), city.CityName()))
+		{
+			matches.PopLast();
+			return false;
+		}
+
+		match.cityKey = MakeCityKey(city.tlCountryCode.Code(), city.tlRegionCode.Code(), city.CityName());
+		return true;
+	}
+
+
 	void Locations::BeforeThreadStart()
 	{
 		m_locationsDir = JoinPath(GetDirectoryOfFileName(GetModulePath()), "Locations");
@@ -278,7 +343,7 @@ namespace At
 	}
 
 
-	Locations::State::State()
+	Locations::BuildState::BuildState()
 		: countries   (Countries   ::key_compare(), Countries   ::allocator_type(BulkStorage::Self()))
 		, cities      (Cities      ::key_compare(), Cities      ::allocator_type(BulkStorage::Self()))
 		, citiesByName(CitiesByName::key_compare(), CitiesByName::allocator_type(BulkStorage::Self()))
@@ -287,36 +352,444 @@ namespace At
 	}
 
 
-	Locations::State::~State()
+	void Locations::State::Close()
 	{
 		if (pView != nullptr)
+		{
 			UnmapViewOfFile(pView);
+			pView = nullptr;
+		}
 
 		if (hMapping != 0)
+		{
 			CloseHandle(hMapping);
+			hMapping = 0;
+		}
+
+		if (hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(hFile);
+			hFile = INVALID_HANDLE_VALUE;
+		}
+
+		countriesWithPostalCodes.Clear();
+		countriesNoPostalCodes.Clear();
+		cities.Clear();
+		postalCodes.Clear();
+		locations.Clear();
+		cityNames.Clear();
+		cityCompletions.Clear();
+		cityCompletionPool.Clear();
+		ipBlocks.Clear();
+		ipTreeKeys.Clear();
+		strings.Clear();
+		ipTree = IpRangeTree<uint32>();
 	}
 
 
 	void Locations::LoadNewState(State& state)
 	{
-		// Load Locations and IpBlocks files
-		FileLoader locationsLoader { m_locationsFilePath };
-		FileLoader ipBlocksLoader  { m_ipBlocksFilePath  };
-		CsvReader  locationsReader { locationsLoader, ',', 0 };
-		CsvReader  ipBlocksReader  { ipBlocksLoader,  ',', 0 };
-		locationsReader.SkipLines(2);
-		ipBlocksReader .SkipLines(2);
+		SnapSource source;
+		GetSnapSource(source);
 
 		// Delete ReInit file if it exists
 		DeleteFileW(WinStr(m_reInitFilePath).Z());
 
-		// Process Locations and IpBlocks files
-		ProcessLocationsFile (state, locationsReader, locationsLoader.Content().n );
-		ProcessIpBlocksFile  (state, ipBlocksReader,  ipBlocksLoader .Content().n );
+		Str snapPath = SnapshotPath(m_locationsDir, source);
+		Str fallbackDir = FallbackSnapDir();
+		Str fallbackPath = SnapshotPath(fallbackDir, source);
+		if (!OpenSnapshot(state, snapPath, source))
+		{
+			// A process that could not write to the Locations directory stored the snapshot in the fallback directory
+			if (OpenSnapshot(state, fallbackPath, source))
+				snapPath = fallbackPath;
+			else
+			{
+				snapPath = CreateSnapshot(snapPath, fallbackPath, source);
+				if (!OpenSnapshot(state, snapPath, source))
+					throw StrErr(Str("Locations: Snapshot is not valid after creating it: ").Add(snapPath));
+			}
+		}
+
+		DeleteOtherSnapshots(m_locationsDir, snapPath);
+		DeleteOtherSnapshots(fallbackDir, snapPath);
+	}
+
+
+
+	// Snapshot
+
+	namespace
+	{
+		byte const c_snapMagic[8] = { 'A', 't', 'L', 'o', 'c', 'S', 'n', 'p' };
+
+		inline uint64 SnapAlign(uint64 n) { return (n + 7) & ~((uint64) 7); }
+	}
+
+
+	void Locations::GetSnapSource(SnapSource& source) const
+	{
+		File::AttrsEx locationsAttrs, ipBlocksAttrs;
+		if (!File::GetAttrsEx(m_locationsFilePath, locationsAttrs))
+			throw WinErr<>(locationsAttrs.m_err, Str("Error in GetFileAttributesEx for ").Add(m_locationsFilePath));
+		if (!File::GetAttrsEx(m_ipBlocksFilePath, ipBlocksAttrs))
+			throw WinErr<>(ipBlocksAttrs.m_err, Str("Error in GetFileAttributesEx for ").Add(m_ipBlocksFilePath));
+
+		source.locationsFileSize = locationsAttrs.m_size;
+		source.locationsFileTime = locationsAttrs.m_times.m_lastWriteTime.ToFt();
+		source.ipBlocksFileSize  = ipBlocksAttrs.m_size;
+		source.ipBlocksFileTime  = ipBlocksAttrs.m_times.m_lastWriteTime.ToFt();
+	}
+
+
+	Str Locations::FallbackSnapDir() const
+	{
+		// Each Locations directory has its own fallback directory, so that processes using different CSV files do not delete each other's snapshots
+		wchar_t tempPathW[MAX_PATH + 1];
+		DWORD tempPathLen = GetTempPathW(MAX_PATH + 1, tempPathW);
+		if (!tempPathLen || tempPathLen > MAX_PATH)
+			{ LastWinErr e; throw e.Make<>("Locations: Error in GetTempPath"); }
+
+		Str tempPath;
+		FromUtf16(tempPathW, NumCast<USHORT>(tempPathLen), tempPath, CP_UTF8);
+
+		Str name;
+		name.Set("AtLocations-").UInt(Crc32(ToLower(m_locationsDir)), 16, 8);
+		return JoinPath(tempPath, name);
+	}
+
+
+	Str Locations::SnapshotPath(Seq dir, SnapSource const& source)
+	{
+		// The file name only needs to distinguish snapshots of different CSV files. The full source is verified when opening
+		Str name;
+		name.Set("Locations-").UInt(SnapVersion).Ch('-').UInt(Crc32(Seq(&source, sizeof(source))), 16, 8).Add(".snap");
+		return JoinPath(dir, name);
+	}
+
+
+	bool Locations::OpenSnapshot(State& state, Seq path, SnapSource const& source) const
+	{
+		static_assert(sizeof(SnapCity)            == 64, "Unexpected SnapCity size");
+		static_assert(sizeof(SnapPostalCode)      == 32, "Unexpected SnapPostalCode size");
+		static_assert(sizeof(SnapLocation)        == 24, "Unexpected SnapLocation size");
+		static_assert(sizeof(SnapCityName)        == 12, "Unexpected SnapCityName size");
+		static_assert(sizeof(SnapCityCompletions) == 16, "Unexpected SnapCityCompletions size");
+		static_assert(sizeof(IpBlock)             == 12, "Unexpected IpBlock size");
+		static_assert((sizeof(SnapHeader) % 8)    ==  0, "Unexpected SnapHeader size");
+
+		state.Close();
+
+		state.hFile = CreateFileW(WinStr(path).Z(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, 0, OPEN_EXISTING, 0, 0);
+		if (state.hFile == INVALID_HANDLE_VALUE)
+		{
+			DWORD rc = GetLastError();
+			if (rc == ERROR_FILE_NOT_FOUND || rc == ERROR_PATH_NOT_FOUND)
+				return false;
+
+			throw WinErr<>(rc, Str("Error in CreateFile for ").Add(path));
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(state.hFile, &fileSize))
+			{ LastWinErr e; throw e.Make<>(Str("Error in GetFileSizeEx for ").Add(path)); }
+
+		if (((uint64) fileSize.QuadPart) < sizeof(SnapHeader) || ((uint64) fileSize.QuadPart) > SIZE_MAX)
+			{ state.Close(); return false; }
+
+		state.hMapping = CreateFileMapping(state.hFile, 0, PAGE_READONLY, 0, 0, 0);
+		if (!state.hMapping)
+			{ LastWinErr e; throw e.Make<>(Str("Error in CreateFileMapping for ").Add(path)); }
+
+		state.pView = (byte const*) MapViewOfFile(state.hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!state.pView)
+			{ LastWinErr e; throw e.Make<>(Str("Error in MapViewOfFile for ").Add(path)); }
+
+		// A snapshot that does not match is replaced by the caller
+		SnapHeader const& header = *(SnapHeader const*) state.pView;
+		if (memcmp(header.magic, c_snapMagic, sizeof(c_snapMagic)) != 0 ||
+			header.version != SnapVersion ||
+			header.headerSize != sizeof(SnapHeader) ||
+			header.fileSize != (uint64) fileSize.QuadPart ||
+			!(header.source == source))
+			{ state.Close(); return false; }
+
+		sizet const recordSizes[SnapSections::Count] = { sizeof(TLCode), sizeof(TLCode), sizeof(SnapCity), sizeof(SnapPostalCode),
+			sizeof(SnapLocation), sizeof(SnapCityName), sizeof(SnapCityCompletions), sizeof(uint32), sizeof(IpBlock), sizeof(uint32), 1 };
+
+		for (sizet i=0; i!=SnapSections::Count; ++i)
+		{
+			SnapSection const& section = header.sections[i];
+			if (section.offset < sizeof(SnapHeader) || section.offset > header.fileSize || (section.offset % 8) != 0 ||
+				section.count > (header.fileSize - section.offset) / recordSizes[i])
+				{ state.Close(); return false; }
+		}
+
+		auto sectionSlice = [&] (auto& slice, SnapSections::E i)
+			{
+				using T = typename std::remove_reference<decltype(slice.First())>::type;
+				T const* p = (T const*) (state.pView + header.sections[i].offset);
+				slice.Set(p, p + header.sections[i].count);
+			};
+
+		sectionSlice(state.countriesWithPostalCodes, SnapSections::CountriesWithPostalCodes);
+		sectionSlice(state.countriesNoPostalCodes,   SnapSections::CountriesNoPostalCodes);
+		sectionSlice(state.cities,                   SnapSections::Cities);
+		sectionSlice(state.postalCodes,              SnapSections::PostalCodes);
+		sectionSlice(state.locations,                SnapSections::Locations);
+		sectionSlice(state.cityNames,                SnapSections::CityNames);
+		sectionSlice(state.cityCompletions,          SnapSections::CityCompletions);
+		sectionSlice(state.cityCompletionPool,       SnapSections::CityCompletionPool);
+		sectionSlice(state.ipBlocks,                 SnapSections::IpBlocks);
+		sectionSlice(state.ipTreeKeys,               SnapSections::IpTree);
+		sectionSlice(state.strings,                  SnapSections::Strings);
+
+		sizet const treeLen = state.ipTreeKeys.Len();
+		if (treeLen == 0 || (treeLen & (treeLen - 1)) != 0 || treeLen <= state.ipBlocks.Len())
+			{ state.Close(); return false; }
+
+		state.ipTree.Set(state.ipTreeKeys, state.ipBlocks.Len());
+		return true;
 	}
 
 
-	void Locations::ProcessLocationsFile(State& state, CsvReader& reader, sizet csvSize)
+	Str Locations::CreateSnapshot(Seq path, Seq fallbackPath, SnapSource const& source)
+	{
+		BuildState state;
+
+		{
+			// Load Locations and IpBlocks files
+			FileLoader locationsLoader { m_locationsFilePath, FileLoader::Mode::Map };
+			FileLoader ipBlocksLoader  { m_ipBlocksFilePath,  FileLoader::Mode::Map };
+			CsvReader  locationsReader { locationsLoader, ',', 0 };
+			CsvReader  ipBlocksReader  { ipBlocksLoader,  ',', 0 };
+			locationsReader.SkipLines(2);
+			ipBlocksReader .SkipLines(2);
+
+			// Process Locations and IpBlocks files
+			ProcessLocationsFile (state, locationsReader, locationsLoader.Content().n );
+			ProcessIpBlocksFile  (state, ipBlocksReader );
+		}
+
+		// City references are known only after processing IpBlocks
+		BuildCityCompletions(state);
+
+		if (TryWriteSnapshot(state, source, path))
+			return Str(path);
+
+		CreateDirectoryIfNotExists(GetDirectoryOfFileName(fallbackPath), DirSecurity::SystemDefault);
+		if (!TryWriteSnapshot(state, source, fallbackPath))
+			throw StrErr(Str("Locations: Access denied when writing snapshot: ").Add(fallbackPath));
+
+		return Str(fallbackPath);
+	}
+
+
+	bool Locations::TryWriteSnapshot(BuildState& state, SnapSource const& source, Seq path)
+	{
+		// Another process might be creating the same snapshot, so write to a file name unique to this process.
+		// DeleteOtherSnapshots relies on the process ID being the extension of the temporary file
+		Str tempPath = Str(path).Add(".tmp").UInt(GetCurrentProcessId());
+		try
+		{
+			WriteSnapshot(state, source, tempPath);
+		}
+		catch (WinErr<> const& e)
+		{
+			DeleteFileW(WinStr(tempPath).Z());
+			if (e.m_code == ERROR_ACCESS_DENIED || e.m_code == ERROR_WRITE_PROTECT)
+				return false;
+			throw;
+		}
+		catch (...)
+		{
+			DeleteFileW(WinStr(tempPath).Z());
+			throw;
+		}
+
+		// Replacing fails if another process has the existing snapshot mapped. That snapshot is then current, or will be replaced
+		if (!MoveFileExW(WinStr(tempPath).Z(), WinStr(path).Z(), MOVEFILE_REPLACE_EXISTING))
+		{
+			LastWinErr e;
+			DeleteFileW(WinStr(tempPath).Z());
+			if (!File::Exists_NotDirectory(path))
+				throw e.Make<>(Str("Error in MoveFileEx to ").Add(path));
+		}
+
+		return true;
+	}
+
+
+	void Locations::WriteSnapshot(BuildState& state, SnapSource const& source, Seq path)
+	{
+		Str strings;
+		auto addStr = [&strings] (Seq s) -> SnapStr
+			{
+				EnsureThrow(strings.Len() + s.n <= UINT32_MAX);
+				SnapStr x { (uint32) strings.Len(), (uint32) s.n };
+				strings.Add(s);
+				return x;
+			};
+
+		// Cities, in key order
+		EnsureThrow(state.cities.size() < SnapNone);
+		Vec<SnapCity> cities;
+		cities.ReserveExact(state.cities.size());
+		for (Cities::value_type& x : state.cities)
+		{
+			City& city = x.second;
+			city.index = (uint32) cities.Len();
+
+			SnapCity& sc = cities.Add();
+			sc.key = addStr(x.first);
+			sc.tlCountryCode = city.tlCountryCode;
+			sc.tlRegionCode = city.tlRegionCode;
+			sc.cityNameLen = city.cityNameLen;
+			memcpy(sc.arCityName, city.arCityName, city.cityNameLen);
+			sc.latitude = city.Latitude();
+			sc.longitude = city.Longitude();
+			sc.references = city.references;
+		}
+
+		Vec<SnapPostalCode> postalCodes;
+		postalCodes.ReserveExact(state.postalCodes.size());
+		for (PostalCodes::value_type const& x : state.postalCodes)
+		{
+			SnapPostalCode& spc = postalCodes.Add();
+			spc.key = addStr(x.first);
+			spc.cityIndex = x.second.city->index;
+			spc.latitude = x.second.Latitude();
+			spc.longitude = x.second.Longitude();
+		}
+
+		Vec<SnapLocation> locations;
+		locations.ReserveExact(state.nrLocations);
+		for (sizet i=0; i!=state.nrLocations; ++i)
+		{
+			Location const& loc = state.locations[i];
+			SnapLocation& sl = locations.Add();
+			sl.cityIndex = If(loc.city != nullptr, uint32, loc.city->index, SnapNone);
+			sl.latitude = loc.latitude;
+			sl.longitude = loc.longitude;
+		}
+
+		Vec<SnapCityName> cityNames;
+		cityNames.ReserveExact(state.cityNames.Len());
+		for (CityNameEntry const& x : state.cityNames)
+			cityNames.Add(SnapCityName { addStr(x.key), x.city->index });
+
+		// A prefix is the beginning of a key already in the strings section
+		Vec<SnapCityCompletions> cityCompletions;
+		cityCompletions.ReserveExact(state.cityCompletions.Len());
+		for (CityCompletions const& x : state.cityCompletions)
+		{
+			SnapStr prefix { cityNames[x.nameIndex].key.off, (uint32) x.prefixLen };
+			cityCompletions.Add(SnapCityCompletions { prefix, x.first, x.len });
+		}
+
+		// IP blocks are already in ascending order
+		Vec<uint32> ipFroms, ipTree;
+		ipFroms.ReserveExact(state.ipBlocks.Len());
+		for (IpBlock const& x : state.ipBlocks)
+			ipFroms.Add(x.ipFrom);
+
+		IpRangeTree<uint32>::Build(ipFroms, ipTree);
+
+		// Write header and sections
+		SnapHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, c_snapMagic, sizeof(c_snapMagic));
+		header.version = SnapVersion;
+		header.headerSize = sizeof(SnapHeader);
+		header.source = source;
+
+		Seq sections[SnapSections::Count];
+		sizet counts[SnapSections::Count];
+		auto setSection = [&] (SnapSections::E i, void const* p, sizet count, sizet recordSize)
+			{ sections[i] = Seq(p, count * recordSize); counts[i] = count; };
+
+		setSection(SnapSections::CountriesWithPostalCodes, state.countriesWithPostalCodes.Ptr(), state.countriesWithPostalCodes.Len(), sizeof(TLCode));
+		setSection(SnapSections::CountriesNoPostalCodes,   state.countriesNoPostalCodes.Ptr(),   state.countriesNoPostalCodes.Len(),   sizeof(TLCode));
+		setSection(SnapSections::Cities,                   cities.Ptr(),                         cities.Len(),                         sizeof(SnapCity));
+		setSection(SnapSections::PostalCodes,              postalCodes.Ptr(),                    postalCodes.Len(),                    sizeof(SnapPostalCode));
+		setSection(SnapSections::Locations,                locations.Ptr(),                      locations.Len(),                      sizeof(SnapLocation));
+		setSection(SnapSections::CityNames,                cityNames.Ptr(),                      cityNames.Len(),                      sizeof(SnapCityName));
+		setSection(SnapSections::CityCompletions,          cityCompletions.Ptr(),                cityCompletions.Len(),                sizeof(SnapCityCompletions));
+		setSection(SnapSections::CityCompletionPool,       state.cityCompletionPool.Ptr(),       state.cityCompletionPool.Len(),       sizeof(uint32));
+		setSection(SnapSections::IpBlocks,                 state.ipBlocks.Ptr(),                 state.ipBlocks.Len(),                 sizeof(IpBlock));
+		setSection(SnapSections::IpTree,                   ipTree.Ptr(),                         ipTree.Len(),                         sizeof(uint32));
+		setSection(SnapSections::Strings,                  strings.Ptr(),                        strings.Len(),                        1);
+
+		uint64 offset = sizeof(SnapHeader);
+		for (sizet i=0; i!=SnapSections::Count; ++i)
+		{
+			header.sections[i].offset = offset;
+			header.sections[i].count = counts[i];
+			offset = SnapAlign(offset + sections[i].n);
+		}
+		header.fileSize = offset;
+
+		File file;
+		file.Open(path, File::OpenArgs::DefaultOverwrite());
+		file.Write(&header, sizeof(header));
+
+		byte const zeros[8] {};
+		for (sizet i=0; i!=SnapSections::Count; ++i)
+		{
+			file.Write(sections[i]);
+
+			sizet padding = (sizet) (SnapAlign(sections[i].n) - sections[i].n);
+			if (padding)
+				file.Write(zeros, padding);
+		}
+
+		if (!FlushFileBuffers(file.Handle()))
+			{ LastWinErr e; throw e.Make<>(Str("Error in FlushFileBuffers for ").Add(path)); }
+	}
+
+
+	void Locations::DeleteOtherSnapshots(Seq dir, Seq currentPath)
+	{
+		// Fails for snapshots still mapped by another process. Such a snapshot is deleted on a subsequent attempt
+		Seq currentName = PathParts(currentPath).m_fileName;
+		FindFiles ff { JoinPath(dir, "Locations-*.snap*") };
+		while (ff.Next())
+		{
+			FindFiles::Result const& r = ff.Current();
+			if (r.IsDirectory() || Seq(r.m_fileName).EqualInsensitive(currentName))
+				continue;
+
+			// A temporary file is being written if the process that created it is still running
+			Seq ext = PathParts(r.m_fileName).m_ext;
+			if (ext.StripPrefixInsensitive(".tmp"))
+			{
+				uint64 pid = ext.ReadNrUInt64Dec();
+				if (ext.n || pid > UINT32_MAX || pid == GetCurrentProcessId())
+					continue;
+
+				HANDLE hProcess = OpenProcess(SYNCHRONIZE, false, (DWORD) pid);
+				if (hProcess)
+				{
+					bool running = (WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT);
+					CloseHandle(hProcess);
+					if (running)
+						continue;
+				}
+				else if (GetLastError() != ERROR_INVALID_PARAMETER)
+					continue;
+			}
+			else if (!ext.EqualInsensitive(".snap"))
+				continue;
+
+			DeleteFileW(WinStr(JoinPath(dir, r.m_fileName)).Z());
+		}
+	}
+
+
+
+	// Parsing CSV files
+
+	void Locations::ProcessLocationsFile(BuildState& state, CsvReader& reader, sizet csvSize)
 	{
 		// Smallest CSV-encoded location in GeoLite City is 32 bytes
 		uint64 maxNrLocations = csvSize / 32;
@@ -328,7 +801,7 @@ namespace At
 		sizet recordNr = 0;
 		Vec<wchar_t> convertBuf;
 		CsvLocation loc;
-		Vec<Str> record;
+		Vec<Seq> record;
 		sizet nrFields;
 		record.ResizeExact(7);
 		while (reader.ReadRecord(record, nrFields))
@@ -345,11 +818,11 @@ namespace At
 			loc.id = NumCast<sizet>(locId64);
 
 			loc.countryCode.Clear();
-			if (record[1].Len() == 2)
+			if (record[1].n == 2)
 				loc.countryCode.Upper(record[1]);
 		
 			loc.regionCode.Clear();
-			if (record[2].Len() == 2)
+			if (record[2].n == 2)
 				loc.regionCode.Upper(record[2]);
 
 			StrCvtCp(record[3], loc.cityName, 1252, CP_UTF8, convertBuf);
@@ -388,7 +861,7 @@ namespace At
 	}
 
 
-	void Locations::AddCountryDefinition(State& state, CsvLocation& loc)
+	void Locations::AddCountryDefinition(BuildState& state, CsvLocation& loc)
 	{
 		Countries::iterator it = state.countries.find(loc.countryCode);
 		if (it != state.countries.end())
@@ -417,7 +890,7 @@ namespace At
 	}
 
 
-	Locations::City* Locations::AddCityDefinition(State& state, CsvLocation& loc)
+	Locations::City* Locations::AddCityDefinition(BuildState& state, CsvLocation& loc)
 	{
 		Str key(MakeCityKey(loc.countryCode, loc.regionCode, loc.cityName));	
 		Cities::iterator it = state.cities.find(key);
@@ -437,6 +910,7 @@ namespace At
 			it->second.sumLongitudes = loc.longitude;
 			it->second.definitions = 1;
 			it->second.references = 1;
+			it->second.index = SnapNone;
 		
 			Str cbnKey;
 			cbnKey.ReserveExact(2 + (sizet) (it->second.cityNameLen))
@@ -450,7 +924,7 @@ namespace At
 	}
 
 
-	Locations::PostalCode* Locations::AddPostalCodeDefinition(State& state, CsvLocation& loc, City* city)
+	Locations::PostalCode* Locations::AddPostalCodeDefinition(BuildState& state, CsvLocation& loc, City* city)
 	{
 		Str key;
 		key.ReserveExact(2 + loc.postalCode.Len())
@@ -478,8 +952,13 @@ namespace At
 	}
 
 
-	void Locations::AddLocationDefinition(State& state, CsvLocation& loc, City* city, PostalCode* postalCode)
+	void Locations::AddLocationDefinition(BuildState& state, CsvLocation& loc, City* city, PostalCode* postalCode)
 	{
+		if (loc.id >= state.locations.Len())
+			throw InputErr(Str("locId out of bounds: ").UInt(loc.id));
+
+		state.nrLocations = PickMax<sizet>(state.nrLocations, loc.id + 1);
+
 		Location& l = state.locations[loc.id];
 		l.city = city;
 		l.postalCode = postalCode;
@@ -488,7 +967,7 @@ namespace At
 	}
 
 
-	void Locations::SortCountries(State& state)
+	void Locations::SortCountries(BuildState& state)
 	{
 		std::multimap<sizet, TLCode> countriesWithPostalCodes;
 		std::map<Seq, TLCode> countriesNoPostalCodes;
@@ -521,37 +1000,17 @@ namespace At
 	}
 
 
-	void Locations::ProcessIpBlocksFile(State& state, CsvReader& reader, sizet csvSize)
+	void Locations::ProcessIpBlocksFile(BuildState& state, CsvReader& reader)
 	{
-		// Initializes memory-mapped file
-		// CSV-encoded LocId,IpFrom,IpTo triplet cannot be smaller than 20 bytes as long as IP >= 10.0.0.0
-		uint64 mappingSize64 = (((uint64) csvSize) / 20) * sizeof(IpBlock);
-		if (mappingSize64 > SIZE_MAX)
-			throw ZLitErr("IpBlocks file too large");
-
-		state.mappingSize = NumCast<sizet>(mappingSize64);
-
-		DWORD mappingSizeHi = (DWORD) ((((uint64) state.mappingSize) >> 32) & 0xFFFFFFFF);
-		DWORD mappingSizeLo = (DWORD) ((((uint64) state.mappingSize)      ) & 0xFFFFFFFF);
-
-		state.hMapping = CreateFileMapping(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, mappingSizeHi, mappingSizeLo, 0);
-		if (!state.hMapping)
-			{ LastWinErr e; throw e.Make<>("Error in CreateFileMapping for IpBlocks file"); }
-	
-		state.pView = (IpBlock*) MapViewOfFile(state.hMapping, FILE_MAP_WRITE, 0, 0, state.mappingSize);
-		if (!state.pView)
-			{ LastWinErr e; throw e.Make<>("Error in MapViewOfFile for IpBlocks file"); }
-
 		// Translate records in IpBlocks file
 		sizet recordNr = 0;
-		Vec<Str> record;
+		Vec<Seq> record;
 		sizet nrFields;
 		record.ResizeExact(3);
 		while (reader.ReadRecord(record, nrFields))
 		{
-			IpBlock& ipBlock = state.pView[recordNr++];
-			if (recordNr * sizeof(IpBlock) > state.mappingSize)
-				throw StrErr(Str("IpBlock storage exceeded at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
+			IpBlock& ipBlock = state.ipBlocks.Add();
+			++recordNr;
 		
 			Seq ipFromStr = Seq(record[0]);
 			ipBlock.ipFrom = ipFromStr.ReadNrUInt32();
@@ -564,18 +1023,95 @@ namespace At
 				throw InputErr(Str("Invalid ipTo at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
 			if (ipBlock.ipTo < ipBlock.ipFrom)
 				throw InputErr(Str("ipTo is less than ipFrom at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
+			if (recordNr > 1 && ipBlock.ipFrom <= state.ipBlocks[recordNr - 2].ipTo)
+				throw InputErr(Str("IP block is out of order or overlaps previous block at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
 
 			Seq locIdStr = Seq(record[2]);
 			ipBlock.locId = locIdStr.ReadNrUInt32();
 			if (locIdStr.n)
 				throw InputErr(Str("Invalid locId at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
+			if (ipBlock.locId >= state.nrLocations)
+				throw InputErr(Str("Undefined locId at record ").UInt(recordNr).Add(" in ").Add(reader.Path()));
 		
 			Location& loc = state.locations[ipBlock.locId];
 			if (loc.city)
 				++(loc.city->references);
 		}
-	
-		state.nrIpBlocks = recordNr;
+	}
+
+
+	void Locations::BuildCityCompletions(BuildState& state)
+	{
+		EnsureThrow(state.citiesByName.size() <= UINT32_MAX);
+
+		state.cityNames.ReserveExact(state.citiesByName.size());
+		for (CitiesByName::value_type const& x : state.citiesByName)
+			state.cityNames.Add(CityNameEntry { x.first, x.second });
+
+		// Keys start with a two-letter country code, so the shortest prefix of interest is the country code
+		Vec<uint32> scratch;
+		scratch.ReserveExact(state.cityNames.Len());
+		AddCityCompletions(state, 0, state.cityNames.Len(), 2, scratch);
+	}
+
+
+	void Locations::AddCityCompletions(BuildState& state, sizet first, sizet beyondLast, sizet prefixLen, Vec<uint32>& scratch)
+	{
+		// Prefixes matching few cities are ranked at lookup
+		if (beyondLast - first <= CityCompletionListLen)
+			return;
+
+		// Visiting prefixes depth-first, in the order of citiesByName, adds lists ordered by prefix
+		scratch.Clear();
+		for (sizet i=first; i!=beyondLast; ++i)
+			scratch.Add((uint32) i);
+
+		BuildState const& s = state;
+		std::partial_sort(scratch.begin(), scratch.begin() + CityCompletionListLen, scratch.end(),
+			[&s] (uint32 a, uint32 b) { return CityNameRanksBefore(s, a, b); } );
+
+		CityCompletions& cc = state.cityCompletions.Add();
+		cc.nameIndex = first;
+		cc.prefixLen = prefixLen;
+		cc.first = NumCast<uint32>(state.cityCompletionPool.Len());
+		cc.len = CityCompletionListLen;
+		state.cityCompletionPool.AddSlice(Slice<uint32>(scratch.begin(), scratch.begin() + CityCompletionListLen));
+
+		// Entries equal to the prefix sort first. Entries that extend it are grouped by the next byte
+		sizet i = first;
+		while (i != beyondLast && state.cityNames[i].key.n == prefixLen)
+			++i;
+
+		while (i != beyondLast)
+		{
+			byte c = state.cityNames[i].key.p[prefixLen];
+			sizet j = i + 1;
+			while (j != beyondLast && state.cityNames[j].key.p[prefixLen] == c)
+				++j;
+
+			AddCityCompletions(state, i, j, prefixLen + 1, scratch);
+			i = j;
+		}
+	}
+
+
+	bool Locations::CityNameRanksBefore(BuildState const& state, uint32 a, uint32 b)
+	{
+		sizet refsA = state.cityNames[a].city->references;
+		sizet refsB = state.cityNames[b].city->references;
+		if (refsA != refsB)
+			return refsA > refsB;
+		return a < b;
+	}
+
+
+	bool Locations::SnapCityNameRanksBefore(State const& state, uint32 a, uint32 b)
+	{
+		uint64 refsA = state.cities[state.cityNames[a].cityIndex].references;
+		uint64 refsB = state.cities[state.cityNames[b].cityIndex].references;
+		if (refsA != refsB)
+			return refsA > refsB;
+		return a < b;
 	}
 
 
@@ -2,6 +2,7 @@
 
 #include "AtBulkAlloc.h"
 #include "AtCsv.h"
+#include "AtIpRangeIndex.h"
 #include "AtMutex.h"
 #include "AtRp.h"
 #include "AtSocket.h"
@@ -16,12 +17,18 @@ namespace At
 	// Requires files "IpBlocks.csv" and "Locations.csv" in "Locations" subdirectory under application's main module directory.
 	// Files must be in MaxMind GeoLite/GeoIP City format, stored in the Windows-1252 code page.
 	// Ignores the first two lines of each file; assumes they are copyright line and headers line.
-	// The Locations file is parsed to initialize an in-memory locations database.
-	// The IpBlocks file is translated into a memory-mapped file containing the same information in condensed form.
+	// Both files are parsed into a binary snapshot, stored in the same directory, which is then used through a read-only mapped view.
+	// The snapshot file name is derived from the sizes and last write times of the CSV files. If a snapshot for the current CSV files
+	// already exists, it is used without parsing the CSV files, so initialization takes milliseconds, and processes using the same
+	// Locations directory share the physical memory of the snapshot. A new snapshot is written to a temporary file and then renamed,
+	// so a process never maps a partially written snapshot. Snapshots for previous CSV files are deleted when no longer mapped,
+	// as are temporary files left by processes that exited while writing a snapshot. If the Locations directory is not writable,
+	// for example under Program Files, snapshots are stored in a subdirectory of the temporary directory instead.
 	// Both input files are closed after loading, allowing external applications to modify the CSV files.
 	// To initialize Locations, start it as a thread. Locations is initialized in BeforeThreadStart().
 	// After first loading, the thread will monitor the Locations subdirectory for a file named "ReInit".
-	// If this file appears, information from both CSV files will be reloaded, and the ReInit file deleted.
+	// If this file appears, the ReInit file is deleted, and a snapshot for the current CSV files is loaded, or created if needed.
+	// The new state replaces the previous one atomically: lookups in progress complete using the previous state.
 	
 	struct TLCode
 	{
@@ -75,8 +82,17 @@ namespace At
 		void GetCountries(Vec<TLCode>& withPostalCodes, Vec<TLCode>& noPostalCodes);
 		bool LookupIpAddress(Seq ipStr, LocInfo& locInfo) const;
 		bool LookupIpAddress(SockAddr const& sa, LocInfo& locInfo) const;
+
+		// Looks up many addresses at once, which is faster than looking them up one by one. Resizes locInfos to the number
+		// of addresses. An address that is not found has an empty name in locInfos. Returns the number of addresses found
+		sizet LookupIpAddresses(Slice<SockAddr> addrs, Vec<LocInfo>& locInfos) const;
 		bool LookupPostalCode(Seq countryCode, Seq postalCode, LocInfo& locInfo) const;
 		bool LookupCityKey(Seq cityKey, LocInfo& locInfo) const;
+
+		// Returns cities whose name starts with partialCityName, ordered by number of IP blocks referencing them, most referenced first.
+		// Uses per-prefix lists of top cities computed when the state is loaded, so it does not allocate except for the results,
+		// and the time is independent of the number of matching cities, as long as matchesToReturn <= CityCompletionListLen
+		enum { CityCompletionListLen = 32 };
 		void LookupPartialCityName(Seq countryCode, Seq partialCityName, Vec<CityMatch>& topMatches, sizet matchesToReturn) const;
 	
 	private:
@@ -88,6 +104,8 @@ namespace At
 		Str m_ipBlocksFilePath;
 		Str m_locationsFilePath;
 	
+		// Types used while parsing the CSV files
+
 		struct Country
 		{
 			TLCode tlCountryCode;
@@ -107,6 +125,7 @@ namespace At
 			double sumLongitudes;
 			sizet definitions;
 			sizet references;
+			uint32 index;				// Index in snapshot, assigned when writing the snapshot
 		
 			Seq CityName() const  { return Seq(arCityName, (sizet) cityNameLen); }
 			double Latitude() const  { return sumLatitudes  / definitions; }
@@ -148,24 +167,147 @@ namespace At
 			uint32 ipTo;
 		};
 
-		struct State : public RefCountable, public BulkStorage
+		struct CityNameEntry
+		{
+			Seq   key;						// Key in citiesByName
+			City* city;
+		};
+
+		// Top cities for a prefix of keys in citiesByName. Exists only for prefixes matching more than CityCompletionListLen cities
+		struct CityCompletions
+		{
+			sizet  nameIndex;				// The prefix is the beginning of this entry's key in cityNames
+			sizet  prefixLen;
+			uint32 first;					// Index of first entry in cityCompletionPool
+			uint32 len;
+		};
+
+		struct BuildState : public BulkStorage
 		{
-			State();
-			~State();
+			BuildState();
 
 			Countries countries;
 			Cities cities;
 			CitiesByName citiesByName;
 			PostalCodes postalCodes;
 			Vec<Location> locations;
+			sizet nrLocations {};						// Highest defined locId + 1
+			Vec<IpBlock> ipBlocks;
+
+			Vec<CityNameEntry> cityNames;				// Same order as citiesByName
+			Vec<CityCompletions> cityCompletions;		// Ordered by prefix
+			Vec<uint32> cityCompletionPool;				// Indices into cityNames, ordered by references within each list
 		
 			Vec<TLCode> countriesWithPostalCodes;		// Ordered by number of references
 			Vec<TLCode> countriesNoPostalCodes;			// Ordered by country name alphabetically
-		
-			sizet    mappingSize {};
-			HANDLE   hMapping    {};
-			IpBlock* pView       {};
-			sizet    nrIpBlocks  {};
+		};
+
+		// Snapshot format. Records have fixed size, refer to each other by index, and to strings by offset into the Strings section,
+		// so that a snapshot can be used in place. Sections are aligned to 8 bytes. Increment SnapVersion when changing the format
+
+		enum { SnapVersion = 2 };
+		enum : uint32 { SnapNone = UINT32_MAX };
+
+		struct SnapStr { uint32 off; uint32 len; };
+
+		struct SnapCity
+		{
+			SnapStr key;					// Same as key in Cities
+			TLCode tlCountryCode;
+			TLCode tlRegionCode;
+			byte cityNameLen;
+			byte arCityName[MaxCityNameLen];
+			double latitude;
+			double longitude;
+			uint64 references;
+
+			Seq CityName() const { return Seq(arCityName, (sizet) cityNameLen); }
+		};
+
+		struct SnapPostalCode
+		{
+			SnapStr key;					// Same as key in PostalCodes
+			uint32 cityIndex;
+			uint32 reserved;
+			double latitude;
+			double longitude;
+		};
+
+		struct SnapLocation
+		{
+			uint32 cityIndex;				// SnapNone if no city
+			uint32 reserved;
+			double latitude;
+			double longitude;
+		};
+
+		struct SnapCityName
+		{
+			SnapStr key;					// Same as key in CitiesByName
+			uint32 cityIndex;
+		};
+
+		struct SnapCityCompletions
+		{
+			SnapStr prefix;
+			uint32 first;					// Index of first entry in CityCompletionPool
+			uint32 len;
+		};
+
+		struct SnapSource
+		{
+			uint64 locationsFileSize;
+			uint64 locationsFileTime;
+			uint64 ipBlocksFileSize;
+			uint64 ipBlocksFileTime;
+
+			bool operator== (SnapSource const& x) const { return !memcmp(this, &x, sizeof(SnapSource)); }
+		};
+
+		struct SnapSections { enum E { CountriesWithPostalCodes, CountriesNoPostalCodes, Cities, PostalCodes, Locations,
+			CityNames, CityCompletions, CityCompletionPool, IpBlocks, IpTree, Strings, Count }; };
+
+		struct SnapSection
+		{
+			uint64 offset;
+			uint64 count;					// Number of records
+		};
+
+		struct SnapHeader
+		{
+			byte        magic[8];
+			uint32      version;
+			uint32      headerSize;
+			uint64      fileSize;
+			SnapSource  source;
+			SnapSection sections[SnapSections::Count];
+		};
+
+		// A mapped snapshot. Slices point into the mapped view
+		struct State : public RefCountable
+		{
+			~State() { Close(); }
+			void Close();
+
+			HANDLE      hFile    { INVALID_HANDLE_VALUE };
+			HANDLE      hMapping {};
+			byte const* pView    {};
+
+			Slice<TLCode>              countriesWithPostalCodes;
+			Slice<TLCode>              countriesNoPostalCodes;
+			Slice<SnapCity>            cities;						// Ordered by key
+			Slice<SnapPostalCode>      postalCodes;					// Ordered by key
+			Slice<SnapLocation>        locations;					// Indexed by locId
+			Slice<SnapCityName>        cityNames;					// Ordered by key
+			Slice<SnapCityCompletions> cityCompletions;				// Ordered by prefix
+			Slice<uint32>              cityCompletionPool;
+			Slice<IpBlock>             ipBlocks;					// Ordered by ipFrom
+			Slice<uint32>              ipTreeKeys;					// IpRangeTree over ipFrom of ipBlocks
+			Slice<byte>                strings;
+
+			IpRangeTree<uint32>        ipTree;
+
+			Seq StrOf(SnapStr s) const { EnsureThrow(s.off <= strings.Len() && s.len <= strings.Len() - s.off); return Seq(strings.begin() + s.off, s.len); }
 		};
 	
 		mutable Mutex m_mx;
@@ -186,20 +328,37 @@ namespace At
 
 		void GetState(Rp<State>& state) const;
 		bool MakeLocName(Str& locName, Seq countryCode, Seq regionCode, Seq cityName) const;
+		bool AddCityMatch(Vec<CityMatch>& matches, SnapCity const& city) const;
+		bool SetLocInfo(State const& state, uint32 ipNr, uint32 candidate, LocInfo& locInfo) const;
 	
 		void ReInit();
 		void LoadNewState(State& state);
 
-		void ProcessLocationsFile(State& state, CsvReader& reader, sizet csvSize);
-		void AddCountryDefinition(State& state, CsvLocation& loc);
-		City* AddCityDefinition(State& state, CsvLocation& loc);
-		PostalCode* AddPostalCodeDefinition(State& state, CsvLocation& loc, City* city);
-		void AddLocationDefinition(State& state, CsvLocation& loc, City* city, PostalCode* postalCode);
-		void SortCountries(State& state);
+		void GetSnapSource(SnapSource& source) const;
+		Str FallbackSnapDir() const;
+		static Str SnapshotPath(Seq dir, SnapSource const& source);
+		bool OpenSnapshot(State& state, Seq path, SnapSource const& source) const;
+		Str CreateSnapshot(Seq path, Seq fallbackPath, SnapSource const& source);
+		bool TryWriteSnapshot(BuildState& state, SnapSource const& source, Seq path);
+		void WriteSnapshot(BuildState& state, SnapSource const& source, Seq path);
+		static void DeleteOtherSnapshots(Seq dir, Seq currentPath);
+
+		void ProcessLocationsFile(BuildState& state, CsvReader& reader, sizet csvSize);
+		void AddCountryDefinition(BuildState& state, CsvLocation& loc);
+		City* AddCityDefinition(BuildState& state, CsvLocation& loc);
+		PostalCode* AddPostalCodeDefinition(BuildState& state, CsvLocation& loc, City* city);
+		void AddLocationDefinition(BuildState& state, CsvLocation& loc, City* city, PostalCode* postalCode);
+		void SortCountries(BuildState& state);
 
 		static Str MakeCityKey(Seq countryCode, Seq regionCode, Seq cityName);
 
-		void ProcessIpBlocksFile(State& state, CsvReader& reader, sizet csvSize);
+		void ProcessIpBlocksFile(BuildState& state, CsvReader& reader);
+
+		void BuildCityCompletions(BuildState& state);
+		void AddCityCompletions(BuildState& state, sizet first, sizet beyondLast, sizet prefixLen, Vec<uint32>& scratch);
+
+		static bool CityNameRanksBefore(BuildState const& state, uint32 a, uint32 b);
+		static bool SnapCityNameRanksBefore(State const& state, uint32 a, uint32 b);
 
 	private:	
 		static void SetStr(byte& len, byte* dest, byte maxLen, Seq s);
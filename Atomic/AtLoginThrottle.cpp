@@ -1,93 +1,104 @@
 #include "AtIncludes.h"
 #include "AtLoginThrottle.h"
 
+#include "AtCrypt.h"
 #include "AtTime.h"
 
 namespace At
 {
-	LoginThrottle::~LoginThrottle()
+	bool LoginThrottle::HaveRecentFailure(Seq userName, Seq remoteIdAddr)
 	{
-		for (LoginFailure*& entry : m_entries)
-			if (entry != nullptr)
-			{
-				delete entry;
-				entry = nullptr;
-			}
+		CheckInit();
+
+		Time now = Time::StrictNow();
+		Time cutOff = now - Time::FromSeconds(ThrottleSeconds);
+
+		return HaveRecentFailure(KeyHash(m_userNameSeed,     userName    ), cutOff) ||
+		       HaveRecentFailure(KeyHash(m_remoteIdAddrSeed, remoteIdAddr), cutOff);
 	}
 
 
-	bool LoginThrottle::HaveRecentFailure(Seq userName, Seq remoteIdAddr)
+	void LoginThrottle::AddLoginFailure(Seq userName, Seq remoteIdAddr)
 	{
-		Locker locker(m_mx);
+		CheckInit();
 
 		Time now = Time::StrictNow();
 		Time cutOff = now - Time::FromSeconds(ThrottleSeconds);
 
-		sizet i = m_nextIndex;
-		while (true)
-		{
-			if (i == 0)
-				i = m_entries.Len() - 1;
-			else
-				--i;
-
-			LoginFailure* entry = m_entries[i];
+		AddFailure(KeyHash(m_userNameSeed,     userName    ), now, cutOff);
+		AddFailure(KeyHash(m_remoteIdAddrSeed, remoteIdAddr), now, cutOff);
+	}
 
-			// Reached empty part of list without entries?
-			if (!entry)
-				return false;
 
-			// Reached cut off?
-			if (entry->time < cutOff)
-				return false;
+	void LoginThrottle::CheckInit()
+	{
+		// Seeds cannot be generated in the constructor, since instances can be global, and constructed before Crypt is initialized
+		if (!m_inited)
+		{
+			Locker locker(m_initMx);
+			if (!m_inited)
+			{
+				Crypt::GenRandom(&m_userNameSeed,     sizeof(m_userNameSeed));
+				Crypt::GenRandom(&m_remoteIdAddrSeed, sizeof(m_remoteIdAddrSeed));
+				m_inited = true;
+			}
+		}
+	}
 
-			// Match?
-			if (userName.EqualInsensitive(entry->userName) ||
-				remoteIdAddr.EqualInsensitive(entry->remoteIdAddr))
-				return true;
 
-			// Came all the way around?
-			if (i == m_nextIndex)
-				return false;
-		}
+	uint64 LoginThrottle::KeyHash(uint64 seed, Seq key)
+	{
+		// FNV-1a over the lowercase value, starting from the seed, followed by a final mix so that all bits of the hash depend on the seed
+		uint64 const FnvPrime64 = 1099511628211ull;
+		uint64 x = seed;
+		for (sizet i=0; i!=key.n; ++i)
+			x = (x ^ ToLower(key.p[i])) * FnvPrime64;
+
+		x = ((x >> 32) ^ x) * FnvPrime64;
+		x = ((x >> 32) ^ x) * FnvPrime64;
+		x = ((x >> 32) ^ x);
+		return x;
 	}
 
 
-	void LoginThrottle::AddLoginFailure(Seq userName, Seq remoteIdAddr)
+	bool LoginThrottle::HaveRecentFailure(uint64 hash, Time cutOff)
 	{
-		Locker locker(m_mx);
+		Shard& shard = ShardOf(hash);
+		shard.m_lock.Acquire();
+		OnExit release = [&] { shard.m_lock.Release(); };
 
-		Time now = Time::StrictNow();
-		Time cutOff = now - Time::FromSeconds(ThrottleSeconds);
+		for (Record const& record : shard.m_records)
+			if (record.m_hash == hash)
+				return record.m_time >= cutOff;
 
-		// Make room for entry
-		LoginFailure* entry = m_entries[m_nextIndex];
+		return false;
+	}
 
-		if (entry)
+
+	void LoginThrottle::AddFailure(uint64 hash, Time now, Time cutOff)
+	{
+		Shard& shard = ShardOf(hash);
+		shard.m_lock.Acquire();
+		OnExit release = [&] { shard.m_lock.Release(); };
+
+		// Each hash has at most one record. Update it if present, otherwise reuse an expired record, or add one
+		Record* expired {};
+		for (Record& record : shard.m_records)
 		{
-			if (entry->time > cutOff)
+			if (record.m_hash == hash)
 			{
-				sizet origSize = m_entries.Len();
-				m_entries.ResizeExact(origSize * 2, nullptr);
-				memmove(&m_entries[m_nextIndex], &m_entries[m_nextIndex+origSize], (origSize - m_nextIndex) * m_entries.ValSize());
-				memset(&m_entries[m_nextIndex], 0, origSize * m_entries.ValSize());
-				entry = nullptr;
+				record.m_time = now;
+				return;
 			}
-		}
 
-		if (!entry)
-		{
-			m_entries[m_nextIndex] = new LoginFailure();
-			entry = m_entries[m_nextIndex];
+			if (!expired && record.m_time < cutOff)
+				expired = &record;
 		}
-	
-		// Fill out entry
-		entry->time = now;
-		entry->userName = userName;
-		entry->remoteIdAddr = remoteIdAddr;
-
-		// Move m_nextIndex
-		if (++m_nextIndex == m_entries.Len())
-			m_nextIndex = 0;
+
+		if (!expired)
+			expired = &shard.m_records.Add();
+
+		expired->m_hash = hash;
+		expired->m_time = now;
 	}
 }
@@ -1,20 +1,26 @@
 #pragma once
 
 #include "AtMutex.h"
+#include "AtSpinLock.h"
 #include "AtStr.h"
 #include "AtTime.h"
 #include "AtVec.h"
 
 namespace At
 {
+	// Login failures are recorded by user name and by remote address, each as a keyed 64-bit hash of the case-insensitive value,
+	// together with the time of the latest failure. Records are divided into shards by hash, each with its own spin lock,
+	// so that logins for different users from different addresses rarely contend. A record older than ThrottleSeconds
+	// is reused by the next failure recorded in its shard, so no allocation is made per failure in steady state.
+	//
+	// Hashes are keyed with a random seed, so an attacker cannot predict collisions. A collision could at most cause
+	// a login to be throttled as if it had failed recently.
+
 	class LoginThrottle : NoCopy
 	{
 	public:
 		enum { ThrottleSeconds = 3 };
 
-		LoginThrottle() { m_entries.ResizeAtLeast(1, nullptr); }
-		~LoginThrottle();
-
 		// Returns true if there was a recent login failure either for the specified user name, or from the specified address.
 		bool HaveRecentFailure(Seq userName, Seq remoteIdAddr);
 
@@ -22,15 +28,30 @@ namespace At
 		void AddLoginFailure(Seq userName, Seq remoteIdAddr);
 
 	private:
-		struct LoginFailure
+		enum { NrShards = 64 };
+
+		struct Record
 		{
-			Time time;
-			Str	userName;
-			Str	remoteIdAddr;
+			uint64 m_hash;
+			Time   m_time;
 		};
 
-		Mutex m_mx;
-		Vec<LoginFailure*> m_entries;
-		sizet m_nextIndex {};
+		struct Shard
+		{
+			SpinLock    m_lock;
+			Vec<Record> m_records;
+		};
+
+		bool volatile m_inited {};
+		Mutex         m_initMx;
+		uint64        m_userNameSeed {};
+		uint64        m_remoteIdAddrSeed {};
+		Shard         m_shards[NrShards];
+
+		void CheckInit();
+		static uint64 KeyHash(uint64 seed, Seq key);
+		Shard& ShardOf(uint64 hash) { return m_shards[(hash >> 32) % NrShards]; }
+		bool HaveRecentFailure(uint64 hash, Time cutOff);
+		void AddFailure(uint64 hash, Time now, Time cutOff);
 	};
 }
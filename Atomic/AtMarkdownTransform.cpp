@@ -353,5 +353,46 @@ namespace At
 			return text;
 		}
 
+
+
+		bool CachedToHtml(RenderCache& cache, Seq srcText, bool permitLinks, ObjId owner, uint64 version, HtmlBuilder& html)
+		{
+			RenderCacheKey key { srcText, RenderKind::MarkdownHtml, permitLinks ? (uint32) CacheOption_HtmlPermitLinks : 0U, owner, version };
+			if (cache.Find(key, [&] (Seq fragment) { html.AddFragment(fragment); }))
+				return true;
+
+			Transform xform { srcText };
+			if (!xform.Parse())
+				return false;
+
+			HtmlBuilder fragmentHtml { HtmlBuilder::Fragment, 2 * srcText.n };
+			xform.SetHtmlPermitLinks(permitLinks).ToHtml(fragmentHtml);
+
+			Seq fragment { fragmentHtml.FinalFragment() };
+			cache.Add(key, fragment);
+			html.AddFragment(fragment);
+			return true;
+		}
+
+
+		bool CachedToText(RenderCache& cache, Seq srcText, ObjId owner, uint64 version, Enc& text)
+		{
+			RenderCacheKey key { srcText, RenderKind::MarkdownText, 0, owner, version };
+			if (cache.Find(key, [&] (Seq fragment) { text.Add(fragment); }))
+				return true;
+
+			Transform xform { srcText };
+			if (!xform.Parse())
+				return false;
+
+			TextBuilder fragmentText { 2 * srcText.n };
+			xform.ToText(fragmentText);
+
+			Seq fragment { fragmentText.Final() };
+			cache.Add(key, fragment);
+			text.Add(fragment);
+			return true;
+		}
+
 	}
 }
@@ -2,6 +2,7 @@
 
 #include "AtHtmlBuilder.h"
 #include "AtMarkdownGrammar.h"
+#include "AtRenderCache.h"
 #include "AtTextBuilder.h"
 
 namespace At
@@ -33,5 +34,14 @@ namespace At
 			TextBuilder& ToText(TextBuilder& text, ParseNode const& containerNode) const;
 			TextBuilder& ParaElemsToText(TextBuilder& text, ParseNode const& containerNode) const;
 		};
+
+
+		// Rendering options included in RenderCacheKey::m_options
+		enum { CacheOption_HtmlPermitLinks = 0x01 };
+
+		// Output the rendering of srcText that is found in the cache, or parse and render srcText and add the result to the cache.
+		// The owner of srcText chooses the version, as described for RenderCacheKey. Return false if srcText cannot be parsed
+		bool CachedToHtml(RenderCache& cache, Seq srcText, bool permitLinks, ObjId owner, uint64 version, HtmlBuilder& html);
+		bool CachedToText(RenderCache& cache, Seq srcText, ObjId owner, uint64 version, Enc& text);
 	}
 }
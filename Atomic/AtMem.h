@@ -32,6 +32,7 @@ namespace At
 				return nullptr != HeapReAlloc(s_processHeap, HEAP_REALLOC_IN_PLACE_ONLY, p, n*sizeof(T)); }
 
 		template <class T> static void Free(T* p) noexcept              { EnsureAbort(HeapFree(s_processHeap, 0, p)); }
+		static size_t SizeOf(void const* p) noexcept                    { return HeapSize(s_processHeap, 0, p); }
 		template <class T> static void Copy(T* d, T const* s, size_t n) { memcpy(d, s, n*sizeof(T)); }
 		template <class T> static void Move(T* d, T const* s, size_t n) { memmove(d, s, n*sizeof(T)); }
 		template <class T> static void Zero(T* d, size_t n)             { RtlSecureZeroMemory(d, n*sizeof(T)); }
@@ -0,0 +1,344 @@
+#include "AtIncludes.h"
+#include "AtMpFixed.h"
+
+
+namespace At
+{
+
+	namespace
+	{
+		inline uint64 Mul64x64(uint64 a, uint64 b, uint64& hi) noexcept
+		{
+		#ifdef _M_X64
+			return _umul128(a, b, &hi);
+		#else
+			uint64 aLo = (uint32) a, aHi = a >> 32;
+			uint64 bLo = (uint32) b, bHi = b >> 32;
+			uint64 p0 = aLo * bLo, p1 = aLo * bHi, p2 = aHi * bLo, p3 = aHi * bHi;
+			uint64 mid = (p0 >> 32) + ((uint32) p1) + ((uint32) p2);
+			hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+			return (mid << 32) | ((uint32) p0);
+		#endif
+		}
+
+
+		// Returns the low limb of a*b + c + d, and stores the high limb in "hi". The result cannot overflow 128 bits
+		inline uint64 MulAdd(uint64 a, uint64 b, uint64 c, uint64 d, uint64& hi) noexcept
+		{
+			uint64 lo = Mul64x64(a, b, hi);
+			lo += c; hi += (lo < c);
+			lo += d; hi += (lo < d);
+			return lo;
+		}
+	}
+
+
+
+	// MpLimbs
+
+	namespace MpLimbs
+	{
+		int Cmp(uint64 const* a, uint64 const* b, sizet n) noexcept
+		{
+			while (n--)
+				if (a[n] != b[n])
+					return If(a[n] < b[n], int, -1, 1);
+
+			return 0;
+		}
+
+
+		uint64 Add(uint64* r, uint64 const* a, uint64 const* b, sizet n) noexcept
+		{
+			uint64 carry {};
+			for (sizet i=0; i!=n; ++i)
+			{
+				uint64 bi = b[i];
+				uint64 s = a[i] + carry;
+				carry = (s < carry);
+				s += bi;
+				carry += (s < bi);
+				r[i] = s;
+			}
+			return carry;
+		}
+
+
+		uint64 Sub(uint64* r, uint64 const* a, uint64 const* b, sizet n) noexcept
+		{
+			uint64 borrow {};
+			for (sizet i=0; i!=n; ++i)
+			{
+				uint64 ai = a[i], bi = b[i];
+				uint64 d = ai - bi;
+				uint64 borrowOut = (ai < bi);
+				r[i] = d - borrow;
+				borrowOut |= (d < borrow);
+				borrow = borrowOut;
+			}
+			return borrow;
+		}
+	}
+
+
+
+	// MpMont
+
+	MpMont::MpMont(MpUInt const& m)
+	{
+		EnsureThrow(Supports(m));
+
+		m_n = (m.NrBits() + 63) / 64;
+		m_m.Set(m);
+
+		// Newton iteration for m^-1 mod 2^64. For odd m0, m0 is its own inverse mod 2^3, and each step doubles the correct bits
+		uint64 const m0 = m_m.m_limbs[0];
+		uint64 inv = m0;
+		for (uint i=0; i!=5; ++i)
+			inv *= 2 - m0 * inv;
+		m_mInv = 0 - inv;
+
+		// R^2 mod m by repeated doubling of 1. Costs 128 * n^2 limb operations, but needs no division
+		Elem r { 1 };
+		for (sizet i=0; i!=128*m_n; ++i)
+		{
+			uint64 carry = MpLimbs::Add(r.m_limbs, r.m_limbs, r.m_limbs, m_n);
+			if (carry || MpLimbs::Cmp(r.m_limbs, m_m.m_limbs, m_n) >= 0)
+				MpLimbs::Sub(r.m_limbs, r.m_limbs, m_m.m_limbs, m_n);
+		}
+
+		m_r2 = r;
+		FromMont(m_r2, m_one);
+	}
+
+
+	void MpMont::ToMont(Elem const& x, Elem& r) const
+	{
+		Mul(x, m_r2, r);
+	}
+
+
+	void MpMont::FromMont(Elem const& a, Elem& r) const
+	{
+		Elem one { 1 };
+		Mul(a, one, r);
+	}
+
+
+	void MpMont::Mul(Elem const& a, Elem const& b, Elem& r) const
+	{
+		sizet const n = m_n;
+		uint64 const* ap = a.m_limbs;
+		uint64 const* mp = m_m.m_limbs;
+
+		uint64 t[MaxLimbs + 2];
+		memset(t, 0, (n + 2) * sizeof(uint64));
+
+		for (sizet i=0; i!=n; ++i)
+		{
+			// t += a * b[i]
+			uint64 bi = b.m_limbs[i];
+			uint64 c {};
+			for (sizet j=0; j!=n; ++j)
+				t[j] = MulAdd(ap[j], bi, t[j], c, c);
+
+			uint64 s = t[n] + c;
+			t[n+1] = (s < c);
+			t[n] = s;
+
+			// t = (t + q*m) / 2^64, where q is chosen so that the low limb becomes zero
+			uint64 q = t[0] * m_mInv;
+			MulAdd(q, mp[0], t[0], 0, c);
+			for (sizet j=1; j!=n; ++j)
+				t[j-1] = MulAdd(q, mp[j], t[j], c, c);
+
+			s = t[n] + c;
+			t[n-1] = s;
+			t[n] = t[n+1] + (s < c);
+		}
+
+		// t < 2m
+		if (t[n] || MpLimbs::Cmp(t, mp, n) >= 0)
+			MpLimbs::Sub(r.m_limbs, t, mp, n);
+		else
+			memcpy(r.m_limbs, t, n * sizeof(uint64));
+	}
+
+
+	void MpMont::PowMod(MpUInt const& base, MpUInt const& exp, MpUInt& result) const
+	{
+		Elem b;
+		if (base.NrBits() > 64 * m_n || Elem(base) >= m_m)
+		{
+			MpUInt m, quotient, remainder;
+			m_m.Get(m);
+			base.DivM(m, quotient, remainder);
+			b.Set(remainder);
+		}
+		else
+			b.Set(base);
+
+		Elem bm;
+		ToMont(b, bm);
+
+		Elem acc = m_one;
+		sizet const expBits = exp.NrBits();
+
+		if (expBits <= 64)
+		{
+			for (sizet i=expBits; i--; )
+			{
+				Mul(acc, acc, acc);
+				if (((exp.GetByte(i / 8) >> (i % 8)) & 1) != 0)
+					Mul(acc, bm, acc);
+			}
+		}
+		else
+		{
+			Elem table[16];
+			table[0] = m_one;
+			table[1] = bm;
+			for (uint i=2; i!=16; ++i)
+				Mul(table[i-1], bm, table[i]);
+
+			for (sizet k=(expBits + 3) / 4; k--; )
+			{
+				for (uint i=0; i!=4; ++i)
+					Mul(acc, acc, acc);
+
+				uint nibble = (exp.GetByte(k / 2) >> (4 * (k % 2))) & 0xF;
+				if (nibble)
+					Mul(acc, table[nibble], acc);
+			}
+		}
+
+		FromMont(acc, b);
+		b.Get(result);
+	}
+
+
+
+	// P256Field
+
+	namespace
+	{
+		uint64 const c_p256[4] = { 0xFFFFFFFFFFFFFFFFULL, 0x00000000FFFFFFFFULL, 0x0000000000000000ULL, 0xFFFFFFFF00000001ULL };
+
+		inline void P256_SubPIfNotLess(uint64 carry, uint64* r) noexcept
+		{
+			if (carry || MpLimbs::Cmp(r, c_p256, 4) >= 0)
+				MpLimbs::Sub(r, r, c_p256, 4);
+		}
+	}
+
+
+	P256Field::Elem P256Field::Prime()
+	{
+		Elem p;
+		memcpy(p.m_limbs, c_p256, sizeof(c_p256));
+		return p;
+	}
+
+
+	bool P256Field::IsPrime(MpUInt const& m)
+	{
+		return m.NrBits() == 256 && Elem(m) == Prime();
+	}
+
+
+	void P256Field::Add(Elem const& a, Elem const& b, Elem& r) noexcept
+	{
+		uint64 carry = MpLimbs::Add(r.m_limbs, a.m_limbs, b.m_limbs, 4);
+		P256_SubPIfNotLess(carry, r.m_limbs);
+	}
+
+
+	void P256Field::Sub(Elem const& a, Elem const& b, Elem& r) noexcept
+	{
+		if (MpLimbs::Sub(r.m_limbs, a.m_limbs, b.m_limbs, 4))
+			MpLimbs::Add(r.m_limbs, r.m_limbs, c_p256, 4);
+	}
+
+
+	void P256Field::Mul(Elem const& a, Elem const& b, Elem& r) noexcept
+	{
+		// 512-bit product
+		uint64 t[8] {};
+		for (uint i=0; i!=4; ++i)
+		{
+			uint64 c {};
+			for (uint j=0; j!=4; ++j)
+				t[i+j] = MulAdd(a.m_limbs[i], b.m_limbs[j], t[i+j], c, c);
+			t[i+4] = c;
+		}
+
+		// Solinas reduction over 32-bit words c0..c15 of the product. Each result word is a signed combination
+		// of product words; the sums are then carried into 32-bit words
+		int64 c[16];
+		for (uint i=0; i!=8; ++i)
+		{
+			c[2*i]   = (int64) (t[i] & 0xFFFFFFFFU);
+			c[2*i+1] = (int64) (t[i] >> 32);
+		}
+
+		int64 w[8];
+		w[0] = c[0] + c[ 8] + c[ 9]                              - c[11] - c[12] - c[13] - c[14];
+		w[1] = c[1] + c[ 9] + c[10]                              - c[12] - c[13] - c[14] - c[15];
+		w[2] = c[2] + c[10] + c[11]                              - c[13] - c[14] - c[15];
+		w[3] = c[3] + 2*c[11] + 2*c[12] + c[13]                  - c[15] - c[ 8] - c[ 9];
+		w[4] = c[4] + 2*c[12] + 2*c[13] + c[14]                  - c[ 9] - c[10];
+		w[5] = c[5] + 2*c[13] + 2*c[14] + c[15]                  - c[10] - c[11];
+		w[6] = c[6] + 3*c[14] + 2*c[15] + c[13]                  - c[ 8] - c[ 9];
+		w[7] = c[7] + 3*c[15] + c[ 8]                            - c[10] - c[11] - c[12] - c[13];
+
+		// Propagate carries. A carry out of the top word is folded back using 2^256 = 2^224 - 2^192 - 2^96 + 1 (mod p)
+		while (true)
+		{
+			int64 carry {};
+			for (uint i=0; i!=8; ++i)
+			{
+				carry += w[i];
+				w[i] = carry & 0xFFFFFFFF;
+				carry >>= 32;
+			}
+
+			if (!carry)
+				break;
+
+			w[0] += carry;
+			w[3] -= carry;
+			w[6] -= carry;
+			w[7] += carry;
+		}
+
+		for (uint i=0; i!=4; ++i)
+			r.m_limbs[i] = ((uint64) w[2*i]) | (((uint64) w[2*i+1]) << 32);
+
+		// The value is now less than 2^256, which is less than 2p
+		P256_SubPIfNotLess(0, r.m_limbs);
+	}
+
+
+	void P256Field::Pow(Elem const& a, Elem const& e, Elem& r) noexcept
+	{
+		Elem table[16];
+		table[0].m_limbs[0] = 1;
+		table[1] = a;
+		for (uint i=2; i!=16; ++i)
+			Mul(table[i-1], a, table[i]);
+
+		Elem acc = table[0];
+		for (uint k=64; k--; )
+		{
+			for (uint i=0; i!=4; ++i)
+				Sqr(acc, acc);
+
+			uint nibble = (uint) ((e.m_limbs[k / 16] >> (4 * (k % 16))) & 0xF);
+			if (nibble)
+				Mul(acc, table[nibble], acc);
+		}
+
+		r = acc;
+	}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "AtMpUInt.h"
+
+
+namespace At
+{
+
+	// Operations on little-endian arrays of 64-bit limbs, least significant limb first
+
+	namespace MpLimbs
+	{
+		int    Cmp (uint64 const* a, uint64 const* b, sizet n) noexcept;
+		uint64 Add (uint64* r, uint64 const* a, uint64 const* b, sizet n) noexcept;	// Returns carry. r may alias a or b
+		uint64 Sub (uint64* r, uint64 const* a, uint64 const* b, sizet n) noexcept;	// Returns borrow. r may alias a or b
+	}
+
+
+
+	// MpFixed
+
+	// Fixed-width, allocation-free unsigned integer with 64-bit limbs. Storage type for Montgomery and P-256 field arithmetic.
+	// Unlike MpUInt, the value is not normalized: all N limbs are always present, and unused high limbs are zero.
+
+	template <uint N>
+	struct MpFixed
+	{
+		enum { NrLimbs = N, NrBytes = 8 * N, NrBits = 64 * N };
+
+		uint64 m_limbs[N] {};
+
+		MpFixed() = default;
+		MpFixed(uint64 v) { m_limbs[0] = v; }
+		MpFixed(MpUInt const& x) { Set(x); }
+
+		MpFixed& SetZero()               { memset(m_limbs, 0, sizeof(m_limbs)); return *this; }
+		MpFixed& Set(MpUInt const& x)    { x.ToLimbs64(m_limbs, N); return *this; }
+		void     Get(MpUInt& x) const    { x.FromLimbs64(m_limbs, N); }
+
+		bool IsZero () const noexcept         { for (uint64 v : m_limbs) if (v) return false; return true; }
+		bool IsOdd  () const noexcept         { return (m_limbs[0] & 1) != 0; }
+		bool Bit    (sizet i) const noexcept  { return ((m_limbs[i / 64] >> (i % 64)) & 1) != 0; }
+
+		int Cmp(MpFixed const& x) const noexcept { return MpLimbs::Cmp(m_limbs, x.m_limbs, N); }
+
+		bool operator== (MpFixed const& x) const noexcept { return Cmp(x) == 0; }
+		bool operator!= (MpFixed const& x) const noexcept { return Cmp(x) != 0; }
+		bool operator<  (MpFixed const& x) const noexcept { return Cmp(x) <  0; }
+		bool operator>= (MpFixed const& x) const noexcept { return Cmp(x) >= 0; }
+	};
+
+
+
+	// MpMont
+
+	// Montgomery arithmetic modulo an odd modulus of up to MaxBits bits. Elements are kept in Montgomery form, a*R mod m,
+	// where R = 2^(64 * NrLimbs()). Multiplication interleaves the product with the reduction (CIOS method), and needs
+	// neither division nor allocation. Only the low NrLimbs() limbs of an Elem are used.
+
+	class MpMont
+	{
+	public:
+		enum { MaxLimbs = 64, MaxBits = 64 * MaxLimbs };
+		using Elem = MpFixed<MaxLimbs>;
+
+		static bool Supports(MpUInt const& m) { return m.IsOdd() && m > 1U && m.NrBits() <= MaxBits; }
+
+		MpMont(MpUInt const& m);
+
+		sizet       NrLimbs () const { return m_n; }
+		Elem const& One     () const { return m_one; }
+
+		void ToMont   (Elem const& x, Elem& r) const;					// x must be less than the modulus
+		void FromMont (Elem const& a, Elem& r) const;
+		void Mul      (Elem const& a, Elem const& b, Elem& r) const;	// r may alias a or b
+
+		// Computes (base ^ exp) mod m. Uses a 4-bit fixed window for exponents larger than 64 bits
+		void PowMod(MpUInt const& base, MpUInt const& exp, MpUInt& result) const;
+
+	private:
+		sizet  m_n    {};
+		uint64 m_mInv {};	// -m^-1 mod 2^64
+		Elem   m_m;
+		Elem   m_r2;		// R^2 mod m
+		Elem   m_one;		// R mod m, which is 1 in Montgomery form
+	};
+
+
+
+	// P256Field
+
+	// Arithmetic in the prime field of NIST P-256, p = 2^256 - 2^224 + 2^192 + 2^96 - 1. Products are reduced with
+	// the Solinas method (FIPS 186-4, D.2.3), which uses only additions and subtractions of 32-bit words of the product.
+	// Inputs must be fully reduced, in [0, p), and results are fully reduced. Results may alias inputs.
+
+	struct P256Field
+	{
+		using Elem = MpFixed<4>;
+
+		static Elem Prime();
+		static bool IsPrime(MpUInt const& m);
+
+		static void Add (Elem const& a, Elem const& b, Elem& r) noexcept;
+		static void Sub (Elem const& a, Elem const& b, Elem& r) noexcept;
+		static void Mul (Elem const& a, Elem const& b, Elem& r) noexcept;
+		static void Sqr (Elem const& a, Elem& r) noexcept { Mul(a, a, r); }
+		static void Pow (Elem const& a, Elem const& e, Elem& r) noexcept;
+	};
+
+}
@@ -1,6 +1,8 @@
 #include "AtIncludes.h"
 #include "AtMpUInt.h"
 
+#include "AtMpFixed.h"
+
 namespace At
 {
 
@@ -124,6 +126,35 @@ namespace At
 	}
 
 
+	MpUInt const& MpUInt::ToLimbs64(uint64* limbs, sizet nrLimbs) const
+	{
+		EnsureThrow(NrWords() <= 2 * nrLimbs);
+
+		for (sizet i=0; i!=nrLimbs; ++i)
+		{
+			uint32 lo = If(2*i   < NrWords(), uint32, m_words[2*i  ], 0);
+			uint32 hi = If(2*i+1 < NrWords(), uint32, m_words[2*i+1], 0);
+			limbs[i] = JoinWords(hi, lo);
+		}
+
+		return *this;
+	}
+
+
+	MpUInt& MpUInt::FromLimbs64(uint64 const* limbs, sizet nrLimbs)
+	{
+		m_words.ResizeExact(2 * nrLimbs);
+		for (sizet i=0; i!=nrLimbs; ++i)
+		{
+			m_words[2*i  ] = LoWord(limbs[i]);
+			m_words[2*i+1] = HiWord(limbs[i]);
+		}
+
+		StripLeadingZeros();
+		return *this;
+	}
+
+
 	int MpUInt::CmpS(uint64 x) const
 	{
 		uint32 w[2] = { LoWord(x), HiWord(x) };
@@ -554,6 +585,11 @@ namespace At
 			else
 				result.SetZero();
 		}
+		else if (x && MpMont::Supports(m))
+		{
+			MpMont mont { m };
+			mont.PowMod(*this, MpUInt(x), result);
+		}
 		else
 		{
 			result.Set(1);
@@ -593,6 +629,11 @@ namespace At
 			else
 				result.SetZero();
 		}
+		else if (x.NonZero() && MpMont::Supports(m))
+		{
+			MpMont mont { m };
+			mont.PowMod(*this, x, result);
+		}
 		else
 		{
 			result.Set(1);
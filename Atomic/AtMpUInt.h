@@ -12,6 +12,8 @@ namespace At
 	// - For use in non-critical supporting algorithms, specifically ECC point decompression (not supported by Windows CNG at this time).
 	// - Could use a library such as Crypto++, but this creates project integration issues, and adds a dependency on a large, external moving target.
 	// - For non-critical purposes, prefer smaller, simpler code, even at a significant performance cost; compared to optimized code that's larger and more complex.
+	// - Modular exponentiation with an odd modulus of up to 4096 bits is delegated to Montgomery arithmetic in AtMpFixed, which avoids a long division
+	//   per multiplication. Other operations remain simple word-by-word implementations.
 
 	struct MpUInt_LongDivide;
 
@@ -39,8 +41,14 @@ namespace At
 		MpUInt& ReadBytes(Seq bin);
 		MpUInt const& WriteBytes(Enc& enc, sizet padToMinBytes = 0) const;
 
+		// Conversion to and from 64-bit limbs, least significant limb first. ToLimbs64 pads with zero limbs,
+		// and fails with EnsureThrow if the value does not fit in nrLimbs.
+		MpUInt const& ToLimbs64(uint64* limbs, sizet nrLimbs) const;
+		MpUInt& FromLimbs64(uint64 const* limbs, sizet nrLimbs);
+
 		bool NonZero() const { return m_words.Any(); }
 		bool IsZero() const { return !m_words.Any(); }
+		bool IsOdd() const { return m_words.Any() && (m_words.First() & 1) != 0; }
 
 		int CmpS(uint64 x) const;
 		int CmpS(uint32 x) const;
@@ -1,10 +1,21 @@
 #include "AtIncludes.h"
 #include "AtNumCvt.h"
 
+#include "AtInitOnFirstUse.h"
+
 
 namespace At
 {
 
+	namespace Internal
+	{
+		// Defined in AtNumCvtPow5.cpp
+		extern uint64 const c_eiselLemirePow5[];
+	}
+
+	using namespace Internal;
+
+
 	char const* const NumAlphabet::Upper = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 	char const* const NumAlphabet::Lower = "0123456789abcdefghijklmnopqrstuvwxyz";
 
@@ -18,7 +29,6 @@ namespace At
 	}
 
 
-
 	sizet UInt2Buf(uint64 value, byte* buf, uint base, uint zeroPadWidth, CharCase charCase, uint spacePadWidth) noexcept
 	{
 		byte const* const alphabet = (byte const*) NumAlphabet::Get(charCase);
@@ -53,7 +63,6 @@ namespace At
 	}
 
 
-
 	sizet SInt2Buf(int64 value, byte* buf, AddSign::E addSign, uint base, uint zeroPadWidth, CharCase charCase) noexcept
 	{
 		if (value >= 0)
@@ -119,4 +128,667 @@ namespace At
 		return (sizet) (buf - bufOrig);
 	}
 
+
+
+	// Dbl2Buf_Shortest
+
+	namespace
+	{
+		inline uint64 Mul64x64(uint64 a, uint64 b, uint64& hi) noexcept
+		{
+		#ifdef _M_X64
+			return _umul128(a, b, &hi);
+		#else
+			uint64 aLo = (uint32) a, aHi = a >> 32;
+			uint64 bLo = (uint32) b, bHi = b >> 32;
+			uint64 p0 = aLo * bLo, p1 = aLo * bHi, p2 = aHi * bLo, p3 = aHi * bHi;
+			uint64 mid = (p0 >> 32) + ((uint32) p1) + ((uint32) p2);
+			hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+			return (mid << 32) | ((uint32) p0);
+		#endif
+		}
+
+
+		// x must not be zero
+		inline int CountLeadingZeros64(uint64 x) noexcept
+		{
+			unsigned long i;
+		#ifdef _M_X64
+			_BitScanReverse64(&i, x);
+			return 63 - (int) i;
+		#else
+			if (_BitScanReverse(&i, (unsigned long) (x >> 32)))
+				return 31 - (int) i;
+			_BitScanReverse(&i, (unsigned long) x);
+			return 63 - (int) i;
+		#endif
+		}
+
+
+		inline uint64 DblToBits(double v) noexcept { uint64 u; memcpy(&u, &v, 8); return u; }
+		inline double BitsToDbl(uint64 u) noexcept { double v; memcpy(&v, &u, 8); return v; }
+
+		uint64 const DblSignificandMask = 0x000FFFFFFFFFFFFFULL;
+		uint64 const DblExponentMask    = 0x7FF0000000000000ULL;
+		uint64 const DblSignMask        = 0x8000000000000000ULL;
+		uint64 const DblHiddenBit       = 0x0010000000000000ULL;
+		int    const DblSignificandBits = 52;
+		int    const DblExponentBias    = 0x3FF + DblSignificandBits;
+
+
+		// Grisu2, as described by Florian Loitsch in "Printing Floating-Point Numbers Quickly and Accurately with Integers" (2010).
+		// The output always reads back as the same double. It is the shortest such output for the vast majority of inputs;
+		// for the rest, it may contain one more digit than necessary.
+
+		struct DiyFp
+		{
+			uint64 m_f {};
+			int    m_e {};
+
+			DiyFp() = default;
+			DiyFp(uint64 f, int e) noexcept : m_f(f), m_e(e) {}
+
+			explicit DiyFp(double d) noexcept
+			{
+				uint64 u = DblToBits(d);
+				int biasedExp = (int) ((u & DblExponentMask) >> DblSignificandBits);
+				uint64 significand = (u & DblSignificandMask);
+				if (biasedExp != 0)
+				{
+					m_f = significand + DblHiddenBit;
+					m_e = biasedExp - DblExponentBias;
+				}
+				else
+				{
+					m_f = significand;
+					m_e = 1 - DblExponentBias;
+				}
+			}
+
+			DiyFp operator- (DiyFp const& x) const noexcept { return DiyFp(m_f - x.m_f, m_e); }
+
+			DiyFp operator* (DiyFp const& x) const noexcept
+			{
+				uint64 hi;
+				uint64 lo = Mul64x64(m_f, x.m_f, hi);
+				if (lo & (1ULL << 63))
+					++hi;
+				return DiyFp(hi, m_e + x.m_e + 64);
+			}
+
+			DiyFp Normalize() const noexcept
+			{
+				int s = CountLeadingZeros64(m_f);
+				return DiyFp(m_f << s, m_e - s);
+			}
+
+			void NormalizedBoundaries(DiyFp& minus, DiyFp& plus) const noexcept
+			{
+				DiyFp pl = DiyFp((m_f << 1) + 1, m_e - 1).Normalize();
+				DiyFp mi;
+				if (m_f == DblHiddenBit)
+					mi = DiyFp((m_f << 2) - 1, m_e - 2);
+				else
+					mi = DiyFp((m_f << 1) - 1, m_e - 1);
+
+				mi.m_f <<= mi.m_e - pl.m_e;
+				mi.m_e = pl.m_e;
+				plus = pl;
+				minus = mi;
+			}
+		};
+
+
+		// Normalized 64-bit approximations of 10^k, for k = -348 + 8*i, rounded to nearest
+		uint64 const c_grisuCachedPowers_F[] =
+		{
+			0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+			0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+			0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+			0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+			0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+			0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+			0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+			0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+			0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+			0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+			0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+			0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+			0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+			0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+			0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+			0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+			0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+			0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+			0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+			0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+			0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+			0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+		};
+
+		int16 const c_grisuCachedPowers_E[] =
+		{
+			-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,  -954,  -927,
+			 -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,  -688,  -661,  -635,  -608,
+			 -582,  -555,  -529,  -502,  -475,  -449,  -422,  -396,  -369,  -343,  -316,  -289,
+			 -263,  -236,  -210,  -183,  -157,  -130,  -103,   -77,   -50,   -24,     3,    30,
+			   56,    83,   109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+			  375,   402,   428,   455,   481,   508,   534,   561,   588,   614,   641,   667,
+			  694,   720,   747,   774,   800,   827,   853,   880,   907,   933,   960,   986,
+			 1013,  1039,  1066,
+		};
+
+
+		DiyFp GrisuCachedPower(int e, int& k) noexcept
+		{
+			double dk = ((-61 - e) * 0.30102999566398114) + 347;
+			int ik = (int) dk;
+			if (dk - ik > 0.0)
+				++ik;
+
+			uint index = (uint) ((ik >> 3) + 1);
+			k = -(-348 + (int) (index << 3));
+			return DiyFp(c_grisuCachedPowers_F[index], c_grisuCachedPowers_E[index]);
+		}
+
+
+		uint64 const c_pow10_uint64[] =
+		{
+			1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+			10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+			10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+		};
+
+
+		void GrisuRound(byte* buf, int len, uint64 delta, uint64 rest, uint64 tenKappa, uint64 wpw) noexcept
+		{
+			while (rest < wpw && delta - rest >= tenKappa &&
+			       (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw))
+			{
+				--buf[len - 1];
+				rest += tenKappa;
+			}
+		}
+
+
+		int CountDecimalDigits32(uint32 n) noexcept
+		{
+			int d = 1;
+			while (d < 10 && n >= c_pow10_uint64[d])
+				++d;
+			return d;
+		}
+
+
+		void GrisuDigitGen(DiyFp const& w, DiyFp const& mp, uint64 delta, byte* buf, int& len, int& k) noexcept
+		{
+			DiyFp const one { 1ULL << -mp.m_e, mp.m_e };
+			DiyFp const wpw = mp - w;
+			uint32 p1 = (uint32) (mp.m_f >> -one.m_e);
+			uint64 p2 = mp.m_f & (one.m_f - 1);
+			int kappa = CountDecimalDigits32(p1);
+			len = 0;
+
+			while (kappa > 0)
+			{
+				uint32 div = (uint32) c_pow10_uint64[kappa - 1];
+				uint32 d = p1 / div;
+				p1 %= div;
+
+				if (d || len)
+					buf[len++] = (byte) ('0' + d);
+
+				--kappa;
+				uint64 rest = (((uint64) p1) << -one.m_e) + p2;
+				if (rest <= delta)
+				{
+					k += kappa;
+					GrisuRound(buf, len, delta, rest, c_pow10_uint64[kappa] << -one.m_e, wpw.m_f);
+					return;
+				}
+			}
+
+			while (true)
+			{
+				p2 *= 10;
+				delta *= 10;
+				byte d = (byte) (p2 >> -one.m_e);
+				if (d || len)
+					buf[len++] = (byte) ('0' + d);
+
+				p2 &= one.m_f - 1;
+				--kappa;
+				if (p2 < delta)
+				{
+					k += kappa;
+					int index = -kappa;
+					uint64 wpwScaled {};
+					if (index < 20)
+						wpwScaled = wpw.m_f * c_pow10_uint64[index];
+					GrisuRound(buf, len, delta, p2, one.m_f, wpwScaled);
+					return;
+				}
+			}
+		}
+
+
+		// value must be finite and positive. Writes up to 17 digits to buf. The value is then 0.<digits> * 10^(len+k)
+		void Grisu2(double value, byte* buf, int& len, int& k) noexcept
+		{
+			DiyFp const v { value };
+			DiyFp wm, wp;
+			v.NormalizedBoundaries(wm, wp);
+
+			DiyFp const cmk = GrisuCachedPower(wp.m_e, k);
+			DiyFp const w = v.Normalize() * cmk;
+			DiyFp wpScaled = wp * cmk;
+			DiyFp wmScaled = wm * cmk;
+			++wmScaled.m_f;
+			--wpScaled.m_f;
+			GrisuDigitGen(w, wpScaled, wpScaled.m_f - wmScaled.m_f, buf, len, k);
+		}
+
+
+		byte* WriteDblExponent(int e, byte* p) noexcept
+		{
+			*p++ = 'e';
+			if (e < 0)
+			{
+				*p++ = '-';
+				e = -e;
+			}
+			else
+				*p++ = '+';
+
+			if (e >= 100)
+			{
+				*p++ = (byte) ('0' + (e / 100));
+				e %= 100;
+				*p++ = (byte) ('0' + (e / 10));
+			}
+			else if (e >= 10)
+				*p++ = (byte) ('0' + (e / 10));
+
+			*p++ = (byte) ('0' + (e % 10));
+			return p;
+		}
+	}
+
+
+	sizet Dbl2Buf_Shortest(double value, byte* buf) noexcept
+	{
+		byte* p = buf;
+		uint64 bits = DblToBits(value);
+
+		if ((bits & DblExponentMask) == DblExponentMask)
+		{
+			if (bits & DblSignificandMask)
+				{ memcpy(p, "NaN", 3); return 3; }
+
+			if (bits & DblSignMask)
+				*p++ = '-';
+
+			memcpy(p, "Infinity", 8);
+			return (sizet) (p + 8 - buf);
+		}
+
+		if (bits & DblSignMask)
+		{
+			*p++ = '-';
+			value = -value;
+		}
+
+		if (value == 0.0)
+		{
+			*p++ = '0';
+			return (sizet) (p - buf);
+		}
+
+		// Same formatting rules as ECMAScript Number.prototype.toString(), so output matches what browsers emit for JSON
+		int len, k;
+		Grisu2(value, p, len, k);
+		int const kk = len + k;		// 10^(kk-1) <= value < 10^kk
+
+		if (k >= 0 && kk <= 21)
+		{
+			// 1234e7 -> 12340000000
+			for (int i=len; i<kk; ++i)
+				p[i] = '0';
+			p += kk;
+		}
+		else if (kk > 0 && kk <= 21)
+		{
+			// 1234e-2 -> 12.34
+			memmove(p + kk + 1, p + kk, (sizet) (len - kk));
+			p[kk] = '.';
+			p += len + 1;
+		}
+		else if (kk > -6 && kk <= 0)
+		{
+			// 1234e-6 -> 0.001234
+			int offset = 2 - kk;
+			memmove(p + offset, p, (sizet) len);
+			p[0] = '0';
+			p[1] = '.';
+			for (int i=2; i<offset; ++i)
+				p[i] = '0';
+			p += len + offset;
+		}
+		else if (len == 1)
+		{
+			// 1e30
+			p = WriteDblExponent(kk - 1, p + 1);
+		}
+		else
+		{
+			// 1234e30 -> 1.234e+33
+			memmove(p + 2, p + 1, (sizet) (len - 1));
+			p[1] = '.';
+			p = WriteDblExponent(kk - 1, p + len + 1);
+		}
+
+		return (sizet) (p - buf);
+	}
+
+
+	// Buf2Dbl_Exact
+
+	namespace
+	{
+		double const c_pow10_exactDbl[] =
+		{
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+
+		// Eisel-Lemire, as described by Daniel Lemire in "Number Parsing at a Gigabyte per Second" (2021).
+		// Computes the correctly rounded IEEE bits for w * 10^q, where w != 0 and -342 <= q <= 308, ignoring sign.
+		// Returns false in the rare cases where the result cannot be determined with 128-bit precision.
+
+		bool EiselLemire(uint64 w, int q, uint64& bits) noexcept
+		{
+			int lz = CountLeadingZeros64(w);
+			w <<= lz;
+
+			sizet index = 2 * (sizet) (q + 342);
+			uint64 hi;
+			uint64 lo = Mul64x64(w, c_eiselLemirePow5[index], hi);
+			if ((hi & 0x1FF) == 0x1FF)
+			{
+				uint64 hi2;
+				Mul64x64(w, c_eiselLemirePow5[index + 1], hi2);
+				lo += hi2;
+				if (hi2 > lo)
+					++hi;
+			}
+
+			if (lo == UINT64_MAX && (q < -27 || q > 55))
+				return false;
+
+			int upperBit = (int) (hi >> 63);
+			uint64 mantissa = hi >> (upperBit + 64 - DblSignificandBits - 3);
+			int power2 = (((152170 + 65536) * q) >> 16) + 63 + upperBit - lz + 1023;
+
+			if (power2 <= 0)
+			{
+				// Subnormal
+				if (-power2 + 1 >= 64)
+				{
+					bits = 0;
+					return true;
+				}
+
+				mantissa >>= -power2 + 1;
+				mantissa += (mantissa & 1);
+				mantissa >>= 1;
+				power2 = 0;
+				if (mantissa >= DblHiddenBit)
+					power2 = 1;
+
+				bits = mantissa | (((uint64) power2) << DblSignificandBits);
+				return true;
+			}
+
+			// Exactly halfway between two doubles: round to even
+			if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1)
+				if ((mantissa << (upperBit + 64 - DblSignificandBits - 3)) == hi)
+					mantissa &= ~1ULL;
+
+			mantissa += (mantissa & 1);
+			mantissa >>= 1;
+			if (mantissa >= (DblHiddenBit << 1))
+			{
+				mantissa = DblHiddenBit;
+				++power2;
+			}
+
+			mantissa &= ~DblHiddenBit;
+			if (power2 >= 0x7FF)
+			{
+				bits = DblExponentMask;
+				return true;
+			}
+
+			bits = mantissa | (((uint64) power2) << DblSignificandBits);
+			return true;
+		}
+
+
+		LONG volatile a_cLocale_initFlag {};
+		_locale_t a_cLocale {};
+
+
+		// Slow path for inputs that are too long or too close to a rounding boundary. Rewrites the number as
+		// [-]0.<digits>e<exp> with at most MaxDigits significant digits, plus a sticky digit if any non-zero digits were dropped.
+		// No double requires more than 767 significant digits to be rounded correctly, so this does not change the result.
+
+		double Buf2Dbl_Fallback(byte const* p, byte const* pEnd, bool neg, int64 expAdj) noexcept
+		{
+			enum { MaxDigits = 800 };
+			char buf[MaxDigits + 40];
+			char* w = buf;
+			if (neg)
+				*w++ = '-';
+			*w++ = '0';
+			*w++ = '.';
+
+			int64 exp10 = expAdj;
+			sizet nrDigits {};
+			bool seenNonZero {}, inFrac {}, sticky {};
+			for (; p != pEnd; ++p)
+			{
+				if (*p == '.')
+					{ inFrac = true; continue; }
+
+				uint d = (uint) (*p - '0');
+				if (!seenNonZero)
+				{
+					if (d == 0)
+					{
+						if (inFrac)
+							--exp10;
+						continue;
+					}
+
+					seenNonZero = true;
+				}
+
+				if (!inFrac)
+					++exp10;
+
+				if (nrDigits < MaxDigits)
+				{
+					*w++ = (char) ('0' + d);
+					++nrDigits;
+				}
+				else if (d != 0)
+					sticky = true;
+			}
+
+			if (!nrDigits)
+				return If(neg, double, -0.0, 0.0);
+
+			if (sticky)
+				*w++ = '1';
+
+			if (exp10 > 99999)
+				exp10 = 99999;
+			else if (exp10 < -99999)
+				exp10 = -99999;
+
+			*w++ = 'e';
+			w += SInt2Buf(exp10, (byte*) w);
+			*w = 0;
+
+			InitOnFirstUse(&a_cLocale_initFlag, [] { a_cLocale = _create_locale(LC_NUMERIC, "C"); } );
+			return _strtod_l(buf, nullptr, a_cLocale);
+		}
+	}
+
+
+	sizet Buf2Dbl_Exact(byte const* buf, sizet n, double& value) noexcept
+	{
+		byte const* p = buf;
+		byte const* const pEnd = buf + n;
+
+		bool neg {};
+		if (p != pEnd && *p == '-')
+		{
+			neg = true;
+			++p;
+		}
+
+		// Accumulate up to 19 significant digits in w, so that w * 10^q is the value of the digits read
+		byte const* const pDigits = p;
+		uint64 w {};
+		int64 q {};
+		uint nrSigDigits {};
+		bool truncated {}, anyDigits {};
+
+		for (; p != pEnd && *p >= '0' && *p <= '9'; ++p)
+		{
+			anyDigits = true;
+			uint d = (uint) (*p - '0');
+			if (nrSigDigits < 19)
+			{
+				w = (w * 10) + d;
+				if (w != 0)
+					++nrSigDigits;
+			}
+			else
+			{
+				++q;
+				if (d != 0)
+					truncated = true;
+			}
+		}
+
+		if (p != pEnd && *p == '.')
+		{
+			byte const* pDot = p++;
+			for (; p != pEnd && *p >= '0' && *p <= '9'; ++p)
+			{
+				anyDigits = true;
+				uint d = (uint) (*p - '0');
+				if (nrSigDigits < 19)
+				{
+					w = (w * 10) + d;
+					--q;
+					if (w != 0)
+						++nrSigDigits;
+				}
+				else if (d != 0)
+					truncated = true;
+			}
+
+			if (!anyDigits)
+				p = pDot;
+		}
+
+		if (!anyDigits)
+		{
+			value = std::numeric_limits<double>::quiet_NaN();
+			return 0;
+		}
+
+		byte const* const pDigitsEnd = p;
+
+		int64 exp10 {};
+		if (p != pEnd && (*p == 'e' || *p == 'E'))
+		{
+			byte const* e = p + 1;
+			bool expNeg {};
+			if (e != pEnd && (*e == '+' || *e == '-'))
+				expNeg = (*e++ == '-');
+
+			if (e != pEnd && *e >= '0' && *e <= '9')
+			{
+				for (; e != pEnd && *e >= '0' && *e <= '9'; ++e)
+					if (exp10 < 100000)
+						exp10 = (exp10 * 10) + (*e - '0');
+
+				if (expNeg)
+					exp10 = -exp10;
+
+				p = e;
+			}
+		}
+
+		sizet const nrRead = (sizet) (p - buf);
+		q += exp10;
+
+		if (w == 0)
+		{
+			value = If(neg, double, -0.0, 0.0);
+			return nrRead;
+		}
+
+		if (!truncated)
+		{
+			// Clinger's fast path: both w and 10^|q| are exactly representable, so a single operation rounds correctly
+			if (w <= (1ULL << 53) && q >= -22 && q <= 22)
+			{
+				double d = (double) w;
+				if (q < 0)
+					d /= c_pow10_exactDbl[-q];
+				else
+					d *= c_pow10_exactDbl[q];
+
+				value = If(neg, double, -d, d);
+				return nrRead;
+			}
+		}
+
+		uint64 bits {};
+		bool haveBits {};
+		if (q < -342)
+			haveBits = true;
+		else if (q > 308)
+			{ bits = DblExponentMask; haveBits = true; }
+		else
+		{
+			haveBits = EiselLemire(w, (int) q, bits);
+			if (haveBits && truncated)
+			{
+				// The exact value lies between w * 10^q and (w+1) * 10^q. If both round the same way, that is the result
+				uint64 bitsUp {};
+				if (!EiselLemire(w + 1, (int) q, bitsUp) || bitsUp != bits)
+					haveBits = false;
+			}
+		}
+
+		if (!haveBits)
+		{
+			value = Buf2Dbl_Fallback(pDigits, pDigitsEnd, neg, exp10);
+			return nrRead;
+		}
+
+		if (neg)
+			bits |= DblSignMask;
+
+		value = BitsToDbl(bits);
+		return nrRead;
+	}
+
 }
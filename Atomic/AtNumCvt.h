@@ -26,4 +26,14 @@ namespace At
 	sizet SInt2Buf(int64 value, byte* buf, AddSign::E addSign = AddSign::IfNeg, uint base = 10, uint zeroPadWidth = 0, CharCase charCase = CharCase::Upper) noexcept;
 	sizet Dbl2Buf(double value, byte* buf, uint prec = 4) noexcept;
 
+	// Writes the shortest decimal representation that reads back as exactly the same double, using the same formatting rules
+	// as ECMAScript Number.prototype.toString(): "0.1", "123", "1e+21", "1.5e-7". Infinity and NaN are written as "Infinity" and "NaN".
+	// The buffer must have room for at least Dbl2Buf_Shortest_MaxBytes. Output is NOT null-terminated.
+	enum { Dbl2Buf_Shortest_MaxBytes = 32 };
+	sizet Dbl2Buf_Shortest(double value, byte* buf) noexcept;
+
+	// Reads a decimal number in the format [-]digits[.digits][(e|E)[+|-]digits], and rounds it correctly to the nearest double.
+	// Returns the number of bytes read. If the input does not begin with a number, returns zero and sets value to NaN.
+	sizet Buf2Dbl_Exact(byte const* buf, sizet n, double& value) noexcept;
+
 }
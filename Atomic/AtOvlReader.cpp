@@ -19,7 +19,10 @@ namespace At
 			ReadDest rd = BeginRead(m_readSize, 1);
 			DWORD readSize = NumCast<DWORD>(rd.m_maxBytes);
 			ZeroMemory(&m_ovl, sizeof(m_ovl));
-			m_ovl.hEvent = m_readEvent.Handle();
+
+			// The low-order bit prevents a completion packet from being queued if the handle is associated with a completion port,
+			// as is a socket whose connection has been parked in EmailServerReactor. The event is signaled regardless
+			m_ovl.hEvent = (HANDLE) (((ULONG_PTR) m_readEvent.Handle()) | 1);
 
 			// Read
 			int64       errorCode   {};
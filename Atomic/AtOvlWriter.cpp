@@ -13,7 +13,7 @@ namespace At
 		while (data.n != 0)
 		{
 			ZeroMemory(&m_ovl, sizeof(m_ovl));
-			m_ovl.hEvent = m_writeEvent.Handle();
+			m_ovl.hEvent = (HANDLE) (((ULONG_PTR) m_writeEvent.Handle()) | 1);		// No completion packet, see OvlReader::Read
 
 			int64 errorCode      {};
 			DWORD nrBytesToWrite { (DWORD) PickMin<sizet>(m_writeSize, data.n) };
@@ -133,13 +133,14 @@ namespace At
 	{
 		if (c == 10)
 		{
-			++m_toRow;
+			if (m_toRow != UINT32_MAX)
+				++m_toRow;
 			m_toCol = 1;
 		}
 		else if (c == 9)
-			m_toCol = m_tree.ApplyTab(m_toCol);
+			m_toCol = (uint32) PickMin<sizet>(m_tree.ApplyTab(m_toCol), UINT32_MAX);
 		else
-			m_toCol += Unicode::CharInfo::Get(c).m_width;
+			m_toCol = (uint32) PickMin<uint64>(((uint64) m_toCol) + Unicode::CharInfo::Get(c).m_width, UINT32_MAX);
 	}
 
 
@@ -121,16 +121,12 @@ namespace At
 
 		ParseTree&			m_tree;
 		Ruid const*			m_type;
-		sizet				m_depth       {};
 		ParseNode*			m_parent      {};
 		ParseNode*			m_nextSibling {};
 
 		// Input
 		Seq					m_start;
 		Seq					m_remaining;
-		sizet				m_startRow, m_toRow;
-		sizet				m_startCol, m_toCol;
-		bool				m_committed {};
 	
 		// Value (V-type parsers)
 		Seq					m_value;
@@ -139,6 +135,13 @@ namespace At
 		ParseNode*			m_firstChild {};
 		ParseNode*			m_lastChild  {};
 
+		// Narrow fields are grouped last so that nodes are compact, and more of them fit in a ParseTree::Bucket.
+		// Rows and columns saturate instead of wrapping if the input is too large for them
+		uint32				m_startRow, m_toRow;
+		uint32				m_startCol, m_toCol;
+		uint32				m_depth       {};
+		bool				m_committed   {};
+
 		ParseNode(ParseTree& tree, Seq srcText);
 		ParseNode(ParseNode& parent, Ruid const& type);
 
@@ -4,6 +4,27 @@
 
 namespace At
 {
+	namespace
+	{
+
+		// Set when the thread's storage is destroyed. Trees destroyed later during thread exit free their buckets instead
+		thread_local bool t_parseTree_threadExiting {};
+
+		thread_local ParseTree::ThreadStats t_parseTree_threadStats;
+
+		struct ThreadStorage : ParseTree::Storage
+		{
+			ThreadStorage() noexcept { m_maxBuckets = ParseTree::ThreadStorageMaxBuckets; }
+			~ThreadStorage() noexcept { t_parseTree_threadExiting = true; }
+		};
+
+		thread_local ThreadStorage t_parseTree_storage;
+
+		ParseTree::Storage* CurThreadStorage() noexcept { return t_parseTree_threadExiting ? nullptr : &t_parseTree_storage; }
+
+	} // anon
+
+
 
 	// ParseTree::Bucket
 
@@ -25,6 +46,20 @@ namespace At
 
 	// ParseTree::Storage
 
+	void ParseTree::Storage::PushBucket(Bucket* b) noexcept
+	{
+		if (m_nrBuckets >= m_maxBuckets)
+			NoExcept(delete b);
+		else
+		{
+			b->m_nodesUsed = 0;
+			b->m_prevBucket = m_lastBucket;
+			m_lastBucket = b;
+			++m_nrBuckets;
+		}
+	}
+
+
 	ParseTree::Storage::~Storage() noexcept
 	{
 		for (Bucket* b=m_lastBucket; b!=0; )
@@ -35,19 +70,22 @@ namespace At
 		}
 
 		m_lastBucket = 0;
+		m_nrBuckets = 0;
 	}
 
 
 
 	// ParseTree
 
-	ParseTree::ParseTree(Seq srcText, Storage* storage)
+	ParseTree::ThreadStats const& ParseTree::GetThreadStats() noexcept
 	{
-		if (storage)
-			m_storage = storage;
-		else
-			m_storage = &m_instanceStorage;
+		return t_parseTree_threadStats;
+	}
+
 
+	ParseTree::ParseTree(Seq srcText, Storage* storage)
+		: m_storage(storage)
+	{
 		m_firstBucket = m_lastBucket = GetNewBucket();
 		new (m_firstBucket->AddUnconstructedNode()) ParseNode(*this, srcText);
 
@@ -61,11 +99,17 @@ namespace At
 
 	ParseTree::~ParseTree() noexcept
 	{
+		ThreadStats& stats = t_parseTree_threadStats;
+		++stats.m_nrTrees;
+		stats.m_nrNodes += NrNodes();
+		if (stats.m_maxBucketsPerTree < m_peakNrBuckets)
+			stats.m_maxBucketsPerTree = m_peakNrBuckets;
+
 		for (Bucket* b=m_lastBucket; b!=nullptr; )
 		{
 			Bucket* d = b;
 			b = b->m_prevBucket;
-			m_storage->PushBucket(d);
+			ReleaseBucket(d);
 		}
 
 		m_firstBucket = nullptr;
@@ -175,18 +219,49 @@ namespace At
 			}
 
 			Bucket* b = m_lastBucket->m_prevBucket;
-			m_storage->PushBucket(m_lastBucket);
+			ReleaseBucket(m_lastBucket);
 			m_lastBucket = b;
 		}
 	}
 
 
+	sizet ParseTree::NrNodes() const noexcept
+	{
+		sizet nrNodes {};
+		for (Bucket const* b=m_lastBucket; b!=nullptr; b=b->m_prevBucket)
+			nrNodes += b->m_nodesUsed;
+		return nrNodes;
+	}
+
+
 	ParseTree::Bucket* ParseTree::GetNewBucket()
 	{
-		Bucket* b = m_storage->PopBucket();
-		if (!b)
+		Storage* storage = m_storage ? m_storage : CurThreadStorage();
+		Bucket* b = storage ? storage->PopBucket() : nullptr;
+		if (b)
+			++t_parseTree_threadStats.m_nrBucketsReused;
+		else
+		{
 			b = new Bucket;
+			++t_parseTree_threadStats.m_nrBucketsAllocated;
+		}
+
+		if (++m_nrBuckets > m_peakNrBuckets)
+			m_peakNrBuckets = m_nrBuckets;
+
 		return b;
 	}
 
+
+	void ParseTree::ReleaseBucket(Bucket* b) noexcept
+	{
+		--m_nrBuckets;
+
+		Storage* storage = m_storage ? m_storage : CurThreadStorage();
+		if (storage)
+			storage->PushBucket(b);
+		else
+			NoExcept(delete b);
+	}
+
 }
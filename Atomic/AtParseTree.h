@@ -31,16 +31,36 @@ namespace At
 			Bucket* m_prevBucket {};
 		};
 
+		// Keeps buckets released by trees, so that later trees can reuse them instead of allocating.
+		// Buckets released while the storage already holds m_maxBuckets are freed
 		struct Storage
 		{
 			Bucket* m_lastBucket {};
+			sizet   m_nrBuckets  {};
+			sizet   m_maxBuckets { SIZE_MAX };
 
-			void PushBucket(Bucket* b) noexcept { b->m_nodesUsed = 0; b->m_prevBucket = m_lastBucket; m_lastBucket = b; }
-			Bucket* PopBucket() noexcept { Bucket* b = m_lastBucket; if (b) { m_lastBucket = b->m_prevBucket; b->m_prevBucket = nullptr; } return b; }
+			void PushBucket(Bucket* b) noexcept;
+			Bucket* PopBucket() noexcept { Bucket* b = m_lastBucket; if (b) { m_lastBucket = b->m_prevBucket; b->m_prevBucket = nullptr; --m_nrBuckets; } return b; }
 
 			~Storage() noexcept;
 		};
 
+		// Trees constructed without a Storage use a per-thread storage. A tree returns its buckets to the storage
+		// of the thread that destroys it, which need not be the thread that constructed it
+		enum { ThreadStorageMaxBuckets = 64 };
+
+		// Per-thread counters, updated as trees are destroyed. Useful for sizing ThreadStorageMaxBuckets
+		struct ThreadStats
+		{
+			uint64 m_nrTrees             {};
+			uint64 m_nrNodes             {};
+			uint64 m_nrBucketsAllocated  {};		// Buckets obtained from the heap
+			uint64 m_nrBucketsReused     {};		// Buckets obtained from a Storage
+			sizet  m_maxBucketsPerTree   {};
+		};
+
+		static ThreadStats const& GetThreadStats() noexcept;
+
 	public:
 		ParseTree(Seq srcText, Storage* storage = nullptr);
 		ParseTree(ParseTree&&) noexcept = default;
@@ -69,14 +89,20 @@ namespace At
 		ParseNode&       Root()       { EnsureThrow(HaveRoot()); return *(m_firstBucket->NodePtrAt(0)); }
 		ParseNode const& Root() const { EnsureThrow(HaveRoot()); return *(m_firstBucket->NodePtrAt(0)); }
 
+		sizet NrNodes       () const noexcept;
+		sizet NodeBytes     () const noexcept { return NrNodes() * Bucket::ElemsPerNode * sizeof(sizet); }
+		sizet NrBuckets     () const noexcept { return m_nrBuckets; }
+		sizet PeakNrBuckets () const noexcept { return m_peakNrBuckets; }
+
 	private:
 		uint             m_tabStop { 4 };
 		Vec<Ruid const*> m_flags;
 
-		Storage     m_instanceStorage;
-		Storage*    m_storage;
+		Storage*    m_storage;				// nullptr if using per-thread storage
 		Bucket*     m_firstBucket;
 		Bucket*     m_lastBucket;
+		sizet       m_nrBuckets     {};
+		sizet       m_peakNrBuckets {};
 
 		bool        m_maxDepthExceeded {};
 		Seq			m_bestRemaining;
@@ -98,6 +124,7 @@ namespace At
 		void DiscardNode(ParseNode* p);
 
 		Bucket* GetNewBucket();
+		void ReleaseBucket(Bucket* b) noexcept;
 
 		friend class ParseNode;
 	};
@@ -8,34 +8,73 @@
 namespace At
 {
 
+	// Pop3ServerSession
+
+	struct Pop3ServerSession : EmailServerSession
+	{
+		Pop3ServerSession(EmailServerWorkItem& workItem) : EmailServerSession(workItem.m_sk, workItem.m_saRemote, workItem.m_bindingToken) {}
+
+		Pop3ServerCfg           m_cfg     { Entity::Contained };
+		EmailSrvBinding const*  m_binding {};
+		Str                     m_ourName;
+
+		Rp<Pop3ServerAuthCx>    m_authCx;
+		Str                     m_userName;
+		Str                     m_password;
+		Vec<Pop3ServerMsgEntry> m_msgs;
+	};
+
+
+
+	// Pop3ServerThread
+
 	void Pop3ServerThread::WorkPoolThread_ProcessWorkItem(void* pvWorkItem)
 	{
 		SockInit sockInit;
 		AutoFree<EmailServerWorkItem> workItem = (EmailServerWorkItem*) pvWorkItem;
-		Socket& sk = workItem->m_sk;
+		AutoFree<Pop3ServerSession> session;
+
+		bool const resumed = workItem->m_session.Any();
+		if (resumed)
+			session.Set((Pop3ServerSession*) workItem->m_session.Dismiss());
+		else
+		{
+			session.Set(new Pop3ServerSession(workItem.Ref()));
+
+			Pop3ServerCfg& cfg = session->m_cfg;
+			m_workPool->Pop3Server_GetCfg(cfg);
+
+			EmailSrvBinding const* binding = EmailSrvBindings_FindPtrByToken(cfg.f_bindings, session->m_bindingToken);
+			session->m_binding = binding;
 
-		Pop3ServerCfg cfg { Entity::Contained };
-		m_workPool->Pop3Server_GetCfg(cfg);
+			if (binding && binding->f_computerName.Any()) session->m_ourName = binding->f_computerName;
+			else                                          session->m_ourName = cfg.f_computerName;
+		}
 
-		EmailSrvBinding const* binding = EmailSrvBindings_FindPtrByToken(cfg.f_bindings, workItem->m_bindingToken);
+		session->m_conn.SetStopCtl(*this);
 
-		Str ourName;
-		if (binding && binding->f_computerName.Any()) ourName = binding->f_computerName;
-		else                                          ourName = cfg.f_computerName;
+		if (RunSession(session.Ref(), resumed))
+		{
+			AutoFree<EmailServerSession> parked { session.Dismiss() };
+			m_workPool->ParkSession(parked);
+		}
+	}
 
-		SocketReader reader { sk.GetSocket() };
-		SocketWriter writer { sk.GetSocket() };
-		Schannel conn { &reader, &writer };
-		conn.SetStopCtl(*this);
+
+	bool Pop3ServerThread::RunSession(Pop3ServerSession& session, bool resumed)
+	{
+		Schannel&              conn    = session.m_conn;
+		EmailSrvBinding const* binding = session.m_binding;
+		Str const&             ourName = session.m_ourName;
 
 		try
 		{
 			try
 			{
-				Rp<Pop3ServerAuthCx> l_authCx;
-				Str l_userName;
-				Str l_password;
-				Vec<Pop3ServerMsgEntry> l_msgs;
+				Rp<Pop3ServerAuthCx>&    l_authCx   = session.m_authCx;
+				Str&                     l_userName = session.m_userName;
+				Str&                     l_password = session.m_password;
+				Vec<Pop3ServerMsgEntry>& l_msgs     = session.m_msgs;
 
 				auto startTls = [&] ()
 					{
@@ -76,18 +115,31 @@ namespace At
 							}
 					};
 
-				if (!binding)
-					throw EmailServer_Disconnect("Cannot accept connection: configuration changed, binding no longer present");
+				if (!session.m_greeted)
+				{
+					session.m_greeted = true;
 
-				if (binding->f_implicitTls)
-					startTls();
+					if (!binding)
+						throw EmailServer_Disconnect("Cannot accept connection: configuration changed, binding no longer present");
+
+					if (binding->f_implicitTls)
+						startTls();
 				
-				SendSingleLineReply(conn, Pop3ReplyType::OK, "POP3 Ready");
+					SendSingleLineReply(conn, Pop3ReplyType::OK, "POP3 Ready");
+				}
 
 				while (true)
 				{
+					// In event-driven mode, a session waiting for the next command is parked instead of blocking this thread.
+					// As in SmtpReceiverThread, the first command after resuming is read while blocking
 					EmailServer_ClientCmd cmd;
-					cmd.ReadCmd(conn);
+					if (!m_workPool->EventDriven() || resumed)
+					{
+						cmd.ReadCmd(conn);
+						resumed = false;
+					}
+					else if (!cmd.TryReadCmd(conn))
+						return true;
 				
 					if (cmd.m_cmd == "quit")
 					{
@@ -151,7 +203,7 @@ namespace At
 						else
 						{
 							l_password = Seq(cmd.m_params).Trim();
-							EmailServerAuthResult result = m_workPool->Pop3Server_Authenticate(workItem->m_saRemote, conn, l_userName, l_password, l_authCx);
+							EmailServerAuthResult result = m_workPool->Pop3Server_Authenticate(session.m_saRemote, conn, l_userName, l_password, l_authCx);
 
 							if (EmailServerAuthResult::Success == result)
 							{
@@ -318,6 +370,8 @@ namespace At
 		{
 			// Just close the connection.
 		}
+
+		return false;
 	}
 
 
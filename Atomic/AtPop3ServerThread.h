@@ -11,11 +11,18 @@ namespace At
 	enum class Pop3ReplyType { Err, OK };
 
 
+	struct Pop3ServerSession;
+
+
 	class Pop3ServerThread : public WorkPoolThread<Pop3Server>
 	{
 	private:
 		void WorkPoolThread_ProcessWorkItem(void* pvWorkItem) override;
 
+		// Processes commands until the session ends. In event-driven mode, returns true if the session is waiting for the client's
+		// next command, and should be parked until the client sends it. A resumed session reads its first command while blocking
+		bool RunSession(Pop3ServerSession& session, bool resumed);
+
 		void SendSingleLineReply(Writer& writer, Pop3ReplyType replyType, Seq text);
 
 		// Reply type is assumed to be +OK. First line follows +OK, subsequent lines are .-escaped and followed up with a trailing CRLF-dot-CRLF
@@ -3,6 +3,7 @@
 
 #include "AtAuto.h"
 #include "AtCrypt.h"
+#include "AtPwHashService.h"
 
 namespace At
 {
@@ -27,7 +28,21 @@ namespace At
 
 	bool PwHash::Verify(Seq pw, Seq pwHash)
 	{
-		// If changing this function, remember to update DummyVerify so it continues to match
+		bool match {};
+		PwHashService::Global().Verify(pw, pwHash, match, PwHashService::DefaultDeadline());
+		return match;
+	}
+
+
+	void PwHash::DummyVerify(Seq pw)
+	{
+		PwHashService::Global().DummyVerify(pw, PwHashService::DefaultDeadline());
+	}
+
+
+	bool PwHash::VerifyOnThisThread(Seq pw, Seq pwHash)
+	{
+		// If changing this function, remember to update DummyVerifyOnThisThread so it continues to match
 		// the side channel characteristics of Verify (e.g. memory access, CPU use, timing).
 
 		if (pwHash.n != Len)
@@ -58,7 +73,7 @@ namespace At
 	}
 
 
-	void PwHash::DummyVerify(Seq pw)
+	void PwHash::DummyVerifyOnThisThread(Seq pw)
 	{
 		byte salt[BB_SaltLen] = {};
 		Str digest { BusyBeaver<BB_SHA512>::OutputSize };
@@ -16,10 +16,17 @@ namespace At
 		static void Generate(Seq pw, byte* result);
 		static Str Generate(Seq pw) { Str result; result.ResizeExact(Len); Generate(pw, result.Ptr()); return result; }
 
+		// Verify and DummyVerify run on PwHashService::Global() with its default deadline, and block until done.
+		// If the application has not started the service, they compute on the calling thread.
+		// If the service is overloaded, or the deadline passes before the hash is computed, Verify returns false.
 		static bool Verify(Seq pw, Seq pwHash);
 
 		// A function with similar side channel characteristics (timing, memory, CPU use) as Verify.
 		// Used to guard against side channel attacks when e.g. username was guessed incorrectly.
 		static void DummyVerify(Seq pw);
+
+		// Compute on the calling thread. Used by PwHashService worker threads.
+		static bool VerifyOnThisThread(Seq pw, Seq pwHash);
+		static void DummyVerifyOnThisThread(Seq pw);
 	};
 }
@@ -0,0 +1,252 @@
+#include "AtIncludes.h"
+#include "AtPwHashService.h"
+
+#include "AtPwHash.h"
+#include "AtWait.h"
+
+
+namespace At
+{
+
+	PwHashService& PwHashService::Global()
+	{
+		static PwHashService s_service;
+		return s_service;
+	}
+
+
+	uint PwHashService::NrPhysicalCores()
+	{
+		uint nrCores {};
+
+		DWORD len {};
+		GetLogicalProcessorInformation(nullptr, &len);
+		if (GetLastError() == ERROR_INSUFFICIENT_BUFFER && len != 0)
+		{
+			Vec<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info;
+			info.ResizeExact(len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+			len = NumCast<DWORD>(info.Len() * sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+
+			if (GetLogicalProcessorInformation(info.Ptr(), &len))
+				for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION const& x : info)
+					if (x.Relationship == RelationProcessorCore)
+						++nrCores;
+		}
+
+		if (!nrCores)
+			nrCores = PickMax<uint>(std::thread::hardware_concurrency(), 1);
+
+		return nrCores;
+	}
+
+
+	void PwHashService::Start(Rp<StopCtl> const& stopCtl, uint nrThreads)
+	{
+		if (!nrThreads)
+			nrThreads = NrPhysicalCores();
+
+		{
+			Locker locker { m_mx };
+			EnsureThrow(!m_metrics.m_nrThreads);
+			m_metrics.m_nrThreads = nrThreads;
+		}
+
+		for (uint i=0; i!=nrThreads; ++i)
+		{
+			ThreadPtr<Worker> worker { Thread::Create };
+			worker->SetService(this);
+
+			// Counted before starting, because OnThreadExit is called also if the thread fails to start
+			{
+				Locker locker { m_mx };
+				++m_nrWorkers;
+			}
+
+			worker->Start(stopCtl);
+		}
+	}
+
+
+	void PwHashService::Process(Job* jobs, sizet nrJobs, Time deadline)
+	{
+		if (!nrJobs)
+			return;
+
+		Batch batch;
+		batch.m_nrRemaining = NumCast<LONG>(nrJobs);
+
+		bool runHere {};
+
+		{
+			Locker locker { m_mx };
+
+			if (!m_nrWorkers)
+				runHere = true;
+			else
+			{
+				if (m_queue.size() + nrJobs > m_maxQueueDepth)
+				{
+					m_metrics.m_nrOverloaded += nrJobs;
+					for (sizet i=0; i!=nrJobs; ++i)
+						jobs[i].m_status = Status::Overloaded;
+					return;
+				}
+
+				Time now = Time::NonStrictNow();
+				for (sizet i=0; i!=nrJobs; ++i)
+				{
+					jobs[i].m_status = Status::Pending;
+					m_queue.push_back(QueueEntry { &jobs[i], &batch, deadline, now });
+				}
+
+				m_metrics.m_peakQueueDepth = PickMax<sizet>(m_metrics.m_peakQueueDepth, m_queue.size());
+			}
+		}
+
+		if (runHere)
+		{
+			Time now = Time::NonStrictNow();
+			for (sizet i=0; i!=nrJobs; ++i)
+			{
+				jobs[i].m_status = Status::Pending;
+				RunEntry(QueueEntry { &jobs[i], &batch, deadline, now });
+			}
+			return;
+		}
+
+		m_workAvailableEvent.Signal();
+		batch.m_done.WaitIndefinite();
+	}
+
+
+	PwHashService::Status PwHashService::Verify(Seq pw, Seq pwHash, bool& match, Time deadline)
+	{
+		Job job;
+		job.m_pw = pw;
+		job.m_pwHash = pwHash;
+		Process(job, deadline);
+
+		match = (job.m_status == Status::Done && job.m_match);
+		return job.m_status;
+	}
+
+
+	PwHashService::Status PwHashService::DummyVerify(Seq pw, Time deadline)
+	{
+		Job job;
+		job.m_pw = pw;
+		job.m_dummy = true;
+		Process(job, deadline);
+		return job.m_status;
+	}
+
+
+	PwHashService::Metrics PwHashService::GetMetrics()
+	{
+		Locker locker { m_mx };
+		Metrics metrics = m_metrics;
+		metrics.m_queueDepth = m_queue.size();
+		return metrics;
+	}
+
+
+	void PwHashService::WorkerMain(Event& stopEvent)
+	{
+		// Once the stop event is signaled, keeps taking entries until the queue is empty, so that no caller is left waiting
+		bool stopping {};
+		while (true)
+		{
+			QueueEntry entry;
+			bool haveEntry {}, moreEntries {};
+
+			{
+				Locker locker { m_mx };
+				if (!m_queue.empty())
+				{
+					entry = m_queue.front();
+					m_queue.pop_front();
+					haveEntry = true;
+					moreEntries = !m_queue.empty();
+				}
+			}
+
+			// The work available event is auto-reset and wakes one worker. Pass the signal on if entries remain
+			if (moreEntries)
+				m_workAvailableEvent.Signal();
+
+			if (haveEntry)
+				RunEntry(entry);
+			else if (stopping)
+				break;
+			else if (0 == Wait2(stopEvent.Handle(), m_workAvailableEvent.Handle(), INFINITE))
+				stopping = true;
+		}
+	}
+
+
+	void PwHashService::WorkerExited()
+	{
+		// Entries may have been queued after this worker found the queue empty. If no other worker remains,
+		// they are run on this thread. Callers that submit after this see no workers, and run their jobs themselves
+		std::deque<QueueEntry> remaining;
+
+		{
+			Locker locker { m_mx };
+			EnsureAbort(m_nrWorkers != 0);
+			if (!--m_nrWorkers)
+				remaining.swap(m_queue);
+		}
+
+		for (QueueEntry const& entry : remaining)
+			RunEntry(entry);
+	}
+
+
+	void PwHashService::RunEntry(QueueEntry const& entry)
+	{
+		Job& job = *entry.m_job;
+		Time startTime = Time::NonStrictNow();
+		job.m_waitTime = startTime - entry.m_enqueueTime;
+
+		// Checked immediately before the hash is started, since it is not interrupted once started
+		if (startTime > entry.m_deadline)
+			job.m_status = Status::Expired;
+		else
+		{
+			try
+			{
+				if (job.m_dummy)
+					PwHash::DummyVerifyOnThisThread(job.m_pw);
+				else
+					job.m_match = PwHash::VerifyOnThisThread(job.m_pw, job.m_pwHash);
+			}
+			catch (std::exception const&)
+			{
+				// A hash that could not be computed does not match
+				job.m_match = false;
+			}
+
+			job.m_hashTime = Time::NonStrictNow() - startTime;
+			job.m_status = Status::Done;
+		}
+
+		{
+			Locker locker { m_mx };
+			m_metrics.m_totalWaitTime += job.m_waitTime;
+			m_metrics.m_maxWaitTime = PickMax(m_metrics.m_maxWaitTime, job.m_waitTime);
+
+			if (job.m_status == Status::Expired)
+				++m_metrics.m_nrExpired;
+			else
+			{
+				++m_metrics.m_nrDone;
+				m_metrics.m_totalHashTime += job.m_hashTime;
+				m_metrics.m_maxHashTime = PickMax(m_metrics.m_maxHashTime, job.m_hashTime);
+			}
+		}
+
+		if (!InterlockedDecrement(&entry.m_batch->m_nrRemaining))
+			entry.m_batch->m_done.Signal();
+	}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "AtEvent.h"
+#include "AtMutex.h"
+#include "AtStr.h"
+#include "AtThread.h"
+#include "AtTime.h"
+
+
+namespace At
+{
+
+	// Runs PwHash verifications on a dedicated pool of worker threads, one per physical core. Each verification is deliberately
+	// expensive, so during a burst of logins, verifying on request threads would occupy every request thread and every core.
+	// With the service, request threads wait, and at most one hash per core is computed at any time.
+	//
+	// The application starts the worker threads with Start, using its StopCtl. When the StopCtl is stopped, workers complete
+	// queued jobs before they exit. Before the service is started, and after its workers have exited, jobs are computed
+	// on the calling thread.
+	//
+	// Admission control: a batch that would grow the queue beyond the maximum queue depth is rejected as a whole with
+	// Status::Overloaded, without being computed. A job whose deadline has passed when a worker is about to compute it is
+	// completed with Status::Expired. A hash is not interrupted once started.
+	// Verify and DummyVerify jobs go through the same queue and the same admission rules, so that their observable
+	// timing does not depend on whether the user name was valid.
+
+	class PwHashService : public NoCopy
+	{
+	public:
+		enum { DefaultMaxQueueDepth = 256, DefaultTimeoutMs = 10000 };
+
+		enum class Status { Pending, Done, Overloaded, Expired };
+
+		struct Job
+		{
+			// Inputs. If m_dummy is true, m_pwHash is ignored and the job has the side channel characteristics of Verify
+			Seq    m_pw;
+			Seq    m_pwHash;
+			bool   m_dummy    {};
+
+			// Outputs. m_match is set only if m_status is Done
+			Status m_status   { Status::Pending };
+			bool   m_match    {};
+			Time   m_waitTime;		// Time spent in queue
+			Time   m_hashTime;		// Time spent computing the hash
+		};
+
+		struct Metrics
+		{
+			sizet  m_nrThreads      {};
+			sizet  m_queueDepth     {};
+			sizet  m_peakQueueDepth {};
+			uint64 m_nrDone         {};
+			uint64 m_nrOverloaded   {};
+			uint64 m_nrExpired      {};
+			Time   m_totalWaitTime;
+			Time   m_maxWaitTime;
+			Time   m_totalHashTime;
+			Time   m_maxHashTime;
+		};
+
+		// The instance used by PwHash::Verify and PwHash::DummyVerify. Not started until the application calls Start
+		static PwHashService& Global();
+
+		// Returns the number of physical processor cores, or the number of logical processors if that cannot be determined
+		static uint NrPhysicalCores();
+
+		PwHashService(sizet maxQueueDepth = DefaultMaxQueueDepth) : m_maxQueueDepth(maxQueueDepth) {}
+
+		// May be called once. If nrThreads is zero, starts one thread per physical core. The workers must have exited,
+		// e.g. using StopCtl::WaitAll, before the service is destroyed
+		void Start(Rp<StopCtl> const& stopCtl, uint nrThreads = 0);
+
+		// Submits the jobs and blocks until each of them is completed, expired, or rejected. Jobs in a batch can run in parallel
+		void Process(Job* jobs, sizet nrJobs, Time deadline);
+		void Process(Job& job, Time deadline) { Process(&job, 1, deadline); }
+
+		Status Verify      (Seq pw, Seq pwHash, bool& match, Time deadline);
+		Status DummyVerify (Seq pw, Time deadline);
+
+		static Time DefaultDeadline() { return Time::NonStrictNow() + Time::FromMilliseconds(DefaultTimeoutMs); }
+
+		Metrics GetMetrics();
+
+	private:
+		struct Batch
+		{
+			LONG volatile m_nrRemaining {};
+			Event         m_done        { Event::CreateManual };
+		};
+
+		struct QueueEntry
+		{
+			Job*   m_job   {};
+			Batch* m_batch {};
+			Time   m_deadline;
+			Time   m_enqueueTime;
+		};
+
+		class Worker : public Thread
+		{
+		public:
+			void SetService(PwHashService* service) { EnsureThrow(!Started()); m_service = service; }
+
+		private:
+			PwHashService* m_service {};
+
+			void ThreadMain() override final { m_service->WorkerMain(StopEvent()); }
+			void OnThreadExit(ExitType::E) override final { m_service->WorkerExited(); }
+		};
+
+		sizet const              m_maxQueueDepth;
+		Event                    m_workAvailableEvent { Event::CreateAuto };
+
+		Mutex                    m_mx;
+		sizet                    m_nrWorkers {};	// Protected by m_mx. Workers started and not yet exited
+		std::deque<QueueEntry>   m_queue;		// Protected by m_mx
+		Metrics                  m_metrics;		// Protected by m_mx
+
+		void WorkerMain(Event& stopEvent);
+		void WorkerExited();
+		void RunEntry(QueueEntry const& entry);
+	};
+
+}
@@ -36,6 +36,13 @@ namespace At
 		// - On error, throw an implementation-specific exception that derives from CommunicationErr.
 		virtual void Read(std::function<ReadInstr(Seq&)> process) = 0;
 
+		// Processes only data that has already been read, without waiting for more. Returns true if "process" returned Done.
+		// Returns false if more data is needed; the implementation may then still hold data it has read, but not yet processed.
+		virtual bool TryReadBuffered(std::function<ReadInstr(Seq&)> process) { return TryProcessData(process) == KeepReading::No; }
+
+		// Returns true if data has been read that has not yet been passed to a "process" function
+		virtual bool HaveNewDataToProcess() const { return m_haveNewDataToProcess; }
+
 		void ReadVarStr(Seq& s, sizet maxLen = SIZE_MAX);
 		void ReadVarSInt64(int64& n);
 		void ReadVarUInt64(uint64& n);
@@ -0,0 +1,112 @@
+#include "AtIncludes.h"
+#include "AtRenderCache.h"
+
+#include "AtCrypt.h"
+
+
+namespace At
+{
+
+	RenderCacheKey::RenderCacheKey(Seq srcText, RenderKind::E kind, uint32 options, ObjId owner, uint64 version)
+		: m_srcHash(Hash::HashOf(srcText, CALG_SHA_256)), m_kind(kind), m_options(options), m_owner(owner), m_version(version)
+	{
+	}
+
+
+	bool RenderCacheKey::operator< (RenderCacheKey const& x) const
+	{
+		if (m_kind    != x.m_kind    ) return m_kind    < x.m_kind;
+		if (m_options != x.m_options ) return m_options < x.m_options;
+		if (m_owner   != x.m_owner   ) return m_owner   < x.m_owner;
+		if (m_version != x.m_version ) return m_version < x.m_version;
+		return Seq(m_srcHash) < Seq(x.m_srcHash);
+	}
+
+
+
+	void RenderCache::Add(RenderCacheKey const& key, Seq fragment)
+	{
+		if (fragment.n > m_maxBytes / MaxFragmentFraction)
+			return;
+
+		Locker locker { m_mx };
+
+		// Another thread may have rendered and added the same fragment since this thread's call to Find
+		EntriesByKey::iterator it = m_entriesByKey.find(key);
+		if (it != m_entriesByKey.end())
+		{
+			Touch(it);
+			return;
+		}
+
+		while (m_nrBytes + fragment.n > m_maxBytes)
+		{
+			EnsureThrow(m_entriesByLastUse.size() != 0);
+			Remove(m_entriesByLastUse.begin()->second);
+		}
+
+		it = m_entriesByKey.insert(std::make_pair(key, Entry())).first;
+		it->second.m_fragment = fragment;
+		it->second.m_lastUse = m_nextUse++;
+		m_entriesByLastUse.insert(std::make_pair(it->second.m_lastUse, it));
+		m_nrBytes += fragment.n;
+	}
+
+
+	void RenderCache::RemoveVersion(ObjId owner, uint64 version)
+	{
+		Locker locker { m_mx };
+
+		EntriesByKey::iterator it = m_entriesByKey.begin();
+		while (it != m_entriesByKey.end())
+		{
+			EntriesByKey::iterator cur = it++;
+			if (cur->first.m_owner == owner && cur->first.m_version == version)
+				Remove(cur);
+		}
+	}
+
+
+	void RenderCache::Clear()
+	{
+		Locker locker { m_mx };
+
+		m_entriesByLastUse.clear();
+		m_entriesByKey.clear();
+		m_nrBytes = 0;
+	}
+
+
+	RenderCache::Stats RenderCache::GetStats() const
+	{
+		Locker locker { m_mx };
+
+		Stats stats;
+		stats.m_nrFragments = m_entriesByKey.size();
+		stats.m_nrBytes     = m_nrBytes;
+		stats.m_nrHits      = m_nrHits;
+		stats.m_nrMisses    = m_nrMisses;
+		return stats;
+	}
+
+
+	void RenderCache::Touch(EntriesByKey::iterator it)
+	{
+		EntriesByLastUse::iterator useIt = m_entriesByLastUse.find(it->second.m_lastUse);
+		EnsureThrow(useIt != m_entriesByLastUse.end());
+		m_entriesByLastUse.erase(useIt);
+
+		it->second.m_lastUse = m_nextUse++;
+		m_entriesByLastUse.insert(std::make_pair(it->second.m_lastUse, it));
+	}
+
+
+	void RenderCache::Remove(EntriesByKey::iterator it)
+	{
+		sizet nrErased = m_entriesByLastUse.erase(it->second.m_lastUse);
+		EnsureThrow(nrErased == 1);
+		m_nrBytes -= it->second.m_fragment.Len();
+		m_entriesByKey.erase(it);
+	}
+
+}
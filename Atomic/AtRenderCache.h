@@ -0,0 +1,104 @@
+#pragma once
+
+#include "AtMutex.h"
+#include "AtObjId.h"
+#include "AtStr.h"
+
+
+namespace At
+{
+
+	// Identifies the renderer and the kind of output. Different outputs rendered from the same source text do not share entries
+	struct RenderKind { enum E { MarkdownHtml = 1, MarkdownText = 2 }; };
+
+
+	// A fragment is found by a hash of the source text from which it was rendered, the options that affect rendering,
+	// the owner of the source text, such as an entity, and a version chosen by the owner. An owner whose output depends on
+	// anything other than the source text and the options should change the version when that changes. Fragments rendered
+	// for a previous version then become unreachable, and can be discarded immediately using RenderCache::RemoveVersion.
+	// Versions chosen by different owners do not conflict.
+
+	struct RenderCacheKey
+	{
+		RenderCacheKey(Seq srcText, RenderKind::E kind, uint32 options, ObjId owner, uint64 version);
+
+		Str           m_srcHash;		// SHA-256 of the source text
+		RenderKind::E m_kind;
+		uint32        m_options;
+		ObjId         m_owner;
+		uint64        m_version;
+
+		bool operator< (RenderCacheKey const& x) const;
+	};
+
+
+	// A thread-safe cache of rendered fragments, such as the HTML and text output of Markdown::Transform. The total size of cached
+	// fragments is bounded. When adding a fragment would exceed the bound, least recently used fragments are evicted. Fragments
+	// larger than 1/MaxFragmentFraction of the bound are not cached, so that a single large fragment cannot evict all others.
+
+	class RenderCache : public NoCopy
+	{
+	public:
+		enum { DefaultMaxBytes = 16*1024*1024, MaxFragmentFraction = 8 };
+
+		struct Stats
+		{
+			sizet  m_nrFragments {};
+			sizet  m_nrBytes     {};
+			uint64 m_nrHits      {};
+			uint64 m_nrMisses    {};
+		};
+
+		RenderCache(sizet maxBytes = DefaultMaxBytes) : m_maxBytes(maxBytes) {}
+
+		// If the fragment is found, calls onFound(Seq fragment) and returns true. The cache remains locked while onFound executes,
+		// so the fragment can be appended to output without being copied first. onFound must not call the cache.
+		template <class F>
+		bool Find(RenderCacheKey const& key, F onFound)
+		{
+			Locker locker { m_mx };
+			EntriesByKey::iterator it = m_entriesByKey.find(key);
+			if (it == m_entriesByKey.end())
+			{
+				++m_nrMisses;
+				return false;
+			}
+
+			++m_nrHits;
+			Touch(it);
+			onFound(Seq(it->second.m_fragment));
+			return true;
+		}
+
+		void Add(RenderCacheKey const& key, Seq fragment);
+
+		// Removes fragments with the owner and version
+		void RemoveVersion(ObjId owner, uint64 version);
+		void Clear();
+
+		Stats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			Str    m_fragment;
+			uint64 m_lastUse {};
+		};
+
+		typedef std::map<RenderCacheKey, Entry> EntriesByKey;
+		typedef std::map<uint64, EntriesByKey::iterator> EntriesByLastUse;
+
+		mutable Mutex    m_mx;
+		sizet            m_maxBytes;
+		sizet            m_nrBytes  {};
+		uint64           m_nextUse  {};
+		uint64           m_nrHits   {};
+		uint64           m_nrMisses {};
+		EntriesByKey     m_entriesByKey;
+		EntriesByLastUse m_entriesByLastUse;
+
+		void Touch(EntriesByKey::iterator it);
+		void Remove(EntriesByKey::iterator it);
+	};
+
+}
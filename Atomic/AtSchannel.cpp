@@ -217,6 +217,30 @@ namespace At
 	}
 
 
+	bool Schannel::TryReadBuffered(std::function<ReadInstr(Seq&)> process)
+	{
+		if (m_state == State::NotStarted)
+		{
+			EnsureThrow(m_reader != nullptr);
+			return m_reader->TryReadBuffered(process);
+		}
+
+		EnsureThrow(m_state == State::Started);
+		return TryProcessData(process) == KeepReading::No;
+	}
+
+
+	bool Schannel::HaveNewDataToProcess() const
+	{
+		EnsureThrow(m_reader != nullptr);
+		if (m_state == State::NotStarted)
+			return m_reader->HaveNewDataToProcess();
+
+		// If the peer has ended the TLS session, the next Read reports it
+		return Reader::HaveNewDataToProcess() || m_reader->HaveNewDataToProcess() || m_lastDecryptSt == SEC_I_CONTEXT_EXPIRED;
+	}
+
+
 	void Schannel::Write(Seq data)
 	{
 		try
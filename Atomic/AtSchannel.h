@@ -93,6 +93,11 @@ namespace At
 		void Write(Seq data) override final;
 		void Shutdown() override final;
 
+		// After TLS is started, processes only data that has already been decrypted. Received data that has not yet been
+		// decrypted is reported by HaveNewDataToProcess, and is decrypted by the next call to Read
+		bool TryReadBuffered(std::function<ReadInstr(Seq&)> process) override final;
+		bool HaveNewDataToProcess() const override final;
+
 		bool TlsStarted() const { return m_state != State::NotStarted; }
 
 		void AddCert(Cert const& cert);
@@ -8,10 +8,10 @@ namespace At
 {
 
 Seq c_js_AtDbAdm_Browse {
-	"{ const editLink = Elem('editLink'); const entityJson = Elem('entityJson'); const entitySave = Elem('entitySave'); editLink.addEventListener('click', function (e) { if (entityJson."
-	"disabled) { editLink.innerHTML = 'Cancel'; entityJson.disabled = false; entitySave.disabled = false; } else { editLink.innerHTML = 'Edit'; entityJson.disabled = true; entitySave.di"
-	"sabled = true; } e.preventDefault(); }); }",
-	402 };
+	"'use strict'; { const editLink = Elem('editLink'); const entityJson = Elem('entityJson'); const entitySave = Elem('entitySave'); editLink.addEventListener('click', function (e) { i"
+	"f (entityJson.disabled) { editLink.innerHTML = 'Cancel'; entityJson.disabled = false; entitySave.disabled = false; } else { editLink.innerHTML = 'Edit'; entityJson.disabled = true;"
+	" entitySave.disabled = true; } e.preventDefault(); }); }",
+	416 };
 
 Seq c_js_AtHtmlBuilder_CheckboxEnable {
 	"const checkboxElem = Elem(arg.checkboxId); const otherElem = Elem(arg.otherId); checkboxElem.addEventListener('click', function () { otherElem.disabled = !checkboxElem.checked; });"
@@ -33,19 +33,19 @@ Seq c_js_AtHtmlBuilder_MultiUpload {
 	1183 };
 
 Seq c_js_AtHtmlBuilder_PopUpLinks {
-	"{ const elems = document.getElementsByClassName('popUpLink'); for (let i = 0; i < elems.length; ++i) { const elem = elems[i]; if (elem.tagName.toLowerCase() == 'a') { elem.addEvent"
-	"Listener('click', function (e) { let w = window.open(); w.opener = null; w.location = elem.href; e.preventDefault(); }); } } }",
-	306 };
+	"'use strict'; { const elems = document.getElementsByClassName('popUpLink'); for (let i = 0; i < elems.length; ++i) { const elem = elems[i]; if (elem.tagName.toLowerCase() == 'a') {"
+	" elem.addEventListener('click', function (e) { let w = window.open(); w.opener = null; w.location = elem.href; e.preventDefault(); }); } } }",
+	320 };
 
 Seq c_js_AtHtmlBuilder_ReloadElem {
-	"function ReloadReqHandler(req, outElemId, statusElemId, method, url, retryMs) { if (req.readyState == 4) { if (req.status == 200 || req.status == 203 || req.status == 503) { if (re"
-	"q.status != 503) { Elem(outElemId).innerHTML = r.responseText; Elem(statusElemId).innerHTML = ''; } if (req.status != 200) { setTimeout(function() { return SendReloadReq(outElemId,"
-	" statusElemId, method, url, retryMs); }, retryMs); } } else { Elem(statusElemId).innerHTML = '[ Dynamic page update failed: Unexpected HTTP response code: ' + req.status + ']'; } }"
-	" } function SendReloadReq(outElemId, statusElemId, method, url, retryMs) { var req = new XMLHttpRequest; if (req == null) { Elem(statusElemId).innerHTML = '[ Dynamic page update fa"
-	"iled: XMLHttpRequest is null ]'; } else { req.open(method, url, true); req.onreadystatechange = function() { return ReloadReqHandler(req, outElemId, statusElemId, method, url, retr"
-	"yMs); }; req.send(); } } function ReloadElem(outElemId, statusElemId, method, url, firstWaitMs, retryMs) { setTimeout(function() { return SendReloadReq(outElemId, statusElemId, met"
-	"hod, url, retryMs); }, firstWaitMs); }",
-	1118 };
+	"'use strict'; function ReloadReqHandler(req, outElemId, statusElemId, method, url, retryMs) { if (req.readyState == 4) { if (req.status == 200 || req.status == 203 || req.status =="
+	" 503) { if (req.status != 503) { Elem(outElemId).innerHTML = r.responseText; Elem(statusElemId).innerHTML = ''; } if (req.status != 200) { setTimeout(function() { return SendReload"
+	"Req(outElemId, statusElemId, method, url, retryMs); }, retryMs); } } else { Elem(statusElemId).innerHTML = '[ Dynamic page update failed: Unexpected HTTP response code: ' + req.sta"
+	"tus + ']'; } } } function SendReloadReq(outElemId, statusElemId, method, url, retryMs) { var req = new XMLHttpRequest; if (req == null) { Elem(statusElemId).innerHTML = '[ Dynamic "
+	"page update failed: XMLHttpRequest is null ]'; } else { req.open(method, url, true); req.onreadystatechange = function() { return ReloadReqHandler(req, outElemId, statusElemId, met"
+	"hod, url, retryMs); }; req.send(); } } function ReloadElem(outElemId, statusElemId, method, url, firstWaitMs, retryMs) { setTimeout(function() { return SendReloadReq(outElemId, sta"
+	"tusElemId, method, url, retryMs); }, firstWaitMs); }",
+	1132 };
 
 Seq c_js_AtHtmlBuilder_ReloadElem_Call {
 	"const outElemId = arg.outElemId; const statusElemId = arg.statusElemId; const url = arg.url; const method = arg.method || 'GET'; const firstWaitMs = arg.firstWaitMs || 5000; const "
@@ -65,10 +65,10 @@ Seq c_js_AtHtmlForm_EnablerCb {
 	436 };
 
 Seq c_js_AtSmtpEntities_SenderCfg {
-	"{ const inputIds = [ 'smtpSender_relayHost', 'smtpSender_relayPort', 'smtpSender_relayImplicitTls', 'smtpSender_relayTlsRequirement', 'smtpSender_relayAuthType', 'smtpSender_relayU"
-	"sername', 'smtpSender_relayPassword' ]; const checkbox = Elem('smtpSender_useRelay'); const OnCheckbox = function () { inputIds.forEach(function (id) { Elem(id).disabled = !checkbo"
-	"x.checked; }); }; checkbox.addEventListener('click', OnCheckbox); OnCheckbox(); }",
-	441 };
+	"'use strict'; { const inputIds = [ 'smtpSender_relayHost', 'smtpSender_relayPort', 'smtpSender_relayImplicitTls', 'smtpSender_relayTlsRequirement', 'smtpSender_relayAuthType', 'smt"
+	"pSender_relayUsername', 'smtpSender_relayPassword' ]; const checkbox = Elem('smtpSender_useRelay'); const OnCheckbox = function () { inputIds.forEach(function (id) { Elem(id).disab"
+	"led = !checkbox.checked; }); }; checkbox.addEventListener('click', OnCheckbox); OnCheckbox(); }",
+	455 };
 
 Seq c_css_AtDbAdm {
 	"body { color: #ddd; background: #222; padding: 30px 50px 0px 50px; max-width: 80em; font-family: \"Trebuchet MS\", Arial; font-size: 14px; } .submitErr { color: #f85; } a { color: "
@@ -0,0 +1,11 @@
+AT_SCRIPTS_ASSET(js, AtDbAdm_Browse, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_CheckboxEnable, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_Intro, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_MultiUpload, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_PopUpLinks, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_ReloadElem, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_ReloadElem_Call, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlBuilder_ToggleShowDiv, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtHtmlForm_EnablerCb, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(js, AtSmtpEntities_SenderCfg, ".js", "text/javascript")
+AT_SCRIPTS_ASSET(css, AtDbAdm, ".css", "text/css")
@@ -465,6 +465,16 @@ namespace At
 	}
 
 
+	double Seq::ReadDoubleExact() noexcept
+	{
+		double value;
+		sizet nrRead = Buf2Dbl_Exact(p, n, value);
+		p += nrRead;
+		n -= nrRead;
+		return value;
+	}
+
+
 	bool Seq::ReadIsoStyleTimeStr(Time& t) noexcept
 	{
 		return Time::ReadIsoStyleTimeStr(*this, t);
@@ -137,6 +137,7 @@ namespace At
 		uint16 ReadNrUInt16Dec              (uint16 max = UINT16_MAX)                       noexcept { return          ReadNrUInt16 (10,   max      ); }
 		byte   ReadNrByteDec                (byte   max = 255)                              noexcept { return          ReadNrByte   (10,   max      ); }
 		double ReadDouble                   () noexcept;
+		double ReadDoubleExact              () noexcept;	// Supports exponents, rounds correctly. See Buf2Dbl_Exact
 		bool   ReadIsoStyleTimeStr          (Time& t) noexcept;
 
 		// If onToken returns false, stops enumeration and returns false. Returns true if onToken is never called, or if it always returned true.
@@ -0,0 +1,413 @@
+#include "AtIncludes.h"
+#include "AtSlabAlloc.h"
+
+#include "AtInitOnFirstUse.h"
+
+
+namespace At
+{
+	namespace
+	{
+
+		enum { SlabShift = 16, SlabBytes = 1 << SlabShift, NrClasses = 24, StatsFlushBytes = 65536, StatsFlushOps = 1024 };
+
+	#ifdef _M_X64
+		sizet const c_rangeBytes = ((sizet) 32) << 30;
+	#else
+		sizet const c_rangeBytes = ((sizet) 256) << 20;
+	#endif
+
+		sizet const c_nrSlabs = c_rangeBytes >> SlabShift;
+
+
+		// Sizes up to 128 bytes have classes in steps of 16 bytes. Above that, each doubling of size is divided into four classes
+		inline uint ClassOfSize(sizet nrBytes)
+		{
+			if (nrBytes <= 128)
+				return (uint) ((nrBytes - 1) >> 4);
+
+			unsigned long highBit;
+			_BitScanReverse(&highBit, (unsigned long) (nrBytes - 1));
+			return 8 + ((highBit - 7) * 4) + ((uint) ((nrBytes - 1) >> (highBit - 2)) & 3);
+		}
+
+		inline sizet ClassBytes(uint c)
+		{
+			if (c < 8)
+				return (c + 1) * 16;
+
+			uint group = (c - 8) / 4;
+			uint step  = (c - 8) % 4;
+			return (((sizet) 128) << group) + ((step + 1) * (((sizet) 32) << group));
+		}
+
+		// Number of blocks moved between a thread cache and the central list at once. A thread cache holds up to twice this number
+		inline uint BatchSize(uint c) { return (uint) PickMax<sizet>(4, PickMin<sizet>(64, 8192 / ClassBytes(c))); }
+
+
+		struct FreeBlock
+		{
+			FreeBlock* m_next;
+		};
+
+		struct CentralList
+		{
+			SRWLOCK    m_lock;			// SRWLOCK_INIT is all zeroes
+			FreeBlock* m_head;
+			sizet      m_count;
+		};
+
+		LONG volatile      g_slab_initFlag {};
+		uintptr_t          g_slab_rangeStart {};
+		uintptr_t          g_slab_rangeEnd {};
+		ptrdiff_t volatile g_slab_nrSlabsCarved {};
+		byte               g_slab_slabClass [c_nrSlabs];
+		CentralList        g_slab_central   [NrClasses];
+		MemArena           g_slab_defaultArena { "Default" };
+
+
+		struct ThreadCache
+		{
+			FreeBlock* m_heads  [NrClasses];
+			uint       m_counts [NrClasses];
+		};
+
+		struct ThreadStats
+		{
+			MemArena* m_arena;			// nullptr for the default arena
+			int64     m_nrAllocs;
+			int64     m_nrFrees;
+			int64     m_bytes;
+			uint      m_nrOps;
+		};
+
+		// Returns cached blocks to the central lists when the thread exits. Blocks freed after that, e.g. by destructors
+		// of other thread-local objects, go directly to the central lists. The destructor runs only in threads that used
+		// the object, so every path that adds blocks to the thread cache must set m_active
+		struct ThreadExit
+		{
+			bool m_active {};
+			~ThreadExit() noexcept;
+		};
+
+		// Trivially constructible and destructible, so they remain usable while other thread-local objects are destroyed
+		thread_local ThreadCache t_slab_cache;
+		thread_local ThreadStats t_slab_stats;
+		thread_local bool        t_slab_threadExiting;
+
+		thread_local ThreadExit  t_slab_threadExit;
+
+
+		void InitRange()
+		{
+			// Reserved addresses that are not committed consume no memory. The reservation is aligned to 64 kB, and so are slabs
+			void* p = VirtualAlloc(nullptr, c_rangeBytes, MEM_RESERVE, PAGE_NOACCESS);
+			if (p)
+			{
+				g_slab_rangeStart = (uintptr_t) p;
+				g_slab_rangeEnd = g_slab_rangeStart + c_rangeBytes;
+			}
+		}
+
+
+		inline bool IsSlabBlock(void const* p) { uintptr_t a = (uintptr_t) p; return a >= g_slab_rangeStart && a < g_slab_rangeEnd; }
+
+		inline uint SlabClassOf(void const* p) { return g_slab_slabClass[(((uintptr_t) p) - g_slab_rangeStart) >> SlabShift]; }
+
+
+		void FlushStats(ThreadStats& ts) noexcept
+		{
+			if (ts.m_nrOps)
+			{
+				MemArena* arena = ts.m_arena ? ts.m_arena : &g_slab_defaultArena;
+				arena->Add(ts.m_nrAllocs, ts.m_nrFrees, ts.m_bytes);
+
+				ts.m_nrAllocs = 0;
+				ts.m_nrFrees  = 0;
+				ts.m_bytes    = 0;
+				ts.m_nrOps    = 0;
+			}
+		}
+
+
+		inline void CountOp(int64 nrAllocs, int64 nrFrees, int64 bytes) noexcept
+		{
+			ThreadStats& ts = t_slab_stats;
+			ts.m_nrAllocs += nrAllocs;
+			ts.m_nrFrees  += nrFrees;
+			ts.m_bytes    += bytes;
+
+			if (++ts.m_nrOps >= StatsFlushOps || ts.m_bytes >= StatsFlushBytes || ts.m_bytes <= -StatsFlushBytes)
+				FlushStats(ts);
+		}
+
+
+		// Called with the central list locked. Returns false if the address range is exhausted, or the slab cannot be committed
+		bool CarveSlab(uint c, CentralList& cl)
+		{
+			InitOnFirstUse(&g_slab_initFlag, InitRange);
+			if (!g_slab_rangeStart)
+				return false;
+
+			sizet slabIndex = (sizet) (InterlockedIncrement_PtrDiff(&g_slab_nrSlabsCarved) - 1);
+			if (slabIndex >= c_nrSlabs)
+				return false;
+
+			byte* slab = (byte*) (g_slab_rangeStart + (slabIndex << SlabShift));
+			if (!VirtualAlloc(slab, SlabBytes, MEM_COMMIT, PAGE_READWRITE))
+				return false;
+
+			g_slab_slabClass[slabIndex] = (byte) c;
+
+			// Link blocks so that they are handed out in address order
+			sizet blockBytes = ClassBytes(c);
+			sizet nrBlocks = SlabBytes / blockBytes;
+			for (sizet i=nrBlocks; i--; )
+			{
+				FreeBlock* b = (FreeBlock*) (slab + (i * blockBytes));
+				b->m_next = cl.m_head;
+				cl.m_head = b;
+			}
+
+			cl.m_count += nrBlocks;
+			return true;
+		}
+
+
+		FreeBlock* AllocCentral(uint c)
+		{
+			CentralList& cl = g_slab_central[c];
+			AcquireSRWLockExclusive(&cl.m_lock);
+
+			FreeBlock* b {};
+			if (cl.m_head || CarveSlab(c, cl))
+			{
+				b = cl.m_head;
+				cl.m_head = b->m_next;
+				--cl.m_count;
+			}
+
+			ReleaseSRWLockExclusive(&cl.m_lock);
+			return b;
+		}
+
+
+		void FreeCentral(uint c, FreeBlock* first, FreeBlock* last, sizet count) noexcept
+		{
+			CentralList& cl = g_slab_central[c];
+			AcquireSRWLockExclusive(&cl.m_lock);
+
+			last->m_next = cl.m_head;
+			cl.m_head = first;
+			cl.m_count += count;
+
+			ReleaseSRWLockExclusive(&cl.m_lock);
+		}
+
+
+		bool Refill(uint c, ThreadCache& tc)
+		{
+			t_slab_threadExit.m_active = true;
+
+			CentralList& cl = g_slab_central[c];
+			AcquireSRWLockExclusive(&cl.m_lock);
+
+			bool haveBlocks = (cl.m_head || CarveSlab(c, cl));
+			if (haveBlocks)
+			{
+				FreeBlock* first = cl.m_head;
+				FreeBlock* last = first;
+				uint count = 1;
+				for (uint batch = BatchSize(c); count != batch && last->m_next; ++count)
+					last = last->m_next;
+
+				cl.m_head = last->m_next;
+				cl.m_count -= count;
+
+				last->m_next = tc.m_heads[c];
+				tc.m_heads[c] = first;
+				tc.m_counts[c] += count;
+			}
+
+			ReleaseSRWLockExclusive(&cl.m_lock);
+			return haveBlocks;
+		}
+
+
+		FreeBlock* AllocCached(uint c)
+		{
+			ThreadCache& tc = t_slab_cache;
+			if (!tc.m_heads[c] && !Refill(c, tc))
+				return nullptr;
+
+			FreeBlock* b = tc.m_heads[c];
+			tc.m_heads[c] = b->m_next;
+			--tc.m_counts[c];
+			return b;
+		}
+
+
+		void FreeCached(uint c, FreeBlock* b) noexcept
+		{
+			// A thread that only frees blocks allocated by other threads never calls Refill
+			t_slab_threadExit.m_active = true;
+
+			ThreadCache& tc = t_slab_cache;
+			b->m_next = tc.m_heads[c];
+			tc.m_heads[c] = b;
+
+			uint batch = BatchSize(c);
+			if (++tc.m_counts[c] > 2 * batch)
+			{
+				FreeBlock* first = tc.m_heads[c];
+				FreeBlock* last = first;
+				for (uint i=1; i!=batch; ++i)
+					last = last->m_next;
+
+				tc.m_heads[c] = last->m_next;
+				tc.m_counts[c] -= batch;
+				FreeCentral(c, first, last, batch);
+			}
+		}
+
+
+		ThreadExit::~ThreadExit() noexcept
+		{
+			if (m_active)
+			{
+				ThreadCache& tc = t_slab_cache;
+				for (uint c=0; c!=NrClasses; ++c)
+					if (tc.m_heads[c])
+					{
+						FreeBlock* last = tc.m_heads[c];
+						while (last->m_next)
+							last = last->m_next;
+
+						FreeCentral(c, tc.m_heads[c], last, tc.m_counts[c]);
+						tc.m_heads[c] = nullptr;
+						tc.m_counts[c] = 0;
+					}
+			}
+
+			FlushStats(t_slab_stats);
+			t_slab_threadExiting = true;
+		}
+
+
+		inline int64 AtomicRead(LONG64 const& x) { return InterlockedCompareExchange64((LONG64 volatile*) &x, 0, 0); }
+
+	}	// anon
+
+
+
+	// MemArena
+
+	MemArena::Stats MemArena::GetStats() const
+	{
+		Stats stats;
+		stats.m_nrAllocs  = AtomicRead(m_nrAllocs);
+		stats.m_nrFrees   = AtomicRead(m_nrFrees);
+		stats.m_bytesLive = AtomicRead(m_bytesLive);
+		stats.m_bytesPeak = AtomicRead(m_bytesPeak);
+		return stats;
+	}
+
+
+	void MemArena::Add(int64 nrAllocs, int64 nrFrees, int64 bytes) noexcept
+	{
+		if (nrAllocs) InterlockedExchangeAdd64(&m_nrAllocs, nrAllocs);
+		if (nrFrees)  InterlockedExchangeAdd64(&m_nrFrees,  nrFrees);
+
+		LONG64 live = InterlockedExchangeAdd64(&m_bytesLive, bytes) + bytes;
+		LONG64 peak = AtomicRead(m_bytesPeak);
+		while (live > peak)
+		{
+			LONG64 prevPeak = InterlockedCompareExchange64(&m_bytesPeak, live, peak);
+			if (prevPeak == peak)
+				break;
+
+			peak = prevPeak;
+		}
+	}
+
+
+
+	// SlabAlloc
+
+	MemArena& SlabAlloc::DefaultArena() noexcept
+	{
+		return g_slab_defaultArena;
+	}
+
+
+	SlabAlloc::ArenaScope::ArenaScope(MemArena& arena) noexcept
+	{
+		ThreadStats& ts = t_slab_stats;
+		FlushStats(ts);
+		m_prevArena = ts.m_arena;
+		ts.m_arena = &arena;
+	}
+
+
+	SlabAlloc::ArenaScope::~ArenaScope() noexcept
+	{
+		ThreadStats& ts = t_slab_stats;
+		FlushStats(ts);
+		ts.m_arena = m_prevArena;
+	}
+
+
+	void* SlabAlloc::AllocBytes(sizet nrBytes)
+	{
+		if (nrBytes <= MaxSlabBlockBytes)
+		{
+			uint c = ClassOfSize(PickMax<sizet>(nrBytes, 1));
+			FreeBlock* b = t_slab_threadExiting ? AllocCentral(c) : AllocCached(c);
+			if (b)
+			{
+				CountOp(1, 0, (int64) ClassBytes(c));
+				return b;
+			}
+		}
+
+		byte* p = Mem::Alloc<byte>(nrBytes);
+		CountOp(1, 0, (int64) nrBytes);
+		return p;
+	}
+
+
+	bool SlabAlloc::ReAllocBytesInPlace(void* p, sizet nrBytes)
+	{
+		if (IsSlabBlock(p))
+			return nrBytes <= ClassBytes(SlabClassOf(p));
+
+		sizet prevBytes = Mem::SizeOf(p);
+		if (!Mem::ReAllocInPlace<byte>((byte*) p, nrBytes))
+			return false;
+
+		CountOp(0, 0, ((int64) nrBytes) - ((int64) prevBytes));
+		return true;
+	}
+
+
+	void SlabAlloc::FreeBytes(void* p) noexcept
+	{
+		if (IsSlabBlock(p))
+		{
+			uint c = SlabClassOf(p);
+			CountOp(0, 1, -((int64) ClassBytes(c)));
+
+			FreeBlock* b = (FreeBlock*) p;
+			if (t_slab_threadExiting)
+				FreeCentral(c, b, b, 1);
+			else
+				FreeCached(c, b);
+		}
+		else
+		{
+			CountOp(0, 1, -((int64) Mem::SizeOf(p)));
+			Mem::Free<byte>((byte*) p);
+		}
+	}
+
+}
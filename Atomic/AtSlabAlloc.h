@@ -0,0 +1,91 @@
+#pragma once
+
+#include "AtMem.h"
+#include "AtNum.h"
+
+
+namespace At
+{
+
+	// Allocation statistics are kept per arena. The arena that is current on a thread is selected with SlabAlloc::ArenaScope,
+	// for example for the lifetime of a web request. Each allocation and free is attributed to the arena that is current on the
+	// thread at the time. Memory allocated in one arena's scope and freed in another's, such as a cache entry created by a request,
+	// therefore remains counted as live in the first arena, and reduces the live count of the second. This makes it possible to see
+	// how much memory requests retain.
+	//
+	// Threads accumulate counts locally and add them to the arena in batches, so statistics can lag behind by a few
+	// tens of kilobytes per thread. Allocation rates are obtained by sampling m_nrAllocs at intervals.
+
+	class MemArena
+	{
+	private:
+		MemArena(MemArena const&) = delete;
+		void operator= (MemArena const&) = delete;
+
+	public:
+		struct Stats
+		{
+			int64 m_nrAllocs  {};
+			int64 m_nrFrees   {};
+			int64 m_bytesLive {};
+			int64 m_bytesPeak {};
+		};
+
+		// Constant initialization, so that arenas defined at namespace scope can be used by code that runs during static initialization
+		constexpr MemArena(char const* name) : m_name(name) {}
+
+		char const* Name() const { return m_name; }
+		Stats GetStats() const;
+
+		// Called by SlabAlloc with counts accumulated by a thread
+		void Add(int64 nrAllocs, int64 nrFrees, int64 bytes) noexcept;
+
+	private:
+		// Not declared volatile, which would prevent constant initialization. Accessed using Interlocked functions
+		char const* m_name;
+		LONG64      m_nrAllocs  {};
+		LONG64      m_nrFrees   {};
+		LONG64      m_bytesLive {};
+		LONG64      m_bytesPeak {};
+	};
+
+
+	// Allocator for VecBaseHeap. Blocks of up to MaxSlabBlockBytes are served from size classes, each of which divides
+	// 64 kB slabs into blocks of one size. Each thread caches free blocks of each class, so that most allocations and
+	// frees do not take a lock, and exchanges them with a central free list in batches. A block can be freed by any thread.
+	// Slabs are carved from an address range reserved on first use, and are kept for reuse rather than released.
+	// Larger blocks, and all blocks once the range is exhausted, are allocated from the process heap using Mem.
+
+	struct SlabAlloc
+	{
+		enum { MaxSlabBlockBytes = 2048 };
+
+		static MemArena& DefaultArena() noexcept;
+
+		class ArenaScope : public NoCopy
+		{
+		public:
+			ArenaScope(MemArena& arena) noexcept;
+			~ArenaScope() noexcept;
+
+		private:
+			MemArena* m_prevArena;
+		};
+
+		template <class T> static T* Alloc(sizet n)
+			{	EnsureThrow(n < SIZE_MAX / sizeof(T));
+				return (T*) AllocBytes(n*sizeof(T)); }
+
+		template <class T> static bool ReAllocInPlace(T* p, sizet n)
+			{	EnsureThrow(n < SIZE_MAX / sizeof(T));
+				return ReAllocBytesInPlace(p, n*sizeof(T)); }
+
+		template <class T> static void Free(T* p) noexcept { FreeBytes(p); }
+
+	private:
+		static void* AllocBytes(sizet nrBytes);
+		static bool ReAllocBytesInPlace(void* p, sizet nrBytes);
+		static void FreeBytes(void* p) noexcept;
+	};
+
+}
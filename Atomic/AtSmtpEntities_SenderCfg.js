@@ -1,3 +1,5 @@
+'use strict';
+
 {
     const inputIds = [ 'smtpSender_relayHost', 'smtpSender_relayPort', 'smtpSender_relayImplicitTls', 'smtpSender_relayTlsRequirement',
         'smtpSender_relayAuthType', 'smtpSender_relayUsername', 'smtpSender_relayPassword' ];
@@ -75,57 +75,98 @@ namespace At
 
 
 
+	// SmtpReceiverSession
+
+	struct SmtpReceiverSession : EmailServerSession
+	{
+		SmtpReceiverSession(EmailServerWorkItem& workItem) : EmailServerSession(workItem.m_sk, workItem.m_saRemote, workItem.m_bindingToken) {}
+
+		SmtpReceiverCfg        m_cfg           { Entity::Contained };
+		EmailSrvBinding const* m_binding       {};
+		Str                    m_ourName;
+		uint64                 m_maxInMsgBytes {};
+
+		Rp<SmtpReceiverAuthCx> m_authCx;
+		EhloHost               m_ehloHost;
+		bool                   m_haveMailFrom  {};
+		uint64                 m_fromSize      {};
+		sizet                  m_maxDataBytes  {};
+		Vec<Str>               m_toMailboxes;
+	};
+
+
+
 	// SmtpReceiverThread
 
 	void SmtpReceiverThread::WorkPoolThread_ProcessWorkItem(void* pvWorkItem)
 	{
 		SockInit sockInit;
 		AutoFree<EmailServerWorkItem> workItem = (EmailServerWorkItem*) pvWorkItem;
-		Socket& sk = workItem->m_sk;
+		AutoFree<SmtpReceiverSession> session;
 
-		SmtpReceiverCfg cfg { Entity::Contained };
-		m_workPool->SmtpReceiver_GetCfg(cfg);
+		bool const resumed = workItem->m_session.Any();
+		if (resumed)
+			session.Set((SmtpReceiverSession*) workItem->m_session.Dismiss());
+		else
+		{
+			session.Set(new SmtpReceiverSession(workItem.Ref()));
+			Socket& sk = session->m_sk;
 
-		EmailSrvBinding const* binding = EmailSrvBindings_FindPtrByToken(cfg.f_bindings, workItem->m_bindingToken);
+			SmtpReceiverCfg& cfg = session->m_cfg;
+			m_workPool->SmtpReceiver_GetCfg(cfg);
 
-		Str ourName;
-		if (binding && binding->f_computerName.Any()) ourName = binding->f_computerName;
-		else                                          ourName = cfg.f_computerName;
+			EmailSrvBinding const* binding = EmailSrvBindings_FindPtrByToken(cfg.f_bindings, session->m_bindingToken);
+			session->m_binding = binding;
 
-		uint64 maxInMsgBytes;
-		if (binding && binding->f_maxInMsgKb != 0) maxInMsgBytes = binding->f_maxInMsgKb * 1024;
-		else                                       maxInMsgBytes = cfg.f_maxInMsgKb * 1024;
+			if (binding && binding->f_computerName.Any()) session->m_ourName = binding->f_computerName;
+			else                                          session->m_ourName = cfg.f_computerName;
 
-		// It is NOT a good idea to enable TCP_NODELAY here.
-		// It would cause inefficiency in response sending in combination with PIPELINING.
+			if (binding && binding->f_maxInMsgKb != 0) session->m_maxInMsgBytes = binding->f_maxInMsgKb * 1024;
+			else                                       session->m_maxInMsgBytes = cfg.f_maxInMsgKb * 1024;
 
-		SocketReader reader { sk.GetSocket() };
-		SocketWriter writer { sk.GetSocket() };
-		Schannel conn { &reader, &writer };
-		conn.SetStopCtl(*this);
+			// It is NOT a good idea to enable TCP_NODELAY here.
+			// It would cause inefficiency in response sending in combination with PIPELINING.
 
-		if (cfg.f_transcriptRemoteAddrs.Any())
-		{
-			auto criterion = [&sk] (Str const& addr) -> bool { return Seq(addr).EqualExact("*") || sk.RemoteAddr().EqualsStr_AddrOnly(addr); };
-			if (cfg.f_transcriptRemoteAddrs.Contains(criterion))
+			if (cfg.f_transcriptRemoteAddrs.Any())
 			{
-				Rp<Transcriber> transcriber = TextFileTranscriber::Start("SmtpReceiver", sk);
-				reader.SetTranscriber(transcriber);
-				writer.SetTranscriber(transcriber);
-				conn.SetTranscriber(transcriber);
+				auto criterion = [&sk] (Str const& addr) -> bool { return Seq(addr).EqualExact("*") || sk.RemoteAddr().EqualsStr_AddrOnly(addr); };
+				if (cfg.f_transcriptRemoteAddrs.Contains(criterion))
+				{
+					Rp<Transcriber> transcriber = TextFileTranscriber::Start("SmtpReceiver", sk);
+					session->m_reader.SetTranscriber(transcriber);
+					session->m_writer.SetTranscriber(transcriber);
+					session->m_conn.SetTranscriber(transcriber);
+				}
 			}
 		}
 
+		session->m_conn.SetStopCtl(*this);
+
+		if (RunSession(session.Ref(), resumed))
+		{
+			AutoFree<EmailServerSession> parked { session.Dismiss() };
+			m_workPool->ParkSession(parked);
+		}
+	}
+
+
+	bool SmtpReceiverThread::RunSession(SmtpReceiverSession& session, bool resumed)
+	{
+		Schannel&              conn          = session.m_conn;
+		EmailSrvBinding const* binding       = session.m_binding;
+		Str const&             ourName       = session.m_ourName;
+		uint64 const           maxInMsgBytes = session.m_maxInMsgBytes;
+
 		try
 		{
 			try
 			{
-				Rp<SmtpReceiverAuthCx> l_authCx;
-				EhloHost l_ehloHost;
-				bool     l_haveMailFrom {};
-				uint64   l_fromSize     {};
-				sizet    l_maxDataBytes {};
-				Vec<Str> l_toMailboxes;
+				Rp<SmtpReceiverAuthCx>& l_authCx       = session.m_authCx;
+				EhloHost&               l_ehloHost     = session.m_ehloHost;
+				bool&                   l_haveMailFrom = session.m_haveMailFrom;
+				uint64&                 l_fromSize     = session.m_fromSize;
+				sizet&                  l_maxDataBytes = session.m_maxDataBytes;
+				Vec<Str>&               l_toMailboxes  = session.m_toMailboxes;
 
 				auto rset = [&] ()
 					{
@@ -143,18 +184,33 @@ namespace At
 						conn.StartTls();
 					};
 
-				if (!binding)
-					throw SmtpReceiver_Disconnect(421, "Cannot accept connection: configuration changed, binding no longer present");
+				if (!session.m_greeted)
+				{
+					session.m_greeted = true;
 
-				if (binding->f_implicitTls)
-					startTls();
+					if (!binding)
+						throw SmtpReceiver_Disconnect(421, "Cannot accept connection: configuration changed, binding no longer present");
 
-				SendReply(conn, 220, Str::Join(ourName, " ESMTP Ready"));
+					if (binding->f_implicitTls)
+						startTls();
+
+					SendReply(conn, 220, Str::Join(ourName, " ESMTP Ready"));
+				}
 
 				while (true)
 				{
+					// In event-driven mode, a session waiting for the next command is parked instead of blocking this thread.
+					// A resumed session was parked before the client's data arrived. The data is now in the socket, but not yet
+					// in the reader, so the first command after resuming is read while blocking; further commands only if buffered.
+					// Input that continues a command, such as AUTH responses and message data, is still read while blocking
 					EmailServer_ClientCmd cmd;
-					cmd.ReadCmd(conn);
+					if (!m_workPool->EventDriven() || resumed)
+					{
+						cmd.ReadCmd(conn);
+						resumed = false;
+					}
+					else if (!cmd.TryReadCmd(conn))
+						return true;
 				
 					if (cmd.m_cmd == "quit")
 					{
@@ -295,7 +351,7 @@ namespace At
 
 							if (haveCreds)
 							{
-								EmailServerAuthResult result = m_workPool->SmtpReceiver_Authenticate(workItem->m_saRemote, conn, ourName, l_ehloHost,
+								EmailServerAuthResult result = m_workPool->SmtpReceiver_Authenticate(session.m_saRemote, conn, ourName, l_ehloHost,
 									authorizationIdentity, authenticationIdentity, password, l_authCx);
 
 								if (EmailServerAuthResult::Success == result)
@@ -371,7 +427,7 @@ namespace At
 										instr.Init(l_authCx->SmtpReceiverAuthCx_OnMailFrom(fromMailbox));
 									else
 									{
-										instr.Init(m_workPool->SmtpReceiver_OnMailFrom_NoAuth(workItem->m_saRemote, conn, ourName, l_ehloHost, fromMailbox, l_authCx));
+										instr.Init(m_workPool->SmtpReceiver_OnMailFrom_NoAuth(session.m_saRemote, conn, ourName, l_ehloHost, fromMailbox, l_authCx));
 										if (instr->m_accept)
 											EnsureThrow(l_authCx.Any());
 									}
@@ -480,6 +536,8 @@ namespace At
 		{
 			// Just close the connection.
 		}
+
+		return false;
 	}
 
 
@@ -8,11 +8,18 @@
 namespace At
 {
 
+	struct SmtpReceiverSession;
+
+
 	class SmtpReceiverThread : public WorkPoolThread<SmtpReceiver>
 	{
 	private:
 		void WorkPoolThread_ProcessWorkItem(void* pvWorkItem) override;
 
+		// Processes commands until the session ends. In event-driven mode, returns true if the session is waiting for the client's
+		// next command, and should be parked until the client sends it. A resumed session reads its first command while blocking
+		bool RunSession(SmtpReceiverSession& session, bool resumed);
+
 		EhloHost ParseEhloHost(Seq host);
 
 		bool ReadAuthLoginParameter(Seq& paramReader, Str& result);
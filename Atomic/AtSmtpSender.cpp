@@ -11,6 +11,19 @@
 namespace At
 {
 
+	namespace
+	{
+		// Scans of the queue need only the key and the status of each message. A message to be modified is then loaded in full.
+		// Loading with ObjId::None as the reference is consistent, because the message was read by the same transaction
+		EntityProjection const& SmtpMsgToSend_StatusProjection()
+		{
+			static EntityProjection const s_projection { SmtpMsgToSend::Sample, { "nextAttemptTime", "status" } };
+			return s_projection;
+		}
+	}
+
+
+
 	// SmtpSenderWorkItem
 
 	SmtpSenderWorkItem::~SmtpSenderWorkItem() noexcept
@@ -73,7 +86,7 @@ namespace At
 
 		Rp<SmtpMsgToSend> msgToSend;
 
-		SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(nowPlusOne, nullptr,
+		SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(nowPlusOne, nullptr, SmtpMsgToSend_StatusProjection(),
 			[&] (Rp<SmtpMsgToSend> const& msg) -> bool
 			{
 				if (msg->f_status == SmtpMsgStatus::NonFinal_Idle) { msgToSend = msg; return false; }
@@ -83,6 +96,7 @@ namespace At
 		if (!msgToSend.Any())
 			return false;
 
+		msgToSend->Load(ObjId::None);
 		msgToSend->f_nextAttemptTime = Time();
 		msgToSend->Update();
 
@@ -107,10 +121,13 @@ namespace At
 
 			GetStore().RunTxExclusive( [&] ()
 				{
-					SmtpSender_GetStorageParent().EnumAllChildrenOfKind<SmtpMsgToSend>(
+					SmtpSender_GetStorageParent().EnumAllChildrenOfKind<SmtpMsgToSend>(SmtpMsgToSend_StatusProjection(),
 						[&] (Rp<SmtpMsgToSend> const& msg) -> bool
 							{ if (msg->f_status == SmtpMsgStatus::NonFinal_Sending) msgsToReset.Add(msg); return true; } );
 
+					for (Rp<SmtpMsgToSend> const& msg : msgsToReset)
+						msg->Load(ObjId::None);
+
 					if (msgsToReset.Any())
 					{
 						// Delay when we start resending messages from last run so that the admin has opportunity to take any emergency actions.
@@ -148,6 +165,7 @@ namespace At
 			SmtpSender_GetCfg(cfg);
 
 			bool atMemUsageLimit {};
+			bool atBacklogLimit {};
 			Time nextPumpTime;
 
 			if (0 != cfg.f_memUsageLimitKb)
@@ -171,11 +189,13 @@ namespace At
 						Time timeNowPlusOne = timeNow;
 						++timeNowPlusOne;
 
-						SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(timeMin, &timeNowPlusOne,
+						SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(timeMin, &timeNowPlusOne, SmtpMsgToSend_StatusProjection(),
 							[&] (Rp<SmtpMsgToSend> const& m) -> bool
 							{
 								if (m->f_status == SmtpMsgStatus::NonFinal_Idle)
 								{
+									m->Load(ObjId::None);
+
 									SmtpSenderWorkItem* wi = new SmtpSenderWorkItem;
 									AutoFree<SmtpSenderWorkItem> autoFreeWorkItem { wi };
 									workItems.Add(autoFreeWorkItem);
@@ -205,17 +225,34 @@ namespace At
 								return true;
 							} );
 
-						SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(timeNowPlusOne, nullptr,
+						SmtpSender_GetStorageParent().FindChildren<SmtpMsgToSend>(timeNowPlusOne, nullptr, SmtpMsgToSend_StatusProjection(),
 							[&] (Rp<SmtpMsgToSend> const& m) -> bool
 								{ nextPumpTime = m->f_nextAttemptTime; return false; } );
 					} );
 
-				// Enqueue messages
+				// Enqueue messages. Messages rejected because the backlog is full are returned to idle status, to be picked up by a later pump
+				RpVec<SmtpMsgToSend> rejectedMsgs;
 				for (sizet i=0; i!=workItems.Len(); ++i)
 				{
 					AutoFree<SmtpSenderWorkItem> afwi;
 					workItems.Extract(i, afwi);
-					EnqueueWorkItem(afwi);
+					if (!EnqueueWorkItem(afwi))
+						rejectedMsgs.Add(afwi->m_msg);
+				}
+
+				if (rejectedMsgs.Any())
+				{
+					atBacklogLimit = true;
+
+					GetStore().RunTx(GetStopCtl(), typeid(*this), [&] ()
+						{
+							for (Rp<SmtpMsgToSend> const& msg : rejectedMsgs)
+							{
+								Rp<SmtpMsgToSend> txMsg { new SmtpMsgToSend(msg.Ref()) };
+								txMsg->f_status = SmtpMsgStatus::NonFinal_Idle;
+								txMsg->Update();
+							}
+						} );
 				}
 			}
 
@@ -223,6 +260,8 @@ namespace At
 			DWORD waitMs = INFINITE;
 			if (atMemUsageLimit)
 				waitMs = AtMemUsageLimit_PumpDelayMs;
+			else if (atBacklogLimit)
+				waitMs = AtBacklogLimit_PumpDelayMs;
 			else if (nextPumpTime != Time::Max())
 				waitMs = SatCast<DWORD>((nextPumpTime - Time::StrictNow()).ToMilliseconds());
 
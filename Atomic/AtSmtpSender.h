@@ -99,7 +99,7 @@ namespace At
 	private:
 		enum { InitResumeSend_DelayMins = 3, InitResumeSend_DefaultPerMsgDelayMs = 1000, InitResumeSend_MaxLastMsgDelayMins = 5 };
 
-		enum { AtMemUsageLimit_PumpDelayMs = 100 };
+		enum { AtMemUsageLimit_PumpDelayMs = 100, AtBacklogLimit_PumpDelayMs = 100 };
 		Event m_pumpTrigger { Event::CreateAuto };
 		Rp<SmtpSenderMemUsage> m_memUsage;
 
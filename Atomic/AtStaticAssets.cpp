@@ -0,0 +1,136 @@
+#include "AtIncludes.h"
+#include "AtStaticAssets.h"
+
+#include "AtCrypt.h"
+#include "AtCspBuilder.h"
+#include "AtDeflate.h"
+#include "AtInitOnFirstUse.h"
+#include "AtScripts.h"
+
+
+namespace At
+{
+
+	namespace
+	{
+
+		// Atomic's own scripts and styles, packed into AtScripts. AtScripts_Assets.inl is generated in the build step that runs
+		// ScriptPack, from the same input files, and has one AT_SCRIPTS_ASSET line for each of them
+		struct BuiltInAsset
+		{
+			Seq const*  m_content;
+			char const* m_baseName;
+			char const* m_ext;
+			char const* m_contentType;
+		};
+
+		#define AT_SCRIPTS_ASSET(KIND, BASENAME, EXT, CONTENTTYPE) { &c_##KIND##_##BASENAME, #BASENAME, EXT, CONTENTTYPE },
+
+		BuiltInAsset const c_builtInAssets[] =
+		{
+			#include "AtScripts_Assets.inl"
+			{ nullptr, nullptr, nullptr, nullptr }		// Sentinel, so that the array is not empty if there are no scripts
+		};
+
+		#undef AT_SCRIPTS_ASSET
+
+		enum { NrBuiltInEntries = sizeof(c_builtInAssets) / sizeof(BuiltInAsset),
+			   NrBuiltInAssets  = NrBuiltInEntries - 1 };
+
+		// Storage for the CSP hashes and file names to which the registered StaticAsset entries point
+		StaticAsset g_builtInAssets          [NrBuiltInEntries];
+		Str         g_builtInAssetCspHashes  [NrBuiltInEntries];
+		Str         g_builtInAssetFileNames  [NrBuiltInEntries];
+
+	}	// anon
+
+
+	StaticAssets g_staticAssets;
+
+
+	void StaticAssets::Register(StaticAsset const* assets, sizet nrAssets)
+	{
+		EnsureBuiltInRegistered();
+		AddAssets(assets, nrAssets);
+	}
+
+
+	void StaticAssets::EnsureBuiltInRegistered()
+	{
+		InitOnFirstUse(&m_builtInInitFlag,
+			[this] ()
+			{
+				// The file name includes a hash of the content, so that changed content gets a different name
+				for (sizet i=0; i!=NrBuiltInAssets; ++i)
+				{
+					BuiltInAsset const& bia = c_builtInAssets[i];
+					Seq content = *bia.m_content;
+					g_builtInAssetCspHashes[i] = CspBuilder::Sha256(content);
+					g_builtInAssetFileNames[i].Set(bia.m_baseName).Ch('.')
+						.Add(Seq(Hash::HexHashOf(content, CALG_SHA_256, CharCase::Lower)).ReadBytes(16)).Add(bia.m_ext);
+
+					StaticAsset& asset = g_builtInAssets[i];
+					asset.m_content     = content;
+					asset.m_cspHash     = g_builtInAssetCspHashes[i];
+					asset.m_fileName    = g_builtInAssetFileNames[i];
+					asset.m_contentType = bia.m_contentType;
+				}
+
+				AddAssets(g_builtInAssets, NrBuiltInAssets);
+			} );
+	}
+
+
+	void StaticAssets::AddAssets(StaticAsset const* assets, sizet nrAssets)
+	{
+		for (sizet i=0; i!=nrAssets; ++i)
+		{
+			StaticAsset const* asset = &assets[i];
+			for (StaticAsset const* existing : m_assets)
+				EnsureThrow(!existing->m_fileName.EqualExact(asset->m_fileName));
+
+			m_assets.Add(asset);
+			m_gzipContents.Add();
+		}
+	}
+
+
+	StaticAsset const* StaticAssets::FindByContent(Seq content)
+	{
+		EnsureBuiltInRegistered();
+		for (StaticAsset const* asset : m_assets)
+			if (asset->m_content.p == content.p && asset->m_content.n == content.n)
+				return asset;
+
+		return nullptr;
+	}
+
+
+	StaticAsset const* StaticAssets::FindByFileName(Seq fileName)
+	{
+		EnsureBuiltInRegistered();
+		for (StaticAsset const* asset : m_assets)
+			if (asset->m_fileName.EqualExact(fileName))
+				return asset;
+
+		return nullptr;
+	}
+
+
+	Seq StaticAssets::GzipContent(StaticAsset const& asset)
+	{
+		for (sizet i=0; i!=m_assets.Len(); ++i)
+			if (m_assets[i] == &asset)
+			{
+				Locker locker { m_gzipMx };
+				Str& gzipContent = m_gzipContents[i];
+				if (!gzipContent.Any())
+					DeflateEncoder::Compress(asset.m_content, gzipContent, DeflateEncoder::Format::Gzip);
+				return gzipContent;
+			}
+
+		EnsureThrow(!"Static asset is not registered");
+		return Seq();
+	}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "AtMutex.h"
+#include "AtStr.h"
+#include "AtVec.h"
+
+
+namespace At
+{
+
+	// A CSS or JS resource, such as one packed by ScriptPack. The file name includes a hash of the content, so a response
+	// serving it can be cached indefinitely: changed content gets a different name. For Atomic's own scripts, the CSP hash
+	// and the file name are computed when the registry is first used.
+
+	struct StaticAsset
+	{
+		Seq m_content;
+		Seq m_cspHash;			// CSP hash source expression, including single quotes: 'sha256-...'
+		Seq m_fileName;			// E.g. AtHtmlBuilder_Intro.0123456789abcdef.js
+		Seq m_contentType;
+
+		// Subresource Integrity value for the integrity attribute: the CSP hash without the single quotes
+		Seq Integrity() const { return Seq(m_cspHash).DropByte().RevDropByte(); }
+	};
+
+
+
+	// Registry of static assets, consulted by HtmlBuilder and by WebRequestHandler::SetStaticAssetResponse.
+	// Atomic's own assets, packed into AtScripts, are registered on first use of the registry. An application registers its own
+	// assets with Register. Assets must be registered, and the URL prefix set, during initialization, before requests are processed.
+
+	class StaticAssets : public NoCopy
+	{
+	public:
+		void Register(StaticAsset const* assets, sizet nrAssets);
+
+		// When an URL prefix is set, HtmlBuilder references registered CSS and JS as external resources, instead of including
+		// them inline. The asset URL is the prefix followed by the file name, so the prefix should end with a slash, e.g. "/assets/".
+		// The application must serve requests under this prefix using WebRequestHandler::SetStaticAssetResponse.
+		void SetUrlPrefix(Seq urlPrefix) { m_urlPrefix = urlPrefix; }
+		Seq  UrlPrefix() const { return m_urlPrefix; }
+		bool External() const { return m_urlPrefix.Any(); }
+
+		// Source expression to add to the CSP for assets referenced via the URL prefix
+		Seq CspSource() const { return If(Seq(m_urlPrefix).StartsWithExact("/"), Seq, "'self'", m_urlPrefix); }
+
+		// Finds an asset by the address of its content, so it finds the asset only if passed the Seq generated by ScriptPack,
+		// or a copy of it. Returns nullptr if not found.
+		StaticAsset const* FindByContent(Seq content);
+		StaticAsset const* FindByFileName(Seq fileName);
+
+		// Cache-Control for responses serving an asset: one year, and no revalidation
+		static Seq CacheControl() { return "public, max-age=31536000, immutable"; }
+
+		// Returns the asset content compressed for the "gzip" content coding. An asset is compressed the first time it is requested,
+		// and the result is kept for the lifetime of the registry. The asset must be registered
+		Seq GzipContent(StaticAsset const& asset);
+
+	private:
+		Vec<StaticAsset const*> m_assets;
+		Str                     m_urlPrefix;
+		Mutex                   m_gzipMx;
+		Vec<Str>                m_gzipContents;		// Same order as m_assets. Empty until compressed
+		LONG volatile           m_builtInInitFlag {};
+
+		void EnsureBuiltInRegistered();
+		void AddAssets(StaticAsset const* assets, sizet nrAssets);
+	};
+
+
+	extern StaticAssets g_staticAssets;
+
+}
@@ -0,0 +1,285 @@
+#include "AtIncludes.h"
+#include "AtTaskScheduler.h"
+
+#include "AtWait.h"
+#include "AtWinErr.h"
+
+
+namespace At
+{
+
+	TaskScheduler::TaskScheduler()
+	{
+		m_wakeSemaphore = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+		if (!m_wakeSemaphore)
+			{ LastWinErr e; throw e.Make<>("TaskScheduler: Error in CreateSemaphore"); }
+	}
+
+
+	TaskScheduler::~TaskScheduler() noexcept
+	{
+		delete[] m_workers;
+		CloseHandle(m_wakeSemaphore);
+	}
+
+
+	void TaskScheduler::Init(uint maxWorkers, sizet maxBacklog, BacklogPolicy::E backlogPolicy)
+	{
+		EnsureThrow(!m_workers);
+		EnsureThrow(maxWorkers != 0 && maxWorkers < NoWorker);
+		EnsureThrow(maxBacklog != 0);
+
+		m_maxWorkers = maxWorkers;
+		m_workers = new Worker[maxWorkers];
+		m_maxBacklog = maxBacklog;
+		m_backlogPolicy = backlogPolicy;
+	}
+
+
+	bool TaskScheduler::Enqueue(void* task, TaskPriority::E priority, HANDLE stopEvent, uint worker)
+	{
+		EnsureThrow(m_workers);
+		EnsureThrow(task);
+		EnsureThrow((uint) priority < TaskPriority::Count);
+
+		if (!ReserveRoom(stopEvent))
+			return false;
+
+		bool pushed {};
+		if (worker != NoWorker)
+		{
+			EnsureThrow(worker < m_maxWorkers);
+			Push(m_workers[worker], task, priority);
+			pushed = true;
+		}
+		else
+		{
+			// Skip past workers that are not attached. The shared queue takes the task if no worker is attached
+			LONG const workersEnd = m_workersEnd;
+			for (LONG i=0; i!=workersEnd && !pushed; ++i)
+			{
+				Worker& w = m_workers[((ULONG) InterlockedIncrement(&m_nextWorker)) % ((ULONG) workersEnd)];
+				w.m_lock.Acquire();
+				OnExit release = [&] { w.m_lock.Release(); };
+
+				if (w.m_attached)
+				{
+					w.m_tasks[priority].push_back(task);
+					InterlockedIncrement(&w.m_nrTasks);
+					pushed = true;
+				}
+			}
+
+			if (!pushed)
+				Push(m_shared, task, priority);
+		}
+
+		if (InterlockedCompareExchange(&m_nrIdle, 0, 0) > 0)
+			ReleaseSemaphore(m_wakeSemaphore, 1, nullptr);
+
+		return true;
+	}
+
+
+	bool TaskScheduler::ReserveRoom(HANDLE stopEvent)
+	{
+		while (true)
+		{
+			if ((sizet) InterlockedIncrement64(&m_nrQueued) <= m_maxBacklog)
+				return true;
+
+			InterlockedDecrement64(&m_nrQueued);
+			if (m_backlogPolicy == BacklogPolicy::Reject)
+				return false;
+
+			InterlockedIncrement(&m_nrBlocked);
+			OnExit unblock = [&] { InterlockedDecrement(&m_nrBlocked); };
+
+			// A task taken after the check above signals the event, because this thread is now counted as blocked
+			if ((sizet) InterlockedCompareExchange64(&m_nrQueued, 0, 0) >= m_maxBacklog)
+				if (Wait2(stopEvent, m_roomEvent.Handle(), INFINITE) == 0)
+					throw ExecutionAborted();
+		}
+	}
+
+
+	uint TaskScheduler::AttachWorker()
+	{
+		EnsureThrow(m_workers);
+
+		for (uint i=0; i!=m_maxWorkers; ++i)
+		{
+			Worker& w = m_workers[i];
+			w.m_lock.Acquire();
+			OnExit release = [&] { w.m_lock.Release(); };
+
+			if (!w.m_attached)
+			{
+				w.m_attached = true;
+
+				LONG workersEnd = m_workersEnd;
+				while (workersEnd <= (LONG) i)
+				{
+					LONG prev = InterlockedCompareExchange(&m_workersEnd, (LONG) (i + 1), workersEnd);
+					if (prev == workersEnd)
+						break;
+					workersEnd = prev;
+				}
+
+				return i;
+			}
+		}
+
+		EnsureThrow(!"TaskScheduler: Maximum number of workers already attached");
+		return NoWorker;
+	}
+
+
+	void TaskScheduler::DetachWorker(uint worker)
+	{
+		EnsureThrow(worker < m_maxWorkers);
+		Worker& w = m_workers[worker];
+
+		bool moved {};
+
+		{
+			w.m_lock.Acquire();
+			OnExit release = [&] { w.m_lock.Release(); };
+
+			EnsureThrow(w.m_attached);
+			w.m_attached = false;
+
+			if (w.m_nrTasks)
+			{
+				m_shared.m_lock.Acquire();
+				OnExit releaseShared = [&] { m_shared.m_lock.Release(); };
+
+				for (uint p=0; p!=TaskPriority::Count; ++p)
+				{
+					for (void* task : w.m_tasks[p])
+						m_shared.m_tasks[p].push_back(task);
+
+					w.m_tasks[p].clear();
+				}
+
+				InterlockedExchangeAdd(&m_shared.m_nrTasks, w.m_nrTasks);
+				w.m_nrTasks = 0;
+				moved = true;
+			}
+		}
+
+		if (moved && InterlockedCompareExchange(&m_nrIdle, 0, 0) > 0)
+			ReleaseSemaphore(m_wakeSemaphore, 1, nullptr);
+	}
+
+
+	void* TaskScheduler::TryDequeue(uint worker)
+	{
+		EnsureThrow(worker < m_maxWorkers);
+
+		void* task = TryPop(m_workers[worker]);
+		if (!task)
+			task = TryPop(m_shared);
+
+		if (!task)
+		{
+			LONG const workersEnd = m_workersEnd;
+			for (LONG i=1; i<workersEnd && !task; ++i)
+			{
+				Worker& victim = m_workers[(worker + (uint) i) % (uint) workersEnd];
+				if (victim.m_nrTasks)
+					if (nullptr != (task = TryPop(victim)))
+						InterlockedIncrement64(&m_nrStolen);
+			}
+		}
+
+		if (task)
+			OnTaskTaken();
+
+		return task;
+	}
+
+
+	DWORD TaskScheduler::WaitForTask(HANDLE stopEvent, DWORD waitMs)
+	{
+		InterlockedIncrement(&m_nrIdle);
+		OnExit notIdle = [&] { InterlockedDecrement(&m_nrIdle); };
+
+		// A task enqueued after this check releases the semaphore, because this worker is now counted as idle
+		if (InterlockedCompareExchange64(&m_nrQueued, 0, 0) > 0)
+			return 1;
+
+		DWORD const waitResult = Wait2(stopEvent, m_wakeSemaphore, waitMs);
+
+		// A task enqueued just before the timeout may have found this worker idle, so that no other thread was started for it
+		if (waitResult == WAIT_TIMEOUT && InterlockedCompareExchange64(&m_nrQueued, 0, 0) > 0)
+			return 1;
+
+		return waitResult;
+	}
+
+
+	void TaskScheduler::RemoveAll(std::function<void(void*)> onTask)
+	{
+		auto removeFrom = [&] (Worker& w)
+			{
+				EnsureThrow(!w.m_attached);
+				for (uint p=0; p!=TaskPriority::Count; ++p)
+				{
+					while (!w.m_tasks[p].empty())
+					{
+						void* task = w.m_tasks[p].front();
+						w.m_tasks[p].pop_front();
+						InterlockedDecrement(&w.m_nrTasks);
+						InterlockedDecrement64(&m_nrQueued);
+						onTask(task);
+					}
+				}
+			};
+
+		for (uint i=0; i!=m_maxWorkers; ++i)
+			removeFrom(m_workers[i]);
+
+		removeFrom(m_shared);
+	}
+
+
+	void TaskScheduler::Push(Worker& w, void* task, TaskPriority::E priority)
+	{
+		w.m_lock.Acquire();
+		OnExit release = [&] { w.m_lock.Release(); };
+
+		w.m_tasks[priority].push_back(task);
+		InterlockedIncrement(&w.m_nrTasks);
+	}
+
+
+	void* TaskScheduler::TryPop(Worker& w)
+	{
+		if (!w.m_nrTasks)
+			return nullptr;
+
+		w.m_lock.Acquire();
+		OnExit release = [&] { w.m_lock.Release(); };
+
+		for (uint p=0; p!=TaskPriority::Count; ++p)
+			if (!w.m_tasks[p].empty())
+			{
+				void* task = w.m_tasks[p].front();
+				w.m_tasks[p].pop_front();
+				InterlockedDecrement(&w.m_nrTasks);
+				return task;
+			}
+
+		return nullptr;
+	}
+
+
+	void TaskScheduler::OnTaskTaken()
+	{
+		InterlockedDecrement64(&m_nrQueued);
+		if (InterlockedCompareExchange(&m_nrBlocked, 0, 0) > 0)
+			m_roomEvent.Signal();
+	}
+
+}
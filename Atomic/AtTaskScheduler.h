@@ -0,0 +1,98 @@
+#pragma once
+
+#include "AtEvent.h"
+#include "AtSpinLock.h"
+
+
+namespace At
+{
+
+	struct TaskPriority { enum E { High, Normal, Low, Count }; };
+
+	// When the backlog is full, Block causes Enqueue to wait until a task is taken, and Reject causes Enqueue to return false
+	struct BacklogPolicy { enum E { Block, Reject }; };
+
+
+
+	// TaskScheduler
+
+	// Queues tasks for worker threads. Each worker has its own queues, one for each priority, so that producers and workers
+	// do not all contend for a single lock. A task enqueued by a worker goes to that worker's queues. Tasks enqueued by other
+	// threads are distributed among attached workers round-robin. A worker whose queues are empty steals a task from another
+	// worker. A worker takes the highest priority task in the first queue in which it finds any, so priorities are observed
+	// within each worker's queues, but only approximately across workers.
+	//
+	// Enqueue does not wait for a worker to take the task. It waits only if the backlog is full and the policy is Block.
+	//
+	// The scheduler does not own threads. A worker thread calls AttachWorker, then alternates between TryDequeue and WaitForTask,
+	// and calls DetachWorker before it exits. Tasks still in the queues of a worker that detaches are moved to a shared queue,
+	// which all workers check before stealing. An enqueuer that found the worker idle may not have started another thread for its
+	// task, so a worker that detaches after WaitForTask times out must check NrQueued and attach again if any tasks remain.
+	// Tasks are opaque pointers, owned by the scheduler while queued.
+
+	class TaskScheduler : public NoCopy
+	{
+	public:
+		enum : uint { NoWorker = UINT_MAX };
+
+		TaskScheduler();
+		~TaskScheduler() noexcept;
+
+		// Must be called before workers attach and tasks are enqueued
+		void Init(uint maxWorkers, sizet maxBacklog, BacklogPolicy::E backlogPolicy);
+		bool Inited() const { return m_workers != nullptr; }
+
+		// Returns true if the task was queued. Returns false if the backlog is full and the policy is Reject; the caller then
+		// still owns the task. If the policy is Block, waits for room, and throws ExecutionAborted if stopEvent is signaled first.
+		// A worker passes its index, so that the task is queued locally.
+		bool Enqueue(void* task, TaskPriority::E priority, HANDLE stopEvent, uint worker = NoWorker);
+
+		uint AttachWorker();
+		void DetachWorker(uint worker);
+
+		// Returns nullptr if no task could be found
+		void* TryDequeue(uint worker);
+
+		// Waits until a task may be available. Returns 0 if stopEvent is signaled, 1 if a task may be available,
+		// or WAIT_TIMEOUT if waitMs have elapsed
+		DWORD WaitForTask(HANDLE stopEvent, DWORD waitMs);
+
+		// Removes all queued tasks, passing each to the function. Must not be called while workers are attached
+		void RemoveAll(std::function<void(void*)> onTask);
+
+		sizet  NrQueued      () const { return (sizet) m_nrQueued; }
+		sizet  NrIdleWorkers () const { return (sizet) m_nrIdle; }
+		uint64 NrStolen      () const { return (uint64) m_nrStolen; }
+
+	private:
+		struct Worker : NoCopy
+		{
+			SpinLock          m_lock;
+			bool              m_attached {};
+			LONG volatile     m_nrTasks  {};		// Read without the lock by workers looking for a task to steal
+			std::deque<void*> m_tasks[TaskPriority::Count];
+		};
+
+		uint             m_maxWorkers     {};
+		Worker*          m_workers        {};
+		Worker           m_shared;
+		LONG volatile    m_workersEnd     {};		// One past the highest index ever attached
+		LONG volatile    m_nextWorker     {};
+		sizet            m_maxBacklog     { SIZE_MAX };
+		BacklogPolicy::E m_backlogPolicy  { BacklogPolicy::Block };
+
+		LONG64 volatile  m_nrQueued       {};
+		LONG volatile    m_nrIdle         {};
+		LONG volatile    m_nrBlocked      {};
+		LONG64 volatile  m_nrStolen       {};
+
+		HANDLE           m_wakeSemaphore  {};		// Released once per task enqueued while workers are idle
+		Event            m_roomEvent      { Event::CreateAuto };
+
+		bool ReserveRoom(HANDLE stopEvent);
+		void Push(Worker& w, void* task, TaskPriority::E priority);
+		void* TryPop(Worker& w);
+		void OnTaskTaken();
+	};
+
+}
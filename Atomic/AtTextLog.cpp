@@ -3,6 +3,7 @@
 
 #include "AtPath.h"
 #include "AtTime.h"
+#include "AtWait.h"
 #include "AtWinErr.h"
 #include "AtWinStr.h"
 
@@ -12,12 +13,19 @@ namespace At
 
 	TextLog::~TextLog()
 	{
+		// The writer thread drains the ring buffer before exiting
+		if (m_writerStopCtl.Any())
+		{
+			m_writerStopCtl->Stop("TextLog destroyed");
+			m_writerStopCtl->WaitAll();
+		}
+
 		if (m_h != INVALID_HANDLE_VALUE)
 			CloseHandle(m_h);
 	}
 
 
-	void TextLog::Init(Seq baseName, uint flags)
+	void TextLog::Init(Seq baseName, uint flags, AsyncParams const& asyncParams)
 	{
 		EnsureThrow(m_h == INVALID_HANDLE_VALUE);
 		
@@ -33,6 +41,51 @@ namespace At
 		GetLocalTimeRep(Time::StrictNow(), tzi, datePart, timePart);
 
 		OpenLog(tzBias, datePart, timePart);
+
+		if (0 != (m_flags & Flags::Async))
+		{
+			sizet const maxEntries = asyncParams.m_maxEntries;
+			EnsureThrow(maxEntries >= 2 && (maxEntries & (maxEntries - 1)) == 0);
+			EnsureThrow(asyncParams.m_maxWriteBytes != 0);
+
+			m_asyncParams = asyncParams;
+			m_ring.ResizeExact(maxEntries);
+			for (sizet i=0; i!=maxEntries; ++i)
+				m_ring[i].m_seq = (LONG64) i;
+
+			m_ringMask = (LONG64) (maxEntries - 1);
+			m_writeBuf.ReserveExact(m_asyncParams.m_maxWriteBytes);
+
+			m_writerStopCtl.Set(new StopCtl);
+			m_writer.Create();
+			m_writer->SetLog(this);
+			m_writer->Start(m_writerStopCtl);
+		}
+	}
+
+
+	void TextLog::Flush()
+	{
+		if (0 == (m_flags & Flags::Async))
+			return;
+
+		LONG64 const target = m_enqueuePos;
+		while (m_writtenPos < target)
+		{
+			// Claimed slots might not be published yet, so wake the writer and re-check periodically
+			m_workEvent.Signal();
+			m_writtenEvent.Wait(10);
+		}
+	}
+
+
+	TextLog::AsyncStats TextLog::GetAsyncStats()
+	{
+		Locker locker { m_mx };
+		AsyncStats stats = m_asyncStats;
+		stats.m_nrDropped = (uint64) m_nrDropped;
+		stats.m_nrBlocked = (uint64) m_nrBlocked;
+		return stats;
 	}
 
 
@@ -87,8 +140,44 @@ namespace At
 	}
 
 
+	void TextLog::RolloverIfNeeded(TzBias tzBias, uint datePart, uint timePart)
+	{
+		// Also retries opening a log that could not be opened at the previous rollover
+		if (m_h == INVALID_HANDLE_VALUE || tzBias != m_curLogTzBias || datePart != m_curLogDatePart)
+		{
+			if (m_h != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(m_h);
+				m_h = INVALID_HANDLE_VALUE;
+			}
+
+			OpenLog(tzBias, datePart, timePart);
+		}
+	}
+
+
+	void TextLog::WriteToLog(Seq data)
+	{
+		DWORD bytesWritten;
+		if (!WriteFile(m_h, data.p, NumCast<DWORD>(data.n), &bytesWritten, 0))
+		{
+			DWORD rc = GetLastError();
+			throw WinErr<>(rc, Str("Error in WriteFile for ").Add(m_curLogPath));
+		}
+
+		if (bytesWritten != data.n)
+			throw StrErr(Str("Unexpected number of bytes written to ").Add(m_curLogPath));
+	}
+
+
 	void TextLog::WriteEntry(Time now, TzInfo const& tzi, Seq entry)
 	{
+		if (0 != (m_flags & Flags::Async))
+		{
+			EnqueueEntry(now, tzi, entry);
+			return;
+		}
+
 		Locker locker { m_mx };
 
 		EnsureThrow(m_h != INVALID_HANDLE_VALUE);
@@ -97,26 +186,157 @@ namespace At
 		{
 			uint datePart, timePart;
 			GetLocalTimeRep(now, tzi, datePart, timePart);
+			RolloverIfNeeded(TzBias(tzi), datePart, timePart);
+		}
+
+		WriteToLog(entry);
+	}
+
+
+	void TextLog::EnqueueEntry(Time now, TzInfo const& tzi, Seq entry)
+	{
+		EnsureThrow(m_writerStopCtl.Any());
+
+		uint datePart {}, timePart {};
+		if (0 != (m_flags & Flags::AutoRollover))
+			GetLocalTimeRep(now, tzi, datePart, timePart);
 
-			TzBias tzBias { tzi };
-			if (tzBias != m_curLogTzBias || datePart != m_curLogDatePart)
+		bool blocked {};
+		LONG64 pos = m_enqueuePos;
+		Slot* slot;
+		while (true)
+		{
+			slot = &m_ring[(sizet) (pos & m_ringMask)];
+			LONG64 diff = slot->m_seq - pos;
+			if (diff == 0)
 			{
-				CloseHandle(m_h);
-				m_h = INVALID_HANDLE_VALUE;
+				LONG64 observed = InterlockedCompareExchange64(&m_enqueuePos, pos + 1, pos);
+				if (observed == pos)
+					break;
+				pos = observed;
+			}
+			else if (diff > 0)
+				pos = m_enqueuePos;		// Another producer claimed this slot
+			else
+			{
+				// Ring buffer is full
+				if (m_asyncParams.m_overflow == AsyncParams::Overflow::Drop)
+				{
+					InterlockedIncrement64(&m_nrDropped);
+					return;
+				}
+
+				if (!blocked)
+				{
+					blocked = true;
+					InterlockedIncrement64(&m_nrBlocked);
+				}
+
+				// The writer signals the space event after releasing slots if it sees a waiter. The timeout covers
+				// a release that happens between the check above and the increment below
+				InterlockedIncrement(&m_nrSpaceWaiters);
+				m_workEvent.Signal();
+				m_spaceEvent.Wait(10);
+				InterlockedDecrement(&m_nrSpaceWaiters);
+				pos = m_enqueuePos;
+			}
+		}
+
+		slot->m_tzBias = TzBias(tzi);
+		slot->m_datePart = datePart;
+		slot->m_timePart = timePart;
+		slot->m_entry.Set(entry);
+		InterlockedExchange64(&slot->m_seq, pos + 1);
 
-				OpenLog(tzBias, datePart, timePart);
+		// Wake the writer only if it is idle, or about to become idle. The writer re-checks the ring buffer after setting the flag
+		if (InterlockedCompareExchange(&m_writerIdle, 0, 1) == 1)
+			m_workEvent.Signal();
+	}
+
+
+	bool TextLog::WriteBatch()
+	{
+		enum { MaxRetainedEntryCap = 64 * 1024 };
+
+		m_writeBuf.Clear();
+		TzBias tzBias;
+		uint datePart {}, timePart {};
+		uint64 nrEntries {};
+		bool const autoRollover = (0 != (m_flags & Flags::AutoRollover));
+
+		while (m_writeBuf.Len() < m_asyncParams.m_maxWriteBytes && DequeueReady())
+		{
+			Slot& slot = m_ring[(sizet) (m_dequeuePos & m_ringMask)];
+			if (!nrEntries)
+			{
+				tzBias = slot.m_tzBias;
+				datePart = slot.m_datePart;
+				timePart = slot.m_timePart;
 			}
+			else if (autoRollover && (slot.m_tzBias != tzBias || slot.m_datePart != datePart))
+				break;		// Entry belongs to the next log file
+
+			m_writeBuf.Add(slot.m_entry);
+			if (slot.m_entry.Cap() > MaxRetainedEntryCap)
+				slot.m_entry.Free();
+
+			InterlockedExchange64(&slot.m_seq, m_dequeuePos + m_ringMask + 1);
+			++m_dequeuePos;
+			++nrEntries;
 		}
 
-		DWORD bytesWritten;
-		if (!WriteFile(m_h, entry.p, NumCast<DWORD>(entry.n), &bytesWritten, 0))
+		if (!nrEntries)
+			return false;
+
+		if (m_nrSpaceWaiters != 0)
+			m_spaceEvent.Signal();
+
 		{
-			DWORD rc = GetLastError();
-			throw WinErr<>(rc, Str("Error in WriteFile for ").Add(m_curLogPath));
+			Locker locker { m_mx };
+
+			try
+			{
+				if (autoRollover)
+					RolloverIfNeeded(tzBias, datePart, timePart);
+
+				WriteToLog(m_writeBuf);
+				++m_asyncStats.m_nrWrites;
+				m_asyncStats.m_nrBytes += m_writeBuf.Len();
+			}
+			catch (std::exception const&)
+			{
+				++m_asyncStats.m_nrWriteErrors;
+			}
+
+			m_asyncStats.m_nrEntries += nrEntries;
 		}
 
-		if (bytesWritten != entry.n)
-			throw StrErr(Str("Unexpected number of bytes written to ").Add(m_curLogPath));
+		InterlockedExchange64(&m_writtenPos, m_dequeuePos);
+		m_writtenEvent.Signal();
+		return true;
+	}
+
+
+	void TextLog::WriterMain(Event& stopEvent)
+	{
+		while (true)
+		{
+			if (WriteBatch())
+				continue;
+
+			InterlockedExchange(&m_writerIdle, 1);
+			if (DequeueReady())
+			{
+				InterlockedExchange(&m_writerIdle, 0);
+				continue;
+			}
+
+			if (stopEvent.IsSignaled())
+				break;
+
+			Wait2(stopEvent.Handle(), m_workEvent.Handle(), INFINITE);
+			InterlockedExchange(&m_writerIdle, 0);
+		}
 	}
 
 
@@ -1,27 +1,84 @@
 #pragma once
 
+#include "AtEvent.h"
 #include "AtMutex.h"
 #include "AtStr.h"
+#include "AtThread.h"
 #include "AtTime.h"
 
 
 namespace At
 {
 
+	// With Flags::Async, WriteEntry copies the preformatted entry into a bounded ring buffer and returns without waiting for
+	// the disk. A writer thread concatenates queued entries and writes them with one WriteFile call per batch, which matters
+	// because the log is opened with FILE_FLAG_WRITE_THROUGH. A batch ends where a rollover is due, so each entry still goes
+	// to the log file for its own date. When the ring buffer is full, AsyncParams::m_overflow decides whether WriteEntry waits
+	// for space, or discards the entry. Either event is counted in AsyncStats. Errors writing a batch cannot be reported to
+	// the caller that queued the entries, so they are counted instead. The writer thread runs under a StopCtl owned by the log,
+	// which the destructor stops, so queued entries are written before destruction completes.
+
 	class TextLog : NoCopy
 	{
 	public:
 		virtual ~TextLog();
 
-		struct Flags { enum E : uint { AutoRollover = 1, CreateUnique = 2 }; };
+		struct Flags { enum E : uint { AutoRollover = 1, CreateUnique = 2, Async = 4 }; };
+
+		struct AsyncParams
+		{
+			enum class Overflow { Block, Drop };
+
+			sizet    m_maxEntries    { 4096 };			// Must be a power of 2
+			Overflow m_overflow      { Overflow::Block };
+			sizet    m_maxWriteBytes { 1024 * 1024 };	// A batch may exceed this by at most one entry
+		};
+
+		struct AsyncStats
+		{
+			uint64 m_nrEntries     {};		// Entries written, or lost in a failed write
+			uint64 m_nrWrites      {};
+			uint64 m_nrBytes       {};
+			uint64 m_nrDropped     {};		// Entries discarded because the ring buffer was full
+			uint64 m_nrBlocked     {};		// Calls to WriteEntry that waited because the ring buffer was full
+			uint64 m_nrWriteErrors {};
+		};
+
+		void Init(Seq baseName, uint flags) { Init(baseName, flags, AsyncParams()); }
+		void Init(Seq baseName, uint flags, AsyncParams const& asyncParams);
+
+		// In async mode, blocks until entries queued before the call have been written. In synchronous mode, returns immediately
+		void Flush();
+
+		AsyncStats GetAsyncStats();
 
-		void Init(Seq baseName, uint flags);
+		Str CurLogPath() { Locker locker { m_mx }; return m_curLogPath; }
 
 	protected:
 		void WriteEntry(Time now, TzInfo const& tzi, Seq entry);
 		static void Enc_EntryTime(Enc& s, Time entryTime, TzInfo const& tzi);
 
 	private:
+		class Writer : public Thread
+		{
+		public:
+			void SetLog(TextLog* log) { EnsureThrow(!Started()); m_log = log; }
+
+		private:
+			TextLog* m_log {};
+
+			void ThreadMain() override final { m_log->WriterMain(StopEvent()); }
+		};
+
+		struct Slot
+		{
+			LONG64 volatile m_seq      {};
+			TzBias          m_tzBias;
+			uint            m_datePart {};
+			uint            m_timePart {};
+			Str             m_entry;
+		};
+
 		Mutex  m_mx;
 
 		uint   m_flags {};
@@ -32,8 +89,35 @@ namespace At
 		Str    m_curLogPath;
 		HANDLE m_h { INVALID_HANDLE_VALUE };
 
+		// Async mode. Producers claim slots by advancing m_enqueuePos, and publish a filled slot by setting its m_seq to
+		// its position + 1. The writer thread consumes slots in order, and releases each by setting m_seq to position + capacity
+		AsyncParams     m_asyncParams;
+		Vec<Slot>       m_ring;
+		LONG64          m_ringMask         {};
+		LONG64 volatile m_enqueuePos       {};
+		LONG64          m_dequeuePos       {};		// Accessed only by the writer thread
+		LONG64 volatile m_writtenPos       {};
+		LONG volatile   m_writerIdle       {};
+		LONG volatile   m_nrSpaceWaiters   {};
+		LONG64 volatile m_nrDropped        {};
+		LONG64 volatile m_nrBlocked        {};
+		AsyncStats      m_asyncStats;				// Protected by m_mx, except m_nrDropped and m_nrBlocked
+		Str             m_writeBuf;					// Accessed only by the writer thread
+		Event           m_workEvent        { Event::CreateAuto };
+		Event           m_spaceEvent       { Event::CreateAuto };
+		Event           m_writtenEvent     { Event::CreateAuto };
+		Rp<StopCtl>     m_writerStopCtl;
+		ThreadPtr<Writer> m_writer;
+
 		void GetLocalTimeRep(Time now, TzInfo const& tzi, uint& datePart, uint& timePart);
 		void OpenLog(TzBias tzBias, uint datePart, uint timePart);
+		void RolloverIfNeeded(TzBias tzBias, uint datePart, uint timePart);
+		void WriteToLog(Seq data);
+
+		void EnqueueEntry(Time now, TzInfo const& tzi, Seq entry);
+		bool DequeueReady() const { return m_ring[(sizet) (m_dequeuePos & m_ringMask)].m_seq == m_dequeuePos + 1; }
+		bool WriteBatch();
+		void WriterMain(Event& stopEvent);
 	};
 
 }
@@ -3,8 +3,8 @@
 
 #include "AtDllKernel32.h"
 #include "AtException.h"
+#include "AtInitOnFirstUse.h"
 #include "AtNumCvt.h"
-#include "AtSpinLock.h"
 #include "AtWinErr.h"
 
 #pragma warning (push)
@@ -75,24 +75,146 @@ namespace At
 	namespace
 	{
 		// These global objects MUST be initialized before code that may call Time::StrictNow().
-		SpinLock a_strictNowLock;
-		uint64 a_strictNowLastRet = 0;
+		LONG64 volatile a_strictNowLastRet = 0;
 	}
 
 	Time Time::StrictNow()
 	{
 		Time t { NonStrictNow() };
-		a_strictNowLock.Acquire();
-		
-		if (t.m_ft <= a_strictNowLastRet)
-			t.m_ft = a_strictNowLastRet + 1;
-		a_strictNowLastRet = t.m_ft;
 
-		a_strictNowLock.Release();
+		// On x86, this initial read may be torn. This is harmless: compare-and-swap will fail, and will return the actual value
+		LONG64 prev = a_strictNowLastRet;
+		while (true)
+		{
+			uint64 next = t.m_ft;
+			if (next <= (uint64) prev)
+				next = ((uint64) prev) + 1;
+
+			LONG64 observed = InterlockedCompareExchange64(&a_strictNowLastRet, (LONG64) next, prev);
+			if (observed == prev)
+			{
+				t.m_ft = next;
+				return t;
+			}
+
+			prev = observed;
+		}
+	}
+
+
+	namespace
+	{
+		struct FastClock
+		{
+			bool   m_useTsc      {};
+			uint64 m_baseTsc     {};
+			uint64 m_baseFt      {};
+			uint64 m_tscPerSec   {};
+			uint64 m_ftPerTscQ40 {};		// FILETIME units per TSC tick, as a fixed point number with 40 fractional bits
+		};
+
+		LONG volatile a_fastClock_initFlag {};
+		LONG volatile a_fastClock_ready    {};
+		FastClock     a_fastClock;
+
+
+		bool HaveInvariantTsc()
+		{
+			int regs[4] {};
+			__cpuid(regs, (int) 0x80000000U);
+			if (((uint) regs[0]) < 0x80000007U)
+				return false;
+
+			__cpuid(regs, (int) 0x80000007U);
+			return (regs[3] & (1 << 8)) != 0;
+		}
+
+
+		void CalibrateFastClock()
+		{
+			if (!HaveInvariantTsc())
+				return;
+
+			LARGE_INTEGER qpcFreq;
+			if (!QueryPerformanceFrequency(&qpcFreq) || qpcFreq.QuadPart <= 0)
+				return;
+
+			// Measure TSC frequency against the performance counter over about 10 ms
+			LARGE_INTEGER qpcStart, qpcEnd;
+			QueryPerformanceCounter(&qpcStart);
+			uint64 tscStart = __rdtsc();
+
+			int64 qpcTarget = qpcStart.QuadPart + (qpcFreq.QuadPart / 100);
+			do
+			{
+				Sleep(1);
+				QueryPerformanceCounter(&qpcEnd);
+			}
+			while (qpcEnd.QuadPart < qpcTarget);
+
+			uint64 tscEnd = __rdtsc();
+			if (tscEnd <= tscStart)
+				return;
+
+			double tscPerSec = ((double) (tscEnd - tscStart)) * ((double) qpcFreq.QuadPart) / ((double) (qpcEnd.QuadPart - qpcStart.QuadPart));
+			if (tscPerSec < 1e6)
+				return;
+
+			a_fastClock.m_tscPerSec = (uint64) tscPerSec;
+			a_fastClock.m_ftPerTscQ40 = (uint64) (10000000.0 * 1099511627776.0 / tscPerSec);
+			a_fastClock.m_baseFt = Time::NonStrictNow().ToFt();
+			a_fastClock.m_baseTsc = __rdtsc();
+			a_fastClock.m_useTsc = true;
+		}
+
+
+		inline void EnsureFastClockCalibrated()
+		{
+			if (!a_fastClock_ready)
+			{
+				InitOnFirstUse(&a_fastClock_initFlag, CalibrateFastClock);
+				InterlockedExchange(&a_fastClock_ready, 1);
+			}
+		}
+	}
+
+
+	Time Time::FastNow()
+	{
+		EnsureFastClockCalibrated();
+
+		Time t;
+		if (!a_fastClock.m_useTsc)
+			GetSystemTimeAsFileTime((LPFILETIME) &t.m_ft);
+		else
+		{
+			// TSCs of different cores may be very slightly out of sync. Do not return a time before calibration
+			uint64 tsc = __rdtsc();
+			uint64 ticks {};
+			if (tsc > a_fastClock.m_baseTsc)
+				ticks = tsc - a_fastClock.m_baseTsc;
+
+		#ifdef _M_X64
+			uint64 hi;
+			uint64 lo = _umul128(ticks, a_fastClock.m_ftPerTscQ40, &hi);
+			t.m_ft = a_fastClock.m_baseFt + __shiftright128(lo, hi, 40);
+		#else
+			uint64 f = a_fastClock.m_tscPerSec;
+			t.m_ft = a_fastClock.m_baseFt + ((ticks / f) * 10000000ULL) + (((ticks % f) * 10000000ULL) / f);
+		#endif
+		}
+
 		return t;
 	}
 
 
+	bool Time::FastNowUsesTsc()
+	{
+		EnsureFastClockCalibrated();
+		return a_fastClock.m_useTsc;
+	}
+
+
 	Time Time::UtcToLocal() const
 	{
 		Time t;
@@ -79,8 +79,18 @@ namespace At
 		// Normally, the return value will be the result of GetSystemTimeAsFileTime().
 		// However, whenever the result would be lower than, or equal to, a value returned by a previous call,
 		// the function will return the previously returned value plus one.
+		// Does not take a lock: the last returned value is advanced using compare-and-swap, so concurrent callers do not serialize.
 		static Time StrictNow();
 
+		// Returns a cheap approximation of the current time in UTC, for instrumentation and cache aging.
+		// On CPUs with an invariant TSC, the value is derived from __rdtsc(), calibrated once against the system clock on first use.
+		// Adjustments to the system clock after calibration are not reflected. Without an invariant TSC, falls back to GetSystemTimeAsFileTime().
+		// Values are not unique, and should not be persisted or compared with times obtained from other sources.
+		static Time FastNow();
+
+		// Returns true if FastNow() is TSC-based. Triggers calibration if not yet performed.
+		static bool FastNowUsesTsc();
+
 		// Converts the current value (assumed to be in UTC) to local time on the current computer.
 		Time UtcToLocal() const;
 
@@ -162,10 +162,6 @@ namespace At
 
 		void FindUrisInText(Seq text, Seq prefixes, Vec<Seq>& uris, ParseTree::Storage* storage)
 		{
-			ParseTree::Storage localStorage;
-			if (!storage)
-				storage = &localStorage;
-
 			Seq reader { text };
 			while (reader.n)
 			{
@@ -1,14 +1,19 @@
 #pragma once
 
-#include "AtMem.h"
 #include "AtNum.h"
+#include "AtSlabAlloc.h"
 
 
 namespace At
 {
 
+	// Allocator for VecBaseHeap memory. Mem allocates all blocks from the process heap. SlabAlloc serves small blocks
+	// from thread-cached size-class slabs, and keeps statistics per MemArena
+	typedef SlabAlloc VecHeapAlloc;
+
+
 	// A base for container implementations. Not to be used directly.
-	// Uses an efficient OS allocator to allocate underlying memory. Does not construct objects that are not in use.
+	// Uses VecHeapAlloc to allocate underlying memory. Does not construct objects that are not in use.
 
 	template <class T>
 	class VecBaseHeap
@@ -35,7 +40,7 @@ namespace At
 		void FreeMem() noexcept
 		{
 			if (Cap())
-				Mem::Free<T>(u_mem);
+				VecHeapAlloc::Free<T>(u_mem);
 
 			u_mem = nullptr;
 			m_cap = 0;
@@ -67,7 +72,7 @@ namespace At
 				{
 					if (!u_fix)
 					{
-						u_mem = Mem::Alloc<T>(newCap);
+						u_mem = VecHeapAlloc::Alloc<T>(newCap);
 						m_cap = newCap;
 					}
 					else
@@ -77,7 +82,7 @@ namespace At
 						else
 							throw OutOfFixedStorage();
 
-						u_mem = Mem::Alloc<T>(newCap);
+						u_mem = VecHeapAlloc::Alloc<T>(newCap);
 						m_cap = SizeHiBit | newCap;
 					}
 				}
@@ -86,11 +91,11 @@ namespace At
 					if (FixedCap())
 						throw OutOfFixedStorage();
 
-					if (Mem::ReAllocInPlace<T>(u_mem, newCap))
+					if (VecHeapAlloc::ReAllocInPlace<T>(u_mem, newCap))
 						m_cap = newCap;
 					else
 					{
-						T* newMem { Mem::Alloc<T>(newCap) };
+						T* newMem { VecHeapAlloc::Alloc<T>(newCap) };
 
 						if (std::is_trivially_move_constructible<T>::value &&
 							std::is_trivially_destructible<T>::value)
@@ -111,7 +116,7 @@ namespace At
 						}
 
 						Mem::Zero<T>(u_mem, m_len);
-						Mem::Free<T>(u_mem);
+						VecHeapAlloc::Free<T>(u_mem);
 						u_mem = newMem;
 						m_cap = newCap;
 					}
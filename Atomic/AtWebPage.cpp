@@ -3,6 +3,7 @@
 
 #include "AtHtmlBuilder.h"
 #include "AtPwHash.h"
+#include "AtPwHashService.h"
 
 
 namespace At
@@ -17,6 +18,7 @@ namespace At
 		case WebLoginResult::Success:				return "Login successful";
 		case WebLoginResult::AttemptsTooFrequent:	return "You are trying to log in too frequently; please try again in a little bit";
 		case WebLoginResult::InvalidCredentials:	return "Invalid credentials";
+		case WebLoginResult::ServerBusy:			return "The server is processing too many logins; please try again in a little bit";
 		default:									return "<unrecognized login error>";
 		}
 	}
@@ -226,9 +228,18 @@ namespace At
 			return WebLoginResult::AttemptsTooFrequent;
 
 		appUser = GetAppUser(store, user);
+
+		PwHashService::Status status;
+		bool match {};
 		if (!appUser.Any())
-			PwHash::DummyVerify(password);
-		else if (PwHash::Verify(password, appUser->f_pwHash))
+			status = PwHashService::Global().DummyVerify(password, PwHashService::DefaultDeadline());
+		else
+			status = PwHashService::Global().Verify(password, appUser->f_pwHash, match, PwHashService::DefaultDeadline());
+
+		// Overload is not a login failure, and must not be throttled as one
+		if (status != PwHashService::Status::Done)
+			return WebLoginResult::ServerBusy;
+		if (match)
 			return WebLoginResult::Success;
 
 		g_webLoginThrottle.AddLoginFailure(user, remoteIdAddr);
@@ -23,7 +23,7 @@ namespace At
 
 	struct WebLoginResult
 	{
-		enum E { None, Success, AttemptsTooFrequent, InvalidCredentials };
+		enum E { None, Success, AttemptsTooFrequent, InvalidCredentials, ServerBusy };
 		static char const* Describe(E n);
 	};
 
@@ -2,7 +2,9 @@
 #include "AtWebRequestHandler.h"
 
 #include "AtBaseXY.h"
+#include "AtDeflate.h"
 #include "AtNumCvt.h"
+#include "AtStaticAssets.h"
 #include "AtTime.h"
 #include "AtToken.h"
 #include "AtWinStr.h"
@@ -12,6 +14,7 @@ namespace At
 {
 
 	SymCrypt WebRequestHandler::s_symCrypt;
+	MemArena WebRequestHandler::s_memArena { "WebRequest" };
 
 
 	void WebRequestHandler::StaticInit()
@@ -322,4 +325,146 @@ namespace At
 		}
 	}
 
+
+	void WebRequestHandler::SetStaticAssetResponse(Seq fileName)
+	{
+		StaticAsset const* asset = g_staticAssets.FindByFileName(fileName);
+		if (!asset)
+			throw HttpRequest::Error(HttpStatus::NotFound);
+
+		// Asset content is static and outlives the response, so it need not be copied
+		AddResponseBodyChunk_NoCopy(asset->m_content);
+
+		SetResponseStatus(HttpStatus::OK);
+		SetResponseContentType(asset->m_contentType);
+		SetResponseHeader_CacheControl(StaticAssets::CacheControl());
+		SetResponseCompression();
+	}
+
+
+	namespace
+	{
+		enum class ContentCoding { Identity, Gzip, Deflate };
+
+		bool IsZeroQValue(Seq q)
+		{
+			auto isZeroDigitOrDot = [] (uint c) -> bool { return c == '0' || c == '.'; };
+			return q.StartsWithExact("0") && !q.DropByte().ContainsAnyByteNotOfType(isZeroDigitOrDot);
+		}
+
+		// Prefers gzip, which is the most widely supported. A coding is accepted if it is listed with a non-zero quality value,
+		// or if it is not listed, and "*" is listed with a non-zero quality value
+		ContentCoding NegotiateContentCoding(Seq acceptEncoding)
+		{
+			bool gzipListed {}, gzipOk {}, deflateListed {}, deflateOk {}, anyOk {};
+
+			while (acceptEncoding.n)
+			{
+				Seq elem = acceptEncoding.ReadToByte(',');
+				acceptEncoding.DropByte();
+
+				Seq coding = elem.ReadToByte(';').Trim();
+				bool ok = true;
+				while (elem.n)
+				{
+					elem.DropByte();
+					Seq param = elem.ReadToByte(';').Trim();
+					if (param.StripPrefixInsensitive("q="))
+						ok = !IsZeroQValue(param);
+				}
+
+				     if (coding.EqualInsensitive("gzip") || coding.EqualInsensitive("x-gzip")) { gzipListed    = true; gzipOk    = ok; }
+				else if (coding.EqualInsensitive("deflate"))                                   { deflateListed = true; deflateOk = ok; }
+				else if (coding.EqualInsensitive("*"))                                         { anyOk         = ok;                 }
+			}
+
+			if (gzipListed    ? gzipOk    : anyOk) return ContentCoding::Gzip;
+			if (deflateListed ? deflateOk : anyOk) return ContentCoding::Deflate;
+			return ContentCoding::Identity;
+		}
+
+
+		bool IsCompressibleContentType(Seq contentType)
+		{
+			Seq mediaType = contentType.ReadToByte(';').Trim();
+			if (mediaType.StartsWithInsensitive("text/"))
+				return true;
+
+			if (mediaType.EqualInsensitive("application/json")       ||
+				mediaType.EqualInsensitive("application/javascript") ||
+				mediaType.EqualInsensitive("application/xml")        ||
+				mediaType.EqualInsensitive("image/svg+xml"))
+				return true;
+
+			// Structured syntax suffixes, as in application/xhtml+xml and application/ld+json
+			return mediaType.EndsWithInsensitive("+xml") || mediaType.EndsWithInsensitive("+json");
+		}
+	}
+
+
+	void WebRequestHandler::CompressResponse(HttpRequest& req)
+	{
+		if (!m_compressResponse || !m_responseBodyChunks.Any())
+			return;
+
+		if (m_response.StatusCode == HttpStatus::PartialContent)
+			return;
+
+		HTTP_KNOWN_HEADER const* knownHeaders = m_response.Headers.KnownHeaders;
+		if (knownHeaders[HttpHeaderContentEncoding].RawValueLength)
+			return;
+
+		if (!IsCompressibleContentType(Seq(knownHeaders[HttpHeaderContentType].pRawValue, knownHeaders[HttpHeaderContentType].RawValueLength)))
+			return;
+
+		sizet bodyLen {};
+		for (HTTP_DATA_CHUNK const& chunk : m_responseBodyChunks)
+		{
+			if (chunk.DataChunkType != HttpDataChunkFromMemory)
+				return;
+
+			bodyLen += chunk.FromMemory.BufferLength;
+		}
+
+		if (bodyLen < ResponseCompressionMinBytes)
+			return;
+
+		// Caches must now distinguish responses by Accept-Encoding, even if this request does not accept compression
+		Seq vary { knownHeaders[HttpHeaderVary].pRawValue, knownHeaders[HttpHeaderVary].RawValueLength };
+		if (!vary.n)
+			SetKnownResponseHeader(HttpHeaderVary, "Accept-Encoding");
+		else
+			SetKnownResponseHeader(HttpHeaderVary, Str::Join(vary, ", Accept-Encoding"));
+
+		ContentCoding coding = NegotiateContentCoding(req.RawKnownHeader(HttpHeaderAcceptEncoding));
+		if (coding == ContentCoding::Identity)
+			return;
+
+		Seq compressed;
+		if (coding == ContentCoding::Gzip && m_responseBodyChunks.Len() == 1)
+		{
+			HTTP_DATA_CHUNK const& chunk = m_responseBodyChunks[0];
+			StaticAsset const* asset = g_staticAssets.FindByContent(Seq(chunk.FromMemory.pBuffer, chunk.FromMemory.BufferLength));
+			if (asset)
+				compressed = g_staticAssets.GzipContent(*asset);
+		}
+
+		if (!compressed.n)
+		{
+			DeflateEncoder encoder { m_compressedBody, (coding == ContentCoding::Gzip) ? DeflateEncoder::Format::Gzip : DeflateEncoder::Format::Zlib };
+			for (HTTP_DATA_CHUNK const& chunk : m_responseBodyChunks)
+				encoder.Write(Seq(chunk.FromMemory.pBuffer, chunk.FromMemory.BufferLength));
+			encoder.Finish();
+
+			compressed = m_compressedBody;
+		}
+
+		if (compressed.n >= bodyLen)
+			return;
+
+		m_responseBodyChunks.Clear();
+		AddResponseBodyChunk_NoCopy(compressed);
+		SetKnownResponseHeader(HttpHeaderContentEncoding, (coding == ContentCoding::Gzip) ? "gzip" : "deflate");
+	}
+
 }
@@ -34,6 +34,9 @@ namespace At
 		static SymCrypt s_symCrypt;
 
 	public:
+		// Allocations made while a request is processed, see SlabAlloc::ArenaScope
+		static MemArena s_memArena;
+
 		// Initializes s_symCrypt static object.
 		// Must be called after the application has initialized At::Crypt.
 		static void StaticInit();
@@ -42,6 +45,7 @@ namespace At
 		virtual ~WebRequestHandler();
 
 		bool                      m_abortTxOnSuccess {};
+		bool                      m_compressResponse {};
 		HTTP_RESPONSE             m_response;
 		PinStore                  m_pinStore;
 		Vec<HANDLE>               m_responseHandles;
@@ -50,6 +54,11 @@ namespace At
 
 		void SetAbortTxOnSuccess() { m_abortTxOnSuccess = true; }
 		bool AbortTxOnSuccess() const { return m_abortTxOnSuccess; }
+
+		// Response compression is disabled by default. It must not be enabled for responses that include secrets, such as pages
+		// for an authenticated session or CSRF tokens, together with content that can be influenced by an attacker. Attacks such
+		// as BREACH can infer the secrets from the compressed size. SetStaticAssetResponse enables compression for static assets.
+		void SetResponseCompression() { m_compressResponse = true; }
 	
 		Seq  AddResponseStr              (Seq s)    { return m_pinStore.AddStr(s); }
 		void AddResponseHandle           (HANDLE h) { m_responseHandles.Add(h); }
@@ -97,6 +106,20 @@ namespace At
 		
 		void SetRedirectResponse (uint statusCode, Seq uri);
 		void SetFileResponse     (Seq fullPath, Seq contentType);
+
+		// Responds with a static asset registered in g_staticAssets, with a long-lived Cache-Control.
+		// Throws HttpRequest::Error with HttpStatus::NotFound if there is no asset with the file name.
+		void SetStaticAssetResponse(Seq fileName);
+
+		// Called by the web server thread after the response is generated. Compresses the response body if all of the following are true:
+		// - compression has been enabled with SetResponseCompression;
+		// - the request accepts the gzip or deflate content coding;
+		// - the Content-Type is text, or an application type that is text, such as JSON, JavaScript or XML;
+		// - the response does not already have a Content-Encoding, and is not a partial response;
+		// - the body consists of memory chunks totaling at least ResponseCompressionMinBytes, and compresses to a smaller size.
+		// A body consisting of a registered static asset is taken from the cache of compressed assets in g_staticAssets.
+		enum { ResponseCompressionMinBytes = 1000 };
+		void CompressResponse(HttpRequest& req);
 	
 	public:
 		// Should process the HTTP request. Can optionally generate the response to send in m_response, and return ReqResult::Done.
@@ -116,6 +139,8 @@ namespace At
 		virtual void GenResponse(HttpRequest& req) = 0;
 
 	private:
+		Str m_compressedBody;
+
 		void UpdateResponseEntityChunksPtr();
 
 		void AddCookie          (Seq name, Seq value, Seq domain, Seq path, CookieSecure::E secure, CookieHttpOnly::E httpOnly, int expiresSeconds);
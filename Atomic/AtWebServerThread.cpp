@@ -9,6 +9,9 @@ namespace At
 	template <class WorkPoolType>
 	void WebServerThread<WorkPoolType>::ProcessRequest(Rp<WebRequestHandlerCreator> const& reqHandlerCreator, HttpRequest& req)
 	{
+		// Attribute allocations to the request arena until the request handler, including its PinStore, is destroyed
+		SlabAlloc::ArenaScope arenaScope { WebRequestHandler::s_memArena };
+
 		// Log request
 		m_workPool->RequestLog().OnRequest(req);
 	
@@ -54,6 +57,9 @@ namespace At
 				reqHandler->GenResponse(req);
 			}
 
+			errMsg = "Response generated. Error compressing response";
+			reqHandler->CompressResponse(req);
+
 			if (req.IsSecure())
 			{
 				// As of August 2017, this appears to be the best universal policy. If one connection is secure,
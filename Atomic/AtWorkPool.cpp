@@ -9,6 +9,8 @@ namespace At
 
 	void WorkPoolBase::ThreadMain()
 	{
+		m_scheduler.Init(m_maxNrThreads, m_maxBacklog, m_backlogPolicy);
+
 		try { WorkPool_Run(); }
 		catch (ExecutionAborted const&) {}
 		catch (std::exception const& e) { WorkPool_LogEvent(EVENTLOG_ERROR_TYPE, Str("Stopped by exception: ").Add(e.what())); }
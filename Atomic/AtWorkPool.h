@@ -4,6 +4,7 @@
 #include "AtEvent.h"
 #include "AtLogEvent.h"
 #include "AtMutex.h"
+#include "AtTaskScheduler.h"
 #include "AtThread.h"
 #include "AtWait.h"
 
@@ -17,6 +18,10 @@ namespace At
 		// If not called, default value is used. If called, must be called before work pool is started.
 		void SetMaxNrThreads(uint maxNrThreads) { EnsureThrow(!Started()); m_maxNrThreads = maxNrThreads; }
 
+		// If not called, the backlog is unbounded. If called, must be called before work pool is started.
+		// The backlog is the number of work items enqueued, but not yet taken by a thread.
+		void SetMaxBacklog(sizet maxBacklog, BacklogPolicy::E policy) { EnsureThrow(!Started()); m_maxBacklog = maxBacklog; m_backlogPolicy = policy; }
+
 		// If execution was stopped via StopCtl, can be called before exiting to see how many threads from this WorkPool were aborted
 		ptrdiff NrThreadsAborted() const { return m_nrThreadsAborted; }
 
@@ -24,16 +29,15 @@ namespace At
 		void ThreadMain();
 
 	protected:
-		Event             m_workAvailableEvent { Event::CreateAuto };
-		Event             m_workItemTakenEvent { Event::CreateAuto };
 		uint              m_maxNrThreads       { 100 };
+		sizet             m_maxBacklog         { SIZE_MAX };
+		BacklogPolicy::E  m_backlogPolicy      { BacklogPolicy::Block };
 
 		ptrdiff volatile  m_nrThreads          {};
-		ptrdiff volatile  m_nrThreadsReady     {};
+		ptrdiff volatile  m_nrThreadsStarting  {};		// Started, but not yet looking for work items
 		ptrdiff volatile  m_nrThreadsAborted   {};
 
-		Mutex             m_mxWorkQueue;
-		std::deque<void*> m_workQueue;		// Destroyed in WorkPool<> derived template
+		TaskScheduler     m_scheduler;		// Initialized when the work pool starts. Remaining work items are freed in WorkPool<> derived template
 
 		virtual void WorkPool_Run() = 0;
 		virtual void WorkPool_LogEvent(WORD eventType, Seq text) = 0;
@@ -49,41 +53,29 @@ namespace At
 	public:
 		virtual ~WorkPool()
 		{
-			while (!m_workQueue.empty())
-			{
-				delete (WorkItemType*) m_workQueue.front();
-				m_workQueue.pop_front();
-			}
+			m_scheduler.RemoveAll( [] (void* pvWorkItem) { delete (WorkItemType*) pvWorkItem; } );
 		}
 
-		void EnqueueWorkItem(AutoFree<WorkItemType>& workItem)
+		// Does not wait for a thread to take the work item. If the backlog is full, waits for room if the policy is Block,
+		// or returns false if the policy is Reject. If false is returned, the caller still owns the work item.
+		// Starts another thread if there are more work items waiting than idle threads, up to the maximum number of threads.
+		[[nodiscard]] bool EnqueueWorkItem(AutoFree<WorkItemType>& workItem, TaskPriority::E priority = TaskPriority::Normal)
 		{
-			m_workItemTakenEvent.ClearSignal();
+			if (!m_scheduler.Enqueue(workItem.Ptr(), priority, StopEvent().Handle()))
+				return false;
 
-			{
-				Locker locker { m_mxWorkQueue };
-				m_workQueue.push_back(nullptr);
-				m_workQueue.back() = workItem.Dismiss();
-			}
-
-			m_workAvailableEvent.Signal();
+			workItem.Dismiss();
 
-			DWORD waitMs = 1000;
-			while (true)
+			sizet const nrAvailable = m_scheduler.NrIdleWorkers() + (sizet) InterlockedExchangeAdd_PtrDiff(&m_nrThreadsStarting, 0);
+			if (nrAvailable < m_scheduler.NrQueued() &&
+				InterlockedExchangeAdd_PtrDiff(&m_nrThreads, 0) < SatCast<ptrdiff>(m_maxNrThreads))
 			{
-				if (InterlockedExchangeAdd_PtrDiff(&m_nrThreadsReady, 0) < 1 &&
-					InterlockedExchangeAdd_PtrDiff(&m_nrThreads,      0) < SatCast<ptrdiff>(m_maxNrThreads))
-				{
-					ThreadPtr<ThreadType> thread { Thread::Create };
-					thread->SetWorkPool(this);
-					thread->Start(GetStopCtl());
-					waitMs = INFINITE;
-				}
-
-				DWORD waitResult = Wait2(StopEvent().Handle(), m_workItemTakenEvent.Handle(), waitMs);
-				if (0 == waitResult) throw ExecutionAborted();
-				if (1 == waitResult) break;
+				ThreadPtr<ThreadType> thread { Thread::Create };
+				thread->SetWorkPool(this);
+				thread->Start(GetStopCtl());
 			}
+
+			return true;
 		}
 	};
 
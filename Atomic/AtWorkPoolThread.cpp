@@ -17,11 +17,15 @@ namespace At
 			throw ZLitErr("AtWorkPoolThreadBase: WorkPool not set");
 
 		InterlockedIncrement_PtrDiff(&(m_workPoolBase->m_nrThreads));
+		InterlockedIncrement_PtrDiff(&(m_workPoolBase->m_nrThreadsStarting));
 	}
 
 
-	void WorkPoolThreadBase::OnThreadExit(ExitType::E)
+	void WorkPoolThreadBase::OnThreadExit(ExitType::E exitType)
 	{
+		if (exitType == ExitType::FailedToStart)
+			InterlockedDecrement_PtrDiff(&(m_workPoolBase->m_nrThreadsStarting));
+
 		InterlockedDecrement_PtrDiff(&(m_workPoolBase->m_nrThreads));
 	}
 
@@ -30,23 +34,15 @@ namespace At
 	{
 		try
 		{
-			m_workPoolBase->m_workAvailableEvent.ClearSignal();
+			TaskScheduler& scheduler = m_workPoolBase->m_scheduler;
+			uint worker = scheduler.AttachWorker();
+			OnExit autoDetach( [&] () { if (worker != TaskScheduler::NoWorker) scheduler.DetachWorker(worker); } );
+			InterlockedDecrement_PtrDiff(&(m_workPoolBase->m_nrThreadsStarting));
 
 			while (true)
 			{
-				// Attempt to grab work item from queue
-				void* pvWorkItem {};
-
-				{
-					Locker locker { m_workPoolBase->m_mxWorkQueue };
-					if (!m_workPoolBase->m_workQueue.empty())
-					{
-						pvWorkItem = m_workPoolBase->m_workQueue.front();
-						m_workPoolBase->m_workQueue.pop_front();
-					}
-				}
-
-				m_workPoolBase->m_workItemTakenEvent.Signal();
+				// Attempt to grab work item from own queue, shared queue, or another thread's queue
+				void* pvWorkItem = scheduler.TryDequeue(worker);
 
 				// If we have a work item, process it
 				if (pvWorkItem)
@@ -54,17 +50,22 @@ namespace At
 				else
 				{
 					// Wait a reasonable time for another work item
-					DWORD waitResult {};
+					DWORD const waitResult = scheduler.WaitForTask(StopEvent().Handle(), ReadyStateWaitMs);
+					if (waitResult == 0)
+						break;
 
+					if (waitResult != 1)
 					{
-						InterlockedIncrement_PtrDiff(&(m_workPoolBase->m_nrThreadsReady));
-						OnExit autoDecrement( [&] () { InterlockedDecrement_PtrDiff(&(m_workPoolBase->m_nrThreadsReady)); } );
+						// Timed out. Detach first, so that tasks in this thread's queues move to the shared queue. A task enqueued
+						// while this thread still counted as idle may have started no other thread, so keep running if any remain
+						scheduler.DetachWorker(worker);
+						worker = TaskScheduler::NoWorker;
 
-						waitResult = Wait2(StopEvent().Handle(), m_workPoolBase->m_workAvailableEvent.Handle(), ReadyStateWaitMs);
-					}
+						if (!scheduler.NrQueued())
+							break;
 
-					if (waitResult != 1)
-						break;
+						worker = scheduler.AttachWorker();
+					}
 				}
 			}
 		}
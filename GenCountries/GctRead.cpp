@@ -7,7 +7,7 @@ void GctData::ReadCountries()
 	Str filePath = JoinPath(m_opts.m_inDir.Ref(), "GeoLite2-Country-Locations-en.csv");
 	Console::Out(Str("Reading ").Add(filePath).Add("\r\n"));
 
-	FileLoader fileLoader { filePath };
+	FileLoader fileLoader { filePath, FileLoader::Mode::Map };
 	CsvReader  reader     { fileLoader, ',', 0 };
 	reader.SkipLines(1);
 
@@ -30,7 +30,7 @@ void GctData::ReadCountries()
 		countryCodesRead.Add("--");
 	}
 
-	Vec<Str> fields;
+	Vec<Seq> fields;
 	sizet nrFields;
 	while (reader.ReadRecord(fields, nrFields))
 	{
@@ -101,11 +101,11 @@ void GctData::ReadIps(Seq fileName, IpData& ipData)
 	Str filePath = JoinPath(m_opts.m_inDir.Ref(), fileName);
 	Console::Out(Str("Reading ").Add(filePath).Add("\r\n"));
 
-	FileLoader fileLoader { filePath };
+	FileLoader fileLoader { filePath, FileLoader::Mode::Map };
 	CsvReader  reader     { fileLoader, ',', 0 };
 	reader.SkipLines(1);
 
-	Vec<Str> fields;
+	Vec<Seq> fields;
 	sizet nrFields;
 	while (reader.ReadRecord(fields, nrFields))
 	{
@@ -130,7 +130,7 @@ void GctData::ReadIps(Seq fileName, IpData& ipData)
 			if (x.m_sigBits == 0 || x.m_sigBits == UINT16_MAX)
 				throw StrErr(Str("Invalid sigBits at line ").UInt(reader.LineNr()).Add(": ").Add(fields[0]));
 
-			if (!fields[1].Any())
+			if (!fields[1].n)
 				x.m_geoNameId = 0;
 			else
 			{
@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <exception>
 #include <string>
+#include <type_traits>
 #include <vector>
 #define IPTOCOUNTRY_HEADERS_INCLUDED
 #endif
@@ -96,13 +97,21 @@ public:
 	// - The IPv4 and IPv6 blocks aren't read until needed. This allows an application to avoid
 	//   the memory overhead of loading e.g. IPv6 data when only IPv4 is needed, or vice versa.
 	//   Using the MaxMind GeoLite2 Country database from February 2017, the memory overhead is
-	//   about 2 MB for IPv4 blocks, and 1 MB for IPv6.
+	//   about 2 MB for IPv4 blocks, and 1 MB for IPv6. The search tree built for each section
+	//   adds up to about as much again.
 
 	Country const* FindCountryByIp4(unsigned char const* ip);
 	Country const* FindCountryByIp6(unsigned char const* ip);
 
 	Country const* FindCountryByIp(unsigned char const* ip, size_t ipBytes);
 
+	// Batch lookups. The addresses are consecutive in "ips": 4 bytes each for IPv4, 16 bytes each for IPv6.
+	// A result is stored in "countries" for each address, following the same rules as single lookups.
+	// Searches in a batch proceed in lockstep, so that their memory accesses overlap.
+
+	void FindCountriesByIp4(unsigned char const* ips, size_t nrIps, Country const** countries);
+	void FindCountriesByIp6(unsigned char const* ips, size_t nrIps, Country const** countries);
+
 private:
 	class Reader
 	{
@@ -171,14 +180,57 @@ private:
 		byte          m_countryIndex;
 	};
 
-	std::vector<IpBlock< 4>> m_ip4Blocks;
-	std::vector<IpBlock<16>> m_ip6Blocks;
+	// Search keys, as in Atomic's AtIpRangeIndex.h
+
+	struct Ip6Key
+	{
+		unsigned long long m_hi;
+		unsigned long long m_lo;
+
+		bool operator<= (Ip6Key const& x) const { return m_hi < x.m_hi || (m_hi == x.m_hi && m_lo <= x.m_lo); }
+	};
+
+	static void ReadIpKey (unsigned char const* ip, unsigned int& key);
+	static void ReadIpKey (unsigned char const* ip, Ip6Key& key);
+	static void SetMaxKey (unsigned int& key) { key = 0xFFFFFFFFU; }
+	static void SetMaxKey (Ip6Key& key)       { key.m_hi = key.m_lo = 0xFFFFFFFFFFFFFFFFULL; }
+
+	// Block start addresses are stored in the padded Eytzinger layout described for IpRangeTree in Atomic's AtIpRangeIndex.h.
+	// m_tree has 2^m_height entries, and a search takes m_height steps.
+
+	template <int IpBytes>
+	struct IpSection
+	{
+		typedef typename std::conditional<IpBytes == 4, unsigned int, Ip6Key>::type Key;
+
+		std::vector<IpBlock<IpBytes>> m_blocks;
+		std::vector<Key>              m_tree;
+		unsigned int                  m_height {};
+	};
+
+	IpSection< 4> m_ip4;
+	IpSection<16> m_ip6;
+
+	void ReadIp4Section();
+	void ReadIp6Section();
+
+	template <int IpBytes>
+	void ReadIpSection(IpSection<IpBytes>& section, LONG sectionOffset, unsigned int sectionBytes);
 
 	template <int IpBytes>
-	void ReadIpSection(std::vector<IpBlock<IpBytes>>& ipBlocks, LONG sectionOffset, unsigned int sectionBytes);
+	static void BuildIpTree(IpSection<IpBytes>& section);
 
 	template <int IpBytes>
-	Country const* FindCountryByIpImpl(std::vector<IpBlock<IpBytes>> const& ipBlocks, unsigned char const* ip) const;
+	Country const* FindCountryByIpImpl(IpSection<IpBytes> const& section, unsigned char const* ip) const;
+
+	template <int IpBytes>
+	void FindCountriesByIpImpl(IpSection<IpBytes> const& section, unsigned char const* ips, size_t nrIps, Country const** countries) const;
+
+	template <int IpBytes>
+	Country const* MatchBlock(IpSection<IpBytes> const& section, unsigned char const* ip, size_t treeIndex) const;
+
+	template <class Key>
+	static void PrefetchTreeNode(std::vector<Key> const& tree, size_t k);
 
 	static void SetIpToStartOfSubNet (unsigned char* ip, unsigned int ipBytes, unsigned int sigBits);
 	static void SetIpToEndOfSubNet   (unsigned char* ip, unsigned int ipBytes, unsigned int sigBits);
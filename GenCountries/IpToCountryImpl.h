@@ -109,14 +109,8 @@ IpToCountry::Country const* IpToCountry::FindCountryByIp4(unsigned char const* i
 	if (!m_initialized)
 		throw NotInitialized();
 
-	if (!m_ip4SectionRead)
-		CallOnce(m_ip4CallOnceState, [this]
-			{
-				ReadIpSection<4>(m_ip4Blocks, (LONG) (HeaderBytes + m_countriesBytes), m_ip4Bytes);
-				m_ip4SectionRead = true;
-			} );
-
-	return FindCountryByIpImpl<4>(m_ip4Blocks, ip);
+	ReadIp4Section();
+	return FindCountryByIpImpl<4>(m_ip4, ip);
 }
 
 
@@ -125,14 +119,8 @@ IpToCountry::Country const* IpToCountry::FindCountryByIp6(unsigned char const* i
 	if (!m_initialized)
 		throw NotInitialized();
 
-	if (!m_ip6SectionRead)
-		CallOnce(m_ip6CallOnceState, [this]
-			{
-				ReadIpSection<16>(m_ip6Blocks, (LONG) (HeaderBytes + m_countriesBytes + m_ip4Bytes), m_ip6Bytes);
-				m_ip6SectionRead = true;
-			} );
-
-	return FindCountryByIpImpl<16>(m_ip6Blocks, ip);
+	ReadIp6Section();
+	return FindCountryByIpImpl<16>(m_ip6, ip);
 }
 
 
@@ -148,6 +136,43 @@ IpToCountry::Country const* IpToCountry::FindCountryByIp(unsigned char const* ip
 }
 
 
+void IpToCountry::FindCountriesByIp4(unsigned char const* ips, size_t nrIps, Country const** countries)
+{
+	if (!m_initialized)
+		throw NotInitialized();
+
+	ReadIp4Section();
+	FindCountriesByIpImpl<4>(m_ip4, ips, nrIps, countries);
+}
+
+
+void IpToCountry::FindCountriesByIp6(unsigned char const* ips, size_t nrIps, Country const** countries)
+{
+	if (!m_initialized)
+		throw NotInitialized();
+
+	ReadIp6Section();
+	FindCountriesByIpImpl<16>(m_ip6, ips, nrIps, countries);
+}
+
+
+void IpToCountry::ReadIpKey(unsigned char const* ip, unsigned int& key)
+{
+	key = (((unsigned int) ip[0]) << 24) | (((unsigned int) ip[1]) << 16) | (((unsigned int) ip[2]) << 8) | ((unsigned int) ip[3]);
+}
+
+
+void IpToCountry::ReadIpKey(unsigned char const* ip, Ip6Key& key)
+{
+	unsigned int parts[4];
+	for (unsigned int i=0; i!=4; ++i)
+		ReadIpKey(ip + 4*i, parts[i]);
+
+	key.m_hi = (((unsigned long long) parts[0]) << 32) | parts[1];
+	key.m_lo = (((unsigned long long) parts[2]) << 32) | parts[3];
+}
+
+
 void IpToCountry::ReadFromFile(void* p, unsigned int n)
 {
 	DWORD bytesRead {};
@@ -224,8 +249,10 @@ void IpToCountry::ReadCountries()
 
 
 template <int IpBytes>
-void IpToCountry::ReadIpSection(std::vector<IpBlock<IpBytes>>& ipBlocks, LONG sectionOffset, unsigned int sectionBytes)
+void IpToCountry::ReadIpSection(IpSection<IpBytes>& section, LONG sectionOffset, unsigned int sectionBytes)
 {
+	std::vector<IpBlock<IpBytes>>& ipBlocks = section.m_blocks;
+
 	if (SetFilePointer(m_hFile, sectionOffset, 0, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
 		throw SetFilePointerFailed(GetLastError());
 
@@ -325,55 +352,152 @@ void IpToCountry::ReadIpSection(std::vector<IpBlock<IpBytes>>& ipBlocks, LONG se
 	}
 
 	reader.ExpectEnd();
+
+	BuildIpTree<IpBytes>(section);
+}
+
+
+void IpToCountry::ReadIp4Section()
+{
+	if (!m_ip4SectionRead)
+		CallOnce(m_ip4CallOnceState, [this]
+			{
+				ReadIpSection<4>(m_ip4, (LONG) (HeaderBytes + m_countriesBytes), m_ip4Bytes);
+				m_ip4SectionRead = true;
+			} );
+}
+
+
+void IpToCountry::ReadIp6Section()
+{
+	if (!m_ip6SectionRead)
+		CallOnce(m_ip6CallOnceState, [this]
+			{
+				ReadIpSection<16>(m_ip6, (LONG) (HeaderBytes + m_countriesBytes + m_ip4Bytes), m_ip6Bytes);
+				m_ip6SectionRead = true;
+			} );
 }
 
 
 template <int IpBytes>
-IpToCountry::Country const* IpToCountry::FindCountryByIpImpl(std::vector<IpBlock<IpBytes>> const& ipBlocks, unsigned char const* ip) const
+void IpToCountry::BuildIpTree(IpSection<IpBytes>& section)
 {
-	// std::lower_bound returns the first block that is greater than or equal to ip; otherwise, end() if none such found
-	auto it = std::lower_bound(ipBlocks.begin(), ipBlocks.end(), ip,
-		[] (IpBlock<IpBytes> const& block, unsigned char const* ip) -> bool
-			{ return memcmp(block.m_ip, ip, IpBytes) < 0; } );
+	typedef typename IpSection<IpBytes>::Key Key;
+
+	size_t const nrBlocks = section.m_blocks.size();
+	unsigned int height = 0;
+	while ((((size_t) 1) << height) <= nrBlocks)
+		++height;
+
+	size_t const size = ((size_t) 1) << height;
+	section.m_tree.resize(size);
+	section.m_height = height;
+	SetMaxKey(section.m_tree[0]);
 
-	if (it == ipBlocks.end())
+	// In a complete tree, the in-order rank of node k at depth d follows from the position of k within its level
+	unsigned int depth = 0;
+	for (size_t k=1; k!=size; ++k)
 	{
-		// There is no block that is greater than or equal to ip. Therefore, there must be a last block that is less than ip.
-		if (ipBlocks.empty())
-			throw InvalidNrBlocks();
+		if (k == (((size_t) 2) << depth))
+			++depth;
 
-		--it;
+		size_t rank = ((2 * (k - (((size_t) 1) << depth)) + 1) << (height - 1 - depth)) - 1;
+		Key& key = section.m_tree[k];
+		if (rank < nrBlocks)
+			ReadIpKey(section.m_blocks[rank].m_ip, key);
+		else
+			SetMaxKey(key);
 	}
-	else
+}
+
+
+template <class Key>
+void IpToCountry::PrefetchTreeNode(std::vector<Key> const& tree, size_t k)
+{
+	// Descendants of node k that are a cache line of keys below it are adjacent to each other
+	size_t const stride = 64 / sizeof(Key);
+	if (k * stride < tree.size())
+		PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, &tree[k * stride]);
+}
+
+
+template <int IpBytes>
+IpToCountry::Country const* IpToCountry::FindCountryByIpImpl(IpSection<IpBytes> const& section, unsigned char const* ip) const
+{
+	typename IpSection<IpBytes>::Key key;
+	ReadIpKey(ip, key);
+
+	size_t k = 1;
+	for (unsigned int level=0; level!=section.m_height; ++level)
 	{
-		// Block found that is greater or equal to ip.
-		if (memcmp(it->m_ip, ip, IpBytes) > 0)
+		PrefetchTreeNode(section.m_tree, k);
+		k = 2*k + (section.m_tree[k] <= key);
+	}
+
+	return MatchBlock<IpBytes>(section, ip, k);
+}
+
+
+template <int IpBytes>
+void IpToCountry::FindCountriesByIpImpl(IpSection<IpBytes> const& section, unsigned char const* ips, size_t nrIps, Country const** countries) const
+{
+	enum { GroupSize = 8 };
+
+	for (size_t base=0; base<nrIps; base+=GroupSize)
+	{
+		size_t const n = (nrIps - base < GroupSize) ? (nrIps - base) : (size_t) GroupSize;
+
+		typename IpSection<IpBytes>::Key keys[GroupSize];
+		size_t k[GroupSize];
+		for (size_t j=0; j!=n; ++j)
 		{
-			// Block is greater than ip. We are interested in previous block that is less than ip.
-			if (it == ipBlocks.begin())
+			ReadIpKey(ips + (base+j)*IpBytes, keys[j]);
+			k[j] = 1;
+		}
+
+		for (unsigned int level=0; level!=section.m_height; ++level)
+			for (size_t j=0; j!=n; ++j)
 			{
-				// There is no block less than or equal to ip. No match. Return null.
-				return nullptr;
+				PrefetchTreeNode(section.m_tree, k[j]);
+				k[j] = 2*k[j] + (section.m_tree[k[j]] <= keys[j]);
 			}
 
-			--it;
-		}
+		for (size_t j=0; j!=n; ++j)
+			countries[base+j] = MatchBlock<IpBytes>(section, ips + (base+j)*IpBytes, k[j]);
+	}
+}
+
+
+template <int IpBytes>
+IpToCountry::Country const* IpToCountry::MatchBlock(IpSection<IpBytes> const& section, unsigned char const* ip, size_t treeIndex) const
+{
+	// The index reached below the last level gives the number of blocks that start at or before ip.
+	// Padding keys are maximum keys, so for the maximum address, the count can include some of them.
+	size_t nrBlocksBefore = treeIndex - section.m_tree.size();
+	if (nrBlocksBefore > section.m_blocks.size())
+		nrBlocksBefore = section.m_blocks.size();
+
+	if (!nrBlocksBefore)
+	{
+		// There is no block less than or equal to ip. No match. Return null.
+		return nullptr;
 	}
 
 	// We have the highest block that is less than or equal to ip. Construct a copy of ip with insignificant bits cleared.
+	IpBlock<IpBytes> const& block = section.m_blocks[nrBlocksBefore - 1];
 	unsigned char sigIp[IpBytes];
 	memcpy(sigIp, ip, IpBytes);
-	SetIpToStartOfSubNet(sigIp, IpBytes, it->m_sigBits);
+	SetIpToStartOfSubNet(sigIp, IpBytes, block.m_sigBits);
 
 	// We have a copy of ip with insignificant bits cleared. Does it match the block IP?
-	if (memcmp(it->m_ip, sigIp, IpBytes) != 0)
+	if (memcmp(block.m_ip, sigIp, IpBytes) != 0)
 	{
 		// No match. Return null.
 		return nullptr;
 	}
 
 	// This block matches the ip.
-	return &m_countries[it->m_countryIndex];
+	return &m_countries[block.m_countryIndex];
 }
 
 